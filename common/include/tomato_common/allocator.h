@@ -1,23 +1,62 @@
 /*
  * @Author: Tomato
  * @Date: 2021-12-18 13:08:13
- * @LastEditTime: 2023-02-01 22:48:33
+ * @LastEditTime: 2026-10-18 23:48:43
  */
 #ifndef TOMATODB_COMMON_INCLUDE_TOMATODB_ALLOCATOR_H
 #define TOMATODB_COMMON_INCLUDE_TOMATODB_ALLOCATOR_H
 
 #include <vector>
 #include <atomic>
+#include <memory>
+#include <mutex>
+#include <cstddef>
+#include <cstdint>
 
 namespace tomato {
 
+/**
+ * @brief 统计多个分配器的内存: 分配内存块时计入, 分配器不再分配时转为等待释放, 分配器析构时释放
+ * 
+ */
+class AllocationTracker {
+public:
+    virtual ~AllocationTracker() = default;
+
+    /**
+     * @brief 分配器分配了一个内存块
+     * @param bytes 字节数
+     */
+    virtual void reserveMemory(size_t bytes) = 0;
+
+    /**
+     * @brief 分配器不再分配, 它的内存会在之后释放
+     * @param bytes 分配器的总字节数
+     */
+    virtual void scheduleFreeMemory(size_t bytes) = 0;
+
+    /**
+     * @brief 分配器的内存已经释放
+     * @param bytes 分配器的总字节数
+     */
+    virtual void freeMemory(size_t bytes) = 0;
+};
+
 /**
  * @brief 内存分配器
  * 
  */
 class Allocator {
 public:
-    Allocator(): pool_begin_(nullptr), current_remaining_(0), allocated_size_(0) {}
+    Allocator(): pool_begin_(nullptr), current_remaining_(0), allocated_size_(0), tracker_(), done_allocating_(false) {}
+
+    /**
+     * @brief 构造向tracker报告内存的分配器
+     * @param tracker 内存统计, 可以为空
+     */
+    explicit Allocator(std::shared_ptr<AllocationTracker> tracker)
+        : pool_begin_(nullptr), current_remaining_(0), allocated_size_(0), 
+          tracker_(std::move(tracker)), done_allocating_(false) {}
 
     /**
      * @brief 回收所有分配过的内存，分配器分配过的内存只有在分配器析构时才会被回收
@@ -41,6 +80,14 @@ public:
      */
     char* allocateAligned(size_t bytes);
 
+    /**
+     * @brief 线程安全地分配内存，内存首地址是对齐的，供多线程并发写入内存表时使用
+     * 
+     * @param bytes 要分配的内存
+     * @return char* 内存块首地址
+     */
+    char* allocateAlignedConcurrently(size_t bytes);
+
     /**
      * @brief 获取内存分配池已经分配的内存字节数
      * 
@@ -50,6 +97,11 @@ public:
         return allocated_size_.load(std::memory_order_relaxed);
     }
 
+    /**
+     * @brief 之后不再分配内存, 向tracker报告内存等待释放; 只报告一次, 之后仍可以读取已分配的内存
+     */
+    void doneAllocating();
+
     Allocator(Allocator&&) = delete;
     Allocator(const Allocator&) = delete;
     Allocator& operator=(const Allocator&) = delete;
@@ -68,6 +120,13 @@ private:
     // 已经分配了多少内存
     std::atomic<size_t> allocated_size_;
 
+    // 并发分配时使用的锁
+    std::mutex mutex_;
+
+    // 内存统计, 以及是否已经报告过不再分配
+    std::shared_ptr<AllocationTracker> tracker_;
+    std::atomic<bool> done_allocating_;
+
     // 内存块尺寸
     static const int POOL_BLOCK_BYTES;
 
@@ -78,10 +137,6 @@ private:
     static const int ALIGN;
 };
 
-const int Allocator::POOL_BLOCK_BYTES = 4096;
-const int Allocator::BIG_BYTES_THRESHOLD = Allocator::POOL_BLOCK_BYTES / 4;
-const int Allocator::ALIGN = (sizeof(void*) > 8) ? 8 : sizeof(void*);
-
 }
 
 
@@ -1,13 +1,14 @@
 /*
  * @Author: Tomato
  * @Date: 2021-12-22 21:48:44
- * @LastEditTime: 2021-12-24 21:56:15
+ * @LastEditTime: 2026-10-18 21:47:22
  */
 #ifndef TOMATODB_COMMON_INCLUDE_TOMATO_CODEC_H
 #define TOMATODB_COMMON_INCLUDE_TOMATO_CODEC_H
 
 #include <string>
 #include <utility>
+#include <cstdint>
 
 namespace tomato {
 namespace codec {
@@ -76,6 +77,31 @@ std::string encodeVar64(uint64_t value);
  */
 std::pair<uint64_t, int> decodeVar64(const std::string& value);
 
+/**
+ * @brief 解码begin处的32位定长数字, 调用方保证至少有4个字节
+ * 
+ * @param begin 
+ * @return uint32_t 
+ */
+uint32_t decodeFixed32(const char* begin);
+
+/**
+ * @brief 解码begin处的64位定长数字, 调用方保证至少有8个字节
+ * 
+ * @param begin 
+ * @return uint64_t 
+ */
+uint64_t decodeFixed64(const char* begin);
+
+/**
+ * @brief 解码[begin, end)范围内的变长64位无符号数字, 不会越过end读取
+ * 
+ * @param begin 编码首地址
+ * @param end 可读范围的尾后地址
+ * @return [result, offset], 数据不完整或超长时offset为0
+ */
+std::pair<uint64_t, int> decodeVar64(const char* begin, const char* end);
+
 }
 }
 
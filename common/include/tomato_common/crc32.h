@@ -20,6 +20,17 @@ namespace tomato {
  */
 uint32_t crc32(const char* seq, size_t length);
 
+/**
+ * @brief 在已有crc的基础上继续计算后续字节的crc, crc32(init_crc, b, n)等价于对a+b整体计算crc,
+ *        其中init_crc = crc32(a, m)
+ * 
+ * @param init_crc 前面字节串的crc校验和
+ * @param seq 字节串
+ * @param length 多少个字节
+ * @return uint32_t crc32校验和
+ */
+uint32_t crc32(uint32_t init_crc, const char* seq, size_t length);
+
 }
 
 #endif
\ No newline at end of file
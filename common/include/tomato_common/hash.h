@@ -0,0 +1,26 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 22:56:37
+ * @LastEditTime: 2026-10-18 22:56:37
+ */
+#ifndef TOMATODB_COMMON_INCLUDE_TOMATO_HASH_H
+#define TOMATODB_COMMON_INCLUDE_TOMATO_HASH_H
+
+#include <cstdint>
+#include <cstddef>
+
+namespace tomato {
+
+/**
+ * @brief 类似murmur的32位哈希, 结果会写入文件(布隆过滤器、block哈希索引), 不能修改
+ * 
+ * @param data 字节串
+ * @param length 多少个字节
+ * @param seed 种子
+ * @return uint32_t 哈希值
+ */
+uint32_t hashBytes(const char* data, size_t length, uint32_t seed);
+
+}
+
+#endif
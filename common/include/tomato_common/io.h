@@ -1,13 +1,17 @@
 /*
  * @Author: Tomato
  * @Date: 2021-12-22 00:04:56
- * @LastEditTime: 2022-01-16 19:09:20
+ * @LastEditTime: 2026-10-18 00:14:23
  */
 #ifndef TOMATODB_COMMON_INCLUDE_TOMATO_IO_H
 #define TOMATODB_COMMON_INCLUDE_TOMATO_IO_H
 
 #include <string>
 #include <memory>
+#include <vector>
+#include <cstdint>
+
+#include <sys/types.h>
 
 namespace tomato {
 
@@ -44,6 +48,10 @@ public:
     int getCode() const {
         return code_;
     }
+
+    const std::string& getMessage() const {
+        return message_;
+    }
 public:
     static OperatorResult success() {
         return OperatorResult(0);
@@ -54,6 +62,31 @@ private:
     std::string message_;
 };
 
+/**
+ * @brief 追加写文件的配置
+ * 
+ */
+struct AppendOnlyFileOptions {
+    /**
+     * @brief 每写入多少字节就通过sync_file_range发起一次异步回写, 把脏页分摊到写入过程中,
+     *        避免sync时一次性刷出大量数据; 0表示不开启
+     * 
+     */
+    uint64_t bytes_per_sync = 0;
+
+    /**
+     * @brief 每次通过fallocate预分配的磁盘空间, 避免写入时频繁分配extent带来的元数据更新; 0表示不预分配
+     * 
+     */
+    uint64_t preallocate_size = 0;
+
+    /**
+     * @brief sync时使用fdatasync代替fsync, 只落盘数据及读取数据所必需的元数据(如文件长度)
+     * 
+     */
+    bool use_fdatasync = true;
+};
+
 /**
  * @brief 追加写文件
  * 
@@ -116,6 +149,25 @@ public:
     virtual std::string getDirName() const = 0;
 };
 
+/**
+ * @brief 顺序读文件的配置
+ * 
+ */
+struct SequentialFileOptions {
+    /**
+     * @brief 预读窗口大小, 小于该值的读请求会一次性从内核读满整个窗口, 后续请求直接从窗口中获取;
+     *        大于等于该值的读请求直接读入调用方的内存; 0表示不使用预读窗口
+     * 
+     */
+    size_t readahead_size = 1 << 20;
+
+    /**
+     * @brief 是否通过posix_fadvise(SEQUENTIAL)提示内核加大预读
+     * 
+     */
+    bool advise_sequential = true;
+};
+
 /**
  * @brief 顺序读文件
  * 
@@ -136,7 +188,8 @@ public:
     virtual bool isOpen() const = 0;
     
     /**
-     * @brief 从文件上次的offset开始，顺序读取n个字节
+     * @brief 从文件上次的offset开始，顺序读取n个字节, 追加到output末尾;
+     *        读到文件末尾时实际读取的字节数会小于n, 此时isEof()返回true
      * 
      * @param size 要读取的字节数
      * @param output [out] 将数据读取到这块内存中
@@ -144,6 +197,14 @@ public:
      */
     virtual OperatorResult read(size_t size, std::string& output) = 0;
 
+    /**
+     * @brief 上一次读取是否已经到达文件末尾
+     * 
+     * @return true 已到达文件末尾
+     * @return false 未到达文件末尾
+     */
+    virtual bool isEof() const = 0;
+
     /**
      * @brief 从文件当前偏移位置开始，跳过n个字节
      * 
@@ -195,6 +256,15 @@ public:
      */
     virtual OperatorResult read(uint64_t offset, size_t size, std::string& output) = 0;
 
+    /**
+     * @brief 文件映射到内存时的起始地址, 文件关闭前可以直接读取而不复制
+     * 
+     * @return const char* 没有映射到内存时为空
+     */
+    virtual const char* getMappedData() const {
+        return nullptr;
+    }
+
     /**
      * @brief 得到文件名(得到的是构造文件时传入的值)
      * 
@@ -233,6 +303,16 @@ public:
  */
 std::shared_ptr<AppendOnlyFile> createAppendOnlyFile(const std::string& filename);
 
+/**
+ * @brief 创建顺序写文件
+ * 
+ * @param filename 文件名或全路径名或相对路径名
+ * @param options 回写、预分配等配置
+ * @return std::shared_ptr<AppendOnlyFile> 
+ */
+std::shared_ptr<AppendOnlyFile> createAppendOnlyFile(const std::string& filename,
+                                                     const AppendOnlyFileOptions& options);
+
 /**
  * @brief 创建顺序读文件
  * 
@@ -241,6 +321,16 @@ std::shared_ptr<AppendOnlyFile> createAppendOnlyFile(const std::string& filename
  */
 std::shared_ptr<SequentialFile> createSequentialFile(const std::string& filename);
 
+/**
+ * @brief 创建顺序读文件
+ * 
+ * @param filename 文件名或全路径名或相对路径名
+ * @param options 预读配置
+ * @return std::shared_ptr<SequentialFile> 
+ */
+std::shared_ptr<SequentialFile> createSequentialFile(const std::string& filename,
+                                                     const SequentialFileOptions& options);
+
 /**
  * @brief 创建随机读文件
  * 
@@ -249,6 +339,48 @@ std::shared_ptr<SequentialFile> createSequentialFile(const std::string& filename
  */
 std::shared_ptr<RandomAccessFile> createRandomAccessFile(const std::string& filename);
 
+/**
+ * @brief 创建文件夹, 文件夹已存在时视为成功
+ * 
+ * @param dirname 文件夹路径
+ * @return OperatorResult 
+ */
+OperatorResult createDir(const std::string& dirname);
+
+/**
+ * @brief 列出文件夹下的所有文件名(不含路径, 不含.与..)
+ * 
+ * @param dirname 文件夹路径
+ * @param children [out] 文件名
+ * @return OperatorResult 
+ */
+OperatorResult listDir(const std::string& dirname, std::vector<std::string>& children);
+
+/**
+ * @brief 删除文件
+ * 
+ * @param filename 文件名或全路径名或相对路径名
+ * @return OperatorResult 
+ */
+OperatorResult removeFile(const std::string& filename);
+
+/**
+ * @brief 重命名文件, 目标文件已存在时原子地替换
+ * 
+ * @param from 原文件名
+ * @param to 新文件名
+ * @return OperatorResult 
+ */
+OperatorResult renameFile(const std::string& from, const std::string& to);
+
+/**
+ * @brief 将目录落盘, 之前在目录中创建、删除与重命名的文件项在崩溃后仍然存在
+ * 
+ * @param dirname 目录名
+ * @return OperatorResult 
+ */
+OperatorResult syncDir(const std::string& dirname);
+
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,76 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 22:47:45
+ * @LastEditTime: 2026-10-18 22:52:21
+ */
+#ifndef TOMATODB_COMMON_INCLUDE_TOMATO_LZ_H
+#define TOMATODB_COMMON_INCLUDE_TOMATO_LZ_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace tomato {
+namespace lz {
+
+/**
+ * @brief LZ77族的快速压缩, 不依赖第三方库, 格式:
+ *        [原始长度(变长)][序列 1]...[序列 n]
+ *        序列为[token(高4位字面量长度, 低4位匹配长度-4)][字面量长度扩展][字面量][偏移量(定长16位)][匹配长度扩展],
+ *        长度为15时后面跟着扩展字节, 每个字节累加, 直到遇到不为255的字节;
+ *        最后一个序列只有字面量, 解压出原始长度的数据后结束
+ * 
+ * @param input 原始数据
+ * @param size 原始数据的字节数
+ * @param output [out] 追加到output末尾
+ */
+void compress(const char* input, size_t size, std::string& output);
+
+/**
+ * @brief 解压compress的输出, 不会越界读写
+ * 
+ * @param input 压缩后的数据
+ * @param size 压缩后的字节数
+ * @param output [out] 解压后的数据, 覆盖原有内容
+ * @return true 成功; false 数据损坏
+ */
+bool decompress(const char* input, size_t size, std::string& output);
+
+/**
+ * @brief 以字典作为已经输出过的内容进行压缩, 匹配可以引用字典末尾64KB内的数据,
+ *        小块数据单独压缩时也能利用块之间的重复内容
+ * 
+ * @param dict 字典, 解压时需要同样的字典
+ * @param dict_size 字典的字节数, 为0时与compress相同
+ * @param input 原始数据
+ * @param size 原始数据的字节数
+ * @param output [out] 追加到output末尾
+ */
+void compressWithDict(const char* dict, size_t dict_size, const char* input, size_t size, std::string& output);
+
+/**
+ * @brief 解压compressWithDict的输出
+ * 
+ * @param dict 压缩时使用的字典
+ * @param dict_size 字典的字节数
+ * @param input 压缩后的数据
+ * @param size 压缩后的字节数
+ * @param output [out] 解压后的数据, 覆盖原有内容
+ * @return true 成功; false 数据损坏或字典不匹配
+ */
+bool decompressWithDict(const char* dict, size_t dict_size, const char* input, size_t size, std::string& output);
+
+/**
+ * @brief 从样本中训练字典: 把样本切成定长的片段, 按片段中的短序列出现在多少个样本中打分,
+ *        贪心地选出得分最高的片段, 已经选中的短序列不再计分; 得分高的片段放在字典末尾, 匹配的偏移量更小
+ * 
+ * @param samples 样本, 如缓存的data block
+ * @param max_size 字典的最大字节数
+ * @return std::string 字典, 样本之间没有重复内容时为空
+ */
+std::string trainDictionary(const std::vector<std::string>& samples, size_t max_size);
+
+}
+}
+
+#endif
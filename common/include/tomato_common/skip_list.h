@@ -1,7 +1,7 @@
 /*
  * @Author: Tomato
  * @Date: 2021-12-18 23:51:23
- * @LastEditTime: 2022-11-24 11:20:08
+ * @LastEditTime: 2026-10-18 22:03:41
  */
 #ifndef TOMATODB_COMMON_INCLUDE_TOMATO_SKIP_LIST_H
 #define TOMATODB_COMMON_INCLUDE_TOMATO_SKIP_LIST_H
@@ -48,12 +48,24 @@ public:
          */
         bool valid() const;
 
+        /**
+         * @brief 将cur_指向跳表最后一个节点
+         * 
+         */
+        void seekToLast();
+
         /**
          * @brief 向后移动
          * 
          */
         void next();
 
+        /**
+         * @brief 向前移动, 跳表没有反向指针, 需要重新查找前驱节点
+         * 
+         */
+        void prev();
+
         /**
          * @brief 查找符合条件的值，设置到cur_上
          * 
@@ -83,6 +95,22 @@ public:
      */
     void insert(const Value& value);
 
+    /**
+     * @brief 线程安全地插入一个值, 可与其他insertConcurrently/insertSortedConcurrently及读操作并发执行,
+     *        但不能与insert、remove并发执行
+     * 
+     * @param value 要插入的值
+     */
+    void insertConcurrently(const Value& value);
+
+    /**
+     * @brief 线程安全地批量插入一组有序的值, 每次插入从上一个值的前驱节点开始查找,
+     *        有序数据不需要每次都从头节点开始搜索; 并发限制同insertConcurrently
+     * 
+     * @param values 按comparator升序排列的值
+     */
+    void insertSortedConcurrently(const std::vector<Value>& values);
+
     /**
      * @brief 查询值是否存在
      * 
@@ -148,7 +176,27 @@ private:
      * @param level 节点有几层
      * @return Node* 
      */
-    Node* newNode(const Value& value, int level);
+    Node* newNode(const Value& value, int level, bool concurrent = false);
+
+    /**
+     * @brief 并发插入一个值
+     * 
+     * @param value 要插入的值
+     * @param prev [in/out] 每一层的前驱节点提示, 提示节点必须小于value, nullptr表示没有提示;
+     *             插入完成后记录新节点每一层的前驱节点
+     */
+    void insertConcurrently(const Value& value, std::vector<Node*>& prev);
+
+    /**
+     * @brief 从before开始，在某一层中查找value的前驱与后继节点
+     * 
+     * @param value 目标值
+     * @param before 查找起点, 必须小于value
+     * @param level 层数
+     * @param prev [out] 前驱节点
+     * @param next [out] 后继节点
+     */
+    void findSpliceForLevel(const Value& value, Node* before, int level, Node** prev, Node** next) const;
 
     /**
      * @brief 查询跳表中第一个不小于target元素的节点
@@ -167,6 +215,21 @@ private:
      */
     Node* searchFirstNotLess(const Value& target, std::vector<Node*>* path) const;
 
+    /**
+     * @brief 查询跳表中最后一个小于target元素的节点
+     * 
+     * @param target 目标节点
+     * @return 查询结果, 没有时返回nullptr
+     */
+    Node* searchLastLess(const Value& target) const;
+
+    /**
+     * @brief 查询跳表中最后一个节点
+     * 
+     * @return 查询结果, 跳表为空时返回nullptr
+     */
+    Node* searchLast() const;
+
     /**
      * @brief Set the Current Max Level 
      * 
@@ -202,6 +265,19 @@ public:
         next_[level].store(node, std::memory_order_release);
     }
 
+    /**
+     * @brief 当前节点的下一个节点仍为expected时, 将其替换为node
+     * 
+     * @param level 层数
+     * @param expected 期望的下一个节点
+     * @param node 要设置的下一个节点
+     * @return true 替换成功; false 下一个节点已被其他线程修改
+     */
+    bool casNext(int level, Node* expected, Node* node) {
+        assert(level >= 0);
+        return next_[level].compare_exchange_strong(expected, node);
+    }
+
 public:
     const Value val;
 private:
@@ -250,6 +326,75 @@ void SkipList<Value, Comparator>::insert(const Value& value) {
     }
 }
 
+template<typename Value, typename Comparator>
+void SkipList<Value, Comparator>::insertConcurrently(const Value& value) {
+    std::vector<Node*> prev(MAX_LEVEL, nullptr);
+    insertConcurrently(value, prev);
+}
+
+template<typename Value, typename Comparator>
+void SkipList<Value, Comparator>::insertSortedConcurrently(const std::vector<Value>& values) {
+    // 上一个值的前驱节点一定小于当前值，可以作为当前值的查找起点
+    std::vector<Node*> prev(MAX_LEVEL, nullptr);
+    for (const Value& value : values) {
+        insertConcurrently(value, prev);
+    }
+}
+
+template<typename Value, typename Comparator>
+void SkipList<Value, Comparator>::insertConcurrently(const Value& value, std::vector<Node*>& prev) {
+    int new_node_level = randomLevel();
+    Node* insert_node = newNode(value, new_node_level, true);
+
+    // 先抬高最大层高，读线程看到更高的层时只会遇到空指针
+    int old_max_level = getCurrentMaxLevel();
+    while (old_max_level < new_node_level && 
+           !max_level_.compare_exchange_weak(old_max_level, new_node_level)) {
+    }
+
+    // 自顶向下查找每一层的前驱与后继，起点取提示节点与上一层前驱中更靠后的一个
+    std::vector<Node*> next(MAX_LEVEL, nullptr);
+    Node* before = head_;
+    for (int level = MAX_LEVEL - 1; level >= 0; --level) {
+        Node* hint = prev[level];
+        if (hint != nullptr && hint != before &&
+                (before == head_ || comparator_(before->val, hint->val) < 0)) {
+            before = hint;
+        }
+        findSpliceForLevel(value, before, level, &prev[level], &next[level]);
+        before = prev[level];
+    }
+
+    // 自底向上链接，CAS失败说明有其他线程在同一位置插入，从原前驱重新查找
+    for (int level = 0; level < new_node_level; ++level) {
+        while (true) {
+            insert_node->setNext(level, next[level]);
+            if (prev[level]->casNext(level, next[level], insert_node)) {
+                break;
+            }
+            findSpliceForLevel(value, prev[level], level, &prev[level], &next[level]);
+        }
+    }
+
+    // 新节点成为后续有序插入的前驱提示
+    for (int level = 0; level < new_node_level; ++level) {
+        prev[level] = insert_node;
+    }
+}
+
+template<typename Value, typename Comparator>
+void SkipList<Value, Comparator>::findSpliceForLevel(const Value& value, Node* before, int level, 
+                                                     Node** prev, Node** next) const {
+    Node* cur = before;
+    Node* cur_next = cur->next(level);
+    while (cur_next && comparator_(cur_next->val, value) < 0) {
+        cur = cur_next;
+        cur_next = cur->next(level);
+    }
+    *prev = cur;
+    *next = cur_next;
+}
+
 template<typename Value, typename Comparator>
 bool SkipList<Value, Comparator>::contains(const Value& value) const {
     Node* result = searchFirstNotLess(value);
@@ -331,9 +476,10 @@ int SkipList<Value, Comparator>::randomLevel() {
 
 template<typename Value, typename Comparator>
 typename SkipList<Value, Comparator>::Node* 
-SkipList<Value, Comparator>::newNode(const Value& value, int level) {
-    char* const m = allocator_->allocateAligned(
-        sizeof(Node) + sizeof(std::atomic<Node*>) * (level-1));
+SkipList<Value, Comparator>::newNode(const Value& value, int level, bool concurrent) {
+    const size_t bytes = sizeof(Node) + sizeof(std::atomic<Node*>) * static_cast<size_t>(level - 1);
+    char* const m = concurrent ? allocator_->allocateAlignedConcurrently(bytes) 
+                               : allocator_->allocateAligned(bytes);
     Node* result = new (m) Node(value);
     for (int i = 0; i < level; ++i) {
         result->setNext(i, nullptr);
@@ -370,6 +516,33 @@ SkipList<Value, Comparator>::searchFirstNotLess(const Value& target, std::vector
     return cur->next(0);
 }
 
+template<typename Value, typename Comparator>
+typename SkipList<Value, Comparator>::Node* 
+SkipList<Value, Comparator>::searchLastLess(const Value& target) const {
+    Node* cur = head_;
+    for (int level = getCurrentMaxLevel()-1; level >= 0; --level) {
+        Node* cur_next = cur->next(level);
+        while (cur_next && comparator_(cur_next->val, target) < 0) {
+            cur = cur_next;
+            cur_next = cur->next(level);
+        }
+    }
+    return cur == head_ ? nullptr : cur;
+}
+
+template<typename Value, typename Comparator>
+typename SkipList<Value, Comparator>::Node* 
+SkipList<Value, Comparator>::searchLast() const {
+    Node* cur = head_;
+    for (int level = getCurrentMaxLevel()-1; level >= 0; --level) {
+        Node* cur_next = cur->next(level);
+        while (cur_next) {
+            cur = cur_next;
+            cur_next = cur->next(level);
+        }
+    }
+    return cur == head_ ? nullptr : cur;
+}
 
 template<typename Value, typename Comparator>
 SkipList<Value, Comparator>::Node::Node(const Value& value): val(value) {
@@ -409,6 +582,16 @@ inline void SkipList<Value, Comparator>::Iterator::seekToFirst() {
     cur_ = list_->head_->next(0);
 }
 
+template<typename Value, typename Comparator>
+inline void SkipList<Value, Comparator>::Iterator::seekToLast() {
+    cur_ = list_->searchLast();
+}
+
+template<typename Value, typename Comparator>
+inline void SkipList<Value, Comparator>::Iterator::prev() {
+    cur_ = list_->searchLastLess(cur_->val);
+}
+
 
 
 }
@@ -0,0 +1,90 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 17:20:36
+ * @LastEditTime: 2026-10-18 17:20:36
+ */
+#ifndef TOMATODB_COMMON_INCLUDE_TOMATODB_THREAD_POOL_H
+#define TOMATODB_COMMON_INCLUDE_TOMATODB_THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace tomato {
+
+/**
+ * @brief 固定线程数的线程池
+ * 
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief 构造线程池
+     * 
+     * @param thread_count 线程数, 为0时任务在提交线程上直接执行
+     */
+    explicit ThreadPool(size_t thread_count);
+
+    /**
+     * @brief 执行完所有已提交的任务后退出
+     * 
+     */
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief 提交一个任务
+     * 
+     * @param function 无参数的可调用对象
+     * @return std::future 任务的返回值
+     */
+    template <typename Function>
+    std::future<typename std::result_of<Function()>::type> submit(Function function) {
+        using Result = typename std::result_of<Function()>::type;
+        std::shared_ptr<std::packaged_task<Result()>> task = 
+            std::make_shared<std::packaged_task<Result()>>(std::move(function));
+        std::future<Result> result = task->get_future();
+        if (threads_.empty()) {
+            (*task)();
+            return result;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.emplace_back([task]() { (*task)(); });
+        }
+        cond_.notify_one();
+        return result;
+    }
+
+    size_t getThreadCount() const {
+        return threads_.size();
+    }
+private:
+    /**
+     * @brief 工作线程不断取出任务执行
+     * 
+     */
+    void workLoop();
+private:
+    std::mutex mutex_;
+    std::condition_variable cond_;
+
+    /**
+     * @brief 等待执行的任务
+     * 
+     */
+    std::deque<std::function<void()>> tasks_;
+    bool stop_;
+    std::vector<std::thread> threads_;
+};
+
+}
+
+#endif
@@ -1,17 +1,31 @@
 /*
  * @Author: Tomato
  * @Date: 2021-12-18 13:19:56
- * @LastEditTime: 2023-02-01 23:01:45
+ * @LastEditTime: 2026-10-18 23:48:43
  */
 #include <tomato_common/allocator.h>
 #include <cassert>
 
 namespace tomato {
 
+const int Allocator::POOL_BLOCK_BYTES = 4096;
+const int Allocator::BIG_BYTES_THRESHOLD = Allocator::POOL_BLOCK_BYTES / 4;
+const int Allocator::ALIGN = (sizeof(void*) > 8) ? 8 : sizeof(void*);
+
 Allocator::~Allocator() {
     for (size_t i = 0; i < pool_.size(); ++i) {
         delete[] pool_[i];
     }
+    if (tracker_) {
+        doneAllocating();
+        tracker_->freeMemory(getAllocatedSize());
+    }
+}
+
+void Allocator::doneAllocating() {
+    if (tracker_ && !done_allocating_.exchange(true)) {
+        tracker_->scheduleFreeMemory(getAllocatedSize());
+    }
 }
 
 char* Allocator::allocate(size_t bytes) {
@@ -64,12 +78,20 @@ char* Allocator::allocateAligned(size_t bytes) {
     return result;
 }
 
+char* Allocator::allocateAlignedConcurrently(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return allocateAligned(bytes);
+}
+
 char* Allocator::doAllocate(size_t bytes) {
     char* result = new char[bytes];
     pool_.push_back(result);
 
     // 加上new时额外存储的数组尺寸
     allocated_size_.fetch_add(sizeof(char*) + bytes, std::memory_order_relaxed);
+    if (tracker_) {
+        tracker_->reserveMemory(sizeof(char*) + bytes);
+    }
     return result;
 }
 
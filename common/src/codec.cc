@@ -1,7 +1,7 @@
 /*
  * @Author: Tomato
  * @Date: 2021-12-22 22:06:13
- * @LastEditTime: 2022-11-24 09:06:07
+ * @LastEditTime: 2026-10-18 21:47:22
  */
 #include <tomato_common/codec.h>
 
@@ -43,7 +43,11 @@ std::string encodeFixed32(uint32_t value) {
  * @return uint32_t
  */
 uint32_t decodeFixed32(const std::string& value) {
-    const uint8_t* seq = reinterpret_cast<const uint8_t*>(value.c_str());
+    return decodeFixed32(value.c_str());
+}
+
+uint32_t decodeFixed32(const char* begin) {
+    const uint8_t* seq = reinterpret_cast<const uint8_t*>(begin);
     uint32_t result = 0;
     uint32_t shift = 0;
     for (size_t i = 0; i < 4; ++i) {
@@ -80,7 +84,11 @@ std::string encodeFixed64(uint64_t value) {
  * @return uint32_t 
  */
 uint64_t decodeFixed64(const std::string& value) {
-    const uint8_t* seq = reinterpret_cast<const uint8_t*>(value.c_str());
+    return decodeFixed64(value.c_str());
+}
+
+uint64_t decodeFixed64(const char* begin) {
+    const uint8_t* seq = reinterpret_cast<const uint8_t*>(begin);
     uint64_t result = 0;
     int shift = 0;
     for (int i = 0; i < 8; ++i) {
@@ -164,8 +172,27 @@ std::pair<uint64_t, int> decodeVar64(const std::string& value) {
     return std::make_pair(result, reinterpret_cast<const char*>(seq) - begin + 1);
 }
 
+/**
+ * @brief 解码变长的64位无符号数字, 不会越过end读取
+ * 
+ * @param begin 
+ * @param end 
+ * @return [result, offset], 失败时offset为0
+ */
+std::pair<uint64_t, int> decodeVar64(const char* begin, const char* end) {
+    const uint8_t* seq = reinterpret_cast<const uint8_t*>(begin);
+    const uint8_t* limit = reinterpret_cast<const uint8_t*>(end);
+    uint64_t result = 0;
+    for (int shift = 0; shift <= 63 && seq < limit; shift += 7) {
+        uint8_t cur = *seq;
+        ++seq;
+        result |= (static_cast<uint64_t>(cur & MASK) << shift);
+        if (!(cur & MOD_CODE)) {
+            return std::make_pair(result, static_cast<int>(reinterpret_cast<const char*>(seq) - begin));
+        }
+    }
+    return std::make_pair(static_cast<uint64_t>(0), 0);
+}
 
-
-
 }
-}
\ No newline at end of file
+}
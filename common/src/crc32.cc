@@ -63,8 +63,12 @@ const uint32_t kCrc32Table[256] = {
     0xbe2da0a5, 0x4c4623a6, 0x5f16d052, 0xad7d5351};
     
 uint32_t crc32(const char* seq, size_t length) {
+    return crc32(0, seq, length);
+}
+
+uint32_t crc32(uint32_t init_crc, const char* seq, size_t length) {
     const uint8_t* int_seq = reinterpret_cast<const uint8_t*>(seq);
-    uint32_t res = kCRC32Xor;
+    uint32_t res = init_crc ^ kCRC32Xor;
     for (size_t i = 0; i < length; ++i) {
         res = (res >> 8) ^ kCrc32Table[(res & 0xff) ^ int_seq[i]];
     }
@@ -0,0 +1,39 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 22:56:37
+ * @LastEditTime: 2026-10-18 22:56:37
+ */
+#include <tomato_common/hash.h>
+#include <tomato_common/codec.h>
+
+namespace tomato {
+
+uint32_t hashBytes(const char* data, size_t length, uint32_t seed) {
+    const uint32_t m = 0xc6a4a793;
+    const uint32_t r = 24;
+    uint32_t h = seed ^ static_cast<uint32_t>(length * m);
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        h += codec::decodeFixed32(data + i);
+        h *= m;
+        h ^= (h >> 16);
+    }
+    switch (length - i) {
+        case 3:
+            h += static_cast<uint32_t>(static_cast<unsigned char>(data[i + 2])) << 16;
+            // fall through
+        case 2:
+            h += static_cast<uint32_t>(static_cast<unsigned char>(data[i + 1])) << 8;
+            // fall through
+        case 1:
+            h += static_cast<unsigned char>(data[i]);
+            h *= m;
+            h ^= (h >> r);
+            break;
+        default:
+            break;
+    }
+    return h;
+}
+
+}
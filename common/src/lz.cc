@@ -0,0 +1,315 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 22:47:45
+ * @LastEditTime: 2026-10-18 22:52:21
+ */
+#include <tomato_common/lz.h>
+#include <tomato_common/codec.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace tomato {
+namespace lz {
+
+/**
+ * @brief 最短匹配长度
+ * 
+ */
+static const size_t MIN_MATCH = 4;
+
+/**
+ * @brief 偏移量用16位保存, 只在之前64KB内查找匹配
+ * 
+ */
+static const size_t MAX_OFFSET = 65535;
+
+/**
+ * @brief 哈希表大小为2^HASH_BITS, 保存每个4字节序列最后出现的位置
+ * 
+ */
+static const int HASH_BITS = 14;
+
+/**
+ * @brief token中长度字段的最大值, 达到它时后面跟着扩展字节
+ * 
+ */
+static const size_t TOKEN_MASK = 15;
+
+/**
+ * @brief 训练字典时计分的短序列长度与片段长度
+ * 
+ */
+static const size_t TRAIN_KMER = 8;
+static const size_t TRAIN_SEGMENT = 64;
+
+/**
+ * @brief 训练字典时短序列频数表的大小为2^TRAIN_HASH_BITS
+ * 
+ */
+static const int TRAIN_HASH_BITS = 18;
+
+static uint32_t read32(const char* p) {
+    uint32_t value = 0;
+    ::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static size_t hash32(uint32_t value) {
+    return static_cast<size_t>((value * 2654435761u) >> (32 - HASH_BITS));
+}
+
+static size_t hashKmer(const char* p) {
+    uint64_t value = 0;
+    ::memcpy(&value, p, sizeof(value));
+    return static_cast<size_t>((value * 0x9e3779b97f4a7c15ull) >> (64 - TRAIN_HASH_BITS));
+}
+
+/**
+ * @brief 写入超出token部分的长度
+ * 
+ */
+static void appendLength(size_t length, std::string& output) {
+    while (length >= 255) {
+        output.push_back(static_cast<char>(255));
+        length -= 255;
+    }
+    output.push_back(static_cast<char>(length));
+}
+
+/**
+ * @brief 读取扩展长度并累加到length上
+ * 
+ */
+static bool consumeLength(const char*& p, const char* end, size_t& length) {
+    while (true) {
+        if (p >= end) {
+            return false;
+        }
+        const unsigned char byte = static_cast<unsigned char>(*p++);
+        length += byte;
+        if (byte != 255) {
+            return true;
+        }
+    }
+}
+
+/**
+ * @brief 写入一个序列, match_length为0时只有字面量
+ * 
+ */
+static void appendSequence(const char* literals, size_t literal_length, size_t offset, size_t match_length,
+                           std::string& output) {
+    const size_t match_code = match_length == 0 ? 0 : match_length - MIN_MATCH;
+    const size_t literal_token = literal_length < TOKEN_MASK ? literal_length : TOKEN_MASK;
+    const size_t match_token = match_code < TOKEN_MASK ? match_code : TOKEN_MASK;
+    output.push_back(static_cast<char>((literal_token << 4) | match_token));
+    if (literal_token == TOKEN_MASK) {
+        appendLength(literal_length - TOKEN_MASK, output);
+    }
+    output.append(literals, literal_length);
+    if (match_length == 0) {
+        return;
+    }
+    output.push_back(static_cast<char>(offset & 0xff));
+    output.push_back(static_cast<char>(offset >> 8));
+    if (match_token == TOKEN_MASK) {
+        appendLength(match_code - TOKEN_MASK, output);
+    }
+}
+
+void compress(const char* input, size_t size, std::string& output) {
+    compressWithDict(nullptr, 0, input, size, output);
+}
+
+bool decompress(const char* input, size_t size, std::string& output) {
+    return decompressWithDict(nullptr, 0, input, size, output);
+}
+
+void compressWithDict(const char* dict, size_t dict_size, const char* input, size_t size, std::string& output) {
+    output.append(codec::encodeVar64(size));
+    // 有字典时把字典与输入拼在一起, 位置从字典的起点开始计算
+    std::string buffer;
+    const char* base = input;
+    if (dict_size > 0) {
+        buffer.reserve(dict_size + size);
+        buffer.append(dict, dict_size);
+        buffer.append(input, size);
+        base = buffer.data();
+    }
+    const size_t total = dict_size + size;
+
+    // 位置加1后保存, 0表示没有出现过
+    std::vector<uint32_t> table(static_cast<size_t>(1) << HASH_BITS, 0);
+    for (size_t pos = dict_size > MAX_OFFSET ? dict_size - MAX_OFFSET : 0; pos + MIN_MATCH <= dict_size; ++pos) {
+        table[hash32(read32(base + pos))] = static_cast<uint32_t>(pos + 1);
+    }
+    size_t anchor = dict_size;
+    size_t pos = dict_size;
+    while (pos + MIN_MATCH <= total) {
+        const uint32_t sequence = read32(base + pos);
+        const size_t hash = hash32(sequence);
+        const size_t candidate = table[hash];
+        table[hash] = static_cast<uint32_t>(pos + 1);
+        if (candidate == 0 || pos + 1 - candidate > MAX_OFFSET || read32(base + candidate - 1) != sequence) {
+            // 长时间找不到匹配时加大步长, 不可压缩的数据很快就能扫过
+            pos += 1 + ((pos - anchor) >> 6);
+            continue;
+        }
+        const size_t match = candidate - 1;
+        size_t length = MIN_MATCH;
+        while (pos + length < total && base[match + length] == base[pos + length]) {
+            ++length;
+        }
+        appendSequence(base + anchor, pos - anchor, pos - match, length, output);
+        pos += length;
+        anchor = pos;
+    }
+    appendSequence(base + anchor, total - anchor, 0, 0, output);
+}
+
+bool decompressWithDict(const char* dict, size_t dict_size, const char* input, size_t size, std::string& output) {
+    const char* p = input;
+    const char* end = input + size;
+    std::pair<uint64_t, int> res = codec::decodeVar64(p, end);
+    if (res.second == 0) {
+        return false;
+    }
+    p += res.second;
+    // 每个输入字节最多展开成255 + 约4个字节, 超出的原始长度一定是损坏的数据
+    const uint64_t expected = res.first;
+    if (expected > static_cast<uint64_t>(end - p) * 260 + 16) {
+        return false;
+    }
+    output.resize(static_cast<size_t>(expected));
+    char* out = &output[0];
+    size_t written = 0;
+    while (true) {
+        if (p >= end) {
+            return false;
+        }
+        const unsigned char token = static_cast<unsigned char>(*p++);
+        size_t literal_length = token >> 4;
+        if (literal_length == TOKEN_MASK && !consumeLength(p, end, literal_length)) {
+            return false;
+        }
+        if (literal_length > static_cast<size_t>(end - p) || literal_length > expected - written) {
+            return false;
+        }
+        ::memcpy(out + written, p, literal_length);
+        p += literal_length;
+        written += literal_length;
+        if (written == expected) {
+            return p == end;
+        }
+
+        if (end - p < 2) {
+            return false;
+        }
+        const size_t offset = static_cast<size_t>(static_cast<unsigned char>(p[0])) |
+                              (static_cast<size_t>(static_cast<unsigned char>(p[1])) << 8);
+        p += 2;
+        size_t match_length = token & TOKEN_MASK;
+        if (match_length == TOKEN_MASK && !consumeLength(p, end, match_length)) {
+            return false;
+        }
+        match_length += MIN_MATCH;
+        if (offset == 0 || offset > written + dict_size || match_length > expected - written) {
+            return false;
+        }
+        char* to = out + written;
+        size_t copied = 0;
+        if (offset > written) {
+            // 匹配从字典中开始
+            const size_t back = offset - written;
+            copied = back < match_length ? back : match_length;
+            ::memcpy(to, dict + dict_size - back, copied);
+        }
+        // 匹配可以与自身重叠, 逐字节复制
+        for (size_t i = copied; i < match_length; ++i) {
+            to[i] = out[written + i - offset];
+        }
+        written += match_length;
+    }
+}
+
+std::string trainDictionary(const std::vector<std::string>& samples, size_t max_size) {
+    // 每个短序列出现在多少个样本中, 只在一个样本中出现的内容单独压缩就能利用
+    const size_t table_size = static_cast<size_t>(1) << TRAIN_HASH_BITS;
+    std::vector<uint32_t> freq(table_size, 0);
+    std::vector<uint32_t> last_sample(table_size, UINT32_MAX);
+    for (size_t i = 0; i < samples.size(); ++i) {
+        const std::string& sample = samples[i];
+        for (size_t pos = 0; pos + TRAIN_KMER <= sample.size(); ++pos) {
+            const size_t hash = hashKmer(sample.data() + pos);
+            if (last_sample[hash] != static_cast<uint32_t>(i)) {
+                last_sample[hash] = static_cast<uint32_t>(i);
+                ++freq[hash];
+            }
+        }
+    }
+
+    auto score = [&](size_t sample, size_t offset) {
+        uint64_t total = 0;
+        const std::string& data = samples[sample];
+        const size_t end = std::min(offset + TRAIN_SEGMENT, data.size());
+        for (size_t pos = offset; pos + TRAIN_KMER <= end; ++pos) {
+            const uint32_t count = freq[hashKmer(data.data() + pos)];
+            // 只计算在多个样本中出现的短序列
+            total += count > 1 ? count : 0;
+        }
+        return total;
+    };
+
+    // 选中片段后它的短序列不再计分, 片段的得分只会降低: 取出得分最高的片段后重新计算,
+    // 仍不低于剩余的最高得分时才选中
+    typedef std::pair<uint64_t, std::pair<size_t, size_t>> Candidate;
+    std::priority_queue<Candidate> candidates;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        for (size_t offset = 0; offset + TRAIN_KMER <= samples[i].size(); offset += TRAIN_SEGMENT) {
+            const uint64_t value = score(i, offset);
+            if (value > 0) {
+                candidates.push(Candidate(value, std::make_pair(i, offset)));
+            }
+        }
+    }
+    std::vector<std::pair<size_t, size_t>> selected;
+    size_t dict_size = 0;
+    while (!candidates.empty() && dict_size < max_size) {
+        const Candidate top = candidates.top();
+        candidates.pop();
+        const uint64_t value = score(top.second.first, top.second.second);
+        if (value == 0) {
+            continue;
+        }
+        if (!candidates.empty() && value < candidates.top().first) {
+            candidates.push(Candidate(value, top.second));
+            continue;
+        }
+        const std::string& data = samples[top.second.first];
+        const size_t end = std::min(top.second.second + TRAIN_SEGMENT, data.size());
+        for (size_t pos = top.second.second; pos + TRAIN_KMER <= end; ++pos) {
+            freq[hashKmer(data.data() + pos)] = 0;
+        }
+        selected.push_back(top.second);
+        dict_size += end - top.second.second;
+    }
+
+    // 先选中的片段得分高, 放在字典末尾
+    std::string dict;
+    for (auto it = selected.rbegin(); it != selected.rend(); ++it) {
+        const std::string& data = samples[it->first];
+        dict.append(data, it->second, std::min(TRAIN_SEGMENT, data.size() - it->second));
+    }
+    if (dict.size() > max_size) {
+        dict.erase(0, dict.size() - max_size);
+    }
+    return dict;
+}
+
+}
+}
@@ -1,11 +1,12 @@
 /*
  * @Author: Tomato
  * @Date: 2022-01-14 22:25:32
- * @LastEditTime: 2022-11-24 08:43:31
+ * @LastEditTime: 2026-10-18 00:14:23
  */
 
 #include <tomato_common/io.h>
 
+#include <dirent.h>
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -14,6 +15,7 @@
 #include <algorithm>
 #include <cstring>
 #include <cerrno>
+#include <cstdio>
 
 namespace tomato {
 
@@ -37,8 +39,14 @@ uint64_t getFileSize(const std::string& filename) {
 
 class PosixAppendOnlyFile final : public AppendOnlyFile {
 public:
-    explicit PosixAppendOnlyFile(std::string filename)
-        : buffer_pos_(0), filename_(std::move(filename)), dirname_(findDirName(filename)) {
+    explicit PosixAppendOnlyFile(std::string filename, const AppendOnlyFileOptions& options = AppendOnlyFileOptions())
+        : buffer_pos_(0), 
+          filename_(std::move(filename)), 
+          dirname_(findDirName(filename_)),
+          options_(options),
+          file_size_(0),
+          range_synced_size_(0),
+          preallocated_size_(0) {
         fd_ = ::open(filename_.c_str(), O_TRUNC | O_WRONLY | O_CREAT | 0, 0644);
     }
 
@@ -91,15 +99,22 @@ public:
         if (!status.isSuccess()) {
             return status;
         }
-        // page-cache写回
-        if (::fsync(fd_) < 0) {
+        // page-cache写回, fdatasync不会等待mtime等无关元数据落盘
+        int res = options_.use_fdatasync ? ::fdatasync(fd_) : ::fsync(fd_);
+        if (res < 0) {
             return {errno, "fsync error, filename: " + filename_};
         }
+        range_synced_size_ = file_size_;
         return OperatorResult::success();
     }
 
     OperatorResult close() override {
         OperatorResult status = flush();
+        // 归还预分配但没有用到的磁盘空间
+        if (preallocated_size_ > file_size_ && 
+                ::ftruncate(fd_, static_cast<::off_t>(file_size_)) < 0 && status.isSuccess()) {
+            status = {errno, "ftruncate error, filename: " + filename_};
+        }
         if (::close(fd_) < 0) {
             status = {errno, "close file error, filename: " + filename_};
         }
@@ -127,6 +142,13 @@ private:
      * @return OperatorResult 操作信息
      */
     OperatorResult systemWrite(const char* data_ptr, size_t unwritten_size) {
+        if (unwritten_size == 0) {
+            return OperatorResult::success();
+        }
+        OperatorResult status = preallocate(unwritten_size);
+        if (!status.isSuccess()) {
+            return status;
+        }
         while (unwritten_size > 0) {
             ::ssize_t written_size = ::write(fd_, data_ptr, unwritten_size);
             if (written_size < 0) {
@@ -138,7 +160,61 @@ private:
             } 
             unwritten_size -= static_cast<size_t>(written_size);
             data_ptr += written_size;
+            file_size_ += static_cast<uint64_t>(written_size);
+        }
+        return rangeSync();
+    }
+
+    /**
+     * @brief 写入前保证磁盘上有足够的预分配空间, 每次按preallocate_size的整数倍扩展
+     * 
+     * @param size 即将写入的字节数
+     * @return OperatorResult 
+     */
+    OperatorResult preallocate(size_t size) {
+        if (options_.preallocate_size == 0 || file_size_ + size <= preallocated_size_) {
+            return OperatorResult::success();
         }
+#if defined(__linux__)
+        const uint64_t step = options_.preallocate_size;
+        uint64_t target = (file_size_ + size + step - 1) / step * step;
+        // KEEP_SIZE: 只分配磁盘块, 不改变文件长度
+        if (::fallocate(fd_, FALLOC_FL_KEEP_SIZE, static_cast<::off_t>(preallocated_size_),
+                        static_cast<::off_t>(target - preallocated_size_)) < 0) {
+            // 文件系统不支持时关闭预分配, 不影响正常写入
+            if (errno == EOPNOTSUPP || errno == ENOSYS) {
+                options_.preallocate_size = 0;
+                return OperatorResult::success();
+            }
+            return {errno, "fallocate error, filename: " + filename_};
+        }
+        preallocated_size_ = target;
+#endif
+        return OperatorResult::success();
+    }
+
+    /**
+     * @brief 未回写的数据超过bytes_per_sync时, 异步发起这段数据的回写
+     * 
+     * @return OperatorResult 
+     */
+    OperatorResult rangeSync() {
+        if (options_.bytes_per_sync == 0 || file_size_ - range_synced_size_ < options_.bytes_per_sync) {
+            return OperatorResult::success();
+        }
+#if defined(__linux__)
+        // 只发起回写不等待完成, 真正的落盘保证依旧由sync负责
+        if (::sync_file_range(fd_, static_cast<::off_t>(range_synced_size_), 
+                              static_cast<::off_t>(file_size_ - range_synced_size_),
+                              SYNC_FILE_RANGE_WRITE) < 0) {
+            if (errno == ENOSYS || errno == ESPIPE) {
+                options_.bytes_per_sync = 0;
+                return OperatorResult::success();
+            }
+            return {errno, "sync_file_range error, filename: " + filename_};
+        }
+#endif
+        range_synced_size_ = file_size_;
         return OperatorResult::success();
     }
 private:
@@ -170,13 +246,47 @@ private:
      * 
      */
     const std::string dirname_;
+
+    /**
+     * @brief 回写、预分配配置
+     * 
+     */
+    AppendOnlyFileOptions options_;
+
+    /**
+     * @brief 已经写入page cache的字节数
+     * 
+     */
+    uint64_t file_size_;
+
+    /**
+     * @brief 已经发起过回写的字节数
+     * 
+     */
+    uint64_t range_synced_size_;
+
+    /**
+     * @brief 已经预分配的磁盘空间
+     * 
+     */
+    uint64_t preallocated_size_;
 };
 
 class PosixSequentialFile final : public SequentialFile {
 public:
-    explicit PosixSequentialFile(std::string filename)
-        : filename_(std::move(filename)), dirname_(findDirName(filename)) {
+    explicit PosixSequentialFile(std::string filename, 
+                                 const SequentialFileOptions& options = SequentialFileOptions())
+        : filename_(std::move(filename)), 
+          dirname_(findDirName(filename_)),
+          buffer_capacity_(options.readahead_size),
+          buffer_(buffer_capacity_ > 0 ? new char[buffer_capacity_] : nullptr),
+          buffer_begin_(0),
+          buffer_end_(0),
+          eof_(false) {
         fd_ = ::open(filename_.c_str(), O_RDONLY | 0);
+        if (fd_ >= 0 && options.advise_sequential) {
+            ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+        }
     }
 
     ~PosixSequentialFile() override {
@@ -186,26 +296,59 @@ public:
     }
 
     OperatorResult read(size_t size, std::string& output) override {
-        size_t unreaded_size = size;
-        char buffer[BUFFER_SIZE];
-        while(unreaded_size > 0) {
-            ::ssize_t readed_size = ::read(fd_, buffer, BUFFER_SIZE);
-            if (readed_size < 0) {
-                if (errno == EINTR) {
-                    continue;
-                }
-                return {errno, "read file error, filename: " + filename_};
+        // 直接写入output的内存, 读取结束后再截掉没有读满的部分
+        const size_t origin_size = output.size();
+        output.resize(origin_size + size);
+        char* dest = &output[0] + origin_size;
+        size_t readed_size = 0;
+        OperatorResult status = OperatorResult::success();
+
+        while (readed_size < size) {
+            // 优先消费预读窗口中的数据
+            if (buffer_begin_ < buffer_end_) {
+                size_t n = std::min(size - readed_size, buffer_end_ - buffer_begin_);
+                std::memcpy(dest + readed_size, buffer_.get() + buffer_begin_, n);
+                buffer_begin_ += n;
+                readed_size += n;
+                continue;
+            }
+            if (eof_) {
+                break;
+            }
+            size_t n = 0;
+            // 大请求直接读入调用方内存，小请求先填满预读窗口
+            if (size - readed_size >= buffer_capacity_) {
+                status = systemRead(dest + readed_size, size - readed_size, n);
+                readed_size += n;
+            } else {
+                status = systemRead(buffer_.get(), buffer_capacity_, n);
+                buffer_begin_ = 0;
+                buffer_end_ = n;
+            }
+            if (!status.isSuccess()) {
+                break;
             }
-            unreaded_size -= static_cast<size_t>(readed_size);
-            output.append(buffer, static_cast<size_t>(readed_size));
         }
-        return OperatorResult::success();
+        output.resize(origin_size + readed_size);
+        return status;
+    }
+
+    bool isEof() const override {
+        return eof_ && buffer_begin_ == buffer_end_;
     }
 
     OperatorResult skip(::off_t size) override {
-        if (::lseek(fd_, size, SEEK_CUR) < 0) {
+        // 跳过的数据还在预读窗口内时不需要系统调用
+        const size_t buffered = buffer_end_ - buffer_begin_;
+        if (size >= 0 && static_cast<size_t>(size) <= buffered) {
+            buffer_begin_ += static_cast<size_t>(size);
+            return OperatorResult::success();
+        }
+        if (::lseek(fd_, size - static_cast<::off_t>(buffered), SEEK_CUR) < 0) {
             return {errno, "lseek error, filename: " + filename_};
         }
+        buffer_begin_ = buffer_end_ = 0;
+        eof_ = false;
         return OperatorResult::success();
     }
 
@@ -228,10 +371,56 @@ public:
     bool isOpen() const override {
         return fd_ >= 0;
     }
+private:
+    /**
+     * @brief 调用一次::read, 读到0字节时标记文件结束
+     * 
+     * @param dest 读入的内存
+     * @param size 最多读取的字节数
+     * @param readed_size [out] 实际读取的字节数
+     * @return OperatorResult 
+     */
+    OperatorResult systemRead(char* dest, size_t size, size_t& readed_size) {
+        readed_size = 0;
+        while (true) {
+            ::ssize_t n = ::read(fd_, dest, size);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return {errno, "read file error, filename: " + filename_};
+            }
+            if (n == 0) {
+                eof_ = true;
+            }
+            readed_size = static_cast<size_t>(n);
+            return OperatorResult::success();
+        }
+    }
 private:
     int fd_;
     std::string filename_;
     std::string dirname_;
+
+    /**
+     * @brief 预读窗口
+     * 
+     */
+    const size_t buffer_capacity_;
+    std::unique_ptr<char[]> buffer_;
+
+    /**
+     * @brief 预读窗口中未被消费的数据区间[buffer_begin_, buffer_end_)
+     * 
+     */
+    size_t buffer_begin_;
+    size_t buffer_end_;
+
+    /**
+     * @brief 是否已经读到文件末尾
+     * 
+     */
+    bool eof_;
 };
 
 class PosixRandomAccessFile final : public RandomAccessFile {
@@ -265,6 +454,10 @@ public:
         return OperatorResult::success();
     }
 
+    const char* getMappedData() const override {
+        return mmap_base_;
+    }
+
     std::string getFileName() const override {
         return filename_;
     }
@@ -300,12 +493,73 @@ std::shared_ptr<AppendOnlyFile> createAppendOnlyFile(const std::string& filename
     return std::make_shared<PosixAppendOnlyFile>(filename);
 }
 
+std::shared_ptr<AppendOnlyFile> createAppendOnlyFile(const std::string& filename, 
+                                                     const AppendOnlyFileOptions& options) {
+    return std::make_shared<PosixAppendOnlyFile>(filename, options);
+}
+
 std::shared_ptr<SequentialFile> createSequentialFile(const std::string& filename) {
     return std::make_shared<PosixSequentialFile>(filename);
 }
 
+std::shared_ptr<SequentialFile> createSequentialFile(const std::string& filename, 
+                                                     const SequentialFileOptions& options) {
+    return std::make_shared<PosixSequentialFile>(filename, options);
+}
+
 std::shared_ptr<RandomAccessFile> createRandomAccessFile(const std::string& filename) {
     return std::make_shared<PosixRandomAccessFile>(filename);
 }
 
-}
\ No newline at end of file
+OperatorResult createDir(const std::string& dirname) {
+    if (::mkdir(dirname.c_str(), 0755) < 0 && errno != EEXIST) {
+        return {errno, "mkdir error, dirname: " + dirname};
+    }
+    return OperatorResult::success();
+}
+
+OperatorResult listDir(const std::string& dirname, std::vector<std::string>& children) {
+    children.clear();
+    ::DIR* dir = ::opendir(dirname.c_str());
+    if (dir == nullptr) {
+        return {errno, "opendir error, dirname: " + dirname};
+    }
+    struct ::dirent* entry;
+    while ((entry = ::readdir(dir)) != nullptr) {
+        std::string name(entry->d_name);
+        if (name != "." && name != "..") {
+            children.push_back(std::move(name));
+        }
+    }
+    ::closedir(dir);
+    return OperatorResult::success();
+}
+
+OperatorResult removeFile(const std::string& filename) {
+    if (::unlink(filename.c_str()) < 0) {
+        return {errno, "unlink error, filename: " + filename};
+    }
+    return OperatorResult::success();
+}
+
+OperatorResult renameFile(const std::string& from, const std::string& to) {
+    if (::rename(from.c_str(), to.c_str()) < 0) {
+        return {errno, "rename error, from: " + from + ", to: " + to};
+    }
+    return OperatorResult::success();
+}
+
+OperatorResult syncDir(const std::string& dirname) {
+    int fd = ::open(dirname.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd < 0) {
+        return {errno, "open dir error, dirname: " + dirname};
+    }
+    OperatorResult status = OperatorResult::success();
+    if (::fsync(fd) < 0) {
+        status = {errno, "fsync dir error, dirname: " + dirname};
+    }
+    ::close(fd);
+    return status;
+}
+
+}
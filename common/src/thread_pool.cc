@@ -0,0 +1,50 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 17:20:36
+ * @LastEditTime: 2026-10-18 17:20:36
+ */
+#include <tomato_common/thread_pool.h>
+
+namespace tomato {
+
+ThreadPool::ThreadPool(size_t thread_count)
+    : mutex_(),
+      cond_(),
+      tasks_(),
+      stop_(false),
+      threads_() {
+    threads_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads_.emplace_back(&ThreadPool::workLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cond_.notify_all();
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+void ThreadPool::workLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cond_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+            // 退出前先把队列中剩余的任务执行完
+            if (tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+}
@@ -1,7 +1,7 @@
 /*
  * @Author: Tomato
  * @Date: 2021-12-24 20:34:10
- * @LastEditTime: 2022-11-24 09:06:57
+ * @LastEditTime: 2026-10-18 21:47:22
  */
 #include <gtest/gtest.h>
 #include <tomato_common/codec.h>
@@ -99,4 +99,16 @@ TEST(Coding, Varint64) {
 
 
 
+TEST(Coding, Varint64Bounded) {
+  std::string s = encodeVar64(~static_cast<uint64_t>(0));
+  std::pair<uint64_t, int> res = decodeVar64(s.data(), s.data() + s.size());
+  ASSERT_EQ(~static_cast<uint64_t>(0), res.first);
+  ASSERT_EQ(s.size(), res.second);
+
+  // 数据被截断时返回0
+  for (size_t i = 0; i < s.size(); ++i) {
+    ASSERT_EQ(0, decodeVar64(s.data(), s.data() + i).second);
+  }
+}
+
 }}
@@ -41,4 +41,8 @@ TEST(CRC, Values) {
     ASSERT_NE(crc32("a", 1), crc32("foo", 3));
 }
 
+TEST(CRC, Extend) {
+    ASSERT_EQ(crc32("hello world", 11), crc32(crc32("hello ", 6), "world", 5));
+}
+
 }
\ No newline at end of file
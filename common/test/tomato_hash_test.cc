@@ -0,0 +1,34 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 22:56:37
+ * @LastEditTime: 2026-10-18 22:56:37
+ */
+#include <tomato_common/hash.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace tomato {
+
+static uint32_t hashString(const std::string& data, uint32_t seed) {
+    return hashBytes(data.data(), data.size(), seed);
+}
+
+TEST(HASH, StableResults) {
+    // 哈希值保存在文件中, 修改实现会使已有的过滤器失效
+    EXPECT_EQ(0xbc9f1d34u, hashString("", 0xbc9f1d34));
+    EXPECT_EQ(0x286e9db0u, hashString("a", 0xbc9f1d34));
+    EXPECT_EQ(0x39aca330u, hashString("ab", 0xbc9f1d34));
+    EXPECT_EQ(0x855d012fu, hashString("abc", 0xbc9f1d34));
+    EXPECT_EQ(0xb9c83353u, hashString("abcd", 0xbc9f1d34));
+    EXPECT_EQ(0x2b0fda93u, hashString("hello, tomato", 0xbc9f1d34));
+    EXPECT_EQ(0x02b2be28u, hashString("hello, tomato", 0));
+}
+
+TEST(HASH, Prefix) {
+    // 只对前length个字节计算
+    const std::string data = "user-key\x01\x02\x03\x04\x05\x06\x07\x08";
+    EXPECT_EQ(hashString("user-key", 7), hashBytes(data.data(), 8, 7));
+}
+
+}
@@ -0,0 +1,130 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 22:47:45
+ * @LastEditTime: 2026-10-18 22:52:21
+ */
+#include <tomato_common/lz.h>
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace tomato {
+
+static std::string roundTrip(const std::string& input) {
+    std::string compressed;
+    lz::compress(input.data(), input.size(), compressed);
+    std::string output("garbage");
+    EXPECT_TRUE(lz::decompress(compressed.data(), compressed.size(), output));
+    return output;
+}
+
+TEST(LZ, RoundTrip) {
+    ASSERT_EQ("", roundTrip(""));
+    ASSERT_EQ("a", roundTrip("a"));
+    ASSERT_EQ("abcd", roundTrip("abcd"));
+    ASSERT_EQ("abcdabcdabcdabcdabcd", roundTrip("abcdabcdabcdabcdabcd"));
+    ASSERT_EQ(std::string(100000, 'x'), roundTrip(std::string(100000, 'x')));
+
+    std::mt19937 rng(301);
+    std::string random(70000, '\0');
+    for (char& c : random) {
+        c = static_cast<char>(rng());
+    }
+    ASSERT_EQ(random, roundTrip(random));
+
+    // 超过64KB的重复距离只能部分匹配
+    std::string far = random + random.substr(0, 1000) + random;
+    ASSERT_EQ(far, roundTrip(far));
+}
+
+TEST(LZ, Compressible) {
+    std::string input;
+    for (int i = 0; i < 2000; ++i) {
+        input.append("user" + std::to_string(i % 97) + "|value-of-some-record|");
+    }
+    std::string compressed;
+    lz::compress(input.data(), input.size(), compressed);
+    ASSERT_LT(compressed.size() * 3, input.size());
+
+    // 追加到已有内容之后
+    std::string appended("prefix");
+    lz::compress(input.data(), input.size(), appended);
+    ASSERT_EQ("prefix" + compressed, appended);
+}
+
+TEST(LZ, Corrupted) {
+    std::string input;
+    for (int i = 0; i < 500; ++i) {
+        input.append("key" + std::to_string(i % 13));
+    }
+    std::string compressed;
+    lz::compress(input.data(), input.size(), compressed);
+    std::string output;
+    for (size_t size = 0; size < compressed.size(); ++size) {
+        ASSERT_FALSE(lz::decompress(compressed.data(), size, output));
+    }
+
+    // 原始长度被篡改
+    std::string bad = compressed;
+    bad[0] = static_cast<char>(bad[0] + 1);
+    ASSERT_FALSE(lz::decompress(bad.data(), bad.size(), output));
+
+    // 随机改写不会越界, 结果要么失败要么长度正确
+    std::mt19937 rng(17);
+    for (int i = 0; i < 1000; ++i) {
+        bad = compressed;
+        bad[rng() % bad.size()] = static_cast<char>(rng());
+        if (lz::decompress(bad.data(), bad.size(), output)) {
+            ASSERT_EQ(input.size(), output.size());
+        }
+    }
+}
+
+TEST(LZ, Dictionary) {
+    // 小块单独压缩时几乎没有重复内容, 重复的部分都在块之间
+    std::vector<std::string> samples;
+    for (int i = 0; i < 200; ++i) {
+        samples.push_back("{\"id\": " + std::to_string(i) + ", \"name\": \"user-" + std::to_string(i * 7) + 
+                          "\", \"email_verified\": true, \"created_at\": \"2026-10-18\"}");
+    }
+    const std::string dict = lz::trainDictionary(samples, 1024);
+    ASSERT_FALSE(dict.empty());
+    ASSERT_LE(dict.size(), 1024u);
+
+    size_t plain_size = 0;
+    size_t dict_size = 0;
+    for (const std::string& sample : samples) {
+        std::string plain;
+        lz::compress(sample.data(), sample.size(), plain);
+        std::string compressed;
+        lz::compressWithDict(dict.data(), dict.size(), sample.data(), sample.size(), compressed);
+        plain_size += plain.size();
+        dict_size += compressed.size();
+
+        std::string output;
+        ASSERT_TRUE(lz::decompressWithDict(dict.data(), dict.size(), compressed.data(), compressed.size(), output));
+        ASSERT_EQ(sample, output);
+    }
+    ASSERT_LT(dict_size * 2, plain_size);
+
+    // 没有重复内容时字典为空, 空字典与不使用字典相同
+    ASSERT_TRUE(lz::trainDictionary({"abcdefghijklmnop", "qrstuvwxyz012345"}, 1024).empty());
+    std::string plain;
+    lz::compress(samples[0].data(), samples[0].size(), plain);
+    std::string compressed;
+    lz::compressWithDict("", 0, samples[0].data(), samples[0].size(), compressed);
+    ASSERT_EQ(plain, compressed);
+
+    // 匹配跨越字典与输入的边界, 以及引用超过64KB的字典
+    std::string large_dict(100000, 'd');
+    large_dict.append("boundary");
+    const std::string input = "boundary" + std::string(100, 'd') + "tail";
+    compressed.clear();
+    lz::compressWithDict(large_dict.data(), large_dict.size(), input.data(), input.size(), compressed);
+    std::string output;
+    ASSERT_TRUE(lz::decompressWithDict(large_dict.data(), large_dict.size(), compressed.data(), compressed.size(), 
+                                       output));
+    ASSERT_EQ(input, output);
+}
+
+}
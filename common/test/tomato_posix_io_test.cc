@@ -1,7 +1,7 @@
 /*
  * @Author: Tomato
  * @Date: 2022-01-15 22:59:21
- * @LastEditTime: 2023-02-01 22:13:01
+ * @LastEditTime: 2026-10-18 00:14:23
  */
 #include <gtest/gtest.h>
 #include <tomato_common/io.h>
@@ -11,6 +11,8 @@ namespace tomato {
 
 const std::string FILENAME_1 = "test-1";
 const std::string FILENAME_2 = "test-2";
+const std::string FILENAME_3 = "test-3";
+const std::string FILENAME_4 = "test-4";
 
 std::string writeTestFile(std::shared_ptr<AppendOnlyFile> writer, const std::string& filename) {
     std::string content = "";
@@ -89,4 +91,69 @@ TEST(POSIX_IO, skip_read_test) {
     EXPECT_EQ(result, test_content.substr(skip_size, remain_size));
 }
 
-}
\ No newline at end of file
+TEST(POSIX_IO, range_sync_and_preallocate) {
+    AppendOnlyFileOptions options;
+    options.bytes_per_sync = 1 << 20;
+    options.preallocate_size = 4 << 20;
+    std::shared_ptr<AppendOnlyFile> writer = createAppendOnlyFile(FILENAME_3, options);
+    EXPECT_TRUE(writer->isOpen());
+    std::string content = writeTestFile(writer, FILENAME_3);
+    OperatorResult status = writer->close();
+    EXPECT_TRUE(status.isSuccess());
+
+    // 预分配的空间在关闭时被回收, 文件长度与写入长度一致
+    std::shared_ptr<RandomAccessFile> random_access_reader = createRandomAccessFile(FILENAME_3);
+    EXPECT_TRUE(random_access_reader->isOpen());
+    std::string output;
+    EXPECT_TRUE(random_access_reader->read(0, content.size(), output).isSuccess());
+    EXPECT_EQ(output, content);
+    EXPECT_FALSE(random_access_reader->read(content.size(), 1, output).isSuccess());
+}
+
+TEST(POSIX_IO, sync_dir) {
+    EXPECT_TRUE(syncDir(".").isSuccess());
+    EXPECT_FALSE(syncDir("not-exist-dir").isSuccess());
+}
+
+TEST(POSIX_IO, sequential_read_to_eof) {
+    std::shared_ptr<AppendOnlyFile> writer = createAppendOnlyFile(FILENAME_4);
+    std::string content = writeTestFile(writer, FILENAME_4);
+
+    // 小窗口预读, 随机长度的读取与跳过交替进行
+    SequentialFileOptions options;
+    options.readahead_size = 4096;
+    std::shared_ptr<SequentialFile> reader = createSequentialFile(FILENAME_4, options);
+    EXPECT_TRUE(reader->isOpen());
+    std::random_device seed;
+    std::minstd_rand generator(seed());
+    std::uniform_int_distribution<size_t> distribution(0, 10000);
+    size_t offset = 0;
+    while (offset < content.size()) {
+        size_t size = distribution(generator);
+        if (size % 7 == 0) {
+            EXPECT_TRUE(reader->skip(static_cast<::off_t>(size)).isSuccess());
+            offset += size;
+            continue;
+        }
+        std::string output("prefix");
+        EXPECT_TRUE(reader->read(size, output).isSuccess());
+        size_t expect_size = offset < content.size() ? std::min(size, content.size() - offset) : 0;
+        ASSERT_EQ(output.substr(6), content.substr(offset, expect_size));
+        offset += size;
+    }
+
+    // 读到文件末尾后返回空数据
+    std::string output;
+    EXPECT_TRUE(reader->read(100, output).isSuccess());
+    EXPECT_TRUE(output.empty());
+    EXPECT_TRUE(reader->isEof());
+
+    // 超过文件长度的读取只返回剩余的数据
+    reader = createSequentialFile(FILENAME_4);
+    output.clear();
+    EXPECT_TRUE(reader->read(content.size() + 100, output).isSuccess());
+    EXPECT_EQ(output, content);
+    EXPECT_TRUE(reader->isEof());
+}
+
+}
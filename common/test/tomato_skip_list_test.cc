@@ -1,7 +1,7 @@
 /*
  * @Author: Tomato
  * @Date: 2021-12-19 11:28:21
- * @LastEditTime: 2023-02-01 22:13:10
+ * @LastEditTime: 2026-10-18 22:03:41
  */
 #include <gtest/gtest.h>
 #include <tomato_common/allocator.h>
@@ -9,6 +9,7 @@
 #include <atomic>
 #include <vector>
 #include <set>
+#include <thread>
 
 namespace tomato {
 
@@ -127,6 +128,57 @@ TEST(SKIP_LIST_TEST, iterator) {
     Key target = values.size()/2;
     it.seek(target);
     EXPECT_TRUE(cmp(target,it.key()) == 0);
+    it.prev();
+    ASSERT_TRUE(it.valid());
+    EXPECT_EQ(it.key(), target - 1);
+
+    index = static_cast<int>(values.size());
+    for (it.seekToLast(); it.valid(); it.prev()) {
+        EXPECT_EQ(values[--index], it.key());
+    }
+    EXPECT_EQ(index, 0);
+}
+
+TEST(SKIP_LIST_TEST, concurrent_insert) {
+    Allocator allocator;
+    Comparator cmp;
+    SkipList<Key, Comparator> list(&allocator, cmp);
+
+    // 一半线程逐个插入交错的值，一半线程批量插入有序的值
+    const int thread_count = 8;
+    const Key per_thread = 5000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&list, t] {
+            if (t % 2 == 0) {
+                for (Key i = 0; i < per_thread; ++i) {
+                    list.insertConcurrently(i * thread_count + static_cast<Key>(t));
+                }
+            } else {
+                std::vector<Key> values;
+                for (Key i = 0; i < per_thread; ++i) {
+                    values.push_back(i * thread_count + static_cast<Key>(t));
+                }
+                list.insertSortedConcurrently(values);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    Key expect = 0;
+    auto it = SkipList<Key, Comparator>::Iterator(&list);
+    for (it.seekToFirst(); it.valid(); it.next()) {
+        ASSERT_EQ(expect++, it.key());
+    }
+    EXPECT_EQ(expect, per_thread * thread_count);
+    for (int i = 1; i < list.getCurrentMaxLevel(); ++i) {
+        std::vector<Key> levelElements = list.getLevel(i);
+        for (size_t j = 1; j < levelElements.size(); ++j) {
+            ASSERT_LT(levelElements[j-1], levelElements[j]);
+        }
+    }
 }
 
 } // namespace tomato
\ No newline at end of file
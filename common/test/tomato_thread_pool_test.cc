@@ -0,0 +1,36 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 17:20:36
+ * @LastEditTime: 2026-10-18 17:20:36
+ */
+#include <tomato_common/thread_pool.h>
+#include <gtest/gtest.h>
+
+#include <atomic>
+
+namespace tomato {
+
+TEST(THREAD_POOL, submit) {
+    ThreadPool pool(4);
+    std::atomic<int> counter(0);
+    std::vector<std::future<int>> results;
+    for (int i = 0; i < 100; ++i) {
+        results.push_back(pool.submit([i, &counter]() { 
+            ++counter;
+            return i * i; 
+        }));
+    }
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(results[static_cast<size_t>(i)].get(), i * i);
+    }
+    EXPECT_EQ(counter.load(), 100);
+}
+
+TEST(THREAD_POOL, inline) {
+    ThreadPool pool(0);
+    EXPECT_EQ(pool.getThreadCount(), 0u);
+    std::future<int> result = pool.submit([]() { return 7; });
+    EXPECT_EQ(result.get(), 7);
+}
+
+}
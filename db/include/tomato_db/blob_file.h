@@ -0,0 +1,191 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 22:41:13
+ * @LastEditTime: 2026-10-18 22:41:13
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_BLOB_FILE_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_BLOB_FILE_H
+
+#include <tomato_db/version.h>
+#include <tomato_common/io.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tomato {
+
+/**
+ * @brief blob文件格式: [记录 1]...[记录 n], 只追加写入, 写完后不再修改;
+ *        记录为[用户键长度(变长)][值长度(变长)][用户键][值][值的crc32(定长32位)]
+ *        大值只写一次blob文件, SSTable中保存它的位置(BLOB_INDEX), 合并时只移动位置不重写值
+ * 
+ */
+
+/**
+ * @brief 键值分离的配置
+ * 
+ */
+struct BlobFileOptions {
+    /**
+     * @brief 不小于这个大小的值在刷写与合并时写入blob文件, 0表示不分离
+     * 
+     */
+    uint64_t min_blob_size = 0;
+
+    /**
+     * @brief 单个blob文件的目标大小
+     * 
+     */
+    uint64_t blob_file_size = 64 << 20;
+
+    /**
+     * @brief 垃圾字节数占比达到这个值的blob文件, 合并时把其中经过的有效值搬到新的位置,
+     *        文件中的值全部成为垃圾后删除文件; 0表示不搬移
+     * 
+     */
+    double garbage_ratio = 0.5;
+};
+
+/**
+ * @brief 值在blob文件中的位置
+ * 
+ */
+struct BlobIndex {
+    uint64_t file_number = 0;
+
+    /**
+     * @brief 值的起始偏移量
+     * 
+     */
+    uint64_t offset = 0;
+
+    /**
+     * @brief 值的字节数
+     * 
+     */
+    uint64_t size = 0;
+
+    /**
+     * @brief 编码: 文件编号(变长) + 偏移量(变长) + 字节数(变长)
+     * 
+     * @param output [out] 追加到output末尾
+     */
+    void encodeTo(std::string& output) const;
+
+    /**
+     * @brief 从字符串中解码
+     * 
+     * @return true 解码成功; false 格式错误
+     */
+    bool decodeFrom(const std::string& input);
+};
+
+/**
+ * @brief 把大值写入blob文件, 第一个值写入时才创建文件, 超过目标大小后换一个新文件
+ * 
+ */
+class BlobFileBuilder {
+public:
+    /**
+     * @brief 构造
+     * 
+     * @param db_path 数据库目录
+     * @param versions 分配blob文件编号
+     * @param options 键值分离的配置
+     */
+    BlobFileBuilder(std::string db_path, VersionSet* versions, const BlobFileOptions& options);
+    BlobFileBuilder(const BlobFileBuilder&) = delete;
+    BlobFileBuilder& operator=(const BlobFileBuilder&) = delete;
+
+    /**
+     * @brief 值是否需要写入blob文件
+     * 
+     */
+    bool shouldSeparate(const std::string& value) const {
+        return options_.min_blob_size > 0 && value.size() >= options_.min_blob_size;
+    }
+
+    /**
+     * @brief 写入一个值
+     * 
+     * @param user_key 用户键, 和值一起写入, 便于离线检查blob文件
+     * @param value 值
+     * @param blob_index [out] 编码后的位置
+     * @return OperatorResult 
+     */
+    OperatorResult add(const std::string& user_key, const std::string& value, std::string& blob_index);
+
+    /**
+     * @brief 落盘并关闭当前文件, 之后getOutputs给出所有写出的文件
+     * 
+     * @return OperatorResult 
+     */
+    OperatorResult finish();
+
+    /**
+     * @brief 删除所有写出的文件, 用于刷写或合并失败时
+     * 
+     */
+    void abandon();
+
+    const std::vector<BlobFileMeta>& getOutputs() const {
+        return outputs_;
+    }
+private:
+    /**
+     * @brief 落盘并关闭当前文件
+     * 
+     */
+    OperatorResult finishFile();
+private:
+    const std::string db_path_;
+    VersionSet* versions_;
+    const BlobFileOptions options_;
+
+    /**
+     * @brief 当前写入的文件与已经写出的字节数
+     * 
+     */
+    std::shared_ptr<AppendOnlyFile> file_;
+    uint64_t file_size_;
+    std::vector<BlobFileMeta> outputs_;
+};
+
+/**
+ * @brief 缓存已经打开的blob文件, 按BLOB_INDEX读取值
+ * 
+ */
+class BlobFileCache {
+public:
+    explicit BlobFileCache(std::string db_path);
+    BlobFileCache(const BlobFileCache&) = delete;
+    BlobFileCache& operator=(const BlobFileCache&) = delete;
+
+    /**
+     * @brief 读取值并校验crc
+     * 
+     * @param blob_index 编码后的位置
+     * @param value [out] 值
+     * @return OperatorResult 
+     */
+    OperatorResult getBlob(const std::string& blob_index, std::string& value);
+
+    /**
+     * @brief 文件被删除时移出缓存
+     * 
+     * @param number 文件编号
+     */
+    void evict(uint64_t number);
+private:
+    const std::string db_path_;
+    std::mutex mutex_;
+    std::unordered_map<uint64_t, std::shared_ptr<RandomAccessFile>> files_;
+};
+
+}
+
+#endif
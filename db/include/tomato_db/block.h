@@ -0,0 +1,246 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 17:38:45
+ * @LastEditTime: 2026-10-18 23:25:42
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_BLOCK_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_BLOCK_H
+
+#include <tomato_db/table_meta.h>
+
+#include <cstdint>
+#include <string>
+
+namespace tomato {
+
+/**
+ * @brief 只读的block, 格式见BlockBuilder
+ * 
+ */
+class Block {
+public:
+    /**
+     * @brief 遍历block中的键值对
+     * 
+     */
+    class Iterator {
+    public:
+        Iterator(const Block* block, KeyComparator comparator);
+
+        bool valid() const {
+            return current_ < restarts_offset_;
+        }
+
+        /**
+         * @brief 解析过程中是否遇到格式错误
+         * 
+         */
+        bool isCorrupted() const {
+            return corrupted_;
+        }
+
+        void seekToFirst();
+        void seekToLast();
+
+        /**
+         * @brief 定位到第一个不小于target的键
+         * 
+         * @param target 目标键
+         */
+        void seek(const std::string& target);
+
+        /**
+         * @brief 已知结果大致位置时的seek: 只在[left, right]组内二分查找;
+         *        第left组的首键不小于target或第right + 1组的首键小于target时退回完整的seek
+         * 
+         * @param target 目标键
+         * @param left 第一个候选组
+         * @param right 最后一个候选组
+         */
+        void seekWithHint(const std::string& target, uint32_t left, uint32_t right);
+
+        /**
+         * @brief 点查时的seek, 键必须是内部键: 有哈希索引时直接跳到用户键所在的组,
+         *        没有哈希索引或发生冲突时与seek相同
+         * 
+         * @param target 查找键
+         * @return true 迭代器已经定位: block中有这个用户键时与seek的结果相同, 否则可能停在其他用户键上;
+         *         false block中一定没有这个用户键, 迭代器无效
+         */
+        bool seekForGet(const std::string& target);
+
+        void next();
+
+        /**
+         * @brief 向前移动: 从当前键之前的组起点重新向后解析
+         * 
+         */
+        void prev();
+
+        const std::string& key() const {
+            return key_;
+        }
+
+        const std::string& value() const {
+            return value_;
+        }
+    private:
+        /**
+         * @brief 跳到第index组的起点, 下一次parseNextEntry解析该组的第一个键
+         * 
+         */
+        void seekToRestartPoint(uint32_t index);
+
+        /**
+         * @brief 在[left, right]组内二分查找最后一个首键小于target的组, 再向后线性查找
+         * 
+         */
+        void seekInGroups(const std::string& target, uint32_t left, uint32_t right);
+
+        /**
+         * @brief 解析next_处的键值对
+         * 
+         * @return true 解析成功; false 已到末尾或格式错误
+         */
+        bool parseNextEntry();
+
+        /**
+         * @brief 第index组的起始偏移量
+         * 
+         */
+        uint32_t getRestartPoint(uint32_t index) const;
+
+        /**
+         * @brief 遇到格式错误, 迭代器置为无效
+         * 
+         */
+        void corruptionError();
+    private:
+        const char* data_;
+        KeyComparator comparator_;
+        uint32_t restarts_offset_;
+        uint32_t num_restarts_;
+
+        /**
+         * @brief 哈希索引的桶, 没有哈希索引时桶数为0
+         * 
+         */
+        const unsigned char* buckets_;
+        uint32_t num_buckets_;
+
+        /**
+         * @brief 标签是否按变长编码保存
+         * 
+         */
+        bool varint_tag_;
+
+        /**
+         * @brief 当前键值对的偏移量, 等于restarts_offset_时迭代器无效
+         * 
+         */
+        uint32_t current_;
+
+        /**
+         * @brief 下一个键值对的偏移量
+         * 
+         */
+        uint32_t next_;
+        std::string key_;
+        std::string value_;
+        bool corrupted_;
+    };
+public:
+    /**
+     * @brief 构造block
+     * 
+     * @param contents BlockBuilder::finish的结果
+     */
+    explicit Block(std::string contents);
+
+    /**
+     * @brief 构造不持有内容的block, 直接引用调用者的内存(如文件映射)
+     * 
+     * @param data BlockBuilder::finish的结果, 调用者保证在block及其迭代器的生命周期内有效
+     * @param size 字节数
+     */
+    Block(const char* data, size_t size);
+
+    /**
+     * @brief 组数中的这一位表示block末尾带有哈希索引, 见BlockBuilder
+     * 
+     */
+    static const uint32_t HASH_INDEX_FLAG = 1u << 31;
+
+    /**
+     * @brief 组数中的这一位表示内部键的标签按变长编码保存, 见BlockBuilder
+     * 
+     */
+    static const uint32_t VARINT_TAG_FLAG = 1u << 30;
+
+    /**
+     * @brief 哈希索引桶的特殊值: 没有键, 以及多个组的键落在同一个桶中;
+     *        其余的值为组的下标, 因此组数不超过MAX_HASH_INDEX_RESTARTS时才生成哈希索引
+     * 
+     */
+    static const unsigned char HASH_BUCKET_EMPTY = 255;
+    static const unsigned char HASH_BUCKET_COLLISION = 254;
+    static const uint32_t MAX_HASH_INDEX_RESTARTS = 254;
+
+    /**
+     * @brief 哈希索引使用的哈希, 对内部键中的用户键计算
+     * 
+     */
+    static uint32_t hashUserKey(const char* key, size_t size);
+    Block(const Block&) = delete;
+    Block& operator=(const Block&) = delete;
+
+    /**
+     * @brief 尾部的组偏移量是否完整
+     * 
+     */
+    bool isValid() const {
+        return restarts_offset_ != INVALID_OFFSET;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    /**
+     * @brief block的原始内容, 用于不是键值对格式的block(如过滤器分区); 不持有内容的block返回空串
+     * 
+     */
+    const std::string& getContents() const {
+        return contents_;
+    }
+private:
+    /**
+     * @brief 解析尾部的组偏移量与哈希索引
+     * 
+     */
+    void parse();
+private:
+    static const uint32_t INVALID_OFFSET = UINT32_MAX;
+    const std::string contents_;
+
+    /**
+     * @brief 内容的起始地址与字节数, 持有内容时指向contents_
+     * 
+     */
+    const char* data_;
+    size_t size_;
+    uint32_t restarts_offset_;
+    uint32_t num_restarts_;
+
+    /**
+     * @brief 哈希索引的起始偏移量与桶数, 没有哈希索引时桶数为0
+     * 
+     */
+    uint32_t buckets_offset_;
+    uint32_t num_buckets_;
+    bool varint_tag_;
+};
+
+}
+
+#endif
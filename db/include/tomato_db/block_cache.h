@@ -0,0 +1,132 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 22:47:45
+ * @LastEditTime: 2026-10-18 23:48:43
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_BLOCK_CACHE_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_BLOCK_CACHE_H
+
+#include <tomato_db/block.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace tomato {
+
+/**
+ * @brief 缓存解压后的data block, 按LRU淘汰, 容量按block的字节数计算;
+ *        分成多个分片, 每个分片有自己的锁, 并行查找时互不阻塞
+ * 
+ */
+class BlockCache {
+public:
+    /**
+     * @brief 构造
+     * 
+     * @param capacity 所有分片的总容量(字节)
+     */
+    explicit BlockCache(size_t capacity);
+    BlockCache(const BlockCache&) = delete;
+    BlockCache& operator=(const BlockCache&) = delete;
+
+    /**
+     * @brief 为一个SSTable分配缓存中的编号, 与block的偏移量一起作为缓存的键
+     * 
+     */
+    uint64_t newId() {
+        return next_id_.fetch_add(1);
+    }
+
+    /**
+     * @brief 查找block, 找到时移动到最近使用的位置
+     * 
+     * @return std::shared_ptr<Block> 没有时为空
+     */
+    std::shared_ptr<Block> lookup(uint64_t id, uint64_t offset);
+
+    /**
+     * @brief 插入block, 超出容量时淘汰最久未使用的block; 被淘汰的block仍可被持有者继续使用
+     * 
+     */
+    void insert(uint64_t id, uint64_t offset, std::shared_ptr<Block> block);
+
+    /**
+     * @brief 缓存的总字节数
+     * 
+     */
+    size_t getUsage();
+
+    /**
+     * @brief 从容量中预留内存给缓存之外的使用者(如内存表), 超出剩余容量的block立即淘汰
+     * 
+     * @param bytes 字节数
+     */
+    void reserve(size_t bytes);
+
+    /**
+     * @brief 归还预留的内存
+     * 
+     * @param bytes 字节数, 不超过已经预留的字节数
+     */
+    void release(size_t bytes);
+
+    /**
+     * @brief 已经预留的字节数
+     * 
+     */
+    size_t getReservedUsage() const {
+        return reserved_.load(std::memory_order_relaxed);
+    }
+private:
+    typedef std::pair<uint64_t, uint64_t> CacheKey;
+
+    struct CacheKeyHash {
+        size_t operator()(const CacheKey& key) const {
+            return std::hash<uint64_t>()(key.first * 0x9e3779b97f4a7c15ull ^ key.second);
+        }
+    };
+
+    struct Shard {
+        std::mutex mutex;
+        size_t usage = 0;
+
+        /**
+         * @brief 表头为最近使用的block
+         * 
+         */
+        std::list<std::pair<CacheKey, std::shared_ptr<Block>>> lru;
+        std::unordered_map<CacheKey, std::list<std::pair<CacheKey, std::shared_ptr<Block>>>::iterator, 
+                           CacheKeyHash> table;
+    };
+
+    Shard& getShard(const CacheKey& key) {
+        return shards_[CacheKeyHash()(key) % NUM_SHARDS];
+    }
+
+    /**
+     * @brief 淘汰最久未使用的block, 直到分片不超过扣除预留后的容量, 需持有分片的锁
+     * 
+     */
+    void evict(Shard& shard);
+private:
+    static const size_t NUM_SHARDS = 16;
+    const size_t shard_capacity_;
+    std::atomic<uint64_t> next_id_;
+
+    /**
+     * @brief 预留的总字节数, 平均分摊到每个分片
+     * 
+     */
+    std::atomic<size_t> reserved_;
+    Shard shards_[NUM_SHARDS];
+};
+
+}
+
+#endif
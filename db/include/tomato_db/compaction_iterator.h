@@ -0,0 +1,117 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 23:12:48
+ * @LastEditTime: 2026-10-18 23:25:42
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_COMPACTION_ITERATOR_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_COMPACTION_ITERATOR_H
+
+#include <tomato_db/blob_file.h>
+#include <tomato_db/iterator.h>
+#include <tomato_db/merge_operator.h>
+#include <tomato_db/range_del.h>
+#include <tomato_db/table_meta.h>
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tomato {
+
+/**
+ * @brief 刷写与合并共用的输出迭代器: 按内部键顺序读取输入, 丢弃对所有快照都不可见的版本,
+ *        并把所有快照都能看到的合并操作数与更旧的版本合并成一个值;
+ *        更深的层没有这个键时, 所有快照都能看到的值的序列号改写为0
+ * 
+ */
+class CompactionIterator {
+public:
+    /**
+     * @brief 构造
+     * 
+     * @param input 输入, 生命周期需长于本迭代器
+     * @param smallest_snapshot 最老的快照序列号
+     * @param range_del 所有快照都能看到的范围删除标记, 可以为空
+     * @param merge_operator 合并算子, 为空时合并操作数原样保留
+     * @param is_base_level 更深的层中是否没有这个用户键
+     * @param blob_cache 合并操作数的旧值在blob文件中时从这里读取, 可以为空
+     */
+    CompactionIterator(InternalIterator* input, uint64_t smallest_snapshot, const RangeDelAggregator* range_del,
+                       const MergeOperator* merge_operator, std::function<bool(const std::string&)> is_base_level,
+                       BlobFileCache* blob_cache = nullptr);
+    CompactionIterator(const CompactionIterator&) = delete;
+    CompactionIterator& operator=(const CompactionIterator&) = delete;
+
+    void seekToFirst();
+    void next();
+
+    bool valid() const {
+        return pos_ < outputs_.size();
+    }
+
+    /**
+     * @brief 当前输出的内部键
+     * 
+     */
+    const std::string& key() const {
+        return outputs_[pos_].first;
+    }
+
+    const std::string& value() const {
+        return outputs_[pos_].second;
+    }
+
+    /**
+     * @brief 输入或合并算子的第一个错误
+     * 
+     */
+    OperatorResult getStatus() const;
+private:
+    /**
+     * @brief 读取输入直到产生至少一个输出或输入结束
+     * 
+     */
+    void fill();
+
+    /**
+     * @brief 从当前的合并操作数开始读完这个用户键的所有版本, 输出合并后的结果
+     * 
+     * @param first 当前合并操作数的内部键
+     */
+    void mergeOperands(const ParsedInternalKey& first);
+
+    /**
+     * @brief 输出的版本是否可以把序列号改写为0: 它是所有快照看到的唯一版本, 更深的层没有这个键,
+     *        且没有更旧的范围删除标记覆盖它(改写后会被这些标记遮住)
+     * 
+     */
+    bool canZeroSequence(const ParsedInternalKey& key) const;
+private:
+    InternalIterator* input_;
+    const uint64_t smallest_snapshot_;
+    const RangeDelAggregator* range_del_;
+    const MergeOperator* merge_operator_;
+    std::function<bool(const std::string&)> is_base_level_;
+    BlobFileCache* blob_cache_;
+
+    /**
+     * @brief 当前用户键与它上一个版本的序列号, 还没有上一个版本时为UINT64_MAX
+     * 
+     */
+    std::string current_user_key_;
+    bool has_current_user_key_;
+    uint64_t last_sequence_for_key_;
+
+    /**
+     * @brief 待输出的内部键与值
+     * 
+     */
+    std::vector<std::pair<std::string, std::string>> outputs_;
+    size_t pos_;
+    OperatorResult status_;
+};
+
+}
+
+#endif
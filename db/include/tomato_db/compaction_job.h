@@ -0,0 +1,147 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 22:40:12
+ * @LastEditTime: 2026-10-18 22:41:13
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_COMPACTION_JOB_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_COMPACTION_JOB_H
+
+#include <tomato_db/blob_file.h>
+#include <tomato_db/merge_operator.h>
+#include <tomato_db/range_del.h>
+#include <tomato_db/sstable_builder.h>
+#include <tomato_db/table_cache.h>
+#include <tomato_db/version.h>
+#include <tomato_common/io.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tomato {
+
+/**
+ * @brief 执行一次合并: 归并输入文件, 清理对所有快照都不可见的版本与被范围删除遮住的版本, 
+ *        合并所有快照都能看到的合并操作数, 输出按target_file_size切分成多个第level+1层的文件;
+ *        大值写入blob文件, 已经在blob文件中的值只移动位置, 并向版本报告不再被引用的blob字节数
+ * 
+ */
+class CompactionJob {
+public:
+    /**
+     * @brief 构造
+     * 
+     * @param db_path 数据库目录
+     * @param config SSTable格式配置
+     * @param target_file_size 输出文件的目标大小
+     * @param table_cache 读取输入文件
+     * @param versions 分配输出文件编号, 判断键在更深的层中是否还有旧版本
+     * @param merge_operator 合并算子, 可以为空
+     * @param blob_cache 读取需要搬移或合并的blob值
+     * @param blob_options 键值分离的配置
+     */
+    CompactionJob(std::string db_path, const TableConfig& config, uint64_t target_file_size,
+                  TableCache* table_cache, VersionSet* versions, const MergeOperator* merge_operator,
+                  BlobFileCache* blob_cache, const BlobFileOptions& blob_options);
+    CompactionJob(const CompactionJob&) = delete;
+    CompactionJob& operator=(const CompactionJob&) = delete;
+
+    /**
+     * @brief 执行合并, 失败时删除已写出的输出文件
+     * 
+     * @param compaction 输入文件
+     * @param smallest_snapshot 最老的快照序列号, 不大于它的版本只需保留最新的一个
+     * @param edit [out] 删除输入文件、添加输出文件与blob文件、报告blob文件的垃圾字节数
+     * @return OperatorResult 
+     */
+    OperatorResult run(const Compaction& compaction, uint64_t smallest_snapshot, VersionEdit& edit);
+private:
+    /**
+     * @brief 第level+1层之下没有文件包含user_key
+     * 
+     */
+    bool isBaseLevelForKey(const std::string& user_key) const;
+
+    /**
+     * @brief 第level+1层之下没有文件与[begin, end]相交
+     * 
+     */
+    bool isBaseLevelForRange(const std::string& begin, const std::string& end) const;
+
+    /**
+     * @brief 大值写入blob文件, 垃圾比例达到阈值的blob文件中的值搬到新的位置
+     * 
+     * @param parsed_key 输出的内部键
+     * @param value 输出的值
+     * @param output_key [out] 改写后的内部键
+     * @param output_value [out] 改写后的值
+     * @param rewritten [out] 是否改写, 没有改写时原样输出
+     * @return OperatorResult 
+     */
+    OperatorResult rewriteValue(const ParsedInternalKey& parsed_key, const std::string& value,
+                                std::string& output_key, std::string& output_value, bool& rewritten);
+
+    /**
+     * @brief 创建新的输出文件
+     * 
+     */
+    OperatorResult openOutput();
+
+    /**
+     * @brief 写入落在[lower, upper)内的范围删除标记后结束当前输出文件
+     * 
+     * @param upper 输出文件的上界, 为空时没有上界
+     */
+    OperatorResult finishOutput(const std::string& upper);
+private:
+    const std::string db_path_;
+    const TableConfig config_;
+    const uint64_t target_file_size_;
+    TableCache* table_cache_;
+    VersionSet* versions_;
+    const MergeOperator* merge_operator_;
+    BlobFileCache* blob_cache_;
+    const BlobFileOptions blob_options_;
+
+    /**
+     * @brief 本次合并的上下文
+     * 
+     */
+    const Compaction* compaction_;
+    std::shared_ptr<const Version> version_;
+    uint64_t smallest_snapshot_;
+
+    /**
+     * @brief 需要写入输出文件的范围删除标记
+     * 
+     */
+    std::vector<RangeTombstone> tombstones_;
+
+    /**
+     * @brief 当前输出文件, 下界为空时没有下界
+     * 
+     */
+    std::shared_ptr<AppendOnlyFile> file_;
+    std::unique_ptr<SSTableBuilder> builder_;
+    FileMeta output_;
+    std::string lower_;
+
+    /**
+     * @brief 已经完成的输出文件
+     * 
+     */
+    std::vector<FileMeta> outputs_;
+
+    /**
+     * @brief 写入新的blob文件, 以及输入与输出中每个blob文件被引用的字节数, 两者之差是这次合并产生的垃圾
+     * 
+     */
+    std::unique_ptr<BlobFileBuilder> blob_builder_;
+    std::map<uint64_t, uint64_t> input_blob_bytes_;
+    std::map<uint64_t, uint64_t> output_blob_bytes_;
+};
+
+}
+
+#endif
@@ -0,0 +1,49 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 22:47:45
+ * @LastEditTime: 2026-10-18 22:52:21
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_COMPRESSION_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_COMPRESSION_H
+
+#include <tomato_db/table_meta.h>
+
+#include <cstddef>
+#include <string>
+
+namespace tomato {
+
+/**
+ * @brief 这种压缩方式在当前编译中是否可用
+ * 
+ */
+bool isCompressionSupported(CompressionType type);
+
+/**
+ * @brief 压缩一个block
+ * 
+ * @param type 压缩方式, 不可用时使用内置的LZ压缩
+ * @param raw 原始内容
+ * @param dict 压缩字典, 为空时不使用字典
+ * @param output [out] 压缩后的内容, 覆盖原有内容
+ * @return CompressionType 实际使用的压缩方式, 为NO_COMPRESSION时output无意义
+ */
+CompressionType compressBlock(CompressionType type, const std::string& raw, const std::string& dict, 
+                              std::string& output);
+
+/**
+ * @brief 解压一个block
+ * 
+ * @param type 压缩方式
+ * @param data 压缩后的内容
+ * @param size 压缩后的字节数
+ * @param dict 压缩时使用的字典, 为空时没有使用字典
+ * @param output [out] 原始内容, 覆盖原有内容
+ * @return true 成功; false 数据损坏或压缩方式不可用
+ */
+bool uncompressBlock(CompressionType type, const char* data, size_t size, const std::string& dict, 
+                     std::string& output);
+
+}
+
+#endif
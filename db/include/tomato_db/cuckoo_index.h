@@ -0,0 +1,108 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 23:14:19
+ * @LastEditTime: 2026-10-18 23:14:19
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_CUCKOO_INDEX_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_CUCKOO_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tomato {
+
+/**
+ * @brief 布谷鸟哈希索引格式: [桶 0]...[桶 n-1][桶数(定长64位)]
+ *        桶为CUCKOO_BUCKET_SLOTS个槽, 大小与缓存行相同; 槽为[偏移量 + 1(定长64位)][标签(定长32位)][保留(定长32位)],
+ *        偏移量为0表示空槽; 每个用户键放在它的两个候选桶之一中, 查找时只检查这两个桶
+ * 
+ */
+static const size_t CUCKOO_BUCKET_SLOTS = 4;
+static const size_t CUCKOO_SLOT_SIZE = 16;
+static const size_t CUCKOO_BUCKET_SIZE = CUCKOO_BUCKET_SLOTS * CUCKOO_SLOT_SIZE;
+
+/**
+ * @brief 生成布谷鸟哈希索引
+ * 
+ */
+class CuckooIndexBuilder {
+public:
+    CuckooIndexBuilder();
+    CuckooIndexBuilder(const CuckooIndexBuilder&) = delete;
+    CuckooIndexBuilder& operator=(const CuckooIndexBuilder&) = delete;
+
+    /**
+     * @brief 添加一个用户键, 每个用户键只添加一次
+     * 
+     * @param user_key 用户键
+     * @param offset 用户键的第一个版本在文件中的偏移量
+     */
+    void add(const std::string& user_key, uint64_t offset);
+
+    /**
+     * @brief 放置所有的键并结束, 之后不能再调用其他方法
+     * 
+     * @return const std::string& 索引的完整内容
+     */
+    const std::string& finish();
+private:
+    struct Item {
+        uint32_t buckets[2];
+        uint32_t tag;
+        uint64_t offset;
+    };
+
+    /**
+     * @brief 按给定的桶数放置所有的键
+     * 
+     * @param bucket_count 桶数
+     * @param slots [out] 每个槽中的键的下标, 空槽为-1
+     * @return true 成功; false 有键在踢出次数用完后仍无法放置
+     */
+    bool place(uint64_t bucket_count, std::vector<int64_t>& slots) const;
+private:
+    std::vector<Item> items_;
+    std::string result_;
+};
+
+/**
+ * @brief 读取布谷鸟哈希索引, 不复制内容
+ * 
+ */
+class CuckooIndexReader {
+public:
+    /**
+     * @brief 一次查找最多的候选偏移量个数
+     * 
+     */
+    static const size_t MAX_CANDIDATES = 2 * CUCKOO_BUCKET_SLOTS;
+
+    CuckooIndexReader();
+
+    /**
+     * @brief 解析索引, 调用者保证data在读取期间有效
+     * 
+     * @param data 索引的内容
+     * @param size 字节数
+     * @return true 成功; false 格式错误
+     */
+    bool init(const char* data, size_t size);
+
+    /**
+     * @brief 标签与用户键相同的槽中的偏移量, 调用者需要比较偏移量处的键
+     * 
+     * @param user_key 用户键
+     * @param offsets [out] 至少能容纳MAX_CANDIDATES个偏移量
+     * @return size_t 候选偏移量个数
+     */
+    size_t getCandidates(const std::string& user_key, uint64_t* offsets) const;
+private:
+    const char* data_;
+    uint64_t bucket_count_;
+};
+
+}
+
+#endif
@@ -1,38 +1,423 @@
 /*
  * @Author: Tomato
  * @Date: 2022-01-26 22:08:13
- * @LastEditTime: 2022-01-28 17:47:58
+ * @LastEditTime: 2026-10-19 00:48:18
  */
 #ifndef TOMATO_DB_DB_INCLUDE_TOMATO_DB_H
 #define TOMATO_DB_DB_INCLUDE_TOMATO_DB_H
 
+#include <tomato_db/blob_file.h>
+#include <tomato_db/block_cache.h>
+#include <tomato_db/write_batch.h>
+#include <tomato_db/merge_operator.h>
+#include <tomato_db/table_meta.h>
+#include <tomato_db/write_buffer_manager.h>
+#include <tomato_common/io.h>
+
 #include <vector>
 #include <string>
 #include <memory>
 
 namespace tomato {
 
+/**
+ * @brief 写入的限流状态
+ * 
+ */
+enum class WriteStallCondition {
+    // 不限制
+    NORMAL,
+    // 按令牌桶限速
+    DELAYED,
+    // 停止写入, 等待合并
+    STOPPED,
+};
+
+/**
+ * @brief 写入限流的统计
+ * 
+ */
+struct WriteStallStats {
+    WriteStallCondition condition = WriteStallCondition::NORMAL;
+
+    /**
+     * @brief 当前的限速(字节/秒), 只在DELAYED时有意义
+     * 
+     */
+    uint64_t delayed_write_rate = 0;
+
+    /**
+     * @brief 被限速等待的写入次数与累计等待的微秒数
+     * 
+     */
+    uint64_t delayed_writes = 0;
+    uint64_t delayed_micros = 0;
+
+    /**
+     * @brief 被停止的写入次数与累计停止的微秒数
+     * 
+     */
+    uint64_t stopped_writes = 0;
+    uint64_t stopped_micros = 0;
+};
 
 class DataBaseConfig {
+public:
+    DataBaseConfig() {
+        log_file_options.bytes_per_sync = 1 << 20;
+        log_file_options.preallocate_size = 4 << 20;
+    }
+
+    /**
+     * @brief 数据库文件所在的目录
+     * 
+     */
+    std::string db_path = "tomato_data";
+
+    /**
+     * @brief 写入返回前是否等待预写日志落盘
+     * 
+     */
+    bool sync_write = false;
+
+    /**
+     * @brief 重启时回放预写日志的解码线程数
+     * 
+     */
+    int replay_threads = 4;
+
+    /**
+     * @brief 内存表超过这个大小后写成SSTable
+     * 
+     */
+    size_t write_buffer_size = 4 << 20;
+
+    /**
+     * @brief 等待刷写的不可变内存表个数上限, 达到上限时写入等待刷写完成
+     * 
+     */
+    size_t max_immutable_memtables = 2;
+
+    /**
+     * @brief 后台刷写不可变内存表的线程数, 多个不可变内存表可以并行刷写
+     * 
+     */
+    size_t flush_threads = 2;
+
+    /**
+     * @brief 多个数据库共用的写缓冲区管理, 所有内存表的总内存超出它的预算时刷写活跃内存最多的内存表; 可以为空
+     * 
+     */
+    std::shared_ptr<WriteBufferManager> write_buffer_manager;
+
+    /**
+     * @brief 批量查找时并行读取data block的线程数, 为0时在调用线程上依次读取
+     * 
+     */
+    size_t read_threads = 4;
+
+    /**
+     * @brief 第0层的文件数达到这个值后合并到第1层
+     * 
+     */
+    int l0_compaction_trigger = 4;
+
+    /**
+     * @brief 第1层的容量上限, 之后每层是上一层的10倍
+     * 
+     */
+    uint64_t max_bytes_for_level_base = 10 << 20;
+
+    /**
+     * @brief 合并输出的单个SSTable的目标大小
+     * 
+     */
+    uint64_t target_file_size = 2 << 20;
+
+    /**
+     * @brief 第0层的文件数达到这个值后开始限制写入速度, 达到停止阈值后停止写入直到合并跟上;
+     *        停止阈值不小于l0_compaction_trigger
+     * 
+     */
+    int level0_slowdown_writes_trigger = 20;
+    int level0_stop_writes_trigger = 36;
+
+    /**
+     * @brief 估算的待合并字节数超过软上限后开始限制写入速度, 超过硬上限后停止写入, 0表示不检查
+     * 
+     */
+    uint64_t soft_pending_compaction_bytes_limit = 64ull << 30;
+    uint64_t hard_pending_compaction_bytes_limit = 256ull << 30;
+
+    /**
+     * @brief 开始限速时的写入速度(字节/秒), 越接近停止阈值速度越低;
+     *        max_immutable_memtables不小于3时, 等待刷写的内存表只差一个达到上限也会限速
+     * 
+     */
+    uint64_t delayed_write_rate = 16 << 20;
+
+    /**
+     * @brief 合并算子, 为空时不能调用merge
+     * 
+     */
+    std::shared_ptr<const MergeOperator> merge_operator;
+
+    /**
+     * @brief SSTable的格式配置
+     * 
+     */
+    TableConfig table_config;
+
+    /**
+     * @brief 键值分离: 大值写入blob文件, SSTable中只保存它的位置, 合并时不再重写大值
+     * 
+     */
+    BlobFileOptions blob_options;
+
+    /**
+     * @brief 缓存解压后的data block的总字节数, 0表示不缓存
+     * 
+     */
+    size_t block_cache_size = 8 << 20;
+
+    /**
+     * @brief 多个数据库共用的block缓存, 设置后忽略block_cache_size
+     * 
+     */
+    std::shared_ptr<BlockCache> block_cache;
+
+    /**
+     * @brief 一个写入组最多合并多少字节的数据
+     * 
+     */
+    size_t max_write_group_bytes = 1 << 20;
+
+    /**
+     * @brief 预写日志文件的回写与预分配配置
+     * 
+     */
+    AppendOnlyFileOptions log_file_options;
+};
+
+/**
+ * @brief 快照: 只能看到创建时已经写入的数据, 快照存在期间这些数据的版本不会被清理;
+ *        快照需要在数据库关闭前释放
+ * 
+ */
+class Snapshot {
+public:
+    explicit Snapshot(uint64_t sequence): sequence_(sequence) {}
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+    uint64_t getSequence() const {
+        return sequence_;
+    }
+private:
+    const uint64_t sequence_;
+};
+
+/**
+ * @brief 读操作的配置
+ * 
+ */
+struct ReadOptions {
+    /**
+     * @brief 在这个快照上读取, 为空时读取迭代器创建时的最新数据
+     * 
+     */
+    std::shared_ptr<const Snapshot> snapshot;
 
+    /**
+     * @brief 迭代器只遍历小于upper_bound的键, 为空时没有上界
+     * 
+     */
+    std::string upper_bound;
+
+    /**
+     * @brief 前缀查找模式, 需要在table_config中设置前缀提取器: seek之后只遍历与目标前缀相同的键,
+     *        跳过前缀过滤器排除这个前缀的SSTable与data block; 目标没有前缀时按全序查找, 
+     *        seekToFirst与seekToLast不受前缀限制
+     * 
+     */
+    bool prefix_seek = false;
+};
+
+/**
+ * @brief 按键遍历数据库, 每个键只给出快照中的最新值, 已删除的键被跳过;
+ *        迭代器创建后看到的数据不再变化, 遍历时只持有每个数据源的当前位置, 内存占用与数据量无关
+ * 
+ */
+class Iterator {
+public:
+    Iterator() = default;
+    Iterator(const Iterator&) = delete;
+    Iterator& operator=(const Iterator&) = delete;
+    virtual ~Iterator() = default;
+
+    virtual bool valid() const = 0;
+    virtual void seekToFirst() = 0;
+
+    /**
+     * @brief 定位到最后一个键, 设置了上界时为最后一个小于上界的键
+     * 
+     */
+    virtual void seekToLast() = 0;
+
+    /**
+     * @brief 定位到第一个不小于key的键
+     * 
+     * @param key 键
+     */
+    virtual void seek(const std::string& key) = 0;
+    virtual void next() = 0;
+    virtual void prev() = 0;
+
+    /**
+     * @brief 当前的键, 只在valid时可调用
+     * 
+     */
+    virtual const std::string& key() const = 0;
+    virtual const std::string& value() const = 0;
+
+    /**
+     * @brief 遍历过程中遇到的第一个错误, 出错后迭代器变为无效
+     * 
+     */
+    virtual OperatorResult getStatus() const = 0;
 };
 
 class DataBase {
 public:
-    DataBase();
+    DataBase() = default;
     DataBase(const DataBase&) = delete;
     DataBase& operator=(const DataBase&) = delete;
     
     virtual ~DataBase() {}
 
-    virtual void put(const std::string& key, const std::string& value) = 0;
-    virtual std::string get(const std::string& key) = 0;
-    virtual void del(std::string& key) = 0;
-    virtual std::vector<std::string> scan(const std::string& begin, const std::string& end);
+    /**
+     * @brief 写入一个键值对
+     * 
+     * @param key 键
+     * @param value 值
+     * @return OperatorResult 
+     */
+    virtual OperatorResult put(const std::string& key, const std::string& value) = 0;
+
+    /**
+     * @brief 查找一个键
+     * 
+     * @param key 键
+     * @return std::shared_ptr<std::string> 被智能指针包裹的值, 若未查找到值, 返回空的智能指针
+     */
+    virtual std::shared_ptr<std::string> get(const std::string& key) = 0;
+
+    /**
+     * @brief 批量查找: 键排序后依次查找内存表, 剩余的键按SSTable与data block分组,
+     *        每个data block只读取一次, 不同data block并行读取
+     * 
+     * @param keys 键, 可以重复
+     * @return std::vector<std::shared_ptr<std::string>> 与keys一一对应的值, 未查找到或读取出错的值为空的智能指针
+     */
+    virtual std::vector<std::shared_ptr<std::string>> multiGet(const std::vector<std::string>& keys) = 0;
+
+    /**
+     * @brief 批量查找并给出每个键的查找结果: 读取SSTable或blob文件出错的键停止查找, 值为空,
+     *        不会再从更旧的数据中读到已被覆盖或删除的值
+     * 
+     * @param keys 键, 可以重复
+     * @param statuses [out] 与keys一一对应的查找结果
+     * @return std::vector<std::shared_ptr<std::string>> 与keys一一对应的值
+     */
+    virtual std::vector<std::shared_ptr<std::string>> multiGet(const std::vector<std::string>& keys, 
+                                                               std::vector<OperatorResult>& statuses) = 0;
+
+    /**
+     * @brief 删除一个键
+     * 
+     * @param key 键
+     * @return OperatorResult 
+     */
+    virtual OperatorResult del(const std::string& key) = 0;
+
+    /**
+     * @brief 删除[begin, end)内的所有键, 只写入一个范围删除标记, 耗时与范围内的键数无关;
+     *        被遮住的数据在合并时清理, 完全被遮住的SSTable直接删除
+     * 
+     * @param begin 起始键(包含)
+     * @param end 结束键(不包含)
+     * @return OperatorResult 
+     */
+    virtual OperatorResult deleteRange(const std::string& begin, const std::string& end) = 0;
+
+    /**
+     * @brief 追加一个合并操作数, 不读取旧值; 读取时由配置的合并算子与旧值合并, 
+     *        刷写与合并时提前合并所有快照都能看到的操作数
+     * 
+     * @param key 键
+     * @param operand 合并操作数
+     * @return OperatorResult 未配置合并算子时返回错误
+     */
+    virtual OperatorResult merge(const std::string& key, const std::string& operand) = 0;
+
+    /**
+     * @brief 把与[begin, end]相交的SSTable逐层合并到最底层, 清理已删除与被覆盖的版本
+     * 
+     * @param begin 起始键(包含)
+     * @param end 结束键(包含), 为空时没有上界
+     * @return OperatorResult 
+     */
+    virtual OperatorResult compactRange(const std::string& begin, const std::string& end) = 0;
+
+    /**
+     * @brief 原子地写入一组操作: 所有操作使用一段连续的序列号, 作为一条日志记录落盘,
+     *        读操作要么看到全部操作, 要么一个都看不到
+     * 
+     * @param batch 一组操作, 写入后其序列号会被设置为第一个操作的序列号
+     * @return OperatorResult 
+     */
+    virtual OperatorResult write(WriteBatch& batch) = 0;
+
+    /**
+     * @brief 创建迭代器, 合并内存表与所有SSTable
+     * 
+     * @param options 快照与上界
+     * @return std::unique_ptr<Iterator> 
+     */
+    virtual std::unique_ptr<Iterator> newIterator(const ReadOptions& options) = 0;
+
+    /**
+     * @brief 创建当前数据的快照, 智能指针释放时快照随之释放
+     * 
+     * @return std::shared_ptr<const Snapshot> 
+     */
+    virtual std::shared_ptr<const Snapshot> getSnapshot() = 0;
+
+    /**
+     * @brief 范围查找, 会把结果全部读入内存, 大范围遍历请使用newIterator
+     * 
+     * @param begin 起始键(包含)
+     * @param end 结束键(不包含)
+     * @return std::vector<std::string> 范围内所有未删除的值, 按键升序排列
+     */
+    virtual std::vector<std::string> scan(const std::string& begin, const std::string& end) = 0;
+
+    /**
+     * @brief 写入限流的当前状态, 以及写入被限速与停止的次数和时长
+     * 
+     * @return WriteStallStats 
+     */
+    virtual WriteStallStats getWriteStallStats() const = 0;
 };
 
+/**
+ * @brief 打开数据库, 目录不存在时创建, 存在时回放预写日志恢复数据
+ * 
+ * @param config_ 数据库配置
+ * @return std::shared_ptr<DataBase> 打开失败时返回空的智能指针
+ */
 std::shared_ptr<DataBase> createDataBaseInstance(DataBaseConfig config_);
 
 
 }
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,418 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 15:42:10
+ * @LastEditTime: 2026-10-19 00:48:18
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_DB_IMPL_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_DB_IMPL_H
+
+#include <tomato_db/blob_file.h>
+#include <tomato_db/db.h>
+#include <tomato_db/log_writer.h>
+#include <tomato_db/memory_table.h>
+#include <tomato_db/range_del.h>
+#include <tomato_db/table_cache.h>
+#include <tomato_db/version.h>
+#include <tomato_db/write_controller.h>
+#include <tomato_db/write_pipeline.h>
+#include <tomato_common/thread_pool.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+
+namespace tomato {
+
+/**
+ * @brief 数据库实现
+ * 
+ */
+class DBImpl final : public DataBase {
+public:
+    explicit DBImpl(const DataBaseConfig& config);
+    ~DBImpl() override;
+
+    /**
+     * @brief 打开数据库目录, 读取清单文件并把预写日志回放为SSTable
+     * 
+     * @return OperatorResult 
+     */
+    OperatorResult open();
+
+    OperatorResult put(const std::string& key, const std::string& value) override;
+    std::shared_ptr<std::string> get(const std::string& key) override;
+    std::vector<std::shared_ptr<std::string>> multiGet(const std::vector<std::string>& keys) override;
+    std::vector<std::shared_ptr<std::string>> multiGet(const std::vector<std::string>& keys, 
+                                                       std::vector<OperatorResult>& statuses) override;
+    OperatorResult del(const std::string& key) override;
+    OperatorResult merge(const std::string& key, const std::string& operand) override;
+    OperatorResult deleteRange(const std::string& begin, const std::string& end) override;
+    OperatorResult compactRange(const std::string& begin, const std::string& end) override;
+    OperatorResult write(WriteBatch& batch) override;
+    std::vector<std::string> scan(const std::string& begin, const std::string& end) override;
+    std::unique_ptr<Iterator> newIterator(const ReadOptions& options) override;
+    std::shared_ptr<const Snapshot> getSnapshot() override;
+
+    /**
+     * @brief 已经对读可见的最大序列号
+     * 
+     */
+    uint64_t getLastSequence() const {
+        return pipeline_.getLastSequence();
+    }
+
+    /**
+     * @brief 写入流水线组成过的写入组个数
+     * 
+     */
+    uint64_t getWriteGroupCount() const {
+        return pipeline_.getGroupCount();
+    }
+
+    /**
+     * @brief 写入被限速与停止的次数和时长
+     * 
+     */
+    WriteStallStats getWriteStallStats() const override {
+        return write_controller_.getStats();
+    }
+private:
+    /**
+     * @brief 已封存、等待刷写的内存表
+     * 
+     */
+    struct ImmutableMemoryTable {
+        std::shared_ptr<MemoryTable> memtable;
+
+        /**
+         * @brief 封存时预先分配的SSTable编号, 第0层按编号排列, 编号的顺序需要与内存表的新旧一致
+         * 
+         */
+        uint64_t file_number = 0;
+
+        /**
+         * @brief 封存时新建的预写日志, 刷写后它之前的日志都不再需要
+         * 
+         */
+        uint64_t log_number = 0;
+
+        /**
+         * @brief 内存表中最大的序列号
+         * 
+         */
+        uint64_t last_sequence = 0;
+
+        /**
+         * @brief 刷写是否结束, 以及刷写的结果与要应用的修改
+         * 
+         */
+        bool flushed = false;
+        OperatorResult status = OperatorResult::success();
+        VersionEdit edit;
+    };
+
+    /**
+     * @brief 一次读取使用的数据源, 在memtable_mutex_下一起取得, 刷写前后读到的数据一致
+     * 
+     */
+    struct ReadView {
+        std::shared_ptr<MemoryTable> memtable;
+
+        /**
+         * @brief 不可变内存表, 从新到旧排列
+         * 
+         */
+        std::vector<std::shared_ptr<MemoryTable>> immutables;
+        std::shared_ptr<const Version> version;
+    };
+
+    /**
+     * @brief 取得当前的数据源
+     * 
+     */
+    ReadView getReadView();
+
+    /**
+     * @brief 回放清单文件记录的日志编号之后的预写日志, 回放出的数据都写成第0层的SSTable
+     * 
+     * @param edit [out] 回放产生的修改
+     * @return OperatorResult 
+     */
+    OperatorResult recover(VersionEdit& edit);
+
+    /**
+     * @brief 把内存表写成SSTable, 丢弃对所有快照都不可见的版本并合并合并操作数
+     * 
+     * @param memtable 内存表
+     * @param smallest_snapshot 最老的快照序列号
+     * @param edit [out] 添加写出的SSTable与blob文件, 空内存表不产生文件
+     * @param file_number SSTable的编号, 为0时分配新的编号
+     * @return OperatorResult 
+     */
+    OperatorResult writeLevel0Table(std::shared_ptr<const MemoryTable> memtable, uint64_t smallest_snapshot, 
+                                    VersionEdit& edit, uint64_t file_number = 0);
+
+    /**
+     * @brief 封存当前内存表并切换到新的内存表与预写日志, 只在写日志的leader上调用;
+     *        不可变内存表达到上限时等待刷写, 这是写入唯一会等待刷写的情况
+     * 
+     * @param first_sequence 当前写入组的第一个序列号, 之前的写入都属于被封存的内存表
+     * @return OperatorResult 
+     */
+    OperatorResult switchMemoryTable(uint64_t first_sequence);
+
+    /**
+     * @brief 后台线程把不可变内存表写成第0层的SSTable, 然后按内存表的新旧顺序应用到版本
+     * 
+     */
+    void flushImmutable(const std::shared_ptr<ImmutableMemoryTable>& immutable);
+
+    /**
+     * @brief 写缓冲区管理要求刷写时调用: 空批次经过写入流水线, 由leader封存活跃内存表
+     * 
+     */
+    void requestFlush();
+
+    /**
+     * @brief 活跃内存表的字节数
+     * 
+     */
+    size_t getActiveMemoryUsage();
+
+    /**
+     * @brief 按第0层文件数、等待刷写的内存表数与估算的待合并字节数重新设置写入限流状态,
+     *        在版本或不可变内存表变化后调用
+     * 
+     */
+    void updateWriteStallCondition();
+
+    /**
+     * @brief 写入进入流水线前按限流状态等待: 停止时协助执行合并并等待恢复, 限速时按令牌桶等待
+     * 
+     * @param bytes 批次的字节数
+     * @return OperatorResult 停止期间后台出错时返回错误
+     */
+    OperatorResult delayWrite(size_t bytes);
+
+    /**
+     * @brief 依次执行自动合并, 直到每一层都不超过上限
+     * 
+     * @param wait 已经有合并在执行时是否等待; 不等待时直接返回, 由正在执行的合并继续选择
+     * @return OperatorResult 
+     */
+    OperatorResult runPendingCompactions(bool wait = true);
+
+    /**
+     * @brief 执行一次合并并应用到版本
+     * 
+     */
+    OperatorResult runCompaction(const Compaction& compaction);
+
+    /**
+     * @brief 直接删除被SSTable中更新的范围删除标记完全遮住的SSTable, 不读取文件内容
+     * 
+     * @return OperatorResult 
+     */
+    OperatorResult dropCoveredFiles();
+
+    /**
+     * @brief 直接删除的SSTable中引用的blob值都成为垃圾
+     * 
+     * @param file 被删除的SSTable
+     * @param edit [out] 报告blob文件的垃圾字节数
+     * @return OperatorResult 
+     */
+    OperatorResult collectBlobGarbage(const FileMeta& file, VersionEdit& edit);
+
+    /**
+     * @brief 最老的快照序列号, 没有快照时为最新的序列号
+     * 
+     */
+    uint64_t getOldestSnapshot();
+
+    /**
+     * @brief 删除不再被引用的日志、SSTable与blob文件, 正在写入的文件不会被删除
+     * 
+     * @param remove_temp_files 是否删除临时文件, 只在打开时没有并发的清单写入时删除
+     */
+    void removeObsoleteFiles(bool remove_temp_files = false);
+
+    /**
+     * @brief 在SSTable中查找一个键
+     * 
+     * @param version 提供SSTable的版本, 需要持有到读完blob文件
+     * @param key 用户键
+     * @param snapshot 快照序列号
+     * @param result [out] 查找结果
+     * @param operands [out] 追加找到的版本之前的合并操作数, 从新到旧排列
+     * @return OperatorResult 
+     */
+    OperatorResult getFromTables(const Version& version, const std::string& key, uint64_t snapshot, 
+                                 SSTable::LookupResult& result, std::vector<std::string>& operands);
+
+    /**
+     * @brief 找到的值在blob文件中时读出值
+     * 
+     * @param result [in/out] SSTable的查找结果
+     * @return OperatorResult 
+     */
+    OperatorResult readBlobValue(SSTable::LookupResult& result);
+
+    /**
+     * @brief 把旧值与合并操作数合并成最终的值
+     * 
+     * @param key 键
+     * @param base 旧值, 键不存在或已被删除时为空指针
+     * @param operands 从新到旧排列的合并操作数, 会被重新排列
+     * @return std::shared_ptr<std::string> 没有值或合并失败时为空
+     */
+    std::shared_ptr<std::string> resolveValue(const std::string& key, const std::string* base, 
+                                              std::vector<std::string>& operands) const;
+
+    /**
+     * @brief 创建合并内存表与SSTable的内部迭代器
+     * 
+     * @param view 内存表与提供SSTable的版本
+     * @param upper_bound 遍历的上界, SSTable迭代器用它查询范围过滤器
+     * @param range_del [out] 收集所有数据源的范围删除标记, 可以为空
+     * @param prefix 前缀查找的前缀, 不为空时跳过前缀过滤器排除这个前缀的SSTable
+     */
+    std::unique_ptr<InternalIterator> newInternalIterator(const ReadView& view, const std::string& upper_bound,
+                                                          RangeDelAggregator* range_del, const std::string* prefix);
+
+    /**
+     * @brief 写入流水线的leader把一组批次写入预写日志
+     * 
+     */
+    OperatorResult writeLog(const std::vector<WriteBatch*>& batches, bool sync);
+
+    /**
+     * @brief 写入流水线的成员把自己的批次写入内存表
+     * 
+     */
+    OperatorResult writeMemoryTable(const WriteBatch& batch);
+private:
+    const DataBaseConfig config_;
+
+    /**
+     * @brief 当前写入的内存表, 只在写日志的leader切换内存表时修改, 此时没有写内存表的线程;
+     *        读取时在memtable_mutex_下复制
+     * 
+     */
+    std::shared_ptr<MemoryTable> memtable_;
+
+    /**
+     * @brief 保护内存表的切换、不可变内存表、正在写入的文件与后台错误
+     * 
+     */
+    std::mutex memtable_mutex_;
+
+    /**
+     * @brief 不可变内存表, 从旧到新排列; 刷写可以乱序完成, 但只按这个顺序应用到版本
+     * 
+     */
+    std::deque<std::shared_ptr<ImmutableMemoryTable>> immutables_;
+
+    /**
+     * @brief 不可变内存表被应用到版本时通知等待的写入
+     * 
+     */
+    std::condition_variable immutable_cv_;
+
+    /**
+     * @brief 是否有线程正在按顺序应用刷写结果
+     * 
+     */
+    bool installing_;
+
+    /**
+     * @brief 正在写入的文件的最小编号, 不小于其中最小值的文件都不能作为过时文件删除
+     * 
+     */
+    std::multiset<uint64_t> pending_outputs_;
+
+    /**
+     * @brief 后台刷写或写预写日志的第一个错误; 日志写失败后之后的写入都返回这个错误,
+     *        刷写失败后之后切换内存表时返回给写入
+     * 
+     */
+    OperatorResult background_status_;
+
+    /**
+     * @brief 写缓冲区管理请求刷写, 下一个写日志的leader封存非空的活跃内存表
+     * 
+     */
+    std::atomic<bool> flush_requested_;
+
+    /**
+     * @brief 在写缓冲区管理中注册的编号, 0表示没有注册
+     * 
+     */
+    uint64_t write_buffer_owner_;
+
+    /**
+     * @brief 写入限流, stall_mutex_保证按版本的先后顺序设置状态
+     * 
+     */
+    WriteController write_controller_;
+    std::mutex stall_mutex_;
+
+    /**
+     * @brief 当前的预写日志
+     * 
+     */
+    std::shared_ptr<AppendOnlyFile> log_file_;
+    std::unique_ptr<log::LogWriter> log_writer_;
+
+    /**
+     * @brief 当前的SSTable集合与清单文件
+     * 
+     */
+    VersionSet versions_;
+
+    /**
+     * @brief 所有SSTable共用的block缓存, 可以与其他数据库共用, 先于table_cache_构造, 后于它析构
+     * 
+     */
+    std::shared_ptr<BlockCache> block_cache_;
+    TableCache table_cache_;
+    BlobFileCache blob_cache_;
+
+    /**
+     * @brief 批量查找时并行读取data block
+     * 
+     */
+    ThreadPool read_pool_;
+
+    /**
+     * @brief 同一时刻只执行一个合并
+     * 
+     */
+    std::mutex compaction_mutex_;
+
+    /**
+     * @brief 所有未释放的快照序列号
+     * 
+     */
+    std::mutex snapshot_mutex_;
+    std::multiset<uint64_t> snapshots_;
+
+    /**
+     * @brief 写入流水线
+     * 
+     */
+    WritePipeline pipeline_;
+
+    /**
+     * @brief 刷写不可变内存表的后台线程, 最后声明, 析构时先等待所有刷写结束
+     * 
+     */
+    ThreadPool flush_pool_;
+};
+
+}
+
+#endif
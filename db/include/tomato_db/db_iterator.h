@@ -0,0 +1,202 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 19:20:07
+ * @LastEditTime: 2026-10-18 00:12:45
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_DB_ITERATOR_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_DB_ITERATOR_H
+
+#include <tomato_db/blob_file.h>
+#include <tomato_db/db.h>
+#include <tomato_db/iterator.h>
+#include <tomato_db/merge_operator.h>
+#include <tomato_db/prefix_extractor.h>
+#include <tomato_db/range_del.h>
+#include <tomato_db/table_meta.h>
+#include <tomato_db/version.h>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tomato {
+
+/**
+ * @brief 在迭代器创建时的数据源上重新创建内部迭代器, 参数为前缀查找的前缀, 为空指针时包含所有数据源
+ * 
+ */
+typedef std::function<std::unique_ptr<InternalIterator>(const std::string* prefix)> InternalIteratorFactory;
+
+/**
+ * @brief 把内部键的多版本遍历转换为用户键的遍历: 
+ *        跳过序列号大于快照的版本、同一个键的旧版本、删除标记以及被范围删除遮住的版本, 并在上界处停止;
+ *        最新版本是合并操作数时与更旧的版本合并后给出
+ * 
+ */
+class DBIterator final : public Iterator {
+public:
+    /**
+     * @brief 构造迭代器
+     * 
+     * @param iter 合并了所有数据源的内部迭代器
+     * @param sequence 快照序列号
+     * @param upper_bound 上界(不包含), 为空时没有上界
+     * @param range_del 快照可见的所有范围删除标记, 可以为空
+     * @param merge_operator 合并算子, 为空时遇到合并操作数返回错误
+     * @param prefix_extractor 前缀提取器, 不为空时为前缀查找模式: seek之后只遍历与目标前缀相同的键
+     * @param factory 前缀查找模式下为每个前缀创建只包含可能有这个前缀的数据源的内部迭代器
+     * @param blob_cache 读取保存在blob文件中的值, 为空时遇到BLOB_INDEX返回错误
+     * @param version 数据源所在的版本, 迭代器存在期间持有, 其中的SSTable与blob文件不会被删除
+     */
+    DBIterator(std::unique_ptr<InternalIterator> iter, uint64_t sequence, std::string upper_bound,
+               std::shared_ptr<const RangeDelAggregator> range_del = nullptr, 
+               const MergeOperator* merge_operator = nullptr,
+               const PrefixExtractor* prefix_extractor = nullptr,
+               InternalIteratorFactory factory = nullptr,
+               BlobFileCache* blob_cache = nullptr,
+               std::shared_ptr<const Version> version = nullptr);
+
+    bool valid() const override {
+        return valid_;
+    }
+
+    void seekToFirst() override;
+    void seekToLast() override;
+    void seek(const std::string& key) override;
+    void next() override;
+    void prev() override;
+
+    const std::string& key() const override {
+        return saved_key_;
+    }
+
+    const std::string& value() const override {
+        return saved_value_;
+    }
+
+    OperatorResult getStatus() const override;
+private:
+    /**
+     * @brief 正向遍历时内部迭代器停在当前键的某个可见版本上(合并后可能已经越过当前键),
+     *        反向遍历时停在当前键所有版本之前
+     * 
+     */
+    enum Direction {
+        FORWARD,
+        REVERSE,
+    };
+
+    /**
+     * @brief 从内部迭代器的当前位置向后找到第一个可见且未删除的键
+     * 
+     * @param skipping 是否跳过不大于skip的键
+     * @param skip 要跳过的键
+     */
+    void findNextUserEntry(bool skipping, std::string skip);
+
+    /**
+     * @brief 从内部迭代器的当前位置向前找到第一个可见且未删除的键
+     * 
+     */
+    void findPrevUserEntry();
+
+    /**
+     * @brief 正向遍历时从当前键的最新版本(合并操作数)开始向后收集操作数并合并
+     * 
+     */
+    void mergeValuesForward();
+
+    /**
+     * @brief 用合并算子计算当前键的值
+     * 
+     * @param base 旧值, 没有时为空指针
+     * @param operands 操作数, 从旧到新排列
+     * @return true 成功; false 失败, 迭代器置为无效
+     */
+    bool resolveMerge(const std::string* base, const std::vector<std::string>& operands);
+
+    /**
+     * @brief 从blob文件中读取值
+     * 
+     * @param blob_index 值的位置
+     * @param value [out] 值
+     * @return true 成功; false 失败, 迭代器置为无效
+     */
+    bool readBlob(const std::string& blob_index, std::string& value);
+
+    /**
+     * @brief 解析内部迭代器的当前键
+     * 
+     * @return true 成功; false 内部键格式错误, 迭代器置为无效
+     */
+    bool parseCurrentKey(ParsedInternalKey& parsed_key);
+
+    /**
+     * @brief 用户键是否不小于上界
+     * 
+     */
+    bool reachUpperBound(const std::string& user_key) const {
+        return !upper_bound_.empty() && user_key >= upper_bound_;
+    }
+
+    /**
+     * @brief 前缀查找模式下用户键是否不在当前前缀内
+     * 
+     */
+    bool outOfPrefix(const std::string& user_key) const {
+        return has_prefix_ && user_key.compare(0, prefix_.size(), prefix_) != 0;
+    }
+
+    /**
+     * @brief 前缀查找模式下切换内部迭代器
+     * 
+     * @param prefix 前缀, 为空指针时切换为包含所有数据源的内部迭代器
+     */
+    void resetInternalIterator(const std::string* prefix);
+
+    /**
+     * @brief 版本是否为删除标记或被范围删除遮住
+     * 
+     */
+    bool isDeleted(const ParsedInternalKey& parsed_key) const {
+        return parsed_key.type == ItemType::DELETION || 
+               (range_del_ && range_del_->isDeleted(parsed_key.user_key, parsed_key.seq));
+    }
+
+    /**
+     * @brief 迭代器置为无效
+     * 
+     */
+    void invalidate();
+private:
+    /**
+     * @brief 先于内部迭代器声明, 内部迭代器析构之后才释放版本
+     * 
+     */
+    std::shared_ptr<const Version> version_;
+    std::unique_ptr<InternalIterator> iter_;
+    const uint64_t sequence_;
+    const std::string upper_bound_;
+    std::shared_ptr<const RangeDelAggregator> range_del_;
+    const MergeOperator* merge_operator_;
+    const PrefixExtractor* prefix_extractor_;
+    InternalIteratorFactory factory_;
+    BlobFileCache* blob_cache_;
+
+    /**
+     * @brief 内部迭代器是否只包含可能有prefix_的数据源, 此时遍历限制在这个前缀内
+     * 
+     */
+    bool has_prefix_;
+    std::string prefix_;
+    Direction direction_;
+    bool valid_;
+    std::string saved_key_;
+    std::string saved_value_;
+    OperatorResult status_;
+};
+
+}
+
+#endif
@@ -0,0 +1,105 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 14:58:09
+ * @LastEditTime: 2026-10-18 22:41:13
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_FILENAME_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_FILENAME_H
+
+#include <cstdint>
+#include <string>
+
+namespace tomato {
+
+/**
+ * @brief 数据库目录下的文件类型
+ * 
+ */
+enum FileType {
+    /**
+     * @brief 预写日志, 格式为[编号].log
+     * 
+     */
+    LOG_FILE,
+    /**
+     * @brief SSTable文件, 格式为[编号].sst
+     * 
+     */
+    TABLE_FILE,
+    /**
+     * @brief 保存大值的blob文件, 格式为[编号].blob
+     * 
+     */
+    BLOB_FILE,
+    /**
+     * @brief 记录数据库文件列表的清单文件, 文件名为MANIFEST
+     * 
+     */
+    MANIFEST_FILE,
+    /**
+     * @brief 写入中的临时文件, 格式为[名字].tmp
+     * 
+     */
+    TEMP_FILE,
+    /**
+     * @brief 无法识别的文件
+     * 
+     */
+    UNKNOWN_FILE,
+};
+
+/**
+ * @brief 预写日志文件名
+ * 
+ * @param db_path 数据库目录
+ * @param number 文件编号
+ * @return std::string 
+ */
+std::string logFileName(const std::string& db_path, uint64_t number);
+
+/**
+ * @brief SSTable文件名
+ * 
+ * @param db_path 数据库目录
+ * @param number 文件编号
+ * @return std::string 
+ */
+std::string tableFileName(const std::string& db_path, uint64_t number);
+
+/**
+ * @brief blob文件名
+ * 
+ * @param db_path 数据库目录
+ * @param number 文件编号
+ * @return std::string 
+ */
+std::string blobFileName(const std::string& db_path, uint64_t number);
+
+/**
+ * @brief 清单文件名
+ * 
+ * @param db_path 数据库目录
+ * @return std::string 
+ */
+std::string manifestFileName(const std::string& db_path);
+
+/**
+ * @brief 临时文件名, 写完后通过重命名原子地替换目标文件
+ * 
+ * @param filename 目标文件名
+ * @return std::string 
+ */
+std::string tempFileName(const std::string& filename);
+
+/**
+ * @brief 解析数据库目录下的文件名
+ * 
+ * @param filename 文件名(不含目录)
+ * @param number [out] 文件编号, 只有日志、SSTable与blob文件有编号
+ * @return FileType 文件类型
+ */
+FileType parseFileName(const std::string& filename, uint64_t& number);
+
+}
+
+#endif
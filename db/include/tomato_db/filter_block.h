@@ -0,0 +1,146 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 23:46:03
+ * @LastEditTime: 2026-10-18 23:03:13
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_FILTER_BLOCK_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_FILTER_BLOCK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tomato {
+
+/**
+ * @brief 布隆过滤器: 位数组 + 哈希函数个数(1字节), 不会误判存在的键
+ * 
+ */
+class BloomFilter {
+public:
+    /**
+     * @brief 为一组键生成过滤器
+     * 
+     * @param keys 键
+     * @param bits_per_key 每个键占用的位数, 越大误判率越低
+     * @param dst [out] 追加到dst末尾
+     */
+    static void create(const std::vector<std::string>& keys, int bits_per_key, std::string& dst);
+
+    /**
+     * @brief 键是否可能在过滤器中
+     * 
+     * @param key 键
+     * @param filter 过滤器起始位置
+     * @param size 过滤器字节数
+     * @return true 可能存在或过滤器格式未知; false 一定不存在
+     */
+    static bool mayMatch(const std::string& key, const char* filter, size_t size);
+};
+
+/**
+ * @brief 过滤器block格式:
+ *        [filter 0]...[filter n-1][table filter][filter偏移量(定长32位) * (n + 1)][偏移量数组位置(定长32位)][base_lg(1字节)]
+ *        filter i包含起始偏移量落在[i << base_lg, (i + 1) << base_lg)内的data block中的键,
+ *        table filter包含整个SSTable的键
+ * 
+ */
+class FilterBlockBuilder {
+public:
+    /**
+     * @brief 构造
+     * 
+     * @param bits_per_key 每个键占用的位数
+     * @param base_offset data block偏移量的起点, 分区的过滤器从分区中第一个data block的偏移量开始划分
+     */
+    explicit FilterBlockBuilder(int bits_per_key, uint64_t base_offset = 0);
+    FilterBlockBuilder(const FilterBlockBuilder&) = delete;
+    FilterBlockBuilder& operator=(const FilterBlockBuilder&) = delete;
+
+    /**
+     * @brief 开始一个新的data block, 之后添加的键属于它
+     * 
+     * @param block_offset data block在文件中的偏移量
+     */
+    void startBlock(uint64_t block_offset);
+
+    /**
+     * @brief 添加一个键, 与上一个键相同时忽略
+     * 
+     */
+    void addKey(const std::string& key);
+
+    /**
+     * @brief 生成剩余的过滤器并结束, 之后不能再调用其他方法
+     * 
+     * @return const std::string& 过滤器block的完整内容
+     */
+    const std::string& finish();
+private:
+    /**
+     * @brief 为当前积累的键生成一个data block过滤器
+     * 
+     */
+    void generateFilter();
+private:
+    const int bits_per_key_;
+    const uint64_t base_offset_;
+    std::vector<std::string> keys_;
+    std::vector<std::string> table_keys_;
+    std::string result_;
+    std::vector<uint32_t> filter_offsets_;
+};
+
+/**
+ * @brief 读取过滤器block
+ * 
+ */
+class FilterBlockReader {
+public:
+    FilterBlockReader();
+
+    /**
+     * @brief 解析过滤器block
+     * 
+     * @param contents 过滤器block的内容
+     * @return true 成功; false 格式错误
+     */
+    bool init(std::string contents);
+
+    /**
+     * @brief 解析过滤器block, 不复制内容, 调用者保证data在读取期间有效
+     * 
+     * @param data 过滤器block的内容
+     * @param size 字节数
+     * @return true 成功; false 格式错误
+     */
+    bool init(const char* data, size_t size);
+
+    /**
+     * @brief 起始于block_offset的data block中是否可能有这个键
+     * 
+     */
+    bool blockMayMatch(uint64_t block_offset, const std::string& key) const;
+
+    /**
+     * @brief 整个SSTable中是否可能有这个键
+     * 
+     */
+    bool tableMayMatch(const std::string& key) const;
+private:
+    /**
+     * @brief init(std::string)时持有的内容, data_指向过滤器block的内容
+     * 
+     */
+    std::string contents_;
+    const char* data_;
+    size_t size_;
+    size_t offsets_begin_;
+    size_t filter_count_;
+    int base_lg_;
+};
+
+}
+
+#endif
@@ -0,0 +1,64 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 18:58:13
+ * @LastEditTime: 2026-10-18 18:58:13
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_ITERATOR_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_ITERATOR_H
+
+#include <tomato_common/io.h>
+
+#include <memory>
+#include <string>
+
+namespace tomato {
+
+/**
+ * @brief 按内部键顺序遍历一组数据(内存表或SSTable), 每个内部键都是一个独立的版本
+ * 
+ */
+class InternalIterator {
+public:
+    InternalIterator() = default;
+    InternalIterator(const InternalIterator&) = delete;
+    InternalIterator& operator=(const InternalIterator&) = delete;
+    virtual ~InternalIterator() = default;
+
+    virtual bool valid() const = 0;
+    virtual void seekToFirst() = 0;
+    virtual void seekToLast() = 0;
+
+    /**
+     * @brief 定位到第一个不小于target的内部键
+     * 
+     * @param target 内部键
+     */
+    virtual void seek(const std::string& target) = 0;
+    virtual void next() = 0;
+    virtual void prev() = 0;
+
+    /**
+     * @brief 当前的内部键, 只在valid时可调用
+     * 
+     */
+    virtual const std::string& key() const = 0;
+    virtual const std::string& value() const = 0;
+
+    /**
+     * @brief 遍历过程中遇到的第一个错误
+     * 
+     */
+    virtual OperatorResult getStatus() const = 0;
+};
+
+/**
+ * @brief 创建一个没有数据的迭代器
+ * 
+ * @param status 迭代器返回的状态, 用于把打开数据时的错误交给调用者
+ * @return std::unique_ptr<InternalIterator> 
+ */
+std::unique_ptr<InternalIterator> newEmptyIterator(const OperatorResult& status);
+
+}
+
+#endif
@@ -0,0 +1,103 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 23:08:02
+ * @LastEditTime: 2026-10-18 23:08:02
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_LEARNED_INDEX_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_LEARNED_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tomato {
+
+/**
+ * @brief 学习索引格式:
+ *        [公共前缀长度(变长)][公共前缀][最大误差(变长)][data block个数(变长)][段数(变长)][段 1]...[段 n]
+ *        段为[起点(定长64位)][起点处的block序号(定长64位)][斜率(double, 定长64位)];
+ *        用户键去掉所有data block最后一个键的公共前缀后, 取接下来的8个字节(不足补0)按大端序作为坐标,
+ *        坐标随用户键单调不减; 每一段在它覆盖的拟合点上与block序号的误差不超过最大误差
+ * 
+ */
+class LearnedIndexBuilder {
+public:
+    /**
+     * @brief 构造
+     * 
+     * @param max_error 拟合点上的最大误差(data block个数)
+     */
+    explicit LearnedIndexBuilder(uint32_t max_error);
+    LearnedIndexBuilder(const LearnedIndexBuilder&) = delete;
+    LearnedIndexBuilder& operator=(const LearnedIndexBuilder&) = delete;
+
+    /**
+     * @brief 按顺序添加下一个data block的最后一个用户键
+     * 
+     */
+    void addBlock(const std::string& last_user_key);
+
+    /**
+     * @brief 拟合并结束, 之后不能再调用其他方法
+     * 
+     * @return const std::string& 学习索引的完整内容
+     */
+    const std::string& finish();
+private:
+    const uint32_t max_error_;
+
+    /**
+     * @brief 公共前缀需要等所有键添加后才能确定, 先保存每个data block的最后一个用户键
+     * 
+     */
+    std::vector<std::string> keys_;
+    std::string result_;
+};
+
+/**
+ * @brief 读取学习索引, 预测用户键所在的data block序号范围
+ * 
+ */
+class LearnedIndexReader {
+public:
+    LearnedIndexReader();
+
+    /**
+     * @brief 解析学习索引
+     * 
+     * @param contents 学习索引的内容
+     * @return true 成功; false 格式错误
+     */
+    bool init(const std::string& contents);
+
+    /**
+     * @brief 预测第一个最后一个键不小于用户键的data block的序号范围;
+     *        键的坐标相同等情况下预测可能不准, 调用者需要检查范围两端
+     * 
+     * @param user_key 用户键
+     * @param first [out] 范围起点
+     * @param last [out] 范围终点(包含)
+     */
+    void predict(const std::string& user_key, uint64_t& first, uint64_t& last) const;
+
+    /**
+     * @brief 用户键去掉公共前缀后的坐标, 不以公共前缀开头时取最小或最大值
+     * 
+     */
+    static uint64_t keyToPosition(const std::string& user_key, const std::string& prefix);
+private:
+    struct Segment {
+        uint64_t start;
+        uint64_t first_block;
+        double slope;
+    };
+private:
+    std::string prefix_;
+    uint64_t max_error_;
+    uint64_t block_count_;
+    std::vector<Segment> segments_;
+};
+
+}
+
+#endif
@@ -0,0 +1,61 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 10:12:31
+ * @LastEditTime: 2026-10-18 10:12:31
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_LOG_FORMAT_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_LOG_FORMAT_H
+
+#include <cstddef>
+
+namespace tomato {
+namespace log {
+
+/**
+ * @brief 预写日志的物理记录类型, 超过一个block剩余空间的记录会被拆成FIRST/MIDDLE/LAST多个分片
+ * 
+ */
+enum RecordType {
+    /**
+     * @brief 预留类型, 预分配的空间全为0, 读到时直接跳过
+     * 
+     */
+    ZERO = 0,
+    /**
+     * @brief 完整记录
+     * 
+     */
+    FULL = 1,
+    /**
+     * @brief 第一个分片
+     * 
+     */
+    FIRST = 2,
+    /**
+     * @brief 中间分片
+     * 
+     */
+    MIDDLE = 3,
+    /**
+     * @brief 最后一个分片
+     * 
+     */
+    LAST = 4,
+};
+
+/**
+ * @brief 日志文件按固定大小的block划分, 物理记录不会跨越block
+ * 
+ */
+static const size_t BLOCK_SIZE = 32768;
+
+/**
+ * @brief 物理记录头: crc32(4字节) + 数据长度(2字节) + 类型(1字节), crc覆盖类型与数据
+ * 
+ */
+static const size_t HEADER_SIZE = 4 + 2 + 1;
+
+}
+}
+
+#endif
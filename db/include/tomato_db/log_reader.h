@@ -0,0 +1,104 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 10:41:47
+ * @LastEditTime: 2026-10-18 10:41:47
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_LOG_READER_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_LOG_READER_H
+
+#include <tomato_db/log_format.h>
+#include <tomato_common/io.h>
+
+#include <string>
+
+namespace tomato {
+namespace log {
+
+/**
+ * @brief 预写日志读取器, 校验crc并把分片重新拼成完整记录, 非线程安全
+ * 
+ */
+class LogReader {
+public:
+    /**
+     * @brief 
+     * 
+     * @param file 日志文件, 生命周期由调用方管理
+     */
+    explicit LogReader(SequentialFile* file);
+    LogReader(const LogReader&) = delete;
+    LogReader& operator=(const LogReader&) = delete;
+
+    /**
+     * @brief 读取下一条完整记录, 校验失败或不完整的记录会被丢弃
+     * 
+     * @param record [out] 记录内容
+     * @return true 读到了记录
+     * @return false 日志已经读完
+     */
+    bool readRecord(std::string& record);
+
+    /**
+     * @brief 因为校验失败或者记录不完整被丢弃的字节数
+     * 
+     */
+    uint64_t getDroppedBytes() const {
+        return dropped_bytes_;
+    }
+private:
+    /**
+     * @brief readPhysicalRecord的额外返回值
+     * 
+     */
+    enum {
+        // 文件结束
+        END_OF_FILE = LAST + 1,
+        // 物理记录损坏
+        BAD_RECORD = LAST + 2,
+    };
+
+    /**
+     * @brief 读取一个物理记录
+     * 
+     * @param fragment [out] 物理记录中的数据
+     * @return int RecordType或END_OF_FILE/BAD_RECORD
+     */
+    int readPhysicalRecord(std::string& fragment);
+
+    /**
+     * @brief 丢弃当前block中剩余的数据
+     * 
+     */
+    void dropBuffer();
+private:
+    SequentialFile* file_;
+
+    /**
+     * @brief 当前block的数据
+     * 
+     */
+    std::string buffer_;
+
+    /**
+     * @brief buffer_中下一个物理记录的位置
+     * 
+     */
+    size_t buffer_pos_;
+
+    /**
+     * @brief 是否已经读到文件末尾
+     * 
+     */
+    bool eof_;
+
+    /**
+     * @brief 被丢弃的字节数
+     * 
+     */
+    uint64_t dropped_bytes_;
+};
+
+}
+}
+
+#endif
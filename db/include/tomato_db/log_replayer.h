@@ -0,0 +1,187 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 13:40:52
+ * @LastEditTime: 2026-10-18 13:40:52
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_LOG_REPLAYER_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_LOG_REPLAYER_H
+
+#include <tomato_db/memory_table.h>
+#include <tomato_common/io.h>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace tomato {
+namespace log {
+
+/**
+ * @brief 日志回放配置
+ * 
+ */
+struct ReplayOptions {
+    /**
+     * @brief 解码并写入内存表的线程数
+     * 
+     */
+    int decode_threads = 4;
+
+    /**
+     * @brief 读线程最多领先解码线程多少条记录
+     * 
+     */
+    size_t max_pending_records = 256;
+
+    /**
+     * @brief 内存表超过该大小后交给flush, 并换上新的内存表继续回放
+     * 
+     */
+    size_t write_buffer_size = 4 << 20;
+
+    /**
+     * @brief 操作个数不少于该值且有序的批次走批量插入
+     * 
+     */
+    uint32_t sorted_run_threshold = 64;
+
+    /**
+     * @brief 读取日志文件使用的预读配置
+     * 
+     */
+    SequentialFileOptions file_options;
+};
+
+/**
+ * @brief 并行日志回放: 调用线程顺序读取日志并校验crc, 多个解码线程并发地把批次写入内存表,
+ *        写满的内存表由独立的线程立即flush, 不阻塞后续回放
+ * 
+ */
+class LogReplayer {
+public:
+    /**
+     * @brief 处理写满的内存表, 在flush线程中被调用
+     * 
+     */
+    using FlushFunction = std::function<OperatorResult(std::shared_ptr<MemoryTable>)>;
+public:
+    LogReplayer(const ReplayOptions& options, FlushFunction flush);
+    LogReplayer(const LogReplayer&) = delete;
+    LogReplayer& operator=(const LogReplayer&) = delete;
+
+    /**
+     * @brief 按顺序回放日志文件, 文件中的记录需为WriteBatch的序列化内容
+     * 
+     * @param filenames 日志文件, 按写入先后排列
+     * @param memtable [in/out] 回放的目标内存表, 返回时为最后一个未写满的内存表
+     * @param max_sequence [out] 回放到的最大序列号, 没有任何记录时不修改
+     * @return OperatorResult 
+     */
+    OperatorResult replay(const std::vector<std::string>& filenames,
+                          std::shared_ptr<MemoryTable>& memtable,
+                          uint64_t& max_sequence);
+
+    /**
+     * @brief 回放的记录条数
+     * 
+     */
+    uint64_t getRecordCount() const {
+        return record_count_;
+    }
+
+    /**
+     * @brief 因为校验失败被丢弃的字节数
+     * 
+     */
+    uint64_t getDroppedBytes() const {
+        return dropped_bytes_;
+    }
+private:
+    /**
+     * @brief 解码线程
+     * 
+     */
+    void decodeLoop();
+
+    /**
+     * @brief flush线程
+     * 
+     */
+    void flushLoop();
+
+    /**
+     * @brief 等待所有已读取的记录写入内存表
+     * 
+     * @param lock 持有mutex_的锁
+     */
+    void waitForIdle(std::unique_lock<std::mutex>& lock);
+
+    /**
+     * @brief 记录第一个错误, 需持有mutex_
+     * 
+     */
+    void setError(const OperatorResult& status);
+private:
+    const ReplayOptions options_;
+    const FlushFunction flush_;
+
+    std::mutex mutex_;
+    std::condition_variable records_cv_;
+    std::condition_variable space_cv_;
+    std::condition_variable idle_cv_;
+    std::condition_variable flush_cv_;
+
+    /**
+     * @brief 已读取待解码的记录
+     * 
+     */
+    std::deque<std::string> records_;
+
+    /**
+     * @brief 正在解码的线程数
+     * 
+     */
+    int busy_decoders_;
+
+    /**
+     * @brief 当前写入的内存表
+     * 
+     */
+    std::shared_ptr<MemoryTable> memtable_;
+
+    /**
+     * @brief 等待flush的内存表
+     * 
+     */
+    std::deque<std::shared_ptr<MemoryTable>> immutables_;
+
+    /**
+     * @brief 日志已经读完
+     * 
+     */
+    bool finished_;
+
+    /**
+     * @brief 回放到的最大序列号, 0表示没有记录
+     * 
+     */
+    uint64_t max_sequence_;
+
+    /**
+     * @brief 第一个错误
+     * 
+     */
+    OperatorResult status_;
+
+    uint64_t record_count_;
+    uint64_t dropped_bytes_;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,102 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 10:20:05
+ * @LastEditTime: 2026-10-19 00:17:45
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_LOG_WRITER_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_LOG_WRITER_H
+
+#include <tomato_db/log_format.h>
+#include <tomato_common/io.h>
+
+#include <string>
+
+namespace tomato {
+namespace log {
+
+/**
+ * @brief 预写日志写入器, 负责把记录切分成带crc校验的物理记录, 非线程安全
+ * 
+ */
+class LogWriter {
+public:
+    /**
+     * @brief 
+     * 
+     * @param file 日志文件, 需要是一个新创建的空文件, 生命周期由调用方管理
+     */
+    explicit LogWriter(AppendOnlyFile* file);
+    LogWriter(const LogWriter&) = delete;
+    LogWriter& operator=(const LogWriter&) = delete;
+
+    /**
+     * @brief 追加一条记录
+     * 
+     * @param record 记录内容
+     * @return OperatorResult 
+     */
+    OperatorResult addRecord(const std::string& record);
+
+    /**
+     * @brief 将一条记录编码成物理记录追加到output末尾, 不写文件;
+     *        编码结果必须按编码顺序原样写入文件, 上次写入之后编码的所有记录需要一次写入
+     * 
+     * @param record 记录内容
+     * @param output [out] 编码结果
+     */
+    void encodeRecord(const std::string& record, std::string& output);
+
+    /**
+     * @brief 将编码好的数据写入文件; 写入或落盘失败后文件末尾的内容不确定, 之后的写入都返回这个错误
+     * 
+     * @param encoded 上次写入之后所有encodeRecord的结果
+     * @return OperatorResult 
+     */
+    OperatorResult appendEncoded(const std::string& encoded);
+
+    /**
+     * @brief 将日志落盘
+     * 
+     * @return OperatorResult 
+     */
+    OperatorResult sync();
+private:
+    /**
+     * @brief 编码一个物理记录
+     * 
+     * @param type 记录类型
+     * @param data 数据首地址
+     * @param size 数据长度
+     * @param output [out] 编码结果
+     */
+    void encodePhysicalRecord(RecordType type, const char* data, size_t size, std::string& output);
+private:
+    /**
+     * @brief 日志文件
+     * 
+     */
+    AppendOnlyFile* file_;
+
+    /**
+     * @brief 当前block已经写入文件的字节数, 只在写入成功后前进
+     * 
+     */
+    size_t block_offset_;
+
+    /**
+     * @brief 编码到的位置在当前block中的偏移, 写入成功后成为block_offset_
+     * 
+     */
+    size_t encoded_offset_;
+
+    /**
+     * @brief 第一个写入或落盘错误
+     * 
+     */
+    OperatorResult status_;
+};
+
+}
+}
+
+#endif
@@ -1,17 +1,20 @@
 /*
  * @Author: Tomato
  * @Date: 2021-12-27 16:19:21
- * @LastEditTime: 2022-11-24 10:02:14
+ * @LastEditTime: 2026-10-18 23:48:43
  */
 #ifndef TOMATO_DB_DB_INCLUDE_TOMATO_MEMORY_TABLE_H
 #define TOMATO_DB_DB_INCLUDE_TOMATO_MEMORY_TABLE_H
 
 #include <tomato_db/table_meta.h>
+#include <tomato_db/iterator.h>
 #include <tomato_common/allocator.h>
 #include <tomato_common/skip_list.h>
 
 #include <string>
 #include <memory>
+#include <vector>
+#include <cstdint>
 
 namespace tomato {
 
@@ -24,8 +27,69 @@ namespace tomato {
 class MemoryTable {
 public:
     using Table = SkipList<TableItem, TableItemComparator>;
+
+    /**
+     * @brief 批量写入的键值对
+     * 
+     */
+    struct Entry {
+        uint64_t seq;
+        ItemType type;
+        std::string key;
+        std::string value;
+    };
+
+    /**
+     * @brief 内存表迭代器, 按键升序、同键序列号降序遍历所有版本
+     * 
+     */
+    class Iterator {
+    public:
+        explicit Iterator(const MemoryTable* table): iter_(&table->table_) {}
+
+        bool valid() const {
+            return iter_.valid();
+        }
+
+        void seekToFirst() {
+            iter_.seekToFirst();
+        }
+
+        void seekToLast() {
+            iter_.seekToLast();
+        }
+
+        /**
+         * @brief 定位到第一个不小于(key, seq)的版本, 即该键序列号不大于seq的最新版本或之后的键
+         * 
+         * @param key 键
+         * @param seq 序列号, 默认定位到该键的最新版本
+         */
+        void seek(const std::string& key, uint64_t seq = UINT64_MAX);
+
+        void next() {
+            iter_.next();
+        }
+
+        void prev() {
+            iter_.prev();
+        }
+
+        const TableItem& item() const {
+            return iter_.key();
+        }
+    private:
+        Table::Iterator iter_;
+    };
 public:
     MemoryTable();
+
+    /**
+     * @brief 构造内存表, 内存块的分配与释放报告给tracker
+     * 
+     * @param tracker 内存统计, 可以为空
+     */
+    explicit MemoryTable(std::shared_ptr<AllocationTracker> tracker);
     MemoryTable(const MemoryTable&) = delete;
     MemoryTable& operator=(const MemoryTable&) = delete;
     ~MemoryTable() = default;
@@ -41,6 +105,41 @@ public:
     void add(const uint64_t seq, ItemType type, 
              const std::string& key, const std::string& value);
 
+    /**
+     * @brief 线程安全地向内存表添加一个键值对, 可与其他并发写入及读操作同时执行, 不能与add同时执行
+     * 
+     * @param seq 序列号
+     * @param type 键值对类型
+     * @param key 键
+     * @param value 值
+     */
+    void addConcurrently(const uint64_t seq, ItemType type, 
+                         const std::string& key, const std::string& value);
+
+    /**
+     * @brief 线程安全地批量添加一组有序的键值对, 有序数据只需在相邻节点间查找插入位置
+     * 
+     * @param entries 按键升序、同键序列号降序排列的键值对
+     */
+    void addSortedRunConcurrently(const std::vector<Entry>& entries);
+
+    /**
+     * @brief 内存表已经占用的内存
+     * 
+     * @return size_t 字节
+     */
+    size_t getMemoryUsage() const {
+        return allocator_.getAllocatedSize();
+    }
+
+    /**
+     * @brief 内存表被封存, 之后不再写入, 它的内存转为等待释放
+     * 
+     */
+    void markImmutable() {
+        allocator_.doneAllocating();
+    }
+
     /**
      * @brief 查找内存表
      * 
@@ -49,6 +148,50 @@ public:
      */
     std::shared_ptr<std::string> get(const std::string& key);
 
+    /**
+     * @brief 查找内存表中键的最新版本, 与get不同的是可以区分键不存在与键已被删除
+     * 
+     * @param key 键
+     * @param value [out] 键的值
+     * @param deleted [out] 最新版本是否为删除标记
+     * @param seq 只查找序列号不大于seq的版本
+     * @return true 内存表中有这个键; false 内存表中没有这个键, 或最新版本是需要与更旧数据合并的操作数
+     */
+    bool lookup(const std::string& key, std::string& value, bool& deleted, uint64_t seq = UINT64_MAX);
+
+    /**
+     * @brief 从序列号不大于seq的最新版本开始查找, 合并操作数追加到operands后继续查找更旧的版本,
+     *        直到遇到值、删除标记或遮住它的范围删除标记
+     * 
+     * @param key 键
+     * @param seq 只查找序列号不大于seq的版本
+     * @param value [out] 找到的值
+     * @param deleted [out] 找到的是否为删除标记
+     * @param operands [out] 找到的版本之前的合并操作数, 从新到旧排列
+     * @return true 找到了值或删除标记; false 内存表中没有更旧的版本, operands可能不为空
+     */
+    bool lookup(const std::string& key, uint64_t seq, std::string& value, bool& deleted, 
+                std::vector<std::string>& operands);
+
+    /**
+     * @brief 遮住键的范围删除标记中最大的序列号
+     * @param key 键
+     * @param seq 只考虑序列号不大于seq的范围删除标记
+     * @return uint64_t 序列号, 没有时返回0
+     */
+    uint64_t getMaxCoveringTombstoneSeq(const std::string& key, uint64_t seq = UINT64_MAX) const;
+
+    /**
+     * @brief 取出所有范围删除标记
+     * @param tombstones [out] 追加到末尾
+     */
+    void getRangeTombstones(std::vector<RangeTombstone>& tombstones) const;
+
+    /**
+     * @brief 是否没有任何数据
+     */
+    bool empty() const;
+
 private:
     /**
      * @brief 向内存表添加一个键值对
@@ -59,7 +202,8 @@ private:
      * @param value 值
      */
     TableItem createItem(const uint64_t seq, ItemType type,
-                         const std::string& key, const std::string& value);
+                         const std::string& key, const std::string& value,
+                         bool concurrent = false);
 
 private:
     /**
@@ -79,6 +223,52 @@ private:
      * 
      */
     Table table_;
+
+    /**
+     * @brief 范围删除标记表, 键为范围起点, 值为范围终点
+     * 
+     */
+    Table range_del_table_;
+};
+
+/**
+ * @brief 以内部键的形式遍历内存表, 持有内存表的引用, 遍历期间内存表不会被释放
+ */
+class MemoryTableIterator final : public InternalIterator {
+public:
+    explicit MemoryTableIterator(std::shared_ptr<const MemoryTable> table);
+
+    bool valid() const override {
+        return iter_.valid();
+    }
+
+    void seekToFirst() override;
+    void seekToLast() override;
+    void seek(const std::string& target) override;
+    void next() override;
+    void prev() override;
+
+    const std::string& key() const override {
+        return key_;
+    }
+
+    const std::string& value() const override {
+        return value_;
+    }
+
+    OperatorResult getStatus() const override {
+        return OperatorResult::success();
+    }
+private:
+    /**
+     * @brief 把当前节点编码为内部键
+     */
+    void update();
+private:
+    std::shared_ptr<const MemoryTable> table_;
+    MemoryTable::Iterator iter_;
+    std::string key_;
+    std::string value_;
 };
 
 }
@@ -0,0 +1,59 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 23:05:27
+ * @LastEditTime: 2026-10-18 22:20:54
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_MERGE_OPERATOR_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_MERGE_OPERATOR_H
+
+#include <string>
+#include <vector>
+
+namespace tomato {
+
+/**
+ * @brief 用户提供的合并算子: 把DataBase::merge写入的操作数与旧值合并成新值,
+ *        用于计数器、追加列表等读改写场景, 写入时不需要先读取旧值;
+ *        同一个数据库每次打开都必须使用语义相同的算子
+ * 
+ */
+class MergeOperator {
+public:
+    virtual ~MergeOperator() = default;
+
+    /**
+     * @brief 把旧值与一组操作数合并成最终的值
+     * 
+     * @param key 键
+     * @param existing_value 旧值, 键不存在或已被删除时为空指针
+     * @param operands 操作数, 从旧到新排列
+     * @param result [out] 合并后的值
+     * @return true 成功; false 操作数无法合并, 读取返回错误
+     */
+    virtual bool fullMerge(const std::string& key, const std::string* existing_value,
+                           const std::vector<std::string>& operands, std::string& result) const = 0;
+
+    /**
+     * @brief 在旧值未知时把两个相邻的操作数合并成一个, 用于合并时减少操作数的个数
+     * 
+     * @param key 键
+     * @param left 较旧的操作数
+     * @param right 较新的操作数
+     * @param result [out] 合并后的操作数
+     * @return true 成功; false 不支持, 操作数原样保留
+     */
+    virtual bool partialMerge(const std::string& /* key */, const std::string& /* left */,
+                              const std::string& /* right */, std::string& /* result */) const {
+        return false;
+    }
+
+    /**
+     * @brief 算子的名字
+     * 
+     */
+    virtual const char* name() const = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,77 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 19:04:51
+ * @LastEditTime: 2026-10-18 19:04:51
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_MERGING_ITERATOR_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_MERGING_ITERATOR_H
+
+#include <tomato_db/iterator.h>
+
+#include <memory>
+#include <vector>
+
+namespace tomato {
+
+/**
+ * @brief 把多个有序的内部迭代器归并成一个有序的迭代器
+ *        正向遍历时用最小堆维护各个子迭代器的当前键, 反向遍历时用最大堆,
+ *        每次移动只需调整堆顶, 代价为O(log n); 只持有各个子迭代器, 内存占用与数据量无关
+ * 
+ */
+class MergingIterator final : public InternalIterator {
+public:
+    explicit MergingIterator(std::vector<std::unique_ptr<InternalIterator>> children);
+
+    bool valid() const override {
+        return !heap_.empty();
+    }
+
+    void seekToFirst() override;
+    void seekToLast() override;
+    void seek(const std::string& target) override;
+    void next() override;
+    void prev() override;
+
+    const std::string& key() const override {
+        return heap_.front()->key();
+    }
+
+    const std::string& value() const override {
+        return heap_.front()->value();
+    }
+
+    OperatorResult getStatus() const override;
+private:
+    enum Direction {
+        FORWARD,
+        REVERSE,
+    };
+
+    /**
+     * @brief 用所有有效的子迭代器重建堆
+     * 
+     * @param direction 遍历方向
+     */
+    void rebuildHeap(Direction direction);
+
+    /**
+     * @brief 移动堆顶的子迭代器后调整堆
+     * 
+     * @param forward true 向后移动; false 向前移动
+     */
+    void advanceTop(bool forward);
+private:
+    std::vector<std::unique_ptr<InternalIterator>> children_;
+
+    /**
+     * @brief 有效的子迭代器组成的堆, 堆顶为当前键所在的子迭代器
+     * 
+     */
+    std::vector<InternalIterator*> heap_;
+    Direction direction_;
+};
+
+}
+
+#endif
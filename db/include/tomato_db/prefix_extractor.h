@@ -0,0 +1,63 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 23:40:16
+ * @LastEditTime: 2026-10-18 22:29:05
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_PREFIX_EXTRACTOR_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_PREFIX_EXTRACTOR_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace tomato {
+
+/**
+ * @brief 从用户键中取出前缀, 用于前缀过滤器与前缀查找;
+ *        前缀必须是键的开头部分, 这样同一个前缀的键在键空间中是连续的
+ * 
+ */
+class PrefixExtractor {
+public:
+    virtual ~PrefixExtractor() = default;
+
+    /**
+     * @brief 键是否有前缀, 没有前缀的键不写入前缀过滤器, 以它为目标的查找按全序进行
+     * 
+     */
+    virtual bool inDomain(const std::string& key) const = 0;
+
+    /**
+     * @brief 取出前缀, 只对inDomain的键调用
+     * 
+     */
+    virtual std::string transform(const std::string& key) const = 0;
+
+    /**
+     * @brief 名字, 包含所有影响前缀的参数; 写入SSTable, 名字不同的过滤器不会被使用
+     * 
+     */
+    virtual const char* name() const = 0;
+};
+
+/**
+ * @brief 定长前缀: 取键的前length个字节, 更短的键没有前缀
+ * 
+ * @param length 前缀长度
+ * @return std::shared_ptr<const PrefixExtractor>
+ */
+std::shared_ptr<const PrefixExtractor> newFixedPrefixExtractor(size_t length);
+
+/**
+ * @brief 分隔符前缀: 取到第count个分隔符为止(包含分隔符), 分隔符不足count个的键没有前缀,
+ *        例如分隔符为':', count为2时"tenant:user:item"的前缀为"tenant:user:"
+ * 
+ * @param delimiter 分隔符
+ * @param count 分隔符个数, 需大于0
+ * @return std::shared_ptr<const PrefixExtractor>
+ */
+std::shared_ptr<const PrefixExtractor> newDelimitedPrefixExtractor(char delimiter, int count);
+
+}
+
+#endif
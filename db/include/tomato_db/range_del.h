@@ -0,0 +1,105 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 19:48:30
+ * @LastEditTime: 2026-10-18 22:13:35
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_RANGE_DEL_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_RANGE_DEL_H
+
+#include <tomato_db/table_meta.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tomato {
+
+/**
+ * @brief 汇总多个数据源的范围删除标记, 切分成互不重叠的片段, 每个片段记录覆盖它的最大序列号,
+ *        判断一个版本是否被删除只需二分查找一次
+ * 
+ */
+class RangeDelAggregator {
+public:
+    /**
+     * @brief 构造
+     * 
+     * @param max_seq 只收集序列号不大于max_seq的标记, 通常为快照序列号
+     */
+    explicit RangeDelAggregator(uint64_t max_seq);
+    RangeDelAggregator(const RangeDelAggregator&) = delete;
+    RangeDelAggregator& operator=(const RangeDelAggregator&) = delete;
+
+    /**
+     * @brief 添加一个标记, 需要在finish之前调用
+     * 
+     */
+    void add(const RangeTombstone& tombstone);
+
+    /**
+     * @brief 切分所有标记, 之后只能查询
+     * 
+     */
+    void finish();
+
+    /**
+     * @brief 覆盖user_key的标记中最大的序列号
+     * 
+     * @return uint64_t 没有标记覆盖时返回0
+     */
+    uint64_t getMaxCoveringSeq(const std::string& user_key) const;
+
+    /**
+     * @brief 版本(user_key, seq)是否被删除
+     * 
+     */
+    bool isDeleted(const std::string& user_key, uint64_t seq) const {
+        return getMaxCoveringSeq(user_key) > seq;
+    }
+
+    /**
+     * @brief [begin, end]范围内的所有序列号小于seq的版本是否都被删除
+     * 
+     * @param begin 范围起点(包含)
+     * @param end 范围终点
+     * @param end_exclusive 是否不包含终点
+     * @param seq 序列号
+     */
+    bool isRangeDeleted(const std::string& begin, const std::string& end, bool end_exclusive, uint64_t seq) const;
+
+    bool empty() const {
+        return tombstones_.empty();
+    }
+
+    /**
+     * @brief 收集到的原始标记
+     * 
+     */
+    const std::vector<RangeTombstone>& getTombstones() const {
+        return tombstones_;
+    }
+private:
+    /**
+     * @brief 片段[begin, 下一个片段的begin)被序列号小于seq的标记覆盖, seq为0表示没有覆盖
+     * 
+     */
+    struct Fragment {
+        std::string begin;
+        uint64_t seq;
+    };
+
+    /**
+     * @brief 最后一个起点不大于user_key的片段下标
+     * 
+     * @return size_t 没有时返回fragments_.size()
+     */
+    size_t findFragment(const std::string& user_key) const;
+private:
+    const uint64_t max_seq_;
+    std::vector<RangeTombstone> tombstones_;
+    std::vector<Fragment> fragments_;
+};
+
+}
+
+#endif
@@ -0,0 +1,531 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 17:52:19
+ * @LastEditTime: 2026-10-18 23:18:25
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_SSTABLE_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_SSTABLE_H
+
+#include <tomato_db/block.h>
+#include <tomato_db/block_cache.h>
+#include <tomato_db/cuckoo_index.h>
+#include <tomato_db/filter_block.h>
+#include <tomato_db/iterator.h>
+#include <tomato_db/learned_index.h>
+#include <tomato_db/prefix_extractor.h>
+#include <tomato_db/table_format.h>
+#include <tomato_common/io.h>
+#include <tomato_common/thread_pool.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace tomato {
+
+/**
+ * @brief SSTable迭代器的过滤条件
+ * 
+ */
+struct TableIteratorOptions {
+    /**
+     * @brief 前缀提取器与前缀查找的前缀, 提取器为空时不使用前缀过滤器
+     * 
+     */
+    const PrefixExtractor* prefix_extractor = nullptr;
+    std::string prefix;
+
+    /**
+     * @brief 遍历的上界(用户键, 不包含), 为空时没有上界
+     * 
+     */
+    std::string upper_bound;
+
+    /**
+     * @brief 读到的data block是否放入block缓存, 合并等一次性的遍历应关闭, 以免挤掉热点block
+     * 
+     */
+    bool fill_cache = true;
+};
+
+/**
+ * @brief 只读的SSTable, 键为内部键, 可被多个线程同时读取
+ * 
+ */
+class SSTable {
+private:
+    /**
+     * @brief 遍历index: index分区时先遍历顶层index, 再遍历它指向的分区, 分区通过block缓存读取;
+     *        不分区时直接遍历index block
+     * 
+     */
+    class IndexIterator {
+    public:
+        IndexIterator(const SSTable* table, bool fill_cache);
+        IndexIterator(const IndexIterator&) = delete;
+        IndexIterator& operator=(const IndexIterator&) = delete;
+
+        bool valid() const;
+        void seekToFirst();
+        void seekToLast();
+        void seek(const std::string& target);
+        void next();
+        void prev();
+
+        /**
+         * @brief data block的最后一个键
+         * 
+         */
+        const std::string& key() const {
+            return current()->key();
+        }
+
+        /**
+         * @brief data block的位置
+         * 
+         */
+        const std::string& value() const {
+            return current()->value();
+        }
+
+        /**
+         * @brief 读取分区出错或index格式错误
+         * 
+         */
+        OperatorResult getStatus() const;
+    private:
+        const Block::Iterator* current() const {
+            return partition_iter_ ? partition_iter_.get() : &top_iter_;
+        }
+
+        /**
+         * @brief 读取顶层index当前指向的分区
+         * 
+         */
+        void initPartition();
+        void skipEmptyPartitionsForward();
+        void skipEmptyPartitionsBackward();
+    private:
+        const SSTable* table_;
+        const bool fill_cache_;
+        Block::Iterator top_iter_;
+        std::shared_ptr<Block> partition_;
+        std::unique_ptr<Block::Iterator> partition_iter_;
+        OperatorResult status_;
+    };
+public:
+    /**
+     * @brief 一次点查的结果
+     * 
+     */
+    struct LookupResult {
+        /**
+         * @brief 是否找到了用户键的可见版本
+         * 
+         */
+        bool found = false;
+
+        /**
+         * @brief 找到的版本是否为删除标记, 或被表内更新的范围删除标记遮住
+         * 
+         */
+        bool deleted = false;
+
+        /**
+         * @brief 找到的版本的序列号, 被范围删除时为范围删除标记的序列号
+         * 
+         */
+        uint64_t seq = 0;
+        std::string value;
+
+        /**
+         * @brief value是否为值在blob文件中的位置
+         * 
+         */
+        bool blob_index = false;
+
+        /**
+         * @brief 找到的版本之前(更新)的合并操作数, 从新到旧排列; 没有找到时也可能不为空
+         * 
+         */
+        std::vector<std::string> operands;
+    };
+
+    /**
+     * @brief 按内部键顺序遍历SSTable: 先遍历index block, 再遍历它指向的data block;
+     *        前缀过滤器或范围过滤器说明[seek目标, 上界)内没有需要的键时不读取data block,
+     *        迭代器直接置为无效, 此时的seekToLast定位到目标之前的最后一个键
+     * 
+     */
+    class Iterator final : public InternalIterator {
+    public:
+        explicit Iterator(std::shared_ptr<const SSTable> table, TableIteratorOptions options = TableIteratorOptions());
+
+        bool valid() const override {
+            return data_iter_ && data_iter_->valid();
+        }
+
+        void seekToFirst() override;
+        void seekToLast() override;
+        void seek(const std::string& target) override;
+        void next() override;
+        void prev() override;
+
+        const std::string& key() const override {
+            return data_iter_->key();
+        }
+
+        const std::string& value() const override {
+            return data_iter_->value();
+        }
+
+        OperatorResult getStatus() const override {
+            return status_;
+        }
+    private:
+        /**
+         * @brief 读取index迭代器当前指向的data block
+         * 
+         */
+        void initDataBlock();
+
+        /**
+         * @brief 向后跳过已经遍历完的data block
+         * 
+         */
+        void skipEmptyDataBlocksForward();
+
+        /**
+         * @brief 向前跳过已经遍历完的data block
+         * 
+         */
+        void skipEmptyDataBlocksBackward();
+
+        /**
+         * @brief data block解析出错时记录错误
+         * 
+         * @return true 出错
+         */
+        bool checkDataBlockCorruption();
+
+        /**
+         * @brief 过滤器说明从target开始到上界之间没有需要的键
+         * 
+         * @param target seek的目标, index迭代器已经定位到它所在的data block
+         */
+        bool seekExcluded(const std::string& target) const;
+    private:
+        std::shared_ptr<const SSTable> table_;
+        const TableIteratorOptions options_;
+
+        /**
+         * @brief 被前缀过滤器排除的seek目标, 没有被排除时为空
+         * 
+         */
+        std::string excluded_target_;
+        IndexIterator index_iter_;
+        std::shared_ptr<Block> data_block_;
+        std::unique_ptr<Block::Iterator> data_iter_;
+        OperatorResult status_;
+    };
+public:
+    /**
+     * @brief 打开SSTable, 读取footer与index block
+     * 
+     * @param file 文件
+     * @param file_size 文件大小
+     * @param table [out] 打开的SSTable
+     * @param block_cache 缓存解压后的data block, 为空时每次都从文件读取
+     * @return OperatorResult 
+     */
+    static OperatorResult open(std::shared_ptr<RandomAccessFile> file, uint64_t file_size,
+                               std::shared_ptr<SSTable>& table, BlockCache* block_cache = nullptr);
+
+    SSTable(const SSTable&) = delete;
+    SSTable& operator=(const SSTable&) = delete;
+
+    /**
+     * @brief 点查
+     * 
+     * @param lookup_key encodeLookupKey得到的查找键
+     * @param result [out] 查找结果
+     * @return OperatorResult 
+     */
+    OperatorResult get(const std::string& lookup_key, LookupResult& result) const;
+
+    /**
+     * @brief 批量点查: 先按data block给查找键分组, 每个data block只读取一次, 
+     *        不同data block的读取与查找在线程池中并行执行
+     * 
+     * @param lookup_keys 升序排列的查找键
+     * @param results [out] 与lookup_keys一一对应的查找结果, 大小需与lookup_keys相同
+     * @param pool 线程池, 为空时在当前线程依次查找
+     * @return OperatorResult 
+     */
+    OperatorResult multiGet(const std::vector<std::string>& lookup_keys,
+                            std::vector<LookupResult>& results, ThreadPool* pool) const;
+
+    /**
+     * @brief 读取一个block, 校验trailer中的crc并解压
+     * 
+     * @param handle block的位置
+     * @param block [out] 读到的block
+     * @return OperatorResult 
+     */
+    OperatorResult readBlock(const BlockHandle& handle, std::shared_ptr<Block>& block) const;
+
+    /**
+     * @brief 读取一个data block, 先查找block缓存
+     * 
+     * @param handle block的位置
+     * @param block [out] 读到的block
+     * @param fill_cache 缓存中没有时是否放入缓存
+     * @return OperatorResult 
+     */
+    OperatorResult readDataBlock(const BlockHandle& handle, std::shared_ptr<Block>& block, bool fill_cache) const;
+
+    /**
+     * @brief 表内所有的范围删除标记, 打开时一次性读入内存
+     * 
+     */
+    const std::vector<RangeTombstone>& getRangeTombstones() const {
+        return range_tombstones_;
+    }
+
+    /**
+     * @brief 表内是否可能有这个前缀的键
+     * 
+     * @param extractor 前缀提取器
+     * @param prefix 前缀
+     * @return true 可能有, 或表内没有这个提取器生成的过滤器; false 一定没有
+     */
+    bool prefixMayMatch(const PrefixExtractor& extractor, const std::string& prefix) const;
+
+    /**
+     * @brief 表内是否可能有落在[begin, end)内的用户键, 不考虑范围删除标记
+     * 
+     * @param begin 起始用户键(包含)
+     * @param end 结束用户键(不包含), 为空时没有上界
+     * @return true 可能有, 或表内没有范围过滤器; false 一定没有
+     */
+    bool rangeMayMatch(const std::string& begin, const std::string& end) const;
+private:
+    SSTable(std::shared_ptr<RandomAccessFile> file, bool block_trailer, BlockCache* block_cache);
+
+    /**
+     * @brief 读取block的原始内容: 有trailer时校验crc并按压缩方式解压
+     * 
+     * @param handle block的位置
+     * @param dict 压缩字典, 只有data block使用
+     * @param contents [out] 解压后的内容
+     * @return OperatorResult 
+     */
+    OperatorResult readBlockContents(const BlockHandle& handle, const std::string& dict, std::string& contents) const;
+
+    /**
+     * @brief 读取一个block, 先查找block缓存; 不检查block是否为键值对格式
+     * 
+     * @param handle block的位置
+     * @param dict 压缩字典
+     * @param fill_cache 缓存中没有时是否放入缓存
+     * @param block [out] 读到的block
+     * @return OperatorResult 
+     */
+    OperatorResult readCachedBlock(const BlockHandle& handle, const std::string& dict, bool fill_cache,
+                                   std::shared_ptr<Block>& block) const;
+
+    /**
+     * @brief 读取metaindex block以及它指向的meta block
+     * 
+     * @param handle metaindex block的位置
+     * @return OperatorResult 
+     */
+    OperatorResult readMetaBlocks(const BlockHandle& handle);
+
+    /**
+     * @brief 读取范围删除block
+     * 
+     */
+    OperatorResult readRangeDelBlock(const BlockHandle& handle);
+
+    /**
+     * @brief 文件映射到内存时读取布谷鸟哈希索引并校验crc, 之后直接在映射中查找
+     * 
+     * @param handle block的位置
+     * @param limit block之后的meta block的偏移量, block不能越过它
+     */
+    OperatorResult readCuckooIndexBlock(const BlockHandle& handle, uint64_t limit);
+
+    /**
+     * @brief 文件映射到内存时, data block改为直接引用映射中的内容
+     * 
+     * @param limit metaindex block的偏移量, data block不能越过它
+     */
+    void enablePlainTable(uint64_t limit);
+
+    /**
+     * @brief 通过布谷鸟哈希索引点查, 直接解析文件映射中用户键的第一个版本
+     * 
+     * @param lookup_key 查找键
+     * @param result [out] 查找结果
+     * @param finished [out] 查找是否结束; 第一个版本对查找键不可见或是合并操作数时需要按block格式查找
+     * @return OperatorResult 
+     */
+    OperatorResult getFromHashIndex(const std::string& lookup_key, LookupResult& result, bool& finished) const;
+
+    /**
+     * @brief 读取学习索引block
+     * 
+     * @param handle block的位置
+     */
+    OperatorResult readLearnedIndexBlock(const BlockHandle& handle);
+
+    /**
+     * @brief 读取前缀过滤器block
+     * 
+     * @param handle block的位置
+     * @param extractor_name 生成过滤器的前缀提取器的名字
+     */
+    OperatorResult readPrefixFilterBlock(const BlockHandle& handle, std::string extractor_name);
+
+    /**
+     * @brief data block中是否可能有这个前缀的键
+     * 
+     * @param extractor 前缀提取器
+     * @param block_offset data block的起始偏移量
+     * @param block_last_key data block的最后一个键, 用于找到过滤器分区
+     * @param prefix 前缀
+     */
+    bool blockPrefixMayMatch(const PrefixExtractor& extractor, uint64_t block_offset, 
+                             const std::string& block_last_key, const std::string& prefix) const;
+
+    /**
+     * @brief 在第一个最后一个键不小于key的过滤器分区中检查前缀
+     * 
+     * @param key 内部键
+     * @param block_offset 为空时检查整个分区, 否则检查起始于它的data block
+     * @param prefix 前缀
+     */
+    bool partitionPrefixMayMatch(const std::string& key, const uint64_t* block_offset, 
+                                 const std::string& prefix) const;
+
+    /**
+     * @brief 表内遮住user_key的范围删除标记中最大的序列号
+     * 
+     * @param user_key 用户键
+     * @param seq 只考虑序列号不大于seq的标记
+     * @return uint64_t 没有时返回0
+     */
+    uint64_t getMaxCoveringTombstoneSeq(const std::string& user_key, uint64_t seq) const;
+
+    /**
+     * @brief 没有找到可见版本时用表内的范围删除标记修正查找结果
+     * 
+     * @param lookup_key 查找键
+     * @param result [in/out] 查找结果
+     */
+    void finishLookup(const std::string& lookup_key, LookupResult& result) const;
+
+    /**
+     * @brief 从查找键所在的data block开始依次查找后续的data block, 用于合并操作数跨越data block的键
+     * 
+     * @param lookup_key 查找键
+     * @param result [out] 查找结果
+     * @return OperatorResult 
+     */
+    OperatorResult searchAcrossBlocks(const std::string& lookup_key, LookupResult& result) const;
+
+    /**
+     * @brief 在一个data block中依次查找一组键
+     * 
+     * @param handle data block的位置
+     * @param lookup_keys 所有查找键
+     * @param indexes 落在这个data block中的查找键下标
+     * @param results [out] 查找结果
+     * @param unfinished [out] 查到block末尾仍没有结束的查找键置为1
+     * @return OperatorResult 
+     */
+    OperatorResult searchBlock(const BlockHandle& handle,
+                               const std::vector<std::string>& lookup_keys,
+                               const std::vector<size_t>& indexes,
+                               std::vector<LookupResult>& results,
+                               std::vector<char>& unfinished) const;
+
+    /**
+     * @brief 在线程池中并行地查找每一组data block
+     * 
+     */
+    OperatorResult searchBlocksInParallel(const std::vector<BlockHandle>& handles,
+                                          const std::vector<std::vector<size_t>>& groups,
+                                          const std::vector<std::string>& lookup_keys,
+                                          std::vector<LookupResult>& results, std::vector<char>& unfinished,
+                                          ThreadPool* pool) const;
+private:
+    std::shared_ptr<RandomAccessFile> file_;
+
+    /**
+     * @brief block之后是否有trailer, 见table_format.h
+     * 
+     */
+    const bool block_trailer_;
+
+    /**
+     * @brief block缓存与这个表在缓存中的编号, 缓存为空时不使用
+     * 
+     */
+    BlockCache* block_cache_;
+    const uint64_t cache_id_;
+    std::shared_ptr<Block> index_block_;
+    std::vector<RangeTombstone> range_tombstones_;
+
+    /**
+     * @brief 压缩data block时使用的字典, 打开时读入, 随SSTable缓存在TableCache中; 没有时为空
+     * 
+     */
+    std::string compression_dict_;
+
+    /**
+     * @brief 前缀过滤器及生成它的前缀提取器的名字, 没有过滤器时为空
+     * 
+     */
+    std::unique_ptr<FilterBlockReader> prefix_filter_;
+    std::string prefix_filter_name_;
+
+    /**
+     * @brief index是否分区, 以及分区的前缀过滤器的顶层索引, 格式见table_format.h
+     * 
+     */
+    bool partitioned_index_;
+    std::shared_ptr<Block> filter_index_;
+
+    /**
+     * @brief 学习索引, 查找index block时先预测位置, 没有时为空
+     * 
+     */
+    std::unique_ptr<LearnedIndexReader> learned_index_;
+
+    /**
+     * @brief 布谷鸟哈希索引, 以及它指向的键值对所在的文件映射与范围[0, mapped_limit_); 
+     *        文件没有映射到内存时为空, 点查按block格式进行
+     * 
+     */
+    std::unique_ptr<CuckooIndexReader> cuckoo_index_;
+    const char* mapped_data_;
+    uint64_t mapped_limit_;
+
+    /**
+     * @brief PLAIN_TABLE格式且文件映射到内存时为true, data block直接引用[0, mapped_limit_)中的内容
+     * 
+     */
+    bool plain_table_;
+
+    /**
+     * @brief 范围过滤器, 格式见table_format.h, 没有时为空
+     * 
+     */
+    std::shared_ptr<Block> range_filter_;
+};
+
+}
+
+#endif
@@ -1,18 +1,36 @@
 /*
  * @Author: Tomato
  * @Date: 2022-01-05 23:14:28
- * @LastEditTime: 2023-02-02 21:16:30
+ * @LastEditTime: 2026-10-18 23:42:59
  */
 #ifndef TOMATO_DB_DB_INCLUDE_TOMATO_SSTABLE_BUILDER_H
 #define TOMATO_DB_DB_INCLUDE_TOMATO_SSTABLE_BUILDER_H
 
+#include <tomato_db/cuckoo_index.h>
+#include <tomato_db/filter_block.h>
+#include <tomato_db/learned_index.h>
 #include <tomato_db/table_meta.h>
+#include <tomato_db/table_format.h>
 #include <tomato_common/io.h>
+#include <tomato_common/thread_pool.h>
 
+#include <deque>
+#include <future>
+#include <memory>
+#include <utility>
 #include <vector>
 
 namespace tomato {
 
+/**
+ * @brief block格式: 键值对 + 各组起始偏移量(定长32位) + 组数(定长32位), 
+ *        每组第一个键完整保存, 组内其余键只保存与前一个键不同的部分;
+ *        开启哈希索引的data block在组偏移量之后追加: 桶(每个1字节, 为用户键所在组的下标) + 桶数(定长32位),
+ *        组数的最高位置1;
+ *        开启变长标签的data block中键值对为[共享长度][非共享长度][值长度][用户键非共享部分][标签(变长)][值],
+ *        共享部分只在用户键之间计算, 组数的次高位置1
+ * 
+ */
 class BlockBuilder {
 public:
     BlockBuilder(const TableConfig&);
@@ -28,6 +46,13 @@ public:
      */
     void add(const std::string&key, const std::string& value);
 
+    /**
+     * @brief 追加各组的起始偏移量, 结束当前block, 之后只能调用reset
+     * 
+     * @return const std::string& block的完整内容
+     */
+    const std::string& finish();
+
     /**
      * @brief 重置数据
      * 
@@ -41,7 +66,38 @@ public:
      */
     const std::string& getContent();
 
+    /**
+     * @brief block结束后的字节数
+     * 
+     * @return size_t 
+     */
     size_t getBlockSize();
+
+    /**
+     * @brief 是否没有添加过键值对
+     * 
+     */
+    bool empty() const {
+        return contents_.empty();
+    }
+
+    /**
+     * @brief 为内部键的block生成哈希索引
+     * 
+     * @param ratio 桶利用率(键数 / 桶数), 0表示不生成
+     */
+    void enableHashIndex(double ratio) {
+        hash_ratio_ = ratio;
+    }
+
+    /**
+     * @brief 内部键的标签(序列号与类型)按变长编码保存, 序列号为0时只占1个字节; 
+     *        只能用于所有键都是内部键的block, 需要在添加键值对之前调用
+     * 
+     */
+    void enableVarintTag() {
+        varint_tag_ = true;
+    }
 private:
     /**
      * @brief 所有的键值对内容
@@ -72,8 +128,31 @@ private:
      * 
      */
     int current_group_size_;
+
+    /**
+     * @brief 是否已经调用过finish
+     * 
+     */
+    bool finished_;
+
+    /**
+     * @brief 哈希索引的桶利用率, 以及每个键的用户键哈希值与所在组的下标
+     * 
+     */
+    double hash_ratio_;
+    std::vector<std::pair<uint32_t, uint32_t>> hash_entries_;
+
+    /**
+     * @brief 标签是否按变长编码保存
+     * 
+     */
+    bool varint_tag_;
 };
 
+/**
+ * @brief 把有序的键值对写成SSTable文件, 格式见table_format.h
+ * 
+ */
 class SSTableBuilder {
 public:
     SSTableBuilder(const TableConfig&, AppendOnlyFile* file);
@@ -81,14 +160,282 @@ public:
     SSTableBuilder(const SSTableBuilder&) = delete;
     SSTableBuilder& operator=(const SSTableBuilder&) = delete;
 
+    /**
+     * @brief 添加一个键值对, 键必须按内部键升序添加
+     * 
+     * @param key 内部键
+     * @param value 值
+     */
     void add(const std::string&key, const std::string& value);
-    
+
+    /**
+     * @brief 添加一个范围删除标记, 与点数据分开保存在范围删除block中, 不要求有序
+     * 
+     * @param tombstone 范围删除标记
+     */
+    void addRangeTombstone(const RangeTombstone& tombstone);
+
+    /**
+     * @brief 写入剩余的data block、过滤器block、范围删除block、index block与footer, 不负责同步和关闭文件
+     * 
+     * @return OperatorResult 构建过程中第一个写入错误
+     */
+    OperatorResult finish();
+
+    /**
+     * @brief 已经写入文件的字节数加上等待训练字典与正在压缩的data block的字节数, finish后即为文件大小
+     * 
+     */
+    uint64_t getFileSize() const {
+        return offset_ + buffered_bytes_ + pending_bytes_;
+    }
+
+    /**
+     * @brief 添加过的键值对个数
+     * 
+     */
+    uint64_t getEntryCount() const {
+        return entry_count_;
+    }
+
+    /**
+     * @brief 添加过的范围删除标记个数
+     * 
+     */
+    uint64_t getRangeTombstoneCount() const {
+        return range_tombstone_count_;
+    }
+private:
+    /**
+     * @brief 压缩后的block内容与trailer, compressed为false时按原始内容写入
+     * 
+     */
+    struct EncodedBlock {
+        std::string contents;
+        std::string trailer;
+        bool compressed = false;
+    };
+
+    /**
+     * @brief 压缩block并计算trailer, 压缩后没有变小1/8以上时使用原始内容; 不访问成员, 可以在任意线程上执行
+     * 
+     * @param compression 压缩方式
+     * @param contents block内容
+     * @param dict 压缩字典, 为空时不使用字典
+     * @param block [out] 压缩结果
+     */
+    static void encodeBlock(CompressionType compression, const std::string& contents, const std::string& dict,
+                            EncodedBlock& block);
+
+    /**
+     * @brief 结束当前data block并写入文件, 在index block中记录它的最后一个键; 
+     *        等待训练字典时先缓存在内存中
+     * 
+     */
+    void flushDataBlock();
+
+    /**
+     * @brief 写入一个data block, 更新index block与过滤器; 并行压缩时只提交压缩任务, 由writePendingBlock按顺序写入
+     * 
+     * @param contents block的完整内容
+     * @param last_key block中的最后一个键
+     * @param prefixes 延后加入前缀过滤器的前缀, 在写入这个block之前加入
+     */
+    void writeDataBlock(const std::string& contents, const std::string& last_key, 
+                        std::vector<std::string> prefixes);
+
+    /**
+     * @brief 等待最早提交的data block压缩完成并写入文件
+     * 
+     */
+    void writePendingBlock();
+
+    /**
+     * @brief data block写入文件后, 在index block、学习索引与过滤器中记录它
+     * 
+     * @param handle block在文件中的位置
+     * @param last_key block中的最后一个键
+     */
+    void addDataBlockHandle(const BlockHandle& handle, const std::string& last_key);
+
+    /**
+     * @brief 用缓存的data block训练字典, 然后依次写入它们
+     * 
+     */
+    void trainDictionary();
+
+    /**
+     * @brief 写入当前的index分区与过滤器分区, 在顶层索引中记录它们
+     * 
+     * @param last_key 分区中的最后一个键
+     */
+    void flushIndexPartition(const std::string& last_key);
+
+    /**
+     * @brief 结束一个block并写入文件
+     * 
+     * @param builder block
+     * @param handle [out] block在文件中的位置
+     */
+    void writeBlock(BlockBuilder& builder, BlockHandle& handle);
+
+    /**
+     * @brief 压缩block内容后写入文件, 压缩后没有变小1/8以上时按原样写入
+     * 
+     * @param contents block内容
+     * @param dict 压缩字典, 为空时不使用字典
+     * @param handle [out] block在文件中的位置
+     */
+    void writeBlockContents(const std::string& contents, const std::string& dict, BlockHandle& handle);
+
+    /**
+     * @brief 写入block内容与trailer
+     * 
+     * @param contents 压缩后(或原始)的内容
+     * @param type 压缩方式
+     * @param handle [out] block在文件中的位置
+     */
+    void writeRawBlock(const std::string& contents, CompressionType type, BlockHandle& handle);
+
+    /**
+     * @brief 写入block内容与已经算好的trailer
+     * 
+     */
+    void writeEncodedBlock(const std::string& contents, const std::string& trailer, BlockHandle& handle);
+
+    /**
+     * @brief 把用户键的截断键加入范围过滤器, 截断长度需要等到下一个用户键才能确定
+     * 
+     * @param user_key 下一个用户键, 为空指针时结束
+     */
+    void addRangeFilterKey(const std::string* user_key);
+
+    /**
+     * @brief 写入meta block并在metaindex block中记录它的位置
+     * 
+     */
+    void writeMetaBlock(const std::string& name, const std::string& contents, BlockBuilder& metaindex_builder);
 private:
     BlockBuilder data_block_builder_;
     BlockBuilder index_builder_;
+    BlockBuilder range_del_builder_;
+
+    /**
+     * @brief 设置了前缀提取器时记录每个data block中的前缀
+     * 
+     */
+    std::shared_ptr<const PrefixExtractor> prefix_extractor_;
+    std::unique_ptr<FilterBlockBuilder> filter_builder_;
+    const int filter_bits_per_key_;
+
+    /**
+     * @brief index分区: index_builder_为当前分区, 写满后在顶层index中记录它的最后一个键;
+     *        前缀过滤器随index一起分区, filter_base_为当前过滤器分区中第一个data block的偏移量
+     * 
+     */
+    const bool partition_index_;
+    const uint64_t index_partition_size_;
+    BlockBuilder top_index_builder_;
+    BlockBuilder filter_index_builder_;
+    uint64_t filter_base_;
+    uint64_t index_partition_count_;
+
+    /**
+     * @brief 学习索引, 记录每个data block的最后一个用户键, index分区时为空
+     * 
+     */
+    std::unique_ptr<LearnedIndexBuilder> learned_index_builder_;
+
+    /**
+     * @brief 布谷鸟哈希索引, 以及当前data block中每个用户键的第一个版本与它在block中的偏移量;
+     *        block写入后才知道文件中的偏移量, 不是布谷鸟哈希格式时为空
+     * 
+     */
+    std::unique_ptr<CuckooIndexBuilder> cuckoo_builder_;
+    std::vector<std::pair<std::string, uint64_t>> cuckoo_pending_keys_;
+
+    /**
+     * @brief 范围过滤器, 以及还没有确定截断长度的上一个用户键与它和更前一个用户键的公共前缀长度
+     * 
+     */
+    bool range_filter_;
+    BlockBuilder range_filter_builder_;
+    std::string pending_user_key_;
+    size_t pending_shared_;
+    bool has_pending_user_key_;
     AppendOnlyFile* file_;
     uint64_t offset_;
     uint64_t block_threshold_;
+
+    /**
+     * @brief 是否为PLAIN_TABLE格式, 是时所有block都不压缩
+     * 
+     */
+    const bool plain_table_;
+
+    /**
+     * @brief block的压缩方式与串行压缩用的缓冲区
+     * 
+     */
+    CompressionType compression_;
+    EncodedBlock encoded_;
+
+    /**
+     * @brief 等待训练字典的data block, 以及它们的最后一个键与要加入前缀过滤器的前缀;
+     *        过滤器按data block的偏移量划分, 需要等到写入时才能添加
+     * 
+     */
+    struct BufferedBlock {
+        std::string contents;
+        std::string last_key;
+        std::vector<std::string> prefixes;
+    };
+
+    /**
+     * @brief 字典的最大字节数与训练前缓存的字节数, 训练得到的字典; 
+     *        buffering_为true时data block先缓存在buffered_blocks_中
+     * 
+     */
+    uint64_t dict_bytes_;
+    uint64_t dict_sample_bytes_;
+    std::string compression_dict_;
+    bool buffering_;
+    std::vector<BufferedBlock> buffered_blocks_;
+    std::vector<std::string> buffered_prefixes_;
+    uint64_t buffered_bytes_;
+
+    /**
+     * @brief 正在压缩的data block, 按提交顺序排列; 前缀在写入时才加入过滤器
+     * 
+     */
+    struct PendingBlock {
+        std::future<EncodedBlock> encoded;
+        std::string last_key;
+        std::vector<std::string> prefixes;
+        uint64_t size;
+    };
+    std::deque<PendingBlock> pending_blocks_;
+    uint64_t pending_bytes_;
+
+    /**
+     * @brief 最后一个被添加的键
+     * 
+     */
+    std::string last_key_;
+    uint64_t entry_count_;
+    uint64_t range_tombstone_count_;
+
+    /**
+     * @brief 第一个写入错误
+     * 
+     */
+    OperatorResult status_;
+
+    /**
+     * @brief 并行压缩data block的线程池, 最后声明, 析构时先等待压缩任务结束, 它们引用compression_dict_
+     * 
+     */
+    std::unique_ptr<ThreadPool> compression_pool_;
 };
 
 
@@ -0,0 +1,60 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 18:10:27
+ * @LastEditTime: 2026-10-18 22:47:45
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_TABLE_CACHE_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_TABLE_CACHE_H
+
+#include <tomato_db/sstable.h>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace tomato {
+
+/**
+ * @brief 缓存已经打开的SSTable, 避免每次读取都重新解析footer与index block
+ * 
+ */
+class TableCache {
+public:
+    /**
+     * @brief 构造
+     * 
+     * @param db_path 数据库目录
+     * @param block_cache 打开的SSTable共用的block缓存, 可以为空
+     */
+    TableCache(std::string db_path, BlockCache* block_cache);
+    TableCache(const TableCache&) = delete;
+    TableCache& operator=(const TableCache&) = delete;
+
+    /**
+     * @brief 获取SSTable, 未打开时打开并缓存
+     * 
+     * @param number 文件编号
+     * @param file_size 文件大小
+     * @param table [out] SSTable
+     * @return OperatorResult 
+     */
+    OperatorResult findTable(uint64_t number, uint64_t file_size, std::shared_ptr<SSTable>& table);
+
+    /**
+     * @brief 文件被删除时移出缓存
+     * 
+     * @param number 文件编号
+     */
+    void evict(uint64_t number);
+private:
+    const std::string db_path_;
+    BlockCache* block_cache_;
+    std::mutex mutex_;
+    std::unordered_map<uint64_t, std::shared_ptr<SSTable>> tables_;
+};
+
+}
+
+#endif
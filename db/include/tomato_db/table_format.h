@@ -0,0 +1,182 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 16:55:02
+ * @LastEditTime: 2026-10-18 23:25:42
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_TABLE_FORMAT_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_TABLE_FORMAT_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+namespace tomato {
+
+/**
+ * @brief SSTable文件格式:
+ *        [data block 1]...[data block n][meta block 1]...[meta block m][metaindex block][index block][footer]
+ *        index block记录每个data block的最后一个键及其位置, metaindex block记录每个meta block的名字及其位置;
+ *        每个block之后跟着定长的trailer: [压缩方式(1字节)][block内容与压缩方式的crc32(定长32位)],
+ *        BlockHandle中的字节数不包含trailer
+ * 
+ */
+
+/**
+ * @brief block之后trailer的字节数
+ * 
+ */
+static const size_t BLOCK_TRAILER_SIZE = 5;
+
+/**
+ * @brief block在文件中的位置
+ * 
+ */
+struct BlockHandle {
+    /**
+     * @brief 起始偏移量
+     * 
+     */
+    uint64_t offset = 0;
+
+    /**
+     * @brief block的字节数
+     * 
+     */
+    uint64_t size = 0;
+
+    /**
+     * @brief 编码: 偏移量(变长) + 字节数(变长)
+     * 
+     * @param output [out] 追加到output末尾
+     */
+    void encodeTo(std::string& output) const;
+
+    /**
+     * @brief 从[begin, end)中解码, 成功时begin指向已解码部分的末尾
+     * 
+     * @return true 解码成功; false 数据不完整
+     */
+    bool decodeFrom(const char*& begin, const char* end);
+
+    /**
+     * @brief 从字符串中解码
+     * 
+     * @return true 解码成功; false 数据不完整
+     */
+    bool decodeFrom(const std::string& input);
+
+    /**
+     * @brief 编码后的最大长度
+     * 
+     */
+    static const size_t MAX_ENCODED_LENGTH = 10 + 10;
+};
+
+/**
+ * @brief 文件末尾的定长结构
+ * 
+ */
+struct Footer {
+    BlockHandle metaindex_handle;
+    BlockHandle index_handle;
+
+    /**
+     * @brief block之后是否有trailer, 旧格式的文件没有trailer, 用不同的魔数区分
+     * 
+     */
+    bool block_trailer = true;
+
+    /**
+     * @brief 编码: metaindex handle + index handle + 填充 + 魔数(定长64位)
+     * 
+     * @param output [out] 追加到output末尾
+     */
+    void encodeTo(std::string& output) const;
+
+    /**
+     * @brief 从文件末尾ENCODED_LENGTH字节中解码
+     * 
+     * @return true 解码成功; false 魔数不匹配或数据不完整
+     */
+    bool decodeFrom(const std::string& input);
+
+    static const size_t ENCODED_LENGTH = 2 * BlockHandle::MAX_ENCODED_LENGTH + 8;
+};
+
+/**
+ * @brief 压缩字典所在的meta block在metaindex block中的名字, 字典本身不使用字典压缩;
+ *        有这个meta block时所有的data block都用它压缩
+ * 
+ */
+static const char* const COMPRESSION_DICT_BLOCK_NAME = "tomato.compression_dict";
+
+/**
+ * @brief 范围删除标记所在的meta block在metaindex block中的名字,
+ *        block中每一项的键为内部键(范围起点, 序列号, RANGE_DELETION), 值为范围终点
+ * 
+ */
+static const char* const RANGE_DEL_BLOCK_NAME = "tomato.range_del";
+
+/**
+ * @brief 有这个meta block时index block是分区的: footer中的index handle指向顶层index,
+ *        顶层index中每一项的键为分区的最后一个键, 值为分区的位置; meta block的内容为分区数(变长)
+ * 
+ */
+static const char* const INDEX_PARTITIONS_BLOCK_NAME = "tomato.index_partitions";
+
+/**
+ * @brief 布谷鸟哈希索引所在的meta block在metaindex block中的名字, 格式见cuckoo_index.h;
+ *        block不压缩, 起始偏移量按缓存行对齐
+ * 
+ */
+static const char* const CUCKOO_INDEX_BLOCK_NAME = "tomato.cuckoo_index";
+
+/**
+ * @brief 学习索引所在的meta block在metaindex block中的名字, 格式见learned_index.h
+ * 
+ */
+static const char* const LEARNED_INDEX_BLOCK_NAME = "tomato.learned_index";
+
+/**
+ * @brief 分区的前缀过滤器的顶层索引在metaindex block中的名字为这个前缀加上前缀提取器的名字:
+ *        每一项的键与顶层index相同, 值为过滤器分区的位置 + 分区中第一个data block的偏移量(变长);
+ *        过滤器分区的格式见filter_block.h, 其中的data block偏移量相对于分区中第一个data block
+ * 
+ */
+static const char* const PARTITIONED_PREFIX_FILTER_BLOCK_PREFIX = "tomato.partitioned_prefix_filter.";
+
+/**
+ * @brief 内容为空的meta block, 表示文件为PLAIN_TABLE格式, 所有的data block都不压缩
+ * 
+ */
+static const char* const PLAIN_TABLE_BLOCK_NAME = "tomato.plain_table";
+
+/**
+ * @brief 前缀过滤器所在的meta block在metaindex block中的名字为这个前缀加上前缀提取器的名字, 格式见filter_block.h
+ * 
+ */
+static const char* const PREFIX_FILTER_BLOCK_PREFIX = "tomato.prefix_filter.";
+
+/**
+ * @brief 范围过滤器所在的meta block在metaindex block中的名字: 
+ *        按升序保存每个用户键区别于相邻用户键的最短前缀(截断的trie), 值为空;
+ *        用户键一定以它的截断键开头, 查询范围时不会漏掉存在的键
+ * 
+ */
+static const char* const RANGE_FILTER_BLOCK_NAME = "tomato.range_filter";
+
+/**
+ * @brief SSTable魔数
+ * 
+ */
+static const uint64_t TABLE_MAGIC_NUMBER = 0x746f6d61746f6463ull;
+
+/**
+ * @brief block没有trailer的旧格式SSTable的魔数, 只用于读取
+ * 
+ */
+static const uint64_t LEGACY_TABLE_MAGIC_NUMBER = 0x746f6d61746f6462ull;
+
+}
+
+#endif
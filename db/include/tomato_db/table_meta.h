@@ -1,20 +1,155 @@
 /*
  * @Author: Tomato
  * @Date: 2021-12-27 22:17:45
- * @LastEditTime: 2022-11-24 10:37:30
+ * @LastEditTime: 2026-10-18 23:42:59
  */
 #ifndef TOMATO_DB_DB_INCLUDE_TOMATO_DATA_H
 #define TOMATO_DB_DB_INCLUDE_TOMATO_DATA_H
 
+#include <tomato_db/prefix_extractor.h>
 
 #include <cstdint>
 #include <cstddef>
+#include <memory>
+#include <string>
 
 namespace tomato {
 
+/**
+ * @brief SSTable的格式
+ * 
+ */
+enum TableFormat {
+    /**
+     * @brief data block + index block
+     * 
+     */
+    BLOCK_BASED_TABLE = 0x0,
+    /**
+     * @brief 在block格式之外带有布谷鸟哈希索引, 用于只点查不遍历的数据:
+     *        data block不压缩, 每个键值对都从组的起点开始; 哈希索引记录每个用户键的第一个版本在文件中的偏移量,
+     *        文件映射到内存时点查最多访问两个缓存行, 不解析index block与data block; 遍历与合并仍按block格式进行
+     * 
+     */
+    CUCKOO_HASH_TABLE = 0x1,
+    /**
+     * @brief 在block格式之外不压缩任何data block, 用于tmpfs等内存中的部署:
+     *        文件映射到内存时data block直接引用映射的内存, 不经过block cache也不复制;
+     *        index block在打开时读入内存, 作为稀疏的前缀索引
+     * 
+     */
+    PLAIN_TABLE = 0x2,
+};
+
+/**
+ * @brief block的压缩方式, 写在每个block之后的类型字节中
+ * 
+ */
+enum CompressionType {
+    /**
+     * @brief 不压缩, 压缩后没有明显变小的block也按原样保存
+     * 
+     */
+    NO_COMPRESSION = 0x0,
+    /**
+     * @brief 内置的LZ压缩(tomato_common/lz.h), 总是可用
+     * 
+     */
+    LZ_COMPRESSION = 0x1,
+    /**
+     * @brief 编译时找到系统的zstd或lz4库才可用, 不可用时写入使用内置的LZ压缩
+     * 
+     */
+    ZSTD_COMPRESSION = 0x2,
+    LZ4_COMPRESSION = 0x3,
+};
+
 struct TableConfig {
     uint64_t block_size_threshold = 4096;
     int block_group_size = 16;
+
+    /**
+     * @brief 前缀提取器, 设置后每个SSTable带有前缀布隆过滤器, 支持前缀查找
+     * 
+     */
+    std::shared_ptr<const PrefixExtractor> prefix_extractor;
+
+    /**
+     * @brief 前缀布隆过滤器中每个前缀占用的位数
+     * 
+     */
+    int filter_bits_per_key = 10;
+
+    /**
+     * @brief 是否为每个SSTable生成范围过滤器, 有上界的遍历用它跳过范围内没有键的SSTable
+     * 
+     */
+    bool range_filter = false;
+
+    /**
+     * @brief SSTable的格式, 整个数据库使用同一种格式写入, 读取时按文件内容识别
+     * 
+     */
+    TableFormat format = TableFormat::BLOCK_BASED_TABLE;
+
+    /**
+     * @brief block的压缩方式
+     * 
+     */
+    CompressionType compression = CompressionType::LZ_COMPRESSION;
+
+    /**
+     * @brief 每个SSTable训练的压缩字典的最大字节数, 0表示不使用字典; 
+     *        内置的LZ压缩只能引用字典末尾的64KB
+     * 
+     */
+    uint64_t compression_dict_bytes = 0;
+
+    /**
+     * @brief 训练字典前缓存的data block字节数, 这些block作为样本, 训练后与之后的data block一起用字典压缩
+     * 
+     */
+    uint64_t compression_dict_sample_bytes = 1 << 20;
+
+    /**
+     * @brief 每个SSTable并行压缩data block的线程数, 0表示在添加键值对的线程上压缩; 
+     *        压缩与校验在线程池中进行, 写入文件与记录index仍按block的顺序进行, 写出的文件与串行压缩相同
+     * 
+     */
+    size_t compression_threads = 0;
+
+    /**
+     * @brief data block哈希索引的桶利用率(键数 / 桶数), 0表示不生成; 
+     *        点查通过哈希索引直接定位到用户键所在的组, 不再二分查找
+     * 
+     */
+    double data_block_hash_ratio = 0;
+
+    /**
+     * @brief 是否把index block与前缀过滤器分区: 顶层index只记录每个分区的最后一个键,
+     *        读取时只通过block缓存加载用到的分区, 打开很大的SSTable时不必读入整个index与过滤器
+     * 
+     */
+    bool partition_index = false;
+
+    /**
+     * @brief index分区的目标字节数
+     * 
+     */
+    uint64_t index_partition_size = 4096;
+
+    /**
+     * @brief 是否生成学习索引: 用分段线性函数拟合用户键到data block序号的映射,
+     *        查找index block时只在预测位置附近的几项中二分; index分区时不生成
+     * 
+     */
+    bool learned_index = false;
+
+    /**
+     * @brief 学习索引在拟合点上的最大误差(data block个数)
+     * 
+     */
+    uint32_t learned_index_error = 2;
 };
 
 enum ItemType {
@@ -28,6 +163,32 @@ enum ItemType {
      * 
      */
     DELETION = 0x1,
+    /**
+     * @brief 范围删除: 键为范围起点(包含), 值为范围终点(不包含), 
+     *        遮住范围内所有序列号更小的版本
+     * 
+     */
+    RANGE_DELETION = 0x2,
+    /**
+     * @brief 合并操作数: 写入时不读取旧值, 读取、刷写与合并时由合并算子与更旧的版本合并
+     * 
+     */
+    MERGE = 0x3,
+    /**
+     * @brief 值在blob文件中的位置(BlobIndex), 只出现在SSTable中, 读取时从blob文件取出值
+     * 
+     */
+    BLOB_INDEX = 0x4,
+};
+
+/**
+ * @brief 范围删除标记, 删除[begin, end)内所有序列号小于seq的版本
+ * 
+ */
+struct RangeTombstone {
+    std::string begin;
+    std::string end;
+    uint64_t seq;
 };
 
 /**
@@ -100,6 +261,92 @@ struct TableItemComparator {
     int operator()(const TableItem& v1, const TableItem& v2) const;
 };
 
+/**
+ * @brief 序列号的最大值, 序列号与类型一起打包成64位的tag, 序列号占高56位
+ * 
+ */
+static const uint64_t MAX_SEQUENCE = (static_cast<uint64_t>(1) << 56) - 1;
+
+/**
+ * @brief 内部键: 用户键 + tag(定长64位, seq << 8 | type), SSTable中按内部键排序
+ * 
+ */
+struct ParsedInternalKey {
+    std::string user_key;
+    uint64_t seq;
+    ItemType type;
+};
+
+/**
+ * @brief 编码内部键
+ * 
+ * @param user_key 用户键
+ * @param seq 序列号
+ * @param type 类型
+ * @return std::string 
+ */
+std::string encodeInternalKey(const std::string& user_key, uint64_t seq, ItemType type);
+
+/**
+ * @brief 编码用于查找的内部键, 它排在该用户键所有序列号不大于seq的版本之前
+ * 
+ * @param user_key 用户键
+ * @param seq 快照序列号
+ * @return std::string 
+ */
+std::string encodeLookupKey(const std::string& user_key, uint64_t seq);
+
+/**
+ * @brief 编码范围终点的内部键: tag全为1, 排在该用户键所有版本之前, 
+ *        用作SSTable的最大键时表示不包含这个用户键
+ * 
+ * @param user_key 范围终点
+ * @return std::string 
+ */
+std::string encodeRangeEndKey(const std::string& user_key);
+
+/**
+ * @brief 内部键是否为范围终点
+ * 
+ */
+bool isRangeEndKey(const std::string& internal_key);
+
+/**
+ * @brief 解析内部键
+ * 
+ * @param internal_key 内部键
+ * @param result [out] 解析结果
+ * @return true 解析成功; false 内部键格式错误
+ */
+bool parseInternalKey(const std::string& internal_key, ParsedInternalKey& result);
+
+/**
+ * @brief 取出内部键中的用户键
+ * 
+ * @param internal_key 内部键
+ * @return std::string 
+ */
+std::string extractUserKey(const std::string& internal_key);
+
+/**
+ * @brief 键的比较方式
+ * 
+ * @return <0 : a < b; == 0: a == b; >0: a > b;
+ */
+typedef int (*KeyComparator)(const std::string& a, const std::string& b);
+
+/**
+ * @brief 字典序比较
+ * 
+ */
+int compareBytewise(const std::string& a, const std::string& b);
+
+/**
+ * @brief 内部键比较: 用户键升序, 用户键相同时序列号降序
+ * 
+ */
+int compareInternalKey(const std::string& a, const std::string& b);
+
 
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,388 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 18:16:40
+ * @LastEditTime: 2026-10-19 00:43:08
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_VERSION_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_VERSION_H
+
+#include <tomato_common/io.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tomato {
+
+/**
+ * @brief SSTable的层数
+ * 
+ */
+static const int NUM_LEVELS = 7;
+
+/**
+ * @brief SSTable文件的元信息
+ * 
+ */
+struct FileMeta {
+    uint64_t number = 0;
+    uint64_t file_size = 0;
+
+    /**
+     * @brief 最小的内部键
+     * 
+     */
+    std::string smallest;
+
+    /**
+     * @brief 最大的内部键, 为范围终点(encodeRangeEndKey)时不包含该用户键
+     * 
+     */
+    std::string largest;
+
+    /**
+     * @brief 文件中最小与最大的序列号(包括范围删除标记)
+     * 
+     */
+    uint64_t smallest_seq = 0;
+    uint64_t largest_seq = 0;
+};
+
+/**
+ * @brief blob文件的元信息
+ * 
+ */
+struct BlobFileMeta {
+    uint64_t number = 0;
+
+    /**
+     * @brief 文件中所有值的总字节数
+     * 
+     */
+    uint64_t total_bytes = 0;
+
+    /**
+     * @brief 已经不再被SSTable引用的值的总字节数, 达到total_bytes时文件从版本中删除
+     * 
+     */
+    uint64_t garbage_bytes = 0;
+};
+
+/**
+ * @brief 用文件中的一个内部键扩展文件的键范围与序列号范围
+ * 
+ */
+void extendFileRange(FileMeta& file, const std::string& internal_key, uint64_t seq);
+
+/**
+ * @brief 文件的所有键都小于user_key
+ * 
+ */
+bool fileBeforeKey(const FileMeta& file, const std::string& user_key);
+
+/**
+ * @brief 文件的键范围是否包含user_key
+ * 
+ */
+bool fileContainsKey(const FileMeta& file, const std::string& user_key);
+
+/**
+ * @brief 文件的键范围是否与[begin, end]相交, end为空时没有上界
+ * 
+ */
+bool fileOverlapsRange(const FileMeta& file, const std::string& begin, const std::string& end);
+
+/**
+ * @brief 一次合并: 把第level层的inputs[0]与第level+1层的inputs[1]合并后写入第level+1层
+ * 
+ */
+struct Compaction {
+    int level = 0;
+    std::vector<FileMeta> inputs[2];
+
+    /**
+     * @brief 是否为手动合并
+     * 
+     */
+    bool manual = false;
+};
+
+/**
+ * @brief 某一时刻数据库中所有SSTable的集合, 创建后不再修改
+ *        第0层的文件之间键范围可能重叠, 按编号从大到小(从新到旧)排列; 
+ *        其余各层文件之间键范围不重叠, 按最小键升序排列
+ * 
+ */
+class Version {
+public:
+    /**
+     * @brief 按查找顺序(从新到旧)给出键范围包含user_key的文件
+     * 
+     * @param user_key 用户键
+     * @param files [out] 文件
+     */
+    void getOverlappingFiles(const std::string& user_key, std::vector<const FileMeta*>& files) const;
+
+    const std::vector<FileMeta>& getFiles(int level) const {
+        return files_[level];
+    }
+
+    /**
+     * @brief 第level层中与[begin, end]相交的文件, end为空时没有上界
+     * 
+     * @param level 层
+     * @param begin 用户键
+     * @param end 用户键
+     * @param files [out] 文件
+     */
+    void getOverlappingInputs(int level, const std::string& begin, const std::string& end, 
+                              std::vector<FileMeta>& files) const;
+
+    /**
+     * @brief 第level层所有文件的总大小
+     * 
+     */
+    uint64_t getLevelBytes(int level) const;
+
+    /**
+     * @brief 估算使每一层回到上限以内还需要合并写出的字节数: 第0层达到触发文件数时与第1层整体合并,
+     *        其余各层超出上限的部分与下一层按10倍的比例合并, 并累加到下一层
+     * 
+     * @param l0_trigger 第0层触发合并的文件数
+     * @param level_base_bytes 第1层的容量上限
+     */
+    uint64_t estimateCompactionDebt(int l0_trigger, uint64_t level_base_bytes) const;
+
+    /**
+     * @brief 仍有值被引用的blob文件, 按编号升序排列
+     * 
+     */
+    const std::vector<BlobFileMeta>& getBlobFiles() const {
+        return blob_files_;
+    }
+
+    /**
+     * @brief 查找blob文件
+     * 
+     * @return const BlobFileMeta* 不存在时为空指针
+     */
+    const BlobFileMeta* getBlobFile(uint64_t number) const;
+private:
+    friend class VersionSet;
+    std::vector<FileMeta> files_[NUM_LEVELS];
+    std::vector<BlobFileMeta> blob_files_;
+};
+
+/**
+ * @brief 对Version的一次修改
+ * 
+ */
+struct VersionEdit {
+    /**
+     * @brief 编号小于log_number的预写日志中的数据都已写入SSTable
+     * 
+     */
+    bool has_log_number = false;
+    uint64_t log_number = 0;
+
+    bool has_last_sequence = false;
+    uint64_t last_sequence = 0;
+
+    /**
+     * @brief 新增的文件: (层, 文件)
+     * 
+     */
+    std::vector<std::pair<int, FileMeta>> new_files;
+
+    /**
+     * @brief 删除的文件: (层, 文件编号)
+     * 
+     */
+    std::vector<std::pair<int, uint64_t>> deleted_files;
+
+    /**
+     * @brief 新增的blob文件
+     * 
+     */
+    std::vector<BlobFileMeta> new_blob_files;
+
+    /**
+     * @brief blob文件新增的垃圾字节数: (文件编号, 字节数)
+     * 
+     */
+    std::vector<std::pair<uint64_t, uint64_t>> blob_garbage;
+
+    void setLogNumber(uint64_t number) {
+        has_log_number = true;
+        log_number = number;
+    }
+
+    void setLastSequence(uint64_t seq) {
+        has_last_sequence = true;
+        last_sequence = seq;
+    }
+
+    void addFile(int level, const FileMeta& file) {
+        new_files.emplace_back(level, file);
+    }
+
+    void deleteFile(int level, uint64_t number) {
+        deleted_files.emplace_back(level, number);
+    }
+
+    void addBlobFile(const BlobFileMeta& file) {
+        new_blob_files.push_back(file);
+    }
+
+    void addBlobGarbage(uint64_t number, uint64_t bytes) {
+        blob_garbage.emplace_back(number, bytes);
+    }
+};
+
+/**
+ * @brief 管理当前Version与清单文件
+ *        清单文件只有一条带CRC的日志记录, 保存完整的SSTable与blob文件列表、日志编号、下一个文件编号与最大序列号;
+ *        每次修改都先写临时文件再重命名, 重启时读到的总是某一次完整的修改结果
+ * 
+ */
+class VersionSet {
+public:
+    explicit VersionSet(std::string db_path);
+    VersionSet(const VersionSet&) = delete;
+    VersionSet& operator=(const VersionSet&) = delete;
+
+    /**
+     * @brief 读取清单文件, 清单文件不存在时为空数据库
+     * 
+     * @return OperatorResult 
+     */
+    OperatorResult recover();
+
+    /**
+     * @brief 在当前Version上应用修改, 写入清单文件后替换当前Version, 线程安全
+     * 
+     * @param edit 修改
+     * @return OperatorResult 
+     */
+    OperatorResult logAndApply(const VersionEdit& edit);
+
+    /**
+     * @brief 当前Version, 持有期间其中的文件不会被删除
+     * 
+     */
+    std::shared_ptr<const Version> current() const;
+
+    /**
+     * @brief 当前Version与它对应的日志编号, 二者在同一把锁下取得
+     * 
+     * @param log_number 编号小于它的预写日志中的数据都已在返回的Version中
+     */
+    std::shared_ptr<const Version> current(uint64_t& log_number) const;
+
+    /**
+     * @brief 分配一个新的文件编号
+     * 
+     */
+    uint64_t newFileNumber() {
+        return next_file_number_.fetch_add(1);
+    }
+
+    /**
+     * @brief 下一个将要分配的文件编号, 之后分配的编号都不小于它
+     * 
+     */
+    uint64_t getNextFileNumber() const {
+        return next_file_number_.load();
+    }
+
+    /**
+     * @brief 目录中已经存在的文件编号不能再分配
+     * 
+     */
+    void markFileNumberUsed(uint64_t number);
+
+    uint64_t getLogNumber() const;
+    uint64_t getLastSequence() const;
+
+    /**
+     * @brief 选择一次自动合并: 第0层文件数达到l0_trigger, 或第n层总大小超过level_base_bytes * 10^(n-1)
+     * 
+     * @param l0_trigger 第0层文件数阈值
+     * @param level_base_bytes 第1层大小上限
+     * @return std::unique_ptr<Compaction> 不需要合并时为空
+     */
+    std::unique_ptr<Compaction> pickCompaction(int l0_trigger, uint64_t level_base_bytes);
+
+    /**
+     * @brief 选择第level层与[begin, end]相交的文件进行手动合并
+     * 
+     * @return std::unique_ptr<Compaction> 该层没有相交的文件时为空
+     */
+    std::unique_ptr<Compaction> compactRange(int level, const std::string& begin, const std::string& end);
+
+    /**
+     * @brief 所有仍被持有的Version引用的SSTable与blob文件编号, 这些文件不能删除
+     * 
+     * @param numbers [out] 文件编号
+     */
+    void getLiveFiles(std::vector<uint64_t>& numbers);
+private:
+    /**
+     * @brief 补全第level+1层的输入
+     * 
+     */
+    void setupOtherInputs(const Version& version, Compaction& compaction);
+
+    /**
+     * @brief 编码清单文件内容
+     * 
+     */
+    std::string encodeManifest(const Version& version, uint64_t log_number,
+                               uint64_t next_file_number, uint64_t last_sequence) const;
+
+    /**
+     * @brief 解码清单文件内容
+     * 
+     * @return true 成功; false 格式错误
+     */
+    bool decodeManifest(const std::string& record, Version& version);
+
+    /**
+     * @brief 先写临时文件并落盘, 再重命名为清单文件
+     * 
+     */
+    OperatorResult writeManifest(const std::string& record);
+private:
+    const std::string db_path_;
+
+    /**
+     * @brief 串行化logAndApply, 写清单文件期间不阻塞读取current
+     * 
+     */
+    std::mutex apply_mutex_;
+    mutable std::mutex mutex_;
+    std::shared_ptr<const Version> current_;
+
+    /**
+     * @brief 创建过的Version, 读操作可能仍持有旧的Version
+     * 
+     */
+    std::vector<std::weak_ptr<const Version>> versions_;
+
+    /**
+     * @brief 每层上一次自动合并的最大键, 下一次从它之后的文件开始, 使各层文件轮流被合并
+     * 
+     */
+    std::string compact_pointer_[NUM_LEVELS];
+    std::atomic<uint64_t> next_file_number_;
+    uint64_t log_number_;
+    uint64_t last_sequence_;
+};
+
+}
+
+#endif
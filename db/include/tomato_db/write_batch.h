@@ -0,0 +1,162 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 13:02:18
+ * @LastEditTime: 2026-10-18 22:20:54
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_WRITE_BATCH_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_WRITE_BATCH_H
+
+#include <tomato_db/table_meta.h>
+#include <tomato_common/io.h>
+
+#include <string>
+
+namespace tomato {
+
+class MemoryTable;
+
+/**
+ * @brief 一组写操作, 内部是紧凑的序列化格式, 同时也是预写日志的记录格式:
+ *        序列号(定长64位) + 操作个数(定长32位) + 操作...
+ *        操作: 类型(1字节) + key长度(变长) + key [+ value长度(变长) + value]
+ *        范围删除的key为范围起点, value为范围终点
+ * 
+ */
+class WriteBatch {
+public:
+    /**
+     * @brief 遍历写操作的回调
+     * 
+     */
+    class Handler {
+    public:
+        virtual ~Handler() = default;
+        virtual void put(const std::string& key, const std::string& value) = 0;
+        virtual void del(const std::string& key) = 0;
+        virtual void deleteRange(const std::string& begin, const std::string& end) = 0;
+        virtual void merge(const std::string& key, const std::string& operand) = 0;
+    };
+public:
+    WriteBatch();
+    WriteBatch(const WriteBatch&) = default;
+    WriteBatch& operator=(const WriteBatch&) = default;
+
+    /**
+     * @brief 写入一个键值对
+     * 
+     * @param key 键
+     * @param value 值
+     */
+    void put(const std::string& key, const std::string& value);
+
+    /**
+     * @brief 删除一个键
+     * 
+     * @param key 键
+     */
+    void del(const std::string& key);
+
+    /**
+     * @brief 删除[begin, end)内的所有键, 只写入一条范围删除标记, 代价与范围内的键数无关
+     * 
+     * @param begin 范围起点(包含)
+     * @param end 范围终点(不包含)
+     */
+    void deleteRange(const std::string& begin, const std::string& end);
+
+    /**
+     * @brief 追加一个合并操作数, 不读取旧值
+     * 
+     * @param key 键
+     * @param operand 合并操作数
+     */
+    void merge(const std::string& key, const std::string& operand);
+
+    /**
+     * @brief 清空所有操作
+     * 
+     */
+    void clear();
+
+    /**
+     * @brief 把另一个批次的操作追加到当前批次之后
+     * 
+     * @param other 另一个批次
+     */
+    void append(const WriteBatch& other);
+
+    /**
+     * @brief 序列化后的字节数, 可用于控制批次大小
+     * 
+     */
+    size_t getApproximateSize() const {
+        return rep_.size();
+    }
+
+    /**
+     * @brief 操作个数
+     * 
+     */
+    uint32_t getCount() const;
+
+    /**
+     * @brief 第一个操作的序列号, 第i个操作的序列号为getSequence() + i
+     * 
+     */
+    uint64_t getSequence() const;
+
+    /**
+     * @brief 设置第一个操作的序列号
+     * 
+     * @param seq 序列号
+     */
+    void setSequence(uint64_t seq);
+
+    /**
+     * @brief 序列化后的内容
+     * 
+     */
+    const std::string& getContent() const {
+        return rep_;
+    }
+
+    /**
+     * @brief 用序列化后的内容重建
+     * 
+     * @param content 序列化后的内容
+     * @return OperatorResult 内容长度不足一个头部时失败
+     */
+    OperatorResult setContent(const std::string& content);
+
+    /**
+     * @brief 按写入顺序遍历所有操作
+     * 
+     * @param handler 回调
+     * @return OperatorResult 内容损坏时失败
+     */
+    OperatorResult iterate(Handler* handler) const;
+
+    /**
+     * @brief 把所有操作写入内存表, 第i个操作使用序列号getSequence() + i
+     * 
+     * @param table 内存表
+     * @param concurrent 是否与其他线程并发写入同一个内存表
+     * @param sorted_run_threshold 并发写入时, 操作个数不少于该值且按键有序的批次走批量插入
+     * @return OperatorResult 
+     */
+    OperatorResult insertInto(MemoryTable* table, bool concurrent, uint32_t sorted_run_threshold = 64) const;
+public:
+    /**
+     * @brief 序列号 + 操作个数
+     * 
+     */
+    static const size_t HEADER_SIZE = 12;
+private:
+    void setCount(uint32_t count);
+private:
+    std::string rep_;
+};
+
+}
+
+#endif
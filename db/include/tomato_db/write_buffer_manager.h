@@ -0,0 +1,147 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 23:48:43
+ * @LastEditTime: 2026-10-19 00:44:39
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_WRITE_BUFFER_MANAGER_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_WRITE_BUFFER_MANAGER_H
+
+#include <tomato_db/block_cache.h>
+#include <tomato_common/allocator.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace tomato {
+
+/**
+ * @brief 多个数据库共用的写缓冲区管理: 所有内存表的内存块都计入同一个预算,
+ *        超出预算时刷写活跃内存最多的内存表; 可以把内存表占用的内存计入共享的block缓存的容量
+ * 
+ */
+class WriteBufferManager final : public AllocationTracker {
+public:
+    /**
+     * @brief 刷写请求的回调: 返回活跃内存表的字节数, 以及让这个数据库封存并刷写活跃内存表
+     * 
+     */
+    using ActiveUsageFunction = std::function<size_t()>;
+    using FlushFunction = std::function<void()>;
+public:
+    /**
+     * @brief 构造
+     * 
+     * @param buffer_size 所有内存表的内存预算(字节), 0表示只统计不刷写
+     * @param block_cache 内存表占用的内存从这个缓存的容量中预留, 可以为空
+     */
+    explicit WriteBufferManager(size_t buffer_size, std::shared_ptr<BlockCache> block_cache = nullptr);
+    ~WriteBufferManager() override;
+    WriteBufferManager(const WriteBufferManager&) = delete;
+    WriteBufferManager& operator=(const WriteBufferManager&) = delete;
+
+    void reserveMemory(size_t bytes) override;
+    void scheduleFreeMemory(size_t bytes) override;
+    void freeMemory(size_t bytes) override;
+
+    /**
+     * @brief 是否需要刷写: 活跃内存超过预算的7/8, 或总内存超过预算且活跃内存不少于一半;
+     *        等待刷写的内存表不计入活跃内存, 刷写期间不会接连选中更多的内存表
+     * 
+     */
+    bool shouldFlush() const;
+
+    /**
+     * @brief 请求活跃内存最多的数据库刷写它的活跃内存表; 回调在锁外调用, 返回前数据库不会完成注销;
+     *        同一时间只有一个刷写请求, 其他线程不等待直接返回
+     * 
+     */
+    void flushLargest();
+
+    /**
+     * @brief 注册一个数据库
+     * 
+     * @return uint64_t 注销时使用的编号
+     */
+    uint64_t addOwner(ActiveUsageFunction active_usage, FlushFunction flush);
+
+    /**
+     * @brief 注销数据库, 等待正在进行的刷写请求结束
+     * 
+     */
+    void removeOwner(uint64_t id);
+
+    size_t getBufferSize() const {
+        return buffer_size_;
+    }
+
+    /**
+     * @brief 所有内存表的字节数
+     * 
+     */
+    size_t getMemoryUsage() const {
+        return memory_used_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 还没有封存的内存表的字节数
+     * 
+     */
+    size_t getActiveMemoryUsage() const {
+        return memory_active_.load(std::memory_order_relaxed);
+    }
+private:
+    /**
+     * @brief 按内存用量调整在block缓存中预留的字节数, 每次调整CACHE_RESERVE_UNIT的整数倍
+     * 
+     */
+    void updateCacheReservation();
+private:
+    static const size_t CACHE_RESERVE_UNIT;
+
+    const size_t buffer_size_;
+    std::atomic<size_t> memory_used_;
+    std::atomic<size_t> memory_active_;
+
+    /**
+     * @brief 预留内存的block缓存与已经预留的字节数
+     * 
+     */
+    std::shared_ptr<BlockCache> block_cache_;
+    std::mutex cache_mutex_;
+    std::atomic<size_t> cache_reserved_;
+
+    /**
+     * @brief 注册的数据库
+     * 
+     */
+    struct Owner {
+        ActiveUsageFunction active_usage;
+        FlushFunction flush;
+
+        /**
+         * @brief 锁外正在使用回调的flushLargest数量, 受owners_mutex_保护
+         * 
+         */
+        int in_flight = 0;
+    };
+    std::mutex owners_mutex_;
+    std::condition_variable owners_cv_;
+    std::map<uint64_t, std::shared_ptr<Owner>> owners_;
+
+    /**
+     * @brief 是否有线程正在请求刷写
+     * 
+     */
+    bool flushing_;
+    uint64_t next_owner_id_;
+};
+
+}
+
+#endif
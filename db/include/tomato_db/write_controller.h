@@ -0,0 +1,105 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 23:58:05
+ * @LastEditTime: 2026-10-19 00:48:18
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_WRITE_CONTROLLER_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_WRITE_CONTROLLER_H
+
+#include <tomato_db/db.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace tomato {
+
+/**
+ * @brief 写入限流: LSM树的形状变差时先用令牌桶逐步降低写入速度, 超过停止阈值后才停止写入;
+ *        状态由数据库在版本变化后设置, 写入在进入写入流水线前检查
+ * 
+ */
+class WriteController {
+public:
+    /**
+     * @brief 构造
+     * 
+     * @param max_delayed_write_rate 刚开始限速时的速度(字节/秒), 压力增大时逐步降低
+     */
+    explicit WriteController(uint64_t max_delayed_write_rate);
+    WriteController(const WriteController&) = delete;
+    WriteController& operator=(const WriteController&) = delete;
+
+    /**
+     * @brief 设置限流状态
+     * 
+     * @param condition 状态
+     * @param pressure DELAYED时距离停止阈值的程度, 取值[0, 1], 限速从最大速度线性降到最小速度
+     */
+    void setCondition(WriteStallCondition condition, double pressure = 0);
+
+    WriteStallCondition getCondition() const {
+        return condition_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief 从令牌桶中取出bytes个令牌, 令牌不足时返回需要等待的微秒数;
+     *        多个写入依次透支令牌, 后来的写入等待更久, 总速度不超过限速
+     * 
+     * @param bytes 写入的字节数
+     * @return uint64_t 需要等待的微秒数, 不限速时为0
+     */
+    uint64_t getDelay(size_t bytes);
+
+    /**
+     * @brief 等待状态离开STOPPED或超时
+     * 
+     * @param timeout_micros 最长等待的微秒数
+     */
+    void waitWhileStopped(uint64_t timeout_micros);
+
+    void recordDelay(uint64_t micros);
+    void recordStop(uint64_t micros);
+
+    WriteStallStats getStats() const;
+
+    /**
+     * @brief 单调时钟的当前微秒数
+     * 
+     */
+    static uint64_t nowMicros();
+private:
+    /**
+     * @brief 限速的下限, 压力再大也保留这个速度, 让写入继续推进
+     * 
+     */
+    static const uint64_t MIN_DELAYED_WRITE_RATE;
+
+    /**
+     * @brief 令牌桶最多积攒这么长时间的令牌, 限制空闲之后的突发
+     * 
+     */
+    static const uint64_t MAX_BURST_MICROS;
+
+    const uint64_t max_delayed_write_rate_;
+    std::atomic<WriteStallCondition> condition_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable resume_cv_;
+
+    /**
+     * @brief 当前的限速与令牌桶: 可用的令牌数为负时表示已经透支, 上次补充令牌的时间
+     * 
+     */
+    uint64_t delayed_write_rate_;
+    int64_t available_bytes_;
+    uint64_t last_refill_micros_;
+
+    WriteStallStats stats_;
+};
+
+}
+
+#endif
@@ -0,0 +1,144 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 15:20:44
+ * @LastEditTime: 2026-10-18 23:39:19
+ */
+#ifndef TOMATO_DB_DB_INCLUDE_TOMATO_WRITE_PIPELINE_H
+#define TOMATO_DB_DB_INCLUDE_TOMATO_WRITE_PIPELINE_H
+
+#include <tomato_db/write_batch.h>
+#include <tomato_common/io.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace tomato {
+
+/**
+ * @brief 流水线写入: 并发的写入线程排队组成写入组, 组内第一个线程作为leader一次性为整组分配序列号并写预写日志,
+ *        日志写完后组内每个线程并发地把自己的批次写入内存表, 同时下一组的leader可以开始写日志;
+ *        各组按序列号顺序发布, 发布后写入才对读可见并返回
+ * 
+ */
+class WritePipeline {
+public:
+    /**
+     * @brief 把一组批次写入预写日志, 只会被leader串行调用
+     * 
+     */
+    using LogFunction = std::function<OperatorResult(const std::vector<WriteBatch*>& batches, bool sync)>;
+
+    /**
+     * @brief 把一个批次写入内存表, 会被多个线程并发调用
+     * 
+     */
+    using MemoryTableFunction = std::function<OperatorResult(const WriteBatch& batch)>;
+public:
+    /**
+     * @brief 
+     * 
+     * @param log_function 写日志
+     * @param memtable_function 写内存表
+     * @param max_group_bytes 一组最多合并多少字节的批次
+     */
+    WritePipeline(LogFunction log_function, MemoryTableFunction memtable_function, 
+                  size_t max_group_bytes = 1 << 20);
+    WritePipeline(const WritePipeline&) = delete;
+    WritePipeline& operator=(const WritePipeline&) = delete;
+
+    /**
+     * @brief 写入一个批次, 返回时批次已经写入内存表并对读可见
+     * 
+     * @param batch 批次, 序列号由流水线设置
+     * @param sync 返回前是否需要日志落盘
+     * @return OperatorResult 
+     */
+    OperatorResult write(WriteBatch* batch, bool sync);
+
+    /**
+     * @brief 设置已经使用过的最大序列号, 只能在没有写入时调用
+     * 
+     * @param seq 序列号
+     */
+    void setLastSequence(uint64_t seq);
+
+    /**
+     * @brief 已发布的最大序列号, 不大于该值的写入都已经完整写入内存表
+     * 
+     */
+    uint64_t getLastSequence() const {
+        return published_sequence_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief 等待不大于seq的写入全部发布; 只能由写日志的leader调用, 等待的是之前的组写完内存表
+     * 
+     * @param seq 序列号
+     */
+    void waitForPublished(uint64_t seq);
+
+    /**
+     * @brief 已经组成过的写入组个数
+     * 
+     */
+    uint64_t getGroupCount() const;
+private:
+    struct Writer;
+    struct WriteGroup;
+
+    /**
+     * @brief 按顺序发布已经全部写完内存表的组, 需持有mutex_
+     * 
+     */
+    void publishGroups();
+private:
+    const LogFunction log_function_;
+    const MemoryTableFunction memtable_function_;
+    const size_t max_group_bytes_;
+
+    mutable std::mutex mutex_;
+
+    /**
+     * @brief 等待写日志的线程, 队首为leader
+     * 
+     */
+    std::deque<Writer*> log_writers_;
+
+    /**
+     * @brief 已经写完日志、正在写内存表的组, 按序列号排列
+     * 
+     */
+    std::deque<WriteGroup*> memtable_groups_;
+
+    /**
+     * @brief 已经分配的最大序列号, mutex_保护
+     * 
+     */
+    uint64_t allocated_sequence_;
+
+    /**
+     * @brief 已经发布的最大序列号
+     * 
+     */
+    std::atomic<uint64_t> published_sequence_;
+
+    /**
+     * @brief 有组发布时通知waitForPublished
+     * 
+     */
+    std::condition_variable published_cv_;
+
+    /**
+     * @brief 组成过的写入组个数, mutex_保护
+     * 
+     */
+    uint64_t group_count_;
+};
+
+}
+
+#endif
@@ -0,0 +1,155 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 22:41:13
+ * @LastEditTime: 2026-10-18 22:41:13
+ */
+#include <tomato_db/blob_file.h>
+#include <tomato_db/filename.h>
+#include <tomato_common/codec.h>
+#include <tomato_common/crc32.h>
+
+#include <cerrno>
+
+namespace tomato {
+
+void BlobIndex::encodeTo(std::string& output) const {
+    output.append(codec::encodeVar64(file_number));
+    output.append(codec::encodeVar64(offset));
+    output.append(codec::encodeVar64(size));
+}
+
+bool BlobIndex::decodeFrom(const std::string& input) {
+    const char* begin = input.data();
+    const char* end = input.data() + input.size();
+    uint64_t* fields[] = {&file_number, &offset, &size};
+    for (uint64_t* field : fields) {
+        std::pair<uint64_t, int> res = codec::decodeVar64(begin, end);
+        if (res.second == 0) {
+            return false;
+        }
+        *field = res.first;
+        begin += res.second;
+    }
+    return begin == end;
+}
+
+BlobFileBuilder::BlobFileBuilder(std::string db_path, VersionSet* versions, const BlobFileOptions& options)
+    : db_path_(std::move(db_path)),
+      versions_(versions),
+      options_(options),
+      file_(),
+      file_size_(0),
+      outputs_() {}
+
+OperatorResult BlobFileBuilder::add(const std::string& user_key, const std::string& value, std::string& blob_index) {
+    if (!file_) {
+        BlobFileMeta meta;
+        meta.number = versions_->newFileNumber();
+        const std::string filename = blobFileName(db_path_, meta.number);
+        file_ = createAppendOnlyFile(filename);
+        if (!file_->isOpen()) {
+            file_.reset();
+            return {errno, "create blob file error, filename: " + filename};
+        }
+        file_size_ = 0;
+        outputs_.push_back(meta);
+    }
+
+    std::string record;
+    record.append(codec::encodeVar64(user_key.size()));
+    record.append(codec::encodeVar64(value.size()));
+    record.append(user_key);
+    BlobIndex index;
+    index.file_number = outputs_.back().number;
+    index.offset = file_size_ + record.size();
+    index.size = value.size();
+    record.append(value);
+    record.append(codec::encodeFixed32(crc32(value.data(), value.size())));
+    OperatorResult status = file_->append(record);
+    if (!status.isSuccess()) {
+        return status;
+    }
+    file_size_ += record.size();
+    outputs_.back().total_bytes += value.size();
+    blob_index.clear();
+    index.encodeTo(blob_index);
+
+    if (file_size_ >= options_.blob_file_size) {
+        return finishFile();
+    }
+    return OperatorResult::success();
+}
+
+OperatorResult BlobFileBuilder::finish() {
+    if (!file_) {
+        return OperatorResult::success();
+    }
+    return finishFile();
+}
+
+void BlobFileBuilder::abandon() {
+    if (file_) {
+        file_->close();
+        file_.reset();
+    }
+    for (const BlobFileMeta& output : outputs_) {
+        removeFile(blobFileName(db_path_, output.number));
+    }
+    outputs_.clear();
+}
+
+OperatorResult BlobFileBuilder::finishFile() {
+    OperatorResult status = file_->sync();
+    if (status.isSuccess()) {
+        status = file_->close();
+    }
+    file_.reset();
+    return status;
+}
+
+BlobFileCache::BlobFileCache(std::string db_path)
+    : db_path_(std::move(db_path)),
+      mutex_(),
+      files_() {}
+
+OperatorResult BlobFileCache::getBlob(const std::string& blob_index, std::string& value) {
+    BlobIndex index;
+    if (!index.decodeFrom(blob_index)) {
+        return {EINVAL, "bad blob index"};
+    }
+    std::shared_ptr<RandomAccessFile> file;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = files_.find(index.file_number);
+        if (it != files_.end()) {
+            file = it->second;
+        } else {
+            file = createRandomAccessFile(blobFileName(db_path_, index.file_number));
+            if (!file->isOpen()) {
+                return {errno, "open blob file error, filename: " + file->getFileName()};
+            }
+            files_[index.file_number] = file;
+        }
+    }
+
+    // 值之后紧跟着它的crc
+    std::string contents;
+    OperatorResult status = file->read(index.offset, static_cast<size_t>(index.size) + 4, contents);
+    if (!status.isSuccess()) {
+        return status;
+    }
+    const size_t size = static_cast<size_t>(index.size);
+    if (contents.size() != size + 4 || codec::decodeFixed32(contents.data() + size) != crc32(contents.data(), size)) {
+        return {EINVAL, "bad blob record, filename: " + file->getFileName()};
+    }
+    contents.resize(size);
+    value.swap(contents);
+    return OperatorResult::success();
+}
+
+void BlobFileCache::evict(uint64_t number) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    files_.erase(number);
+}
+
+}
@@ -0,0 +1,296 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 17:38:45
+ * @LastEditTime: 2026-10-18 23:25:42
+ */
+#include <tomato_db/block.h>
+#include <tomato_common/codec.h>
+#include <tomato_common/hash.h>
+
+namespace tomato {
+
+/**
+ * @brief 哈希索引的种子, 与布隆过滤器不同
+ * 
+ */
+static const uint32_t HASH_INDEX_SEED = 0x3c6ef372;
+
+uint32_t Block::hashUserKey(const char* key, size_t size) {
+    return hashBytes(key, size - sizeof(uint64_t), HASH_INDEX_SEED);
+}
+
+Block::Block(std::string contents)
+    : contents_(std::move(contents)),
+      data_(contents_.data()),
+      size_(contents_.size()),
+      restarts_offset_(INVALID_OFFSET),
+      num_restarts_(0),
+      buckets_offset_(0),
+      num_buckets_(0),
+      varint_tag_(false) {
+    parse();
+}
+
+Block::Block(const char* data, size_t size)
+    : contents_(),
+      data_(data),
+      size_(size),
+      restarts_offset_(INVALID_OFFSET),
+      num_restarts_(0),
+      buckets_offset_(0),
+      num_buckets_(0),
+      varint_tag_(false) {
+    parse();
+}
+
+void Block::parse() {
+    if (size_ < sizeof(uint32_t)) {
+        return;
+    }
+    size_t end = size_ - sizeof(uint32_t);
+    const uint32_t footer = codec::decodeFixed32(data_ + end);
+    if (footer & HASH_INDEX_FLAG) {
+        // [组偏移量][桶][桶数(定长32位)][组数 | HASH_INDEX_FLAG(定长32位)]
+        if (end < sizeof(uint32_t)) {
+            return;
+        }
+        end -= sizeof(uint32_t);
+        const uint32_t num_buckets = codec::decodeFixed32(data_ + end);
+        if (num_buckets == 0 || num_buckets > end) {
+            return;
+        }
+        end -= num_buckets;
+        buckets_offset_ = static_cast<uint32_t>(end);
+        num_buckets_ = num_buckets;
+    }
+    const uint64_t max_restarts = end / sizeof(uint32_t);
+    num_restarts_ = footer & ~(HASH_INDEX_FLAG | VARINT_TAG_FLAG);
+    varint_tag_ = (footer & VARINT_TAG_FLAG) != 0;
+    if (num_restarts_ == 0 || num_restarts_ > max_restarts) {
+        num_restarts_ = 0;
+        num_buckets_ = 0;
+        return;
+    }
+    restarts_offset_ = static_cast<uint32_t>(end - num_restarts_ * sizeof(uint32_t));
+}
+
+Block::Iterator::Iterator(const Block* block, KeyComparator comparator)
+    : data_(block->data_),
+      comparator_(comparator),
+      restarts_offset_(block->isValid() ? block->restarts_offset_ : 0),
+      num_restarts_(block->num_restarts_),
+      buckets_(reinterpret_cast<const unsigned char*>(block->data_) + block->buckets_offset_),
+      num_buckets_(block->num_buckets_),
+      varint_tag_(block->varint_tag_),
+      current_(restarts_offset_),
+      next_(restarts_offset_),
+      key_(),
+      value_(),
+      corrupted_(!block->isValid()) {}
+
+void Block::Iterator::seekToFirst() {
+    if (num_restarts_ == 0) {
+        return;
+    }
+    seekToRestartPoint(0);
+    parseNextEntry();
+}
+
+void Block::Iterator::seek(const std::string& target) {
+    if (num_restarts_ == 0) {
+        return;
+    }
+    seekInGroups(target, 0, num_restarts_ - 1);
+}
+
+void Block::Iterator::seekWithHint(const std::string& target, uint32_t left, uint32_t right) {
+    if (num_restarts_ == 0) {
+        return;
+    }
+    if (right >= num_restarts_) {
+        right = num_restarts_ - 1;
+    }
+    if (left > right) {
+        seek(target);
+        return;
+    }
+    // 结果在范围内需要第left组的首键小于target, 且第right + 1组的首键不小于target
+    if (left > 0) {
+        seekToRestartPoint(left);
+        if (!parseNextEntry()) {
+            return;
+        }
+        if (comparator_(key_, target) >= 0) {
+            seek(target);
+            return;
+        }
+    }
+    if (right + 1 < num_restarts_) {
+        seekToRestartPoint(right + 1);
+        if (!parseNextEntry()) {
+            return;
+        }
+        if (comparator_(key_, target) < 0) {
+            seek(target);
+            return;
+        }
+    }
+    seekInGroups(target, left, right);
+}
+
+void Block::Iterator::seekInGroups(const std::string& target, uint32_t left, uint32_t right) {
+    // 二分查找最后一个首键小于target的组
+    while (left < right) {
+        uint32_t mid = (left + right + 1) / 2;
+        seekToRestartPoint(mid);
+        if (!parseNextEntry()) {
+            return;
+        }
+        if (comparator_(key_, target) < 0) {
+            left = mid;
+        } else {
+            right = mid - 1;
+        }
+    }
+
+    // 组内线性查找
+    seekToRestartPoint(left);
+    while (parseNextEntry()) {
+        if (comparator_(key_, target) >= 0) {
+            return;
+        }
+    }
+}
+
+bool Block::Iterator::seekForGet(const std::string& target) {
+    if (num_buckets_ == 0 || target.size() < sizeof(uint64_t)) {
+        seek(target);
+        return true;
+    }
+    const unsigned char bucket = buckets_[hashUserKey(target.data(), target.size()) % num_buckets_];
+    if (bucket == HASH_BUCKET_EMPTY) {
+        current_ = restarts_offset_;
+        next_ = restarts_offset_;
+        return false;
+    }
+    if (bucket == HASH_BUCKET_COLLISION || bucket >= num_restarts_) {
+        seek(target);
+        return true;
+    }
+    // 用户键的所有版本都在这一组中, 组内线性查找
+    seekToRestartPoint(bucket);
+    while (parseNextEntry()) {
+        if (comparator_(key_, target) >= 0) {
+            break;
+        }
+    }
+    return true;
+}
+
+void Block::Iterator::seekToLast() {
+    if (num_restarts_ == 0) {
+        return;
+    }
+    seekToRestartPoint(num_restarts_ - 1);
+    while (parseNextEntry() && next_ < restarts_offset_) {
+    }
+}
+
+void Block::Iterator::next() {
+    parseNextEntry();
+}
+
+void Block::Iterator::prev() {
+    const uint32_t original = current_;
+    // 二分查找最后一个起点小于当前键的组
+    uint32_t left = 0;
+    uint32_t right = num_restarts_;
+    while (left < right) {
+        uint32_t mid = (left + right) / 2;
+        if (getRestartPoint(mid) < original) {
+            left = mid + 1;
+        } else {
+            right = mid;
+        }
+    }
+    if (left == 0) {
+        // 已经是第一个键
+        current_ = restarts_offset_;
+        next_ = restarts_offset_;
+        return;
+    }
+    seekToRestartPoint(left - 1);
+    while (parseNextEntry() && next_ < original) {
+    }
+}
+
+void Block::Iterator::seekToRestartPoint(uint32_t index) {
+    key_.clear();
+    next_ = getRestartPoint(index);
+}
+
+uint32_t Block::Iterator::getRestartPoint(uint32_t index) const {
+    return codec::decodeFixed32(data_ + restarts_offset_ + index * sizeof(uint32_t));
+}
+
+bool Block::Iterator::parseNextEntry() {
+    current_ = next_;
+    if (current_ >= restarts_offset_) {
+        current_ = restarts_offset_;
+        return false;
+    }
+    const char* begin = data_ + current_;
+    const char* end = data_ + restarts_offset_;
+    uint64_t lengths[3];
+    for (int i = 0; i < 3; ++i) {
+        std::pair<uint64_t, int> res = codec::decodeVar64(begin, end);
+        if (res.second == 0) {
+            corruptionError();
+            return false;
+        }
+        lengths[i] = res.first;
+        begin += res.second;
+    }
+    const uint64_t shared = lengths[0];
+    const uint64_t unshared = lengths[1];
+    const uint64_t value_size = lengths[2];
+    if (varint_tag_) {
+        // 共享部分只在用户键之间计算, 标签还原成定长64位
+        const size_t user_key_size = key_.size() < sizeof(uint64_t) ? 0 : key_.size() - sizeof(uint64_t);
+        if (shared > user_key_size || static_cast<uint64_t>(end - begin) < unshared) {
+            corruptionError();
+            return false;
+        }
+        std::pair<uint64_t, int> tag = codec::decodeVar64(begin + unshared, end);
+        const char* value = begin + unshared + tag.second;
+        if (tag.second == 0 || static_cast<uint64_t>(end - value) < value_size) {
+            corruptionError();
+            return false;
+        }
+        key_.resize(shared);
+        key_.append(begin, unshared);
+        key_.append(codec::encodeFixed64(tag.first));
+        value_.assign(value, value_size);
+        next_ = static_cast<uint32_t>(value + value_size - data_);
+        return true;
+    }
+    if (shared > key_.size() || static_cast<uint64_t>(end - begin) < unshared + value_size) {
+        corruptionError();
+        return false;
+    }
+    key_.resize(shared);
+    key_.append(begin, unshared);
+    value_.assign(begin + unshared, value_size);
+    next_ = static_cast<uint32_t>(begin + unshared + value_size - data_);
+    return true;
+}
+
+void Block::Iterator::corruptionError() {
+    corrupted_ = true;
+    current_ = restarts_offset_;
+    next_ = restarts_offset_;
+    key_.clear();
+    value_.clear();
+}
+
+}
@@ -0,0 +1,76 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 22:47:45
+ * @LastEditTime: 2026-10-18 23:48:43
+ */
+#include <tomato_db/block_cache.h>
+
+#include <algorithm>
+
+namespace tomato {
+
+BlockCache::BlockCache(size_t capacity)
+    : shard_capacity_((capacity + NUM_SHARDS - 1) / NUM_SHARDS),
+      next_id_(1),
+      reserved_(0),
+      shards_() {}
+
+std::shared_ptr<Block> BlockCache::lookup(uint64_t id, uint64_t offset) {
+    const CacheKey key(id, offset);
+    Shard& shard = getShard(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.table.find(key);
+    if (it == shard.table.end()) {
+        return std::shared_ptr<Block>();
+    }
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    return it->second->second;
+}
+
+void BlockCache::insert(uint64_t id, uint64_t offset, std::shared_ptr<Block> block) {
+    const CacheKey key(id, offset);
+    Shard& shard = getShard(key);
+    const size_t charge = block->size();
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.table.find(key);
+    if (it != shard.table.end()) {
+        // 并发读取同一个block时只保留一份
+        return;
+    }
+    shard.lru.emplace_front(key, std::move(block));
+    shard.table[key] = shard.lru.begin();
+    shard.usage += charge;
+    evict(shard);
+}
+
+void BlockCache::evict(Shard& shard) {
+    const size_t reserved = std::min(reserved_.load(std::memory_order_relaxed) / NUM_SHARDS, shard_capacity_);
+    while (shard.usage > shard_capacity_ - reserved && !shard.lru.empty()) {
+        shard.usage -= shard.lru.back().second->size();
+        shard.table.erase(shard.lru.back().first);
+        shard.lru.pop_back();
+    }
+}
+
+void BlockCache::reserve(size_t bytes) {
+    reserved_.fetch_add(bytes, std::memory_order_relaxed);
+    for (Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        evict(shard);
+    }
+}
+
+void BlockCache::release(size_t bytes) {
+    reserved_.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+size_t BlockCache::getUsage() {
+    size_t usage = 0;
+    for (Shard& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        usage += shard.usage;
+    }
+    return usage;
+}
+
+}
@@ -0,0 +1,185 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 23:12:48
+ * @LastEditTime: 2026-10-18 23:25:42
+ */
+#include <tomato_db/compaction_iterator.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+
+namespace tomato {
+
+CompactionIterator::CompactionIterator(InternalIterator* input, uint64_t smallest_snapshot,
+                                       const RangeDelAggregator* range_del, const MergeOperator* merge_operator,
+                                       std::function<bool(const std::string&)> is_base_level,
+                                       BlobFileCache* blob_cache)
+    : input_(input),
+      smallest_snapshot_(smallest_snapshot),
+      range_del_(range_del),
+      merge_operator_(merge_operator),
+      is_base_level_(std::move(is_base_level)),
+      blob_cache_(blob_cache),
+      current_user_key_(),
+      has_current_user_key_(false),
+      last_sequence_for_key_(UINT64_MAX),
+      outputs_(),
+      pos_(0),
+      status_(OperatorResult::success()) {}
+
+void CompactionIterator::seekToFirst() {
+    has_current_user_key_ = false;
+    status_ = OperatorResult::success();
+    input_->seekToFirst();
+    fill();
+}
+
+void CompactionIterator::next() {
+    ++pos_;
+    if (pos_ >= outputs_.size()) {
+        fill();
+    }
+}
+
+OperatorResult CompactionIterator::getStatus() const {
+    if (!status_.isSuccess()) {
+        return status_;
+    }
+    return input_->getStatus();
+}
+
+void CompactionIterator::fill() {
+    outputs_.clear();
+    pos_ = 0;
+    ParsedInternalKey parsed_key;
+    while (outputs_.empty() && status_.isSuccess() && input_->valid()) {
+        if (!parseInternalKey(input_->key(), parsed_key)) {
+            status_ = OperatorResult(EINVAL, "bad internal key in compaction");
+            break;
+        }
+        if (!has_current_user_key_ || parsed_key.user_key != current_user_key_) {
+            current_user_key_ = parsed_key.user_key;
+            has_current_user_key_ = true;
+            last_sequence_for_key_ = UINT64_MAX;
+        }
+
+        bool drop = false;
+        if (last_sequence_for_key_ <= smallest_snapshot_) {
+            // 更新的版本对所有快照可见, 这个版本不会再被读到
+            drop = true;
+        } else if (parsed_key.type == ItemType::DELETION && parsed_key.seq <= smallest_snapshot_ &&
+                   is_base_level_(parsed_key.user_key)) {
+            // 更深的层没有这个键, 删除标记已经没有可以遮住的版本
+            drop = true;
+        } else if (range_del_ && range_del_->isDeleted(parsed_key.user_key, parsed_key.seq)) {
+            drop = true;
+        }
+        last_sequence_for_key_ = parsed_key.seq;
+
+        if (!drop && parsed_key.type == ItemType::MERGE && merge_operator_ &&
+                parsed_key.seq <= smallest_snapshot_) {
+            // 所有快照看到的都是合并后的结果, 更旧的版本只用于计算这个结果
+            mergeOperands(parsed_key);
+            continue;
+        }
+        if (!drop && canZeroSequence(parsed_key)) {
+            outputs_.emplace_back(encodeInternalKey(parsed_key.user_key, 0, parsed_key.type), input_->value());
+        } else if (!drop) {
+            outputs_.emplace_back(input_->key(), input_->value());
+        }
+        input_->next();
+    }
+}
+
+void CompactionIterator::mergeOperands(const ParsedInternalKey& first) {
+    // 从新到旧收集操作数, 直到遇到值、删除标记或被范围删除遮住的版本
+    std::vector<std::string> keys(1, input_->key());
+    std::vector<std::string> operands(1, input_->value());
+    bool resolved = false;
+    bool has_base = false;
+    std::string base;
+    ParsedInternalKey parsed_key;
+    for (input_->next(); input_->valid(); input_->next()) {
+        if (!parseInternalKey(input_->key(), parsed_key)) {
+            status_ = OperatorResult(EINVAL, "bad internal key in compaction");
+            return;
+        }
+        if (parsed_key.user_key != first.user_key) {
+            break;
+        }
+        if (resolved) {
+            // 被合并结果遮住的更旧版本
+            continue;
+        }
+        if (parsed_key.type == ItemType::DELETION ||
+                (range_del_ && range_del_->isDeleted(parsed_key.user_key, parsed_key.seq))) {
+            resolved = true;
+        } else if (parsed_key.type == ItemType::VALUE) {
+            resolved = true;
+            has_base = true;
+            base = input_->value();
+        } else if (parsed_key.type == ItemType::BLOB_INDEX) {
+            resolved = true;
+            has_base = true;
+            if (blob_cache_ == nullptr) {
+                status_ = OperatorResult(EINVAL, "blob file cache is not set");
+                return;
+            }
+            status_ = blob_cache_->getBlob(input_->value(), base);
+            if (!status_.isSuccess()) {
+                return;
+            }
+        } else {
+            keys.push_back(input_->key());
+            operands.push_back(input_->value());
+        }
+    }
+    if (!resolved && is_base_level_(first.user_key)) {
+        resolved = true;
+    }
+
+    std::reverse(operands.begin(), operands.end());
+    if (resolved) {
+        std::string result;
+        if (!merge_operator_->fullMerge(first.user_key, has_base ? &base : nullptr, operands, result)) {
+            status_ = OperatorResult(EINVAL, std::string("merge failed, operator: ") + merge_operator_->name());
+            return;
+        }
+        ParsedInternalKey merged_key = first;
+        merged_key.type = ItemType::VALUE;
+        if (canZeroSequence(merged_key)) {
+            merged_key.seq = 0;
+        }
+        outputs_.emplace_back(encodeInternalKey(merged_key.user_key, merged_key.seq, ItemType::VALUE), 
+                              std::move(result));
+        return;
+    }
+
+    // 更深的层中可能还有旧值, 只能尝试把操作数两两合并
+    std::string merged = operands.front();
+    for (size_t i = 1; i < operands.size(); ++i) {
+        std::string result;
+        if (!merge_operator_->partialMerge(first.user_key, merged, operands[i], result)) {
+            for (size_t j = 0; j < keys.size(); ++j) {
+                outputs_.emplace_back(keys[j], operands[operands.size() - 1 - j]);
+            }
+            return;
+        }
+        merged.swap(result);
+    }
+    outputs_.emplace_back(encodeInternalKey(first.user_key, first.seq, ItemType::MERGE), std::move(merged));
+}
+
+bool CompactionIterator::canZeroSequence(const ParsedInternalKey& key) const {
+    if (key.seq == 0 || key.seq > smallest_snapshot_ ||
+            (key.type != ItemType::VALUE && key.type != ItemType::BLOB_INDEX)) {
+        return false;
+    }
+    if (range_del_ && range_del_->getMaxCoveringSeq(key.user_key) > 0) {
+        return false;
+    }
+    return is_base_level_(key.user_key);
+}
+
+}
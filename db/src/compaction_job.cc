@@ -0,0 +1,365 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 22:40:12
+ * @LastEditTime: 2026-10-18 23:25:42
+ */
+#include <tomato_db/compaction_job.h>
+#include <tomato_db/compaction_iterator.h>
+#include <tomato_db/filename.h>
+#include <tomato_db/merging_iterator.h>
+#include <tomato_db/sstable.h>
+
+#include <algorithm>
+#include <cerrno>
+
+namespace tomato {
+
+/**
+ * @brief 透传输入并统计经过的每个blob文件被引用的字节数, 包括合并时被丢弃的版本
+ * 
+ */
+class BlobBytesCounter final : public InternalIterator {
+public:
+    BlobBytesCounter(InternalIterator* input, std::map<uint64_t, uint64_t>* blob_bytes)
+        : input_(input),
+          blob_bytes_(blob_bytes),
+          status_(OperatorResult::success()) {}
+
+    bool valid() const override {
+        return input_->valid();
+    }
+
+    void seekToFirst() override {
+        input_->seekToFirst();
+        count();
+    }
+
+    void seekToLast() override {
+        input_->seekToLast();
+        count();
+    }
+
+    void seek(const std::string& target) override {
+        input_->seek(target);
+        count();
+    }
+
+    void next() override {
+        input_->next();
+        count();
+    }
+
+    void prev() override {
+        input_->prev();
+        count();
+    }
+
+    const std::string& key() const override {
+        return input_->key();
+    }
+
+    const std::string& value() const override {
+        return input_->value();
+    }
+
+    OperatorResult getStatus() const override {
+        if (!status_.isSuccess()) {
+            return status_;
+        }
+        return input_->getStatus();
+    }
+private:
+    void count() {
+        ParsedInternalKey parsed_key;
+        if (!input_->valid() || !parseInternalKey(input_->key(), parsed_key) || 
+                parsed_key.type != ItemType::BLOB_INDEX) {
+            return;
+        }
+        BlobIndex index;
+        if (!index.decodeFrom(input_->value())) {
+            status_ = OperatorResult(EINVAL, "bad blob index in compaction");
+            return;
+        }
+        (*blob_bytes_)[index.file_number] += index.size;
+    }
+private:
+    InternalIterator* input_;
+    std::map<uint64_t, uint64_t>* blob_bytes_;
+    OperatorResult status_;
+};
+
+CompactionJob::CompactionJob(std::string db_path, const TableConfig& config, uint64_t target_file_size,
+                             TableCache* table_cache, VersionSet* versions, const MergeOperator* merge_operator,
+                             BlobFileCache* blob_cache, const BlobFileOptions& blob_options)
+    : db_path_(std::move(db_path)),
+      config_(config),
+      target_file_size_(target_file_size),
+      table_cache_(table_cache),
+      versions_(versions),
+      merge_operator_(merge_operator),
+      blob_cache_(blob_cache),
+      blob_options_(blob_options),
+      compaction_(nullptr),
+      version_(),
+      smallest_snapshot_(0),
+      tombstones_(),
+      file_(),
+      builder_(),
+      output_(),
+      lower_(),
+      outputs_(),
+      blob_builder_(),
+      input_blob_bytes_(),
+      output_blob_bytes_() {}
+
+OperatorResult CompactionJob::run(const Compaction& compaction, uint64_t smallest_snapshot, VersionEdit& edit) {
+    compaction_ = &compaction;
+    version_ = versions_->current();
+    smallest_snapshot_ = smallest_snapshot;
+    tombstones_.clear();
+    lower_.clear();
+    outputs_.clear();
+    blob_builder_.reset(new BlobFileBuilder(db_path_, versions_, blob_options_));
+    input_blob_bytes_.clear();
+    output_blob_bytes_.clear();
+
+    // 只有所有快照都能看到的范围删除标记才能用来清理数据
+    RangeDelAggregator range_del(smallest_snapshot_);
+    std::vector<std::unique_ptr<InternalIterator>> children;
+    for (int which = 0; which < 2; ++which) {
+        for (const FileMeta& file : compaction.inputs[which]) {
+            std::shared_ptr<SSTable> table;
+            OperatorResult status = table_cache_->findTable(file.number, file.file_size, table);
+            if (!status.isSuccess()) {
+                return status;
+            }
+            // 合并只读一次输入, 不放入block缓存
+            TableIteratorOptions table_options;
+            table_options.fill_cache = false;
+            children.emplace_back(new SSTable::Iterator(table, table_options));
+            for (const RangeTombstone& tombstone : table->getRangeTombstones()) {
+                range_del.add(tombstone);
+                // 更深的层没有数据时, 所有快照都能看到的标记已经没有可以遮住的版本
+                if (tombstone.seq > smallest_snapshot_ || !isBaseLevelForRange(tombstone.begin, tombstone.end)) {
+                    tombstones_.push_back(tombstone);
+                }
+            }
+        }
+    }
+    range_del.finish();
+
+    MergingIterator merged(std::move(children));
+    BlobBytesCounter input(&merged, &input_blob_bytes_);
+    CompactionIterator iter(&input, smallest_snapshot_, &range_del, merge_operator_, 
+                            [this](const std::string& user_key) { return isBaseLevelForKey(user_key); },
+                            blob_cache_);
+    OperatorResult status = OperatorResult::success();
+    ParsedInternalKey parsed_key;
+    std::string current_user_key;
+    bool has_current_user_key = false;
+    std::string output_key;
+    std::string output_value;
+    for (iter.seekToFirst(); iter.valid(); iter.next()) {
+        if (!parseInternalKey(iter.key(), parsed_key)) {
+            status = OperatorResult(EINVAL, "bad internal key in compaction");
+            break;
+        }
+        if (!has_current_user_key || parsed_key.user_key != current_user_key) {
+            // 只在用户键变化处切分文件, 同一个键的所有版本落在同一个文件中
+            if (builder_ && builder_->getFileSize() >= target_file_size_) {
+                status = finishOutput(parsed_key.user_key);
+                if (!status.isSuccess()) {
+                    break;
+                }
+            }
+            current_user_key = parsed_key.user_key;
+            has_current_user_key = true;
+        }
+        if (!builder_) {
+            status = openOutput();
+            if (!status.isSuccess()) {
+                break;
+            }
+        }
+        bool rewritten = false;
+        status = rewriteValue(parsed_key, iter.value(), output_key, output_value, rewritten);
+        if (!status.isSuccess()) {
+            break;
+        }
+        builder_->add(rewritten ? output_key : iter.key(), rewritten ? output_value : iter.value());
+        extendFileRange(output_, iter.key(), parsed_key.seq);
+    }
+    if (status.isSuccess()) {
+        status = iter.getStatus();
+    }
+    if (status.isSuccess()) {
+        status = blob_builder_->finish();
+    }
+
+    // 最后一个文件之后还有范围删除标记时, 写一个只有标记的文件
+    if (status.isSuccess() && !builder_) {
+        for (const RangeTombstone& tombstone : tombstones_) {
+            if (lower_.empty() || tombstone.end > lower_) {
+                status = openOutput();
+                break;
+            }
+        }
+    }
+    if (status.isSuccess() && builder_) {
+        status = finishOutput(std::string());
+    }
+
+    if (!status.isSuccess()) {
+        if (builder_) {
+            outputs_.push_back(output_);
+        }
+        for (const FileMeta& output : outputs_) {
+            removeFile(tableFileName(db_path_, output.number));
+        }
+        blob_builder_->abandon();
+        builder_.reset();
+        file_.reset();
+        return status;
+    }
+
+    for (const FileMeta& file : compaction.inputs[0]) {
+        edit.deleteFile(compaction.level, file.number);
+    }
+    for (const FileMeta& file : compaction.inputs[1]) {
+        edit.deleteFile(compaction.level + 1, file.number);
+    }
+    for (const FileMeta& output : outputs_) {
+        edit.addFile(compaction.level + 1, output);
+    }
+    for (const BlobFileMeta& blob_file : blob_builder_->getOutputs()) {
+        edit.addBlobFile(blob_file);
+    }
+    for (const std::pair<const uint64_t, uint64_t>& input_bytes : input_blob_bytes_) {
+        const uint64_t output_bytes = output_blob_bytes_[input_bytes.first];
+        if (input_bytes.second > output_bytes) {
+            edit.addBlobGarbage(input_bytes.first, input_bytes.second - output_bytes);
+        }
+    }
+    return OperatorResult::success();
+}
+
+OperatorResult CompactionJob::rewriteValue(const ParsedInternalKey& parsed_key, const std::string& value,
+                                           std::string& output_key, std::string& output_value, bool& rewritten) {
+    rewritten = false;
+    if (parsed_key.type != ItemType::VALUE && parsed_key.type != ItemType::BLOB_INDEX) {
+        return OperatorResult::success();
+    }
+
+    const std::string* raw_value = &value;
+    std::string relocated;
+    if (parsed_key.type == ItemType::BLOB_INDEX) {
+        BlobIndex index;
+        if (!index.decodeFrom(value)) {
+            return {EINVAL, "bad blob index in compaction"};
+        }
+        const BlobFileMeta* blob_file = version_->getBlobFile(index.file_number);
+        if (blob_file == nullptr || blob_options_.garbage_ratio <= 0 ||
+                static_cast<double>(blob_file->garbage_bytes) < 
+                    blob_options_.garbage_ratio * static_cast<double>(blob_file->total_bytes)) {
+            // 值留在原来的blob文件中
+            output_blob_bytes_[index.file_number] += index.size;
+            return OperatorResult::success();
+        }
+        OperatorResult status = blob_cache_->getBlob(value, relocated);
+        if (!status.isSuccess()) {
+            return status;
+        }
+        raw_value = &relocated;
+        rewritten = true;
+    }
+
+    if (blob_builder_->shouldSeparate(*raw_value)) {
+        OperatorResult status = blob_builder_->add(parsed_key.user_key, *raw_value, output_value);
+        if (!status.isSuccess()) {
+            return status;
+        }
+        output_key = encodeInternalKey(parsed_key.user_key, parsed_key.seq, ItemType::BLOB_INDEX);
+        rewritten = true;
+    } else if (rewritten) {
+        // 不再分离时搬回SSTable
+        output_key = encodeInternalKey(parsed_key.user_key, parsed_key.seq, ItemType::VALUE);
+        output_value.swap(relocated);
+    }
+    return OperatorResult::success();
+}
+
+bool CompactionJob::isBaseLevelForKey(const std::string& user_key) const {
+    // 每个输出的键都会检查一次, 第1层之下的文件互不重叠, 二分查找
+    for (int level = compaction_->level + 2; level < NUM_LEVELS; ++level) {
+        const std::vector<FileMeta>& files = version_->getFiles(level);
+        auto it = std::lower_bound(files.begin(), files.end(), user_key, 
+            [](const FileMeta& file, const std::string& key) {
+                return fileBeforeKey(file, key);
+            });
+        if (it != files.end() && fileContainsKey(*it, user_key)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool CompactionJob::isBaseLevelForRange(const std::string& begin, const std::string& end) const {
+    for (int level = compaction_->level + 2; level < NUM_LEVELS; ++level) {
+        for (const FileMeta& file : version_->getFiles(level)) {
+            if (fileOverlapsRange(file, begin, end)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+OperatorResult CompactionJob::openOutput() {
+    output_ = FileMeta();
+    output_.number = versions_->newFileNumber();
+    const std::string filename = tableFileName(db_path_, output_.number);
+    file_ = createAppendOnlyFile(filename);
+    if (!file_->isOpen()) {
+        return {errno, "create table file error, filename: " + filename};
+    }
+    builder_.reset(new SSTableBuilder(config_, file_.get()));
+    return OperatorResult::success();
+}
+
+OperatorResult CompactionJob::finishOutput(const std::string& upper) {
+    // 范围删除标记裁剪到[lower_, upper), 相邻文件的键范围不会重叠
+    for (const RangeTombstone& tombstone : tombstones_) {
+        RangeTombstone clipped = tombstone;
+        if (!lower_.empty()) {
+            clipped.begin = std::max(clipped.begin, lower_);
+        }
+        if (!upper.empty()) {
+            clipped.end = std::min(clipped.end, upper);
+        }
+        if (clipped.begin >= clipped.end) {
+            continue;
+        }
+        builder_->addRangeTombstone(clipped);
+        extendFileRange(output_, encodeInternalKey(clipped.begin, clipped.seq, ItemType::RANGE_DELETION), clipped.seq);
+        extendFileRange(output_, encodeRangeEndKey(clipped.end), clipped.seq);
+    }
+
+    OperatorResult status = builder_->finish();
+    if (status.isSuccess()) {
+        status = file_->sync();
+    }
+    if (status.isSuccess()) {
+        status = file_->close();
+    }
+    if (!status.isSuccess()) {
+        return status;
+    }
+    output_.file_size = builder_->getFileSize();
+    outputs_.push_back(output_);
+    builder_.reset();
+    file_.reset();
+    lower_ = upper;
+    return OperatorResult::success();
+}
+
+}
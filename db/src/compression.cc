@@ -0,0 +1,140 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 22:47:45
+ * @LastEditTime: 2026-10-18 22:52:21
+ */
+#include <tomato_db/compression.h>
+#include <tomato_common/codec.h>
+#include <tomato_common/lz.h>
+
+#include <cstdint>
+
+#ifdef TOMATO_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef TOMATO_HAVE_LZ4
+#include <lz4.h>
+#endif
+
+namespace tomato {
+
+#ifdef TOMATO_HAVE_ZSTD
+/**
+ * @brief zstd的压缩级别, 兼顾压缩率与写入速度
+ * 
+ */
+static const int ZSTD_LEVEL = 3;
+#endif
+
+bool isCompressionSupported(CompressionType type) {
+    switch (type) {
+        case CompressionType::NO_COMPRESSION:
+        case CompressionType::LZ_COMPRESSION:
+            return true;
+        case CompressionType::ZSTD_COMPRESSION:
+#ifdef TOMATO_HAVE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+        case CompressionType::LZ4_COMPRESSION:
+#ifdef TOMATO_HAVE_LZ4
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+CompressionType compressBlock(CompressionType type, const std::string& raw, const std::string& dict, 
+                              std::string& output) {
+    output.clear();
+    if (type == CompressionType::NO_COMPRESSION) {
+        return type;
+    }
+    if (!isCompressionSupported(type)) {
+        type = CompressionType::LZ_COMPRESSION;
+    }
+    switch (type) {
+#ifdef TOMATO_HAVE_ZSTD
+        case CompressionType::ZSTD_COMPRESSION: {
+            output.resize(ZSTD_compressBound(raw.size()));
+            ZSTD_CCtx* context = ZSTD_createCCtx();
+            const size_t size = ZSTD_compress_usingDict(context, &output[0], output.size(), raw.data(), raw.size(),
+                                                        dict.data(), dict.size(), ZSTD_LEVEL);
+            ZSTD_freeCCtx(context);
+            if (ZSTD_isError(size)) {
+                return CompressionType::NO_COMPRESSION;
+            }
+            output.resize(size);
+            return type;
+        }
+#endif
+#ifdef TOMATO_HAVE_LZ4
+        case CompressionType::LZ4_COMPRESSION: {
+            // lz4的块格式不记录原始长度, 在前面加上变长的原始长度
+            output = codec::encodeVar64(raw.size());
+            const size_t header_size = output.size();
+            const int bound = LZ4_compressBound(static_cast<int>(raw.size()));
+            output.resize(header_size + static_cast<size_t>(bound));
+            LZ4_stream_t* stream = LZ4_createStream();
+            LZ4_loadDict(stream, dict.data(), static_cast<int>(dict.size()));
+            const int size = LZ4_compress_fast_continue(stream, raw.data(), &output[header_size], 
+                                                        static_cast<int>(raw.size()), bound, 1);
+            LZ4_freeStream(stream);
+            if (size <= 0) {
+                return CompressionType::NO_COMPRESSION;
+            }
+            output.resize(header_size + static_cast<size_t>(size));
+            return type;
+        }
+#endif
+        default:
+            lz::compressWithDict(dict.data(), dict.size(), raw.data(), raw.size(), output);
+            return CompressionType::LZ_COMPRESSION;
+    }
+}
+
+bool uncompressBlock(CompressionType type, const char* data, size_t size, const std::string& dict, 
+                     std::string& output) {
+    switch (type) {
+        case CompressionType::NO_COMPRESSION:
+            output.assign(data, size);
+            return true;
+        case CompressionType::LZ_COMPRESSION:
+            return lz::decompressWithDict(dict.data(), dict.size(), data, size, output);
+#ifdef TOMATO_HAVE_ZSTD
+        case CompressionType::ZSTD_COMPRESSION: {
+            const unsigned long long raw_size = ZSTD_getFrameContentSize(data, size);
+            if (raw_size == ZSTD_CONTENTSIZE_ERROR || raw_size == ZSTD_CONTENTSIZE_UNKNOWN) {
+                return false;
+            }
+            output.resize(static_cast<size_t>(raw_size));
+            ZSTD_DCtx* context = ZSTD_createDCtx();
+            const size_t res = ZSTD_decompress_usingDict(context, &output[0], output.size(), data, size, 
+                                                         dict.data(), dict.size());
+            ZSTD_freeDCtx(context);
+            return !ZSTD_isError(res) && res == output.size();
+        }
+#endif
+#ifdef TOMATO_HAVE_LZ4
+        case CompressionType::LZ4_COMPRESSION: {
+            std::pair<uint64_t, int> res = codec::decodeVar64(data, data + size);
+            if (res.second == 0 || res.first > static_cast<uint64_t>(INT32_MAX)) {
+                return false;
+            }
+            output.resize(static_cast<size_t>(res.first));
+            const int raw_size = LZ4_decompress_safe_usingDict(data + res.second, &output[0], 
+                                                               static_cast<int>(size - static_cast<size_t>(res.second)),
+                                                               static_cast<int>(output.size()), 
+                                                               dict.data(), static_cast<int>(dict.size()));
+            return raw_size >= 0 && static_cast<size_t>(raw_size) == output.size();
+        }
+#endif
+        default:
+            return false;
+    }
+}
+
+}
@@ -0,0 +1,147 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 23:14:19
+ * @LastEditTime: 2026-10-18 23:14:19
+ */
+#include <tomato_db/cuckoo_index.h>
+#include <tomato_common/codec.h>
+#include <tomato_common/hash.h>
+
+#include <utility>
+
+namespace tomato {
+
+/**
+ * @brief 两个候选桶与标签使用不同的种子
+ * 
+ */
+static const uint32_t CUCKOO_SEEDS[2] = {0x9e3779b1, 0x85ebca77};
+static const uint32_t CUCKOO_TAG_SEED = 0xc2b2ae3d;
+
+/**
+ * @brief 桶数按这个装载率估计, 放置失败时增加四分之一
+ * 
+ */
+static const double CUCKOO_LOAD_FACTOR = 0.9;
+
+/**
+ * @brief 放置一个键时最多踢出的次数
+ * 
+ */
+static const int CUCKOO_MAX_KICKS = 500;
+
+CuckooIndexBuilder::CuckooIndexBuilder()
+    : items_(),
+      result_() {}
+
+void CuckooIndexBuilder::add(const std::string& user_key, uint64_t offset) {
+    Item item;
+    for (int i = 0; i < 2; ++i) {
+        item.buckets[i] = hashBytes(user_key.data(), user_key.size(), CUCKOO_SEEDS[i]);
+    }
+    item.tag = hashBytes(user_key.data(), user_key.size(), CUCKOO_TAG_SEED);
+    item.offset = offset;
+    items_.push_back(item);
+}
+
+bool CuckooIndexBuilder::place(uint64_t bucket_count, std::vector<int64_t>& slots) const {
+    slots.assign(static_cast<size_t>(bucket_count * CUCKOO_BUCKET_SLOTS), -1);
+    // 固定种子的xorshift, 同样的输入生成同样的文件
+    uint64_t random = 0x2545f4914f6cdd1dull;
+    for (size_t i = 0; i < items_.size(); ++i) {
+        int64_t current = static_cast<int64_t>(i);
+        uint64_t bucket = items_[i].buckets[0] % bucket_count;
+        for (int kick = 0; kick <= CUCKOO_MAX_KICKS; ++kick) {
+            const Item& item = items_[static_cast<size_t>(current)];
+            const uint64_t candidates[2] = {item.buckets[0] % bucket_count, item.buckets[1] % bucket_count};
+            bool placed = false;
+            for (uint64_t candidate : candidates) {
+                for (size_t slot = 0; slot < CUCKOO_BUCKET_SLOTS && !placed; ++slot) {
+                    int64_t& target = slots[static_cast<size_t>(candidate * CUCKOO_BUCKET_SLOTS + slot)];
+                    if (target < 0) {
+                        target = current;
+                        placed = true;
+                    }
+                }
+            }
+            if (placed) {
+                break;
+            }
+            if (kick == CUCKOO_MAX_KICKS) {
+                return false;
+            }
+            // 两个桶都满了: 轮流选择桶, 随机踢出一个键, 被踢出的键放到它的另一个桶
+            bucket = bucket == candidates[0] ? candidates[1] : candidates[0];
+            random ^= random << 13;
+            random ^= random >> 7;
+            random ^= random << 17;
+            int64_t& victim = slots[static_cast<size_t>(bucket * CUCKOO_BUCKET_SLOTS + random % CUCKOO_BUCKET_SLOTS)];
+            std::swap(victim, current);
+        }
+    }
+    return true;
+}
+
+const std::string& CuckooIndexBuilder::finish() {
+    uint64_t bucket_count = static_cast<uint64_t>(
+            static_cast<double>(items_.size()) / (CUCKOO_BUCKET_SLOTS * CUCKOO_LOAD_FACTOR)) + 1;
+    std::vector<int64_t> slots;
+    while (!place(bucket_count, slots)) {
+        bucket_count += bucket_count / 4 + 1;
+    }
+    result_.reserve(slots.size() * CUCKOO_SLOT_SIZE + sizeof(uint64_t));
+    for (int64_t index : slots) {
+        if (index < 0) {
+            result_.append(CUCKOO_SLOT_SIZE, '\0');
+            continue;
+        }
+        const Item& item = items_[static_cast<size_t>(index)];
+        result_.append(codec::encodeFixed64(item.offset + 1));
+        result_.append(codec::encodeFixed32(item.tag));
+        result_.append(codec::encodeFixed32(0));
+    }
+    result_.append(codec::encodeFixed64(bucket_count));
+    return result_;
+}
+
+CuckooIndexReader::CuckooIndexReader()
+    : data_(nullptr),
+      bucket_count_(0) {}
+
+bool CuckooIndexReader::init(const char* data, size_t size) {
+    if (size < sizeof(uint64_t)) {
+        return false;
+    }
+    const uint64_t bucket_count = codec::decodeFixed64(data + size - sizeof(uint64_t));
+    if (bucket_count == 0 || bucket_count > size / CUCKOO_BUCKET_SIZE ||
+            bucket_count * CUCKOO_BUCKET_SIZE + sizeof(uint64_t) != size) {
+        return false;
+    }
+    data_ = data;
+    bucket_count_ = bucket_count;
+    return true;
+}
+
+size_t CuckooIndexReader::getCandidates(const std::string& user_key, uint64_t* offsets) const {
+    const uint32_t tag = hashBytes(user_key.data(), user_key.size(), CUCKOO_TAG_SEED);
+    size_t count = 0;
+    uint64_t previous = bucket_count_;
+    for (uint32_t seed : CUCKOO_SEEDS) {
+        const uint64_t bucket = hashBytes(user_key.data(), user_key.size(), seed) % bucket_count_;
+        if (bucket == previous) {
+            // 两个候选桶相同
+            break;
+        }
+        previous = bucket;
+        const char* slot = data_ + bucket * CUCKOO_BUCKET_SIZE;
+        for (size_t i = 0; i < CUCKOO_BUCKET_SLOTS; ++i, slot += CUCKOO_SLOT_SIZE) {
+            const uint64_t offset = codec::decodeFixed64(slot);
+            if (offset != 0 && codec::decodeFixed32(slot + sizeof(uint64_t)) == tag) {
+                offsets[count++] = offset - 1;
+            }
+        }
+    }
+    return count;
+}
+
+}
@@ -1,10 +1,1031 @@
 /*
  * @Author: Tomato
  * @Date: 2022-01-26 23:00:43
- * @LastEditTime: 2022-11-24 09:24:20
+ * @LastEditTime: 2026-10-19 00:43:08
  */
-#include <tomato_db/db.h>
+#include <tomato_db/db_impl.h>
+#include <tomato_db/blob_file.h>
+#include <tomato_db/compaction_iterator.h>
+#include <tomato_db/compaction_job.h>
+#include <tomato_db/db_iterator.h>
+#include <tomato_db/merging_iterator.h>
+#include <tomato_db/filename.h>
+#include <tomato_db/log_replayer.h>
+#include <tomato_db/sstable_builder.h>
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <iterator>
+#include <thread>
 
 namespace tomato {
-    
+
+/**
+ * @brief 停止的写入每隔这么久重新检查一次, 协助执行没有被其他线程执行的合并
+ * 
+ */
+static const uint64_t STALL_RETRY_MICROS = 10000;
+
+DBImpl::DBImpl(const DataBaseConfig& config)
+    : config_(config),
+      memtable_(std::make_shared<MemoryTable>(config.write_buffer_manager)),
+      memtable_mutex_(),
+      immutables_(),
+      immutable_cv_(),
+      installing_(false),
+      pending_outputs_(),
+      background_status_(OperatorResult::success()),
+      flush_requested_(false),
+      write_buffer_owner_(0),
+      write_controller_(config.delayed_write_rate),
+      stall_mutex_(),
+      log_file_(),
+      log_writer_(),
+      versions_(config.db_path),
+      block_cache_(config.block_cache ? config.block_cache : 
+                   config.block_cache_size > 0 ? std::make_shared<BlockCache>(config.block_cache_size) : nullptr),
+      table_cache_(config.db_path, block_cache_.get()),
+      blob_cache_(config.db_path),
+      read_pool_(config.read_threads),
+      pipeline_([this](const std::vector<WriteBatch*>& batches, bool sync) { return writeLog(batches, sync); },
+                [this](const WriteBatch& batch) { return writeMemoryTable(batch); },
+                config.max_write_group_bytes),
+      flush_pool_(config.flush_threads) {}
+
+DBImpl::~DBImpl() {
+    // 先注销, 之后写缓冲区管理不会再请求这个数据库刷写
+    if (write_buffer_owner_ != 0) {
+        config_.write_buffer_manager->removeOwner(write_buffer_owner_);
+    }
+    if (log_file_ && log_file_->isOpen()) {
+        log_file_->close();
+    }
+}
+
+OperatorResult DBImpl::open() {
+    OperatorResult status = createDir(config_.db_path);
+    if (!status.isSuccess()) {
+        return status;
+    }
+    status = versions_.recover();
+    if (!status.isSuccess()) {
+        return status;
+    }
+
+    VersionEdit edit;
+    status = recover(edit);
+    if (!status.isSuccess()) {
+        return status;
+    }
+
+    // 回放的数据都已写入SSTable, 新日志之前的日志都不再需要
+    const uint64_t log_number = versions_.newFileNumber();
+    edit.setLogNumber(log_number);
+    status = versions_.logAndApply(edit);
+    if (!status.isSuccess()) {
+        return status;
+    }
+
+    log_file_ = createAppendOnlyFile(logFileName(config_.db_path, log_number), 
+                                     config_.log_file_options);
+    if (!log_file_->isOpen()) {
+        return {errno, "create log file error, filename: " + log_file_->getFileName()};
+    }
+    // 新日志的目录项落盘后, 写入它的数据才能在崩溃后回放
+    status = syncDir(config_.db_path);
+    if (!status.isSuccess()) {
+        return status;
+    }
+    log_writer_.reset(new log::LogWriter(log_file_.get()));
+    removeObsoleteFiles(true);
+    status = runPendingCompactions();
+    updateWriteStallCondition();
+    if (status.isSuccess() && config_.write_buffer_manager) {
+        write_buffer_owner_ = config_.write_buffer_manager->addOwner([this] { return getActiveMemoryUsage(); }, 
+                                                                     [this] { requestFlush(); });
+    }
+    return status;
+}
+
+OperatorResult DBImpl::recover(VersionEdit& edit) {
+    std::vector<std::string> children;
+    OperatorResult status = listDir(config_.db_path, children);
+    if (!status.isSuccess()) {
+        return status;
+    }
+
+    const uint64_t min_log_number = versions_.getLogNumber();
+    std::vector<uint64_t> log_numbers;
+    for (const std::string& child : children) {
+        uint64_t number = 0;
+        FileType type = parseFileName(child, number);
+        if (type == FileType::LOG_FILE || type == FileType::TABLE_FILE || type == FileType::BLOB_FILE) {
+            versions_.markFileNumberUsed(number);
+        }
+        if (type == FileType::LOG_FILE && number >= min_log_number) {
+            log_numbers.push_back(number);
+        }
+    }
+    std::sort(log_numbers.begin(), log_numbers.end());
+    std::vector<std::string> log_files;
+    for (uint64_t number : log_numbers) {
+        log_files.push_back(logFileName(config_.db_path, number));
+    }
+
+    // 回放线程写满的内存表直接写成第0层的SSTable, 回调只在回放器的刷写线程上串行执行;
+    // 恢复期间没有快照, 只需保留每个键的最新版本
+    log::ReplayOptions options;
+    options.decode_threads = config_.replay_threads;
+    options.write_buffer_size = config_.write_buffer_size;
+    log::LogReplayer replayer(options, [this, &edit](std::shared_ptr<MemoryTable> memtable) { 
+        return writeLevel0Table(memtable, MAX_SEQUENCE, edit);
+    });
+    uint64_t max_sequence = 0;
+    status = replayer.replay(log_files, memtable_, max_sequence);
+    if (!status.isSuccess()) {
+        return status;
+    }
+
+    status = writeLevel0Table(memtable_, MAX_SEQUENCE, edit);
+    if (!status.isSuccess()) {
+        return status;
+    }
+    memtable_ = std::make_shared<MemoryTable>(config_.write_buffer_manager);
+
+    max_sequence = std::max(max_sequence, versions_.getLastSequence());
+    edit.setLastSequence(max_sequence);
+    pipeline_.setLastSequence(max_sequence);
+    return OperatorResult::success();
+}
+
+OperatorResult DBImpl::writeLevel0Table(std::shared_ptr<const MemoryTable> memtable, uint64_t smallest_snapshot,
+                                        VersionEdit& edit, uint64_t file_number) {
+    if (memtable->empty()) {
+        // 空内存表不产生文件
+        return OperatorResult::success();
+    }
+
+    FileMeta meta;
+    meta.number = file_number != 0 ? file_number : versions_.newFileNumber();
+    const std::string filename = tableFileName(config_.db_path, meta.number);
+    std::shared_ptr<AppendOnlyFile> file = createAppendOnlyFile(filename);
+    if (!file->isOpen()) {
+        return {errno, "create table file error, filename: " + filename};
+    }
+    SSTableBuilder builder(config_.table_config, file.get());
+    std::vector<RangeTombstone> tombstones;
+    memtable->getRangeTombstones(tombstones);
+    RangeDelAggregator range_del(smallest_snapshot);
+    for (const RangeTombstone& tombstone : tombstones) {
+        range_del.add(tombstone);
+    }
+    range_del.finish();
+
+    // 更深的层中可能还有这个键, 合并操作数只有遇到旧值或删除标记时才能完全合并
+    MemoryTableIterator input(memtable);
+    CompactionIterator iter(&input, smallest_snapshot, &range_del, config_.merge_operator.get(), 
+                            [](const std::string&) { return false; });
+    // 大值只在这里写一次blob文件, 之后的合并只移动它的位置
+    BlobFileBuilder blob_builder(config_.db_path, &versions_, config_.blob_options);
+    OperatorResult status = OperatorResult::success();
+    ParsedInternalKey parsed_key;
+    std::string blob_index;
+    for (iter.seekToFirst(); iter.valid(); iter.next()) {
+        if (!parseInternalKey(iter.key(), parsed_key)) {
+            break;
+        }
+        if (parsed_key.type == ItemType::VALUE && blob_builder.shouldSeparate(iter.value())) {
+            status = blob_builder.add(parsed_key.user_key, iter.value(), blob_index);
+            if (!status.isSuccess()) {
+                break;
+            }
+            builder.add(encodeInternalKey(parsed_key.user_key, parsed_key.seq, ItemType::BLOB_INDEX), blob_index);
+        } else {
+            builder.add(iter.key(), iter.value());
+        }
+        extendFileRange(meta, iter.key(), parsed_key.seq);
+    }
+    // 文件的键范围包含范围删除标记, 查找被遮住的键时才会读到这个文件
+    for (const RangeTombstone& tombstone : tombstones) {
+        builder.addRangeTombstone(tombstone);
+        extendFileRange(meta, encodeInternalKey(tombstone.begin, tombstone.seq, ItemType::RANGE_DELETION), tombstone.seq);
+        extendFileRange(meta, encodeRangeEndKey(tombstone.end), tombstone.seq);
+    }
+
+    if (status.isSuccess()) {
+        status = iter.getStatus();
+    }
+    if (status.isSuccess()) {
+        status = blob_builder.finish();
+    }
+    if (status.isSuccess()) {
+        status = builder.finish();
+    }
+    if (status.isSuccess()) {
+        status = file->sync();
+    }
+    if (status.isSuccess()) {
+        status = file->close();
+    }
+    if (!status.isSuccess()) {
+        removeFile(filename);
+        blob_builder.abandon();
+        return status;
+    }
+    meta.file_size = builder.getFileSize();
+    edit.addFile(0, meta);
+    for (const BlobFileMeta& blob_file : blob_builder.getOutputs()) {
+        edit.addBlobFile(blob_file);
+    }
+    return OperatorResult::success();
+}
+
+OperatorResult DBImpl::switchMemoryTable(uint64_t first_sequence) {
+    {
+        std::unique_lock<std::mutex> lock(memtable_mutex_);
+        if (immutables_.size() >= config_.max_immutable_memtables) {
+            // 不可变内存表达到上限, 整个写入流水线停止等待刷写
+            const uint64_t start = WriteController::nowMicros();
+            immutable_cv_.wait(lock, [this] { 
+                return immutables_.size() < config_.max_immutable_memtables || !background_status_.isSuccess(); 
+            });
+            write_controller_.recordStop(WriteController::nowMicros() - start);
+        }
+        if (!background_status_.isSuccess()) {
+            return background_status_;
+        }
+    }
+    // 之前的组可能还在写旧内存表, 之后的组要等本组写完日志才会开始, 等待之后没有线程在写内存表
+    pipeline_.waitForPublished(first_sequence - 1);
+
+    // 先分配新日志再分配SSTable编号, 刷写后的日志编号不会大于它写出的文件
+    const uint64_t log_number = versions_.newFileNumber();
+    std::shared_ptr<AppendOnlyFile> log_file = createAppendOnlyFile(logFileName(config_.db_path, log_number), 
+                                                                    config_.log_file_options);
+    if (!log_file->isOpen()) {
+        return {errno, "create log file error, filename: " + log_file->getFileName()};
+    }
+    // 新日志的目录项落盘后, 写入它的数据才能在崩溃后回放
+    OperatorResult status = syncDir(config_.db_path);
+    if (!status.isSuccess()) {
+        return status;
+    }
+    std::shared_ptr<ImmutableMemoryTable> immutable = std::make_shared<ImmutableMemoryTable>();
+    immutable->file_number = versions_.newFileNumber();
+    immutable->log_number = log_number;
+    immutable->last_sequence = first_sequence - 1;
+    {
+        std::lock_guard<std::mutex> lock(memtable_mutex_);
+        immutable->memtable = memtable_;
+        immutable->memtable->markImmutable();
+        immutables_.push_back(immutable);
+        pending_outputs_.insert(immutable->file_number);
+        memtable_ = std::make_shared<MemoryTable>(config_.write_buffer_manager);
+    }
+
+    // 旧日志在内存表刷写前仍需保留, 只需关闭
+    status = log_file_->close();
+    log_file_ = log_file;
+    log_writer_.reset(new log::LogWriter(log_file_.get()));
+    updateWriteStallCondition();
+    flush_pool_.submit([this, immutable] { flushImmutable(immutable); });
+    return status;
+}
+
+void DBImpl::flushImmutable(const std::shared_ptr<ImmutableMemoryTable>& immutable) {
+    VersionEdit edit;
+    OperatorResult status = writeLevel0Table(immutable->memtable, getOldestSnapshot(), edit, 
+                                             immutable->file_number);
+    std::unique_lock<std::mutex> lock(memtable_mutex_);
+    immutable->flushed = true;
+    immutable->status = status;
+    immutable->edit = edit;
+    if (installing_) {
+        // 正在应用的线程会继续应用这个结果
+        return;
+    }
+
+    // 刷写可以乱序完成, 但必须按内存表的新旧顺序应用, 日志编号与第0层的顺序才不会倒退
+    installing_ = true;
+    while (!immutables_.empty() && immutables_.front()->flushed && background_status_.isSuccess()) {
+        std::shared_ptr<ImmutableMemoryTable> front = immutables_.front();
+        status = front->status;
+        if (status.isSuccess()) {
+            front->edit.setLogNumber(front->log_number);
+            front->edit.setLastSequence(front->last_sequence);
+            lock.unlock();
+            status = versions_.logAndApply(front->edit);
+            lock.lock();
+        }
+        if (!status.isSuccess()) {
+            // 内存表留在队列中仍可读取, 数据保留在日志里, 重新打开时回放
+            background_status_ = status;
+            break;
+        }
+        immutables_.pop_front();
+        pending_outputs_.erase(pending_outputs_.find(front->file_number));
+    }
+    installing_ = false;
+    immutable_cv_.notify_all();
+    lock.unlock();
+
+    updateWriteStallCondition();
+    removeObsoleteFiles();
+    runPendingCompactions(false);
+}
+
+void DBImpl::requestFlush() {
+    flush_requested_.store(true);
+    WriteBatch batch;
+    pipeline_.write(&batch, false);
+}
+
+void DBImpl::updateWriteStallCondition() {
+    std::lock_guard<std::mutex> stall_lock(stall_mutex_);
+    size_t immutable_count = 0;
+    {
+        std::lock_guard<std::mutex> lock(memtable_mutex_);
+        immutable_count = immutables_.size();
+    }
+    std::shared_ptr<const Version> version = versions_.current();
+    const int l0_files = static_cast<int>(version->getFiles(0).size());
+    const uint64_t debt = version->estimateCompactionDebt(config_.l0_compaction_trigger, 
+                                                          config_.max_bytes_for_level_base);
+
+    // 第0层未达到合并阈值时合并不会减少文件, 停止阈值低于合并阈值会使写入永远停止
+    const int l0_stop = std::max(config_.level0_stop_writes_trigger, config_.l0_compaction_trigger);
+    const int l0_slowdown = std::min(config_.level0_slowdown_writes_trigger, l0_stop);
+    const uint64_t soft_limit = config_.soft_pending_compaction_bytes_limit;
+    const uint64_t hard_limit = config_.hard_pending_compaction_bytes_limit;
+    if (l0_files >= l0_stop || (hard_limit > 0 && debt >= hard_limit)) {
+        write_controller_.setCondition(WriteStallCondition::STOPPED);
+        return;
+    }
+
+    // 压力取各项指标中最接近停止阈值的一项, 越接近限速越低
+    bool delayed = false;
+    double pressure = 0;
+    if (l0_files >= l0_slowdown) {
+        delayed = true;
+        pressure = std::max(pressure, static_cast<double>(l0_files - l0_slowdown) / (l0_stop - l0_slowdown + 1));
+    }
+    if (soft_limit > 0 && debt >= soft_limit) {
+        delayed = true;
+        if (hard_limit > soft_limit) {
+            pressure = std::max(pressure, static_cast<double>(debt - soft_limit) / 
+                                          static_cast<double>(hard_limit - soft_limit));
+        }
+    }
+    // 不可变内存表达到上限时切换内存表会停止整个流水线, 差一个时先限速
+    if (config_.max_immutable_memtables >= 3 && immutable_count + 1 >= config_.max_immutable_memtables) {
+        delayed = true;
+    }
+    write_controller_.setCondition(delayed ? WriteStallCondition::DELAYED : WriteStallCondition::NORMAL, pressure);
+}
+
+OperatorResult DBImpl::delayWrite(size_t bytes) {
+    if (write_controller_.getCondition() == WriteStallCondition::STOPPED) {
+        const uint64_t start = WriteController::nowMicros();
+        while (write_controller_.getCondition() == WriteStallCondition::STOPPED) {
+            {
+                std::lock_guard<std::mutex> lock(memtable_mutex_);
+                if (!background_status_.isSuccess()) {
+                    return background_status_;
+                }
+            }
+            // 没有合并在执行时由停止的写入执行合并, 保证停止总能解除
+            OperatorResult status = runPendingCompactions(false);
+            if (!status.isSuccess()) {
+                return status;
+            }
+            updateWriteStallCondition();
+            write_controller_.waitWhileStopped(STALL_RETRY_MICROS);
+        }
+        write_controller_.recordStop(WriteController::nowMicros() - start);
+    }
+    const uint64_t delay = write_controller_.getDelay(bytes);
+    if (delay > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(delay));
+        write_controller_.recordDelay(delay);
+    }
+    return OperatorResult::success();
+}
+
+size_t DBImpl::getActiveMemoryUsage() {
+    std::lock_guard<std::mutex> lock(memtable_mutex_);
+    return memtable_->getMemoryUsage();
+}
+
+DBImpl::ReadView DBImpl::getReadView() {
+    // 刷写先应用版本再移除不可变内存表, 同一把锁下取得的数据源不会遗漏数据;
+    // 两步之间取得的版本已经包含队首的内存表, 按日志编号跳过, 否则合并操作数会被重复应用
+    ReadView view;
+    std::lock_guard<std::mutex> lock(memtable_mutex_);
+    uint64_t log_number = 0;
+    view.version = versions_.current(log_number);
+    view.memtable = memtable_;
+    for (auto it = immutables_.rbegin(); it != immutables_.rend() && (*it)->log_number > log_number; ++it) {
+        view.immutables.push_back((*it)->memtable);
+    }
+    return view;
+}
+
+void DBImpl::removeObsoleteFiles(bool remove_temp_files) {
+    std::vector<std::string> children;
+    if (!listDir(config_.db_path, children).isSuccess()) {
+        return;
+    }
+    // 正在刷写与合并的输出文件编号都不小于min_pending_output, 要在列出目录之后读取
+    uint64_t min_pending_output = UINT64_MAX;
+    {
+        std::lock_guard<std::mutex> lock(memtable_mutex_);
+        if (!pending_outputs_.empty()) {
+            min_pending_output = *pending_outputs_.begin();
+        }
+    }
+    // 仍在被读取的旧版本中的文件也不能删除
+    std::vector<uint64_t> live_tables;
+    versions_.getLiveFiles(live_tables);
+    const uint64_t log_number = versions_.getLogNumber();
+    for (const std::string& child : children) {
+        uint64_t number = 0;
+        FileType type = parseFileName(child, number);
+        bool obsolete = false;
+        if (type == FileType::LOG_FILE) {
+            obsolete = number < log_number;
+        } else if (type == FileType::TABLE_FILE || type == FileType::BLOB_FILE) {
+            obsolete = number < min_pending_output && 
+                       std::find(live_tables.begin(), live_tables.end(), number) == live_tables.end();
+        } else if (type == FileType::TEMP_FILE) {
+            obsolete = remove_temp_files;
+        }
+        if (obsolete) {
+            if (type == FileType::TABLE_FILE) {
+                table_cache_.evict(number);
+            } else if (type == FileType::BLOB_FILE) {
+                blob_cache_.evict(number);
+            }
+            removeFile(config_.db_path + "/" + child);
+        }
+    }
+}
+
+OperatorResult DBImpl::runPendingCompactions(bool wait) {
+    std::unique_lock<std::mutex> lock(compaction_mutex_, std::defer_lock);
+    if (wait) {
+        lock.lock();
+    } else if (!lock.try_lock()) {
+        return OperatorResult::success();
+    }
+    OperatorResult status = dropCoveredFiles();
+    while (status.isSuccess()) {
+        // 每次修改版本后立即更新限流状态, 不等所有合并结束
+        updateWriteStallCondition();
+        std::unique_ptr<Compaction> compaction = versions_.pickCompaction(config_.l0_compaction_trigger, 
+                                                                          config_.max_bytes_for_level_base);
+        if (!compaction) {
+            break;
+        }
+        status = runCompaction(*compaction);
+    }
+    return status;
+}
+
+OperatorResult DBImpl::runCompaction(const Compaction& compaction) {
+    VersionEdit edit;
+    if (!compaction.manual && compaction.inputs[0].size() == 1 && compaction.inputs[1].empty()) {
+        // 下一层没有相交的文件, 直接把文件移动到下一层
+        const FileMeta& file = compaction.inputs[0].front();
+        edit.deleteFile(compaction.level, file.number);
+        edit.addFile(compaction.level + 1, file);
+        return versions_.logAndApply(edit);
+    }
+
+    // 合并的输出文件在应用到版本之前不能被当作过时文件删除
+    uint64_t pending_output = 0;
+    {
+        std::lock_guard<std::mutex> lock(memtable_mutex_);
+        pending_output = versions_.getNextFileNumber();
+        pending_outputs_.insert(pending_output);
+    }
+    OperatorResult status = OperatorResult::success();
+    {
+        // 合并任务持有输入文件所在的版本, 删除文件前需要先释放
+        CompactionJob job(config_.db_path, config_.table_config, config_.target_file_size, 
+                          &table_cache_, &versions_, config_.merge_operator.get(), 
+                          &blob_cache_, config_.blob_options);
+        status = job.run(compaction, getOldestSnapshot(), edit);
+    }
+    if (status.isSuccess()) {
+        status = versions_.logAndApply(edit);
+    }
+    {
+        std::lock_guard<std::mutex> lock(memtable_mutex_);
+        pending_outputs_.erase(pending_outputs_.find(pending_output));
+    }
+    if (!status.isSuccess()) {
+        return status;
+    }
+    removeObsoleteFiles();
+    return OperatorResult::success();
+}
+
+OperatorResult DBImpl::dropCoveredFiles() {
+    // 只使用所有快照都能看到的标记, 文件中最新的版本也比标记旧时整个文件都不会再被读到;
+    // 内存表中的标记可能还没有落盘, 崩溃后标记丢失而文件已经删除, 只使用已经写入SSTable的标记
+    RangeDelAggregator range_del(getOldestSnapshot());
+    std::vector<RangeTombstone> tombstones;
+    std::shared_ptr<const Version> version = versions_.current();
+    for (int level = 0; level < NUM_LEVELS; ++level) {
+        for (const FileMeta& file : version->getFiles(level)) {
+            std::shared_ptr<SSTable> table;
+            OperatorResult status = table_cache_.findTable(file.number, file.file_size, table);
+            if (!status.isSuccess()) {
+                return status;
+            }
+            tombstones.insert(tombstones.end(), table->getRangeTombstones().begin(), 
+                              table->getRangeTombstones().end());
+        }
+    }
+    for (const RangeTombstone& tombstone : tombstones) {
+        range_del.add(tombstone);
+    }
+    range_del.finish();
+    if (range_del.empty()) {
+        return OperatorResult::success();
+    }
+
+    VersionEdit edit;
+    for (int level = 0; level < NUM_LEVELS; ++level) {
+        for (const FileMeta& file : version->getFiles(level)) {
+            if (range_del.isRangeDeleted(extractUserKey(file.smallest), extractUserKey(file.largest), 
+                                         isRangeEndKey(file.largest), file.largest_seq)) {
+                edit.deleteFile(level, file.number);
+                if (!version->getBlobFiles().empty()) {
+                    OperatorResult status = collectBlobGarbage(file, edit);
+                    if (!status.isSuccess()) {
+                        return status;
+                    }
+                }
+            }
+        }
+    }
+    version.reset();
+    if (edit.deleted_files.empty()) {
+        return OperatorResult::success();
+    }
+    OperatorResult status = versions_.logAndApply(edit);
+    if (status.isSuccess()) {
+        removeObsoleteFiles();
+    }
+    return status;
+}
+
+OperatorResult DBImpl::collectBlobGarbage(const FileMeta& file, VersionEdit& edit) {
+    std::shared_ptr<SSTable> table;
+    OperatorResult status = table_cache_.findTable(file.number, file.file_size, table);
+    if (!status.isSuccess()) {
+        return status;
+    }
+    TableIteratorOptions table_options;
+    table_options.fill_cache = false;
+    SSTable::Iterator iter(table, table_options);
+    ParsedInternalKey parsed_key;
+    BlobIndex index;
+    for (iter.seekToFirst(); iter.valid(); iter.next()) {
+        if (parseInternalKey(iter.key(), parsed_key) && parsed_key.type == ItemType::BLOB_INDEX &&
+                index.decodeFrom(iter.value())) {
+            edit.addBlobGarbage(index.file_number, index.size);
+        }
+    }
+    return iter.getStatus();
+}
+
+uint64_t DBImpl::getOldestSnapshot() {
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+    if (snapshots_.empty()) {
+        return pipeline_.getLastSequence();
+    }
+    return *snapshots_.begin();
+}
+
+OperatorResult DBImpl::compactRange(const std::string& begin, const std::string& end) {
+    std::lock_guard<std::mutex> lock(compaction_mutex_);
+    OperatorResult status = dropCoveredFiles();
+    if (!status.isSuccess()) {
+        return status;
+    }
+
+    // 合并到与范围相交的最深一层为止
+    int max_level = 1;
+    {
+        std::shared_ptr<const Version> version = versions_.current();
+        for (int level = 1; level < NUM_LEVELS; ++level) {
+            for (const FileMeta& file : version->getFiles(level)) {
+                if (fileOverlapsRange(file, begin, end)) {
+                    max_level = level;
+                    break;
+                }
+            }
+        }
+    }
+    for (int level = 0; level < max_level; ++level) {
+        std::unique_ptr<Compaction> compaction = versions_.compactRange(level, begin, end);
+        if (!compaction) {
+            continue;
+        }
+        status = runCompaction(*compaction);
+        if (!status.isSuccess()) {
+            return status;
+        }
+        updateWriteStallCondition();
+    }
+    return OperatorResult::success();
+}
+
+OperatorResult DBImpl::put(const std::string& key, const std::string& value) {
+    WriteBatch batch;
+    batch.put(key, value);
+    return write(batch);
+}
+
+OperatorResult DBImpl::del(const std::string& key) {
+    WriteBatch batch;
+    batch.del(key);
+    return write(batch);
+}
+
+OperatorResult DBImpl::merge(const std::string& key, const std::string& operand) {
+    if (!config_.merge_operator) {
+        return {EINVAL, "merge operator is not set"};
+    }
+    WriteBatch batch;
+    batch.merge(key, operand);
+    return write(batch);
+}
+
+OperatorResult DBImpl::deleteRange(const std::string& begin, const std::string& end) {
+    WriteBatch batch;
+    batch.deleteRange(begin, end);
+    return write(batch);
+}
+
+OperatorResult DBImpl::write(WriteBatch& batch) {
+    if (batch.getCount() == 0) {
+        return OperatorResult::success();
+    }
+    // 所有数据库的内存表超出共同的预算时, 先让活跃内存最多的数据库封存内存表
+    if (config_.write_buffer_manager && config_.write_buffer_manager->shouldFlush()) {
+        config_.write_buffer_manager->flushLargest();
+    }
+    OperatorResult status = delayWrite(batch.getContent().size());
+    if (!status.isSuccess()) {
+        return status;
+    }
+    return pipeline_.write(&batch, config_.sync_write);
+}
+
+std::shared_ptr<std::string> DBImpl::get(const std::string& key) {
+    // 只读取已发布的序列号, 正在写入内存表的批次整体不可见
+    const uint64_t snapshot = pipeline_.getLastSequence();
+    ReadView view = getReadView();
+    std::string value;
+    bool deleted = false;
+    std::vector<std::string> operands;
+    if (view.memtable->lookup(key, snapshot, value, deleted, operands)) {
+        return resolveValue(key, deleted ? nullptr : &value, operands);
+    }
+    for (const std::shared_ptr<MemoryTable>& immutable : view.immutables) {
+        if (immutable->lookup(key, snapshot, value, deleted, operands)) {
+            return resolveValue(key, deleted ? nullptr : &value, operands);
+        }
+    }
+
+    SSTable::LookupResult result;
+    if (!getFromTables(*view.version, key, snapshot, result, operands).isSuccess()) {
+        return std::shared_ptr<std::string>(nullptr);
+    }
+    return resolveValue(key, result.found && !result.deleted ? &result.value : nullptr, operands);
+}
+
+OperatorResult DBImpl::getFromTables(const Version& version, const std::string& key, uint64_t snapshot, 
+                                     SSTable::LookupResult& result, std::vector<std::string>& operands) {
+    std::vector<const FileMeta*> files;
+    version.getOverlappingFiles(key, files);
+    const std::string lookup_key = encodeLookupKey(key, snapshot);
+    for (const FileMeta* file : files) {
+        std::shared_ptr<SSTable> table;
+        OperatorResult status = table_cache_.findTable(file->number, file->file_size, table);
+        if (!status.isSuccess()) {
+            return status;
+        }
+        status = table->get(lookup_key, result);
+        operands.insert(operands.end(), result.operands.begin(), result.operands.end());
+        if (status.isSuccess() && result.found) {
+            status = readBlobValue(result);
+        }
+        if (!status.isSuccess() || result.found) {
+            return status;
+        }
+    }
+    return OperatorResult::success();
+}
+
+OperatorResult DBImpl::readBlobValue(SSTable::LookupResult& result) {
+    if (!result.blob_index) {
+        return OperatorResult::success();
+    }
+    std::string value;
+    OperatorResult status = blob_cache_.getBlob(result.value, value);
+    if (status.isSuccess()) {
+        result.value.swap(value);
+        result.blob_index = false;
+    }
+    return status;
+}
+
+std::shared_ptr<std::string> DBImpl::resolveValue(const std::string& key, const std::string* base, 
+                                                  std::vector<std::string>& operands) const {
+    if (operands.empty()) {
+        return base ? std::make_shared<std::string>(*base) : std::shared_ptr<std::string>(nullptr);
+    }
+    // 操作数是从新到旧收集的
+    std::reverse(operands.begin(), operands.end());
+    std::shared_ptr<std::string> value = std::make_shared<std::string>();
+    if (!config_.merge_operator || !config_.merge_operator->fullMerge(key, base, operands, *value)) {
+        return std::shared_ptr<std::string>(nullptr);
+    }
+    return value;
+}
+
+std::vector<std::shared_ptr<std::string>> DBImpl::multiGet(const std::vector<std::string>& keys) {
+    std::vector<OperatorResult> statuses;
+    return multiGet(keys, statuses);
+}
+
+std::vector<std::shared_ptr<std::string>> DBImpl::multiGet(const std::vector<std::string>& keys, 
+                                                           std::vector<OperatorResult>& statuses) {
+    const uint64_t snapshot = pipeline_.getLastSequence();
+    // 持有版本直到读完blob文件, 期间blob文件不会被删除
+    ReadView view = getReadView();
+    std::vector<std::shared_ptr<std::string>> values(keys.size());
+
+    // 排序去重, 相同的键只查找一次
+    std::vector<size_t> order(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&keys](size_t a, size_t b) { return keys[a] < keys[b]; });
+    std::vector<size_t> unique_keys;
+    for (size_t index : order) {
+        if (unique_keys.empty() || keys[unique_keys.back()] != keys[index]) {
+            unique_keys.push_back(index);
+        }
+    }
+
+    // 先从新到旧查内存表, 内存表中没有结果的键留给SSTable, 已经收集到的合并操作数随键保留
+    std::vector<size_t> pending;
+    std::vector<std::shared_ptr<std::string>> unique_values(keys.size());
+    std::vector<OperatorResult> unique_statuses(keys.size(), OperatorResult::success());
+    std::vector<std::vector<std::string>> operands(keys.size());
+    for (size_t index : unique_keys) {
+        std::string value;
+        bool deleted = false;
+        bool found = view.memtable->lookup(keys[index], snapshot, value, deleted, operands[index]);
+        for (size_t i = 0; !found && i < view.immutables.size(); ++i) {
+            found = view.immutables[i]->lookup(keys[index], snapshot, value, deleted, operands[index]);
+        }
+        if (!found) {
+            pending.push_back(index);
+        } else {
+            unique_values[index] = resolveValue(keys[index], deleted ? nullptr : &value, operands[index]);
+        }
+    }
+
+    // 按从新到旧的顺序查找每个SSTable, 只查找落在它键范围内且仍未找到的键
+    const std::shared_ptr<const Version>& version = view.version;
+    for (int level = 0; level < NUM_LEVELS && !pending.empty(); ++level) {
+        for (const FileMeta& file : version->getFiles(level)) {
+            if (pending.empty()) {
+                break;
+            }
+            const std::string smallest = extractUserKey(file.smallest);
+            const std::string largest = extractUserKey(file.largest);
+            std::vector<size_t> candidates;
+            std::vector<std::string> lookup_keys;
+            for (size_t index : pending) {
+                if (keys[index] >= smallest && keys[index] <= largest) {
+                    candidates.push_back(index);
+                    lookup_keys.push_back(encodeLookupKey(keys[index], snapshot));
+                }
+            }
+            if (candidates.empty()) {
+                continue;
+            }
+
+            std::shared_ptr<SSTable> table;
+            std::vector<SSTable::LookupResult> results(lookup_keys.size());
+            OperatorResult status = table_cache_.findTable(file.number, file.file_size, table);
+            if (status.isSuccess()) {
+                status = table->multiGet(lookup_keys, results, &read_pool_);
+            }
+            // 读取出错的键不能继续查找更旧的文件, 否则会读到已被覆盖或删除的值
+            std::vector<size_t> found;
+            for (size_t i = 0; i < candidates.size(); ++i) {
+                if (!status.isSuccess()) {
+                    unique_statuses[candidates[i]] = status;
+                    found.push_back(candidates[i]);
+                    continue;
+                }
+                std::vector<std::string>& key_operands = operands[candidates[i]];
+                key_operands.insert(key_operands.end(), results[i].operands.begin(), results[i].operands.end());
+                if (!results[i].found) {
+                    continue;
+                }
+                found.push_back(candidates[i]);
+                OperatorResult blob_status = readBlobValue(results[i]);
+                if (!blob_status.isSuccess()) {
+                    unique_statuses[candidates[i]] = blob_status;
+                    continue;
+                }
+                unique_values[candidates[i]] = resolveValue(keys[candidates[i]], 
+                                                            results[i].deleted ? nullptr : &results[i].value,
+                                                            key_operands);
+            }
+            // found与pending都是按键升序排列的
+            std::vector<size_t> remaining;
+            std::set_difference(pending.begin(), pending.end(), found.begin(), found.end(), 
+                                std::back_inserter(remaining), 
+                                [&keys](size_t a, size_t b) { return keys[a] < keys[b]; });
+            pending.swap(remaining);
+        }
+    }
+
+    // 所有数据源都没有旧值的键只合并操作数
+    for (size_t index : pending) {
+        unique_values[index] = resolveValue(keys[index], nullptr, operands[index]);
+    }
+
+    // 重复的键共享同一个结果
+    statuses.assign(keys.size(), OperatorResult::success());
+    size_t current = 0;
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (keys[order[i]] != keys[order[current]]) {
+            current = i;
+        }
+        values[order[i]] = unique_values[order[current]];
+        statuses[order[i]] = unique_statuses[order[current]];
+    }
+    return values;
+}
+
+std::vector<std::string> DBImpl::scan(const std::string& begin, const std::string& end) {
+    std::vector<std::string> result;
+    ReadOptions options;
+    options.upper_bound = end;
+    std::unique_ptr<Iterator> it = newIterator(options);
+    for (it->seek(begin); it->valid(); it->next()) {
+        result.push_back(it->value());
+    }
+    return result;
+}
+
+std::unique_ptr<Iterator> DBImpl::newIterator(const ReadOptions& options) {
+    // 先取序列号再取数据源, 之后发布的数据序列号更大, 对迭代器不可见
+    const uint64_t sequence = options.snapshot ? options.snapshot->getSequence() : pipeline_.getLastSequence();
+    ReadView view = getReadView();
+    std::shared_ptr<RangeDelAggregator> range_del = std::make_shared<RangeDelAggregator>(sequence);
+    std::unique_ptr<InternalIterator> iter = newInternalIterator(view, options.upper_bound, range_del.get(), nullptr);
+    range_del->finish();
+    if (range_del->empty()) {
+        range_del.reset();
+    }
+
+    const PrefixExtractor* prefix_extractor = config_.table_config.prefix_extractor.get();
+    InternalIteratorFactory factory;
+    if (options.prefix_seek && prefix_extractor) {
+        // 每次seek在同一组数据源上重新创建内部迭代器, 范围删除标记已经全部收集
+        const std::string upper_bound = options.upper_bound;
+        factory = [this, view, upper_bound](const std::string* prefix) {
+            return newInternalIterator(view, upper_bound, nullptr, prefix);
+        };
+    }
+    // 迭代器持有版本直到析构, 期间读取的blob文件不会被删除
+    return std::unique_ptr<Iterator>(new DBIterator(std::move(iter), sequence, options.upper_bound, range_del,
+                                                    config_.merge_operator.get(), prefix_extractor,
+                                                    std::move(factory), &blob_cache_, view.version));
+}
+
+std::unique_ptr<InternalIterator> DBImpl::newInternalIterator(const ReadView& view, const std::string& upper_bound,
+                                                              RangeDelAggregator* range_del,
+                                                              const std::string* prefix) {
+    const PrefixExtractor* prefix_extractor = prefix ? config_.table_config.prefix_extractor.get() : nullptr;
+    TableIteratorOptions table_options;
+    table_options.upper_bound = upper_bound;
+    if (prefix_extractor) {
+        table_options.prefix_extractor = prefix_extractor;
+        table_options.prefix = *prefix;
+    }
+    std::vector<std::unique_ptr<InternalIterator>> children;
+    children.emplace_back(new MemoryTableIterator(view.memtable));
+    for (const std::shared_ptr<MemoryTable>& immutable : view.immutables) {
+        children.emplace_back(new MemoryTableIterator(immutable));
+    }
+    std::vector<RangeTombstone> tombstones;
+    if (range_del) {
+        view.memtable->getRangeTombstones(tombstones);
+        for (const std::shared_ptr<MemoryTable>& immutable : view.immutables) {
+            immutable->getRangeTombstones(tombstones);
+        }
+    }
+    for (int level = 0; level < NUM_LEVELS; ++level) {
+        for (const FileMeta& file : view.version->getFiles(level)) {
+            std::shared_ptr<SSTable> table;
+            OperatorResult status = table_cache_.findTable(file.number, file.file_size, table);
+            if (!status.isSuccess()) {
+                children.push_back(newEmptyIterator(status));
+                continue;
+            }
+            if (range_del) {
+                tombstones.insert(tombstones.end(), table->getRangeTombstones().begin(), 
+                                  table->getRangeTombstones().end());
+            }
+            if (prefix_extractor == nullptr || table->prefixMayMatch(*prefix_extractor, *prefix)) {
+                children.emplace_back(new SSTable::Iterator(table, table_options));
+            }
+        }
+    }
+    for (const RangeTombstone& tombstone : tombstones) {
+        range_del->add(tombstone);
+    }
+    return std::unique_ptr<InternalIterator>(new MergingIterator(std::move(children)));
+}
+
+std::shared_ptr<const Snapshot> DBImpl::getSnapshot() {
+    std::lock_guard<std::mutex> lock(snapshot_mutex_);
+    const uint64_t sequence = pipeline_.getLastSequence();
+    snapshots_.insert(sequence);
+    return std::shared_ptr<const Snapshot>(new Snapshot(sequence), [this](const Snapshot* snapshot) {
+        {
+            std::lock_guard<std::mutex> guard(snapshot_mutex_);
+            snapshots_.erase(snapshots_.find(snapshot->getSequence()));
+        }
+        delete snapshot;
+    });
+}
+
+OperatorResult DBImpl::writeLog(const std::vector<WriteBatch*>& batches, bool sync) {
+    // 内存表写满或写缓冲区管理要求刷写时由leader切换, 本组的批次写入新的内存表与新的日志
+    const bool flush_requested = flush_requested_.exchange(false);
+    if (memtable_->getMemoryUsage() >= config_.write_buffer_size || (flush_requested && !memtable_->empty())) {
+        OperatorResult status = switchMemoryTable(batches.front()->getSequence());
+        if (!status.isSuccess()) {
+            return status;
+        }
+    }
+    {
+        // 日志写失败后文件末尾的内容不确定, 之后的写入都返回这个错误
+        std::lock_guard<std::mutex> lock(memtable_mutex_);
+        if (!background_status_.isSuccess()) {
+            return background_status_;
+        }
+    }
+    // 整组编码后一次写入, 每个批次仍是一条独立的日志记录; 请求刷写的空批次不写日志
+    std::string encoded;
+    for (WriteBatch* batch : batches) {
+        if (batch->getCount() > 0) {
+            log_writer_->encodeRecord(batch->getContent(), encoded);
+        }
+    }
+    if (encoded.empty()) {
+        return OperatorResult::success();
+    }
+    OperatorResult status = log_writer_->appendEncoded(encoded);
+    if (status.isSuccess() && sync) {
+        status = log_writer_->sync();
+    }
+    if (!status.isSuccess()) {
+        std::lock_guard<std::mutex> lock(memtable_mutex_);
+        if (background_status_.isSuccess()) {
+            background_status_ = status;
+        }
+        immutable_cv_.notify_all();
+    }
+    return status;
+}
+
+OperatorResult DBImpl::writeMemoryTable(const WriteBatch& batch) {
+    return batch.insertInto(memtable_.get(), true);
+}
+
+std::shared_ptr<DataBase> createDataBaseInstance(DataBaseConfig config_) {
+    std::shared_ptr<DBImpl> db = std::make_shared<DBImpl>(config_);
+    if (!db->open().isSuccess()) {
+        return std::shared_ptr<DataBase>(nullptr);
+    }
+    return db;
+}
+
 }
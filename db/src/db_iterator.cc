@@ -0,0 +1,349 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 19:20:07
+ * @LastEditTime: 2026-10-18 00:12:45
+ */
+#include <tomato_db/db_iterator.h>
+
+#include <algorithm>
+#include <cerrno>
+
+namespace tomato {
+
+/**
+ * @brief 大于所有以prefix开头的键的最小字符串
+ * 
+ * @return true 成功; false prefix全部由0xff组成, 不存在这样的字符串
+ */
+static bool prefixSuccessor(const std::string& prefix, std::string& successor) {
+    successor = prefix;
+    while (!successor.empty()) {
+        unsigned char last = static_cast<unsigned char>(successor.back());
+        if (last != 0xff) {
+            successor.back() = static_cast<char>(last + 1);
+            return true;
+        }
+        successor.pop_back();
+    }
+    return false;
+}
+
+DBIterator::DBIterator(std::unique_ptr<InternalIterator> iter, uint64_t sequence, std::string upper_bound,
+                       std::shared_ptr<const RangeDelAggregator> range_del, const MergeOperator* merge_operator,
+                       const PrefixExtractor* prefix_extractor, InternalIteratorFactory factory,
+                       BlobFileCache* blob_cache, std::shared_ptr<const Version> version)
+    : version_(std::move(version)),
+      iter_(std::move(iter)),
+      sequence_(sequence),
+      upper_bound_(std::move(upper_bound)),
+      range_del_(std::move(range_del)),
+      merge_operator_(merge_operator),
+      prefix_extractor_(factory ? prefix_extractor : nullptr),
+      factory_(std::move(factory)),
+      blob_cache_(blob_cache),
+      has_prefix_(false),
+      prefix_(),
+      direction_(Direction::FORWARD),
+      valid_(false),
+      saved_key_(),
+      saved_value_(),
+      status_(OperatorResult::success()) {}
+
+void DBIterator::seekToFirst() {
+    resetInternalIterator(nullptr);
+    direction_ = Direction::FORWARD;
+    iter_->seekToFirst();
+    findNextUserEntry(false, std::string());
+}
+
+void DBIterator::seekToLast() {
+    resetInternalIterator(nullptr);
+    direction_ = Direction::REVERSE;
+    if (upper_bound_.empty()) {
+        iter_->seekToLast();
+    } else {
+        // 定位到上界之前的最后一个版本
+        iter_->seek(encodeLookupKey(upper_bound_, MAX_SEQUENCE));
+        if (iter_->valid()) {
+            iter_->prev();
+        } else {
+            iter_->seekToLast();
+        }
+    }
+    findPrevUserEntry();
+}
+
+void DBIterator::seek(const std::string& key) {
+    if (prefix_extractor_ && prefix_extractor_->inDomain(key)) {
+        const std::string prefix = prefix_extractor_->transform(key);
+        resetInternalIterator(&prefix);
+    } else {
+        resetInternalIterator(nullptr);
+    }
+    direction_ = Direction::FORWARD;
+    iter_->seek(encodeLookupKey(key, sequence_));
+    findNextUserEntry(false, std::string());
+}
+
+void DBIterator::next() {
+    if (direction_ == Direction::REVERSE) {
+        // 内部迭代器停在当前键之前, 向后移动一步回到当前键的版本上, 再跳过当前键
+        direction_ = Direction::FORWARD;
+        if (!iter_->valid()) {
+            if (has_prefix_) {
+                iter_->seek(encodeLookupKey(prefix_, MAX_SEQUENCE));
+            } else {
+                iter_->seekToFirst();
+            }
+        } else {
+            iter_->next();
+        }
+    }
+    // 内部迭代器停在当前键的版本上或已经越过当前键, 跳过不大于当前键的版本即可
+    findNextUserEntry(true, saved_key_);
+}
+
+void DBIterator::prev() {
+    if (direction_ == Direction::FORWARD) {
+        // 内部迭代器停在当前键上或已经越过当前键, 向前移动到当前键的所有版本之前
+        if (!iter_->valid()) {
+            std::string prefix_end;
+            if (has_prefix_ && prefixSuccessor(prefix_, prefix_end)) {
+                // 前缀查找模式下从前缀之后的第一个键开始向前, 不必从最后一个键走回来
+                iter_->seek(encodeLookupKey(prefix_end, MAX_SEQUENCE));
+                if (iter_->valid()) {
+                    iter_->prev();
+                } else {
+                    iter_->seekToLast();
+                }
+            } else {
+                iter_->seekToLast();
+            }
+        }
+        ParsedInternalKey parsed_key;
+        while (true) {
+            if (!iter_->valid()) {
+                invalidate();
+                return;
+            }
+            if (!parseCurrentKey(parsed_key)) {
+                return;
+            }
+            if (parsed_key.user_key < saved_key_) {
+                break;
+            }
+            iter_->prev();
+        }
+        direction_ = Direction::REVERSE;
+    }
+    findPrevUserEntry();
+}
+
+OperatorResult DBIterator::getStatus() const {
+    if (!status_.isSuccess()) {
+        return status_;
+    }
+    return iter_->getStatus();
+}
+
+void DBIterator::findNextUserEntry(bool skipping, std::string skip) {
+    ParsedInternalKey parsed_key;
+    for (; iter_->valid(); iter_->next()) {
+        if (!parseCurrentKey(parsed_key)) {
+            return;
+        }
+        if (reachUpperBound(parsed_key.user_key) || outOfPrefix(parsed_key.user_key)) {
+            break;
+        }
+        if (parsed_key.seq > sequence_) {
+            continue;
+        }
+        if (skipping && parsed_key.user_key <= skip) {
+            continue;
+        }
+        if (isDeleted(parsed_key)) {
+            // 这个键的更旧版本都被删除标记遮住了
+            skip.swap(parsed_key.user_key);
+            skipping = true;
+            continue;
+        }
+        saved_key_.swap(parsed_key.user_key);
+        if (parsed_key.type == ItemType::MERGE) {
+            mergeValuesForward();
+            return;
+        }
+        if (parsed_key.type == ItemType::BLOB_INDEX) {
+            if (!readBlob(iter_->value(), saved_value_)) {
+                return;
+            }
+        } else {
+            saved_value_ = iter_->value();
+        }
+        valid_ = true;
+        return;
+    }
+    invalidate();
+}
+
+void DBIterator::mergeValuesForward() {
+    // 更旧的版本序列号更小, 都对快照可见
+    std::vector<std::string> operands(1, iter_->value());
+    bool has_base = false;
+    std::string base;
+    ParsedInternalKey parsed_key;
+    for (iter_->next(); iter_->valid(); iter_->next()) {
+        if (!parseCurrentKey(parsed_key)) {
+            return;
+        }
+        if (parsed_key.user_key != saved_key_ || isDeleted(parsed_key)) {
+            break;
+        }
+        if (parsed_key.type == ItemType::VALUE) {
+            has_base = true;
+            base = iter_->value();
+            break;
+        }
+        if (parsed_key.type == ItemType::BLOB_INDEX) {
+            has_base = true;
+            if (!readBlob(iter_->value(), base)) {
+                return;
+            }
+            break;
+        }
+        operands.push_back(iter_->value());
+    }
+    std::reverse(operands.begin(), operands.end());
+    resolveMerge(has_base ? &base : nullptr, operands);
+}
+
+bool DBIterator::resolveMerge(const std::string* base, const std::vector<std::string>& operands) {
+    std::string result;
+    if (merge_operator_ == nullptr) {
+        status_ = OperatorResult(EINVAL, "merge operator is not set");
+    } else if (!merge_operator_->fullMerge(saved_key_, base, operands, result)) {
+        status_ = OperatorResult(EINVAL, std::string("merge failed, operator: ") + merge_operator_->name());
+    }
+    if (!status_.isSuccess()) {
+        invalidate();
+        return false;
+    }
+    saved_value_.swap(result);
+    valid_ = true;
+    return true;
+}
+
+void DBIterator::findPrevUserEntry() {
+    // 反向遍历先遇到旧版本, 一直向前直到遇到更小的键, 最后看到的可见版本就是最新版本;
+    // 合并操作数按从旧到新的顺序收集, 遇到更新的值或删除标记时清空; blob文件中的值只在最后读取一次
+    ItemType value_type = ItemType::DELETION;
+    bool has_base = false;
+    bool base_in_blob = false;
+    std::vector<std::string> operands;
+    ParsedInternalKey parsed_key;
+    while (iter_->valid()) {
+        if (!parseCurrentKey(parsed_key)) {
+            return;
+        }
+        if (has_prefix_ && parsed_key.user_key < prefix_) {
+            // 前缀内的键都不小于前缀, 之前的键都在前缀之外
+            break;
+        }
+        if (parsed_key.seq <= sequence_ && !reachUpperBound(parsed_key.user_key) &&
+                !outOfPrefix(parsed_key.user_key)) {
+            if (value_type != ItemType::DELETION && parsed_key.user_key < saved_key_) {
+                break;
+            }
+            if (isDeleted(parsed_key)) {
+                value_type = ItemType::DELETION;
+                saved_key_.clear();
+                saved_value_.clear();
+                base_in_blob = false;
+                operands.clear();
+            } else if (parsed_key.type == ItemType::VALUE || parsed_key.type == ItemType::BLOB_INDEX) {
+                value_type = ItemType::VALUE;
+                saved_key_.swap(parsed_key.user_key);
+                saved_value_ = iter_->value();
+                base_in_blob = parsed_key.type == ItemType::BLOB_INDEX;
+                operands.clear();
+            } else {
+                if (value_type == ItemType::DELETION) {
+                    saved_key_.swap(parsed_key.user_key);
+                    saved_value_.clear();
+                }
+                if (value_type != ItemType::MERGE) {
+                    has_base = value_type == ItemType::VALUE;
+                }
+                value_type = ItemType::MERGE;
+                operands.push_back(iter_->value());
+            }
+        }
+        iter_->prev();
+    }
+
+    if (value_type == ItemType::DELETION) {
+        invalidate();
+        direction_ = Direction::FORWARD;
+        return;
+    }
+    if (base_in_blob) {
+        const std::string blob_index = saved_value_;
+        if (!readBlob(blob_index, saved_value_)) {
+            return;
+        }
+    }
+    if (value_type == ItemType::MERGE) {
+        const std::string base = saved_value_;
+        resolveMerge(has_base ? &base : nullptr, operands);
+    } else {
+        valid_ = true;
+    }
+}
+
+void DBIterator::resetInternalIterator(const std::string* prefix) {
+    if (!factory_) {
+        return;
+    }
+    if (prefix == nullptr) {
+        if (has_prefix_) {
+            iter_ = factory_(nullptr);
+            has_prefix_ = false;
+            prefix_.clear();
+        }
+        return;
+    }
+    if (!has_prefix_ || *prefix != prefix_) {
+        iter_ = factory_(prefix);
+        has_prefix_ = true;
+        prefix_ = *prefix;
+    }
+}
+
+bool DBIterator::readBlob(const std::string& blob_index, std::string& value) {
+    if (blob_cache_ == nullptr) {
+        status_ = OperatorResult(EINVAL, "blob file cache is not set");
+    } else {
+        status_ = blob_cache_->getBlob(blob_index, value);
+    }
+    if (!status_.isSuccess()) {
+        invalidate();
+        return false;
+    }
+    return true;
+}
+
+bool DBIterator::parseCurrentKey(ParsedInternalKey& parsed_key) {
+    if (!parseInternalKey(iter_->key(), parsed_key)) {
+        status_ = OperatorResult(EINVAL, "bad internal key");
+        invalidate();
+        return false;
+    }
+    return true;
+}
+
+void DBIterator::invalidate() {
+    valid_ = false;
+    saved_key_.clear();
+    saved_value_.clear();
+}
+
+}
@@ -0,0 +1,76 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 14:58:09
+ * @LastEditTime: 2026-10-18 22:41:13
+ */
+#include <tomato_db/filename.h>
+
+#include <cstdio>
+
+namespace tomato {
+
+/**
+ * @brief 拼接[目录]/[6位编号].[后缀]
+ * 
+ */
+static std::string makeFileName(const std::string& db_path, uint64_t number, const char* suffix) {
+    char buffer[32];
+    ::snprintf(buffer, sizeof(buffer), "/%06llu.%s", static_cast<unsigned long long>(number), suffix);
+    return db_path + buffer;
+}
+
+std::string logFileName(const std::string& db_path, uint64_t number) {
+    return makeFileName(db_path, number, "log");
+}
+
+std::string tableFileName(const std::string& db_path, uint64_t number) {
+    return makeFileName(db_path, number, "sst");
+}
+
+std::string blobFileName(const std::string& db_path, uint64_t number) {
+    return makeFileName(db_path, number, "blob");
+}
+
+std::string manifestFileName(const std::string& db_path) {
+    return db_path + "/MANIFEST";
+}
+
+std::string tempFileName(const std::string& filename) {
+    return filename + ".tmp";
+}
+
+FileType parseFileName(const std::string& filename, uint64_t& number) {
+    if (filename == "MANIFEST") {
+        return FileType::MANIFEST_FILE;
+    }
+    if (filename.size() > 4 && filename.compare(filename.size() - 4, 4, ".tmp") == 0) {
+        return FileType::TEMP_FILE;
+    }
+    size_t dot = filename.find('.');
+    if (dot == std::string::npos || dot == 0) {
+        return FileType::UNKNOWN_FILE;
+    }
+    uint64_t result = 0;
+    for (size_t i = 0; i < dot; ++i) {
+        if (filename[i] < '0' || filename[i] > '9') {
+            return FileType::UNKNOWN_FILE;
+        }
+        result = result * 10 + static_cast<uint64_t>(filename[i] - '0');
+    }
+    const std::string suffix = filename.substr(dot + 1);
+    if (suffix == "log") {
+        number = result;
+        return FileType::LOG_FILE;
+    }
+    if (suffix == "sst") {
+        number = result;
+        return FileType::TABLE_FILE;
+    }
+    if (suffix == "blob") {
+        number = result;
+        return FileType::BLOB_FILE;
+    }
+    return FileType::UNKNOWN_FILE;
+}
+
+}
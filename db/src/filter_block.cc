@@ -0,0 +1,182 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 23:46:03
+ * @LastEditTime: 2026-10-18 23:03:13
+ */
+#include <tomato_db/filter_block.h>
+#include <tomato_common/codec.h>
+#include <tomato_common/hash.h>
+
+namespace tomato {
+
+/**
+ * @brief 每个data block过滤器覆盖2KB的偏移量范围
+ * 
+ */
+static const int FILTER_BASE_LG = 11;
+
+static uint32_t bloomHash(const std::string& key) {
+    return hashBytes(key.data(), key.size(), 0xbc9f1d34);
+}
+
+void BloomFilter::create(const std::vector<std::string>& keys, int bits_per_key, std::string& dst) {
+    // 哈希函数个数取bits_per_key * ln2时误判率最低
+    size_t bits = keys.size() * static_cast<size_t>(bits_per_key);
+    if (bits < 64) {
+        bits = 64;
+    }
+    const size_t bytes = (bits + 7) / 8;
+    bits = bytes * 8;
+    int k = static_cast<int>(bits_per_key * 69 / 100);
+    if (k < 1) {
+        k = 1;
+    } else if (k > 30) {
+        k = 30;
+    }
+
+    const size_t init_size = dst.size();
+    dst.resize(init_size + bytes, 0);
+    dst.push_back(static_cast<char>(k));
+    char* array = &dst[init_size];
+    for (const std::string& key : keys) {
+        // 双重哈希: 用一个哈希值的旋转作为步长模拟k个哈希函数
+        uint32_t h = bloomHash(key);
+        const uint32_t delta = (h >> 17) | (h << 15);
+        for (int j = 0; j < k; ++j) {
+            const size_t bit_pos = h % bits;
+            array[bit_pos / 8] = static_cast<char>(array[bit_pos / 8] | (1 << (bit_pos % 8)));
+            h += delta;
+        }
+    }
+}
+
+bool BloomFilter::mayMatch(const std::string& key, const char* filter, size_t size) {
+    if (size < 2) {
+        return false;
+    }
+    const size_t bits = (size - 1) * 8;
+    const int k = static_cast<unsigned char>(filter[size - 1]);
+    if (k > 30) {
+        // 保留给以后的格式
+        return true;
+    }
+    uint32_t h = bloomHash(key);
+    const uint32_t delta = (h >> 17) | (h << 15);
+    for (int j = 0; j < k; ++j) {
+        const size_t bit_pos = h % bits;
+        if ((filter[bit_pos / 8] & (1 << (bit_pos % 8))) == 0) {
+            return false;
+        }
+        h += delta;
+    }
+    return true;
+}
+
+FilterBlockBuilder::FilterBlockBuilder(int bits_per_key, uint64_t base_offset)
+    : bits_per_key_(bits_per_key),
+      base_offset_(base_offset),
+      keys_(),
+      table_keys_(),
+      result_(),
+      filter_offsets_() {}
+
+void FilterBlockBuilder::startBlock(uint64_t block_offset) {
+    const uint64_t filter_index = (block_offset - base_offset_) >> FILTER_BASE_LG;
+    while (filter_index > filter_offsets_.size()) {
+        generateFilter();
+    }
+}
+
+void FilterBlockBuilder::addKey(const std::string& key) {
+    // 同一个前缀的键是连续的, 只需要和上一个键比较
+    if (keys_.empty() || keys_.back() != key) {
+        keys_.push_back(key);
+    }
+    if (table_keys_.empty() || table_keys_.back() != key) {
+        table_keys_.push_back(key);
+    }
+}
+
+const std::string& FilterBlockBuilder::finish() {
+    if (!keys_.empty()) {
+        generateFilter();
+    }
+    filter_offsets_.push_back(static_cast<uint32_t>(result_.size()));
+    BloomFilter::create(table_keys_, bits_per_key_, result_);
+
+    const uint32_t array_offset = static_cast<uint32_t>(result_.size());
+    for (uint32_t offset : filter_offsets_) {
+        result_.append(codec::encodeFixed32(offset));
+    }
+    result_.append(codec::encodeFixed32(array_offset));
+    result_.push_back(static_cast<char>(FILTER_BASE_LG));
+    return result_;
+}
+
+void FilterBlockBuilder::generateFilter() {
+    filter_offsets_.push_back(static_cast<uint32_t>(result_.size()));
+    if (keys_.empty()) {
+        // 这个范围内没有data block, 空过滤器不匹配任何键
+        return;
+    }
+    BloomFilter::create(keys_, bits_per_key_, result_);
+    keys_.clear();
+}
+
+FilterBlockReader::FilterBlockReader()
+    : contents_(),
+      data_(nullptr),
+      size_(0),
+      offsets_begin_(0),
+      filter_count_(0),
+      base_lg_(0) {}
+
+bool FilterBlockReader::init(std::string contents) {
+    contents_ = std::move(contents);
+    return init(contents_.data(), contents_.size());
+}
+
+bool FilterBlockReader::init(const char* data, size_t size) {
+    data_ = data;
+    size_ = size;
+    filter_count_ = 0;
+    if (size_ < 5) {
+        return false;
+    }
+    base_lg_ = static_cast<unsigned char>(data_[size_ - 1]);
+    offsets_begin_ = codec::decodeFixed32(data_ + size_ - 5);
+    if (offsets_begin_ > size_ - 5 || (size_ - 5 - offsets_begin_) % 4 != 0) {
+        return false;
+    }
+    const size_t offset_count = (size_ - 5 - offsets_begin_) / 4;
+    if (offset_count == 0) {
+        return false;
+    }
+    filter_count_ = offset_count - 1;
+    return true;
+}
+
+bool FilterBlockReader::blockMayMatch(uint64_t block_offset, const std::string& key) const {
+    const uint64_t index = block_offset >> base_lg_;
+    if (index >= filter_count_) {
+        return true;
+    }
+    const char* offsets = data_ + offsets_begin_;
+    const size_t start = codec::decodeFixed32(offsets + index * 4);
+    const size_t limit = codec::decodeFixed32(offsets + index * 4 + 4);
+    if (start > limit || limit > offsets_begin_) {
+        // 格式错误时当作可能存在
+        return true;
+    }
+    return BloomFilter::mayMatch(key, data_ + start, limit - start);
+}
+
+bool FilterBlockReader::tableMayMatch(const std::string& key) const {
+    const size_t start = codec::decodeFixed32(data_ + offsets_begin_ + filter_count_ * 4);
+    if (start > offsets_begin_) {
+        return true;
+    }
+    return BloomFilter::mayMatch(key, data_ + start, offsets_begin_ - start);
+}
+
+}
@@ -0,0 +1,47 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 18:58:13
+ * @LastEditTime: 2026-10-18 18:58:13
+ */
+#include <tomato_db/iterator.h>
+
+namespace tomato {
+
+/**
+ * @brief 没有数据的迭代器
+ * 
+ */
+class EmptyIterator final : public InternalIterator {
+public:
+    explicit EmptyIterator(const OperatorResult& status): status_(status), empty_() {}
+
+    bool valid() const override {
+        return false;
+    }
+    void seekToFirst() override {}
+    void seekToLast() override {}
+    void seek(const std::string&) override {}
+    void next() override {}
+    void prev() override {}
+
+    const std::string& key() const override {
+        return empty_;
+    }
+
+    const std::string& value() const override {
+        return empty_;
+    }
+
+    OperatorResult getStatus() const override {
+        return status_;
+    }
+private:
+    const OperatorResult status_;
+    const std::string empty_;
+};
+
+std::unique_ptr<InternalIterator> newEmptyIterator(const OperatorResult& status) {
+    return std::unique_ptr<InternalIterator>(new EmptyIterator(status));
+}
+
+}
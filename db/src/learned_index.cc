@@ -0,0 +1,185 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 23:08:02
+ * @LastEditTime: 2026-10-18 23:08:02
+ */
+#include <tomato_db/learned_index.h>
+#include <tomato_common/codec.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace tomato {
+
+static std::string encodeDouble(double value) {
+    uint64_t bits = 0;
+    ::memcpy(&bits, &value, sizeof(bits));
+    return codec::encodeFixed64(bits);
+}
+
+static double decodeDouble(const char* begin) {
+    const uint64_t bits = codec::decodeFixed64(begin);
+    double value = 0;
+    ::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+LearnedIndexBuilder::LearnedIndexBuilder(uint32_t max_error)
+    : max_error_(max_error),
+      keys_(),
+      result_() {}
+
+void LearnedIndexBuilder::addBlock(const std::string& last_user_key) {
+    keys_.push_back(last_user_key);
+}
+
+const std::string& LearnedIndexBuilder::finish() {
+    // 键有序, 第一个键与最后一个键的公共前缀就是所有键的公共前缀
+    size_t prefix_size = 0;
+    if (!keys_.empty()) {
+        const std::string& first = keys_.front();
+        const std::string& last = keys_.back();
+        while (prefix_size < first.size() && prefix_size < last.size() && first[prefix_size] == last[prefix_size]) {
+            ++prefix_size;
+        }
+    }
+    const std::string prefix = keys_.empty() ? std::string() : keys_.front().substr(0, prefix_size);
+
+    // 收缩锥: 每一段从第一个点出发, 维护使所有点误差不超过max_error_的斜率范围, 范围为空时开始新的一段
+    std::string segments;
+    uint64_t segment_count = 0;
+    uint64_t start = 0;
+    uint64_t first_block = 0;
+    double low = 0;
+    double high = std::numeric_limits<double>::infinity();
+    auto finishSegment = [&]() {
+        const double slope = high == std::numeric_limits<double>::infinity() ? low : (low + high) / 2;
+        segments.append(codec::encodeFixed64(start));
+        segments.append(codec::encodeFixed64(first_block));
+        segments.append(encodeDouble(slope));
+        ++segment_count;
+    };
+    const double error = static_cast<double>(max_error_);
+    for (size_t i = 0; i < keys_.size(); ++i) {
+        const uint64_t position = LearnedIndexReader::keyToPosition(keys_[i], prefix);
+        if (i > 0 && position > start) {
+            const double dx = static_cast<double>(position - start);
+            const double dy = static_cast<double>(i - first_block);
+            const double slope_low = (dy - error) / dx;
+            const double slope_high = (dy + error) / dx;
+            if (slope_low <= high && slope_high >= low) {
+                low = std::max(low, slope_low);
+                high = std::min(high, slope_high);
+                continue;
+            }
+            finishSegment();
+        } else if (i > 0) {
+            // 与段起点坐标相同的键无法用直线区分, 由读取时检查范围两端处理
+            continue;
+        }
+        start = position;
+        first_block = i;
+        low = 0;
+        high = std::numeric_limits<double>::infinity();
+    }
+    if (!keys_.empty()) {
+        finishSegment();
+    }
+
+    result_.append(codec::encodeVar64(prefix.size()));
+    result_.append(prefix);
+    result_.append(codec::encodeVar64(max_error_));
+    result_.append(codec::encodeVar64(keys_.size()));
+    result_.append(codec::encodeVar64(segment_count));
+    result_.append(segments);
+    return result_;
+}
+
+LearnedIndexReader::LearnedIndexReader()
+    : prefix_(),
+      max_error_(0),
+      block_count_(0),
+      segments_() {}
+
+bool LearnedIndexReader::init(const std::string& contents) {
+    const char* p = contents.data();
+    const char* end = contents.data() + contents.size();
+    std::pair<uint64_t, int> res = codec::decodeVar64(p, end);
+    if (res.second == 0 || res.first > static_cast<uint64_t>(end - p - res.second)) {
+        return false;
+    }
+    p += res.second;
+    prefix_.assign(p, static_cast<size_t>(res.first));
+    p += res.first;
+    uint64_t* fields[] = {&max_error_, &block_count_};
+    for (uint64_t* field : fields) {
+        res = codec::decodeVar64(p, end);
+        if (res.second == 0) {
+            return false;
+        }
+        *field = res.first;
+        p += res.second;
+    }
+    res = codec::decodeVar64(p, end);
+    if (res.second == 0) {
+        return false;
+    }
+    p += res.second;
+    const uint64_t segment_count = res.first;
+    if (segment_count == 0 || segment_count * 24 != static_cast<uint64_t>(end - p)) {
+        return false;
+    }
+    segments_.clear();
+    for (uint64_t i = 0; i < segment_count; ++i, p += 24) {
+        Segment segment;
+        segment.start = codec::decodeFixed64(p);
+        segment.first_block = codec::decodeFixed64(p + 8);
+        segment.slope = decodeDouble(p + 16);
+        if (segment.first_block >= block_count_ || !(segment.slope >= 0) ||
+                (!segments_.empty() && segment.start <= segments_.back().start)) {
+            return false;
+        }
+        segments_.push_back(segment);
+    }
+    return true;
+}
+
+void LearnedIndexReader::predict(const std::string& user_key, uint64_t& first, uint64_t& last) const {
+    const uint64_t position = keyToPosition(user_key, prefix_);
+    // 最后一个起点不大于坐标的段, 坐标在第一段之前时预测为第一个block
+    auto it = std::upper_bound(segments_.begin(), segments_.end(), position,
+                               [](uint64_t value, const Segment& segment) {
+                                   return value < segment.start;
+                               });
+    uint64_t predicted = 0;
+    if (it != segments_.begin()) {
+        const Segment& segment = *(it - 1);
+        // 两段之间的键属于下一段的第一个block或之前, 预测值不超过它
+        const uint64_t limit = it == segments_.end() ? block_count_ - 1 : it->first_block;
+        const double offset = segment.slope * static_cast<double>(position - segment.start);
+        const double bound = static_cast<double>(limit - segment.first_block);
+        predicted = segment.first_block + (offset < bound ? static_cast<uint64_t>(offset) : limit - segment.first_block);
+    }
+    // 拟合点之间的键所在的block与预测值相差不超过误差加1
+    const uint64_t window = max_error_ + 1;
+    first = predicted > window ? predicted - window : 0;
+    last = std::min(predicted + window, block_count_ - 1);
+}
+
+uint64_t LearnedIndexReader::keyToPosition(const std::string& user_key, const std::string& prefix) {
+    // 不以公共前缀开头的键(包括公共前缀的前缀)在所有键之前或之后
+    const int cmp = user_key.compare(0, prefix.size(), prefix);
+    if (cmp != 0) {
+        return cmp < 0 ? 0 : UINT64_MAX;
+    }
+    uint64_t position = 0;
+    for (size_t i = 0; i < sizeof(uint64_t); ++i) {
+        const size_t index = prefix.size() + i;
+        const uint64_t byte = index < user_key.size() ? static_cast<unsigned char>(user_key[index]) : 0;
+        position = (position << 8) | byte;
+    }
+    return position;
+}
+
+}
@@ -0,0 +1,138 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 10:41:47
+ * @LastEditTime: 2026-10-18 10:41:47
+ */
+#include <tomato_db/log_reader.h>
+#include <tomato_common/codec.h>
+#include <tomato_common/crc32.h>
+
+namespace tomato {
+namespace log {
+
+LogReader::LogReader(SequentialFile* file)
+    : file_(file),
+      buffer_(),
+      buffer_pos_(0),
+      eof_(false),
+      dropped_bytes_(0) {}
+
+bool LogReader::readRecord(std::string& record) {
+    record.clear();
+    bool in_fragmented_record = false;
+    std::string fragment;
+    while (true) {
+        int type = readPhysicalRecord(fragment);
+        switch (type) {
+        case FULL:
+            if (in_fragmented_record) {
+                dropped_bytes_ += record.size();
+            }
+            record.swap(fragment);
+            return true;
+        case FIRST:
+            if (in_fragmented_record) {
+                dropped_bytes_ += record.size();
+            }
+            record.swap(fragment);
+            in_fragmented_record = true;
+            break;
+        case MIDDLE:
+            if (in_fragmented_record) {
+                record.append(fragment);
+            } else {
+                dropped_bytes_ += fragment.size();
+            }
+            break;
+        case LAST:
+            if (in_fragmented_record) {
+                record.append(fragment);
+                return true;
+            }
+            dropped_bytes_ += fragment.size();
+            break;
+        case END_OF_FILE:
+            // 写入时崩溃留下的不完整记录直接丢弃
+            if (in_fragmented_record) {
+                dropped_bytes_ += record.size();
+            }
+            record.clear();
+            return false;
+        default:
+            if (in_fragmented_record) {
+                dropped_bytes_ += record.size();
+                record.clear();
+                in_fragmented_record = false;
+            }
+            break;
+        }
+    }
+}
+
+int LogReader::readPhysicalRecord(std::string& fragment) {
+    while (true) {
+        if (buffer_.size() - buffer_pos_ < HEADER_SIZE) {
+            // block尾部不足一个记录头的部分是填充字节
+            if (eof_) {
+                dropBuffer();
+                return END_OF_FILE;
+            }
+            buffer_.clear();
+            buffer_pos_ = 0;
+            OperatorResult status = file_->read(BLOCK_SIZE, buffer_);
+            if (!status.isSuccess()) {
+                dropBuffer();
+                eof_ = true;
+                return END_OF_FILE;
+            }
+            if (buffer_.size() < BLOCK_SIZE) {
+                eof_ = true;
+            }
+            continue;
+        }
+
+        const char* header = buffer_.data() + buffer_pos_;
+        const uint32_t length = static_cast<uint32_t>(static_cast<uint8_t>(header[4])) |
+                                (static_cast<uint32_t>(static_cast<uint8_t>(header[5])) << 8);
+        const int type = static_cast<uint8_t>(header[6]);
+        if (HEADER_SIZE + length > buffer_.size() - buffer_pos_) {
+            // 文件末尾的半条记录说明写入时发生了崩溃, 不算作损坏
+            bool truncated = eof_;
+            dropBuffer();
+            if (truncated) {
+                return END_OF_FILE;
+            }
+            return BAD_RECORD;
+        }
+
+        if (type == ZERO && length == 0) {
+            // 预分配产生的全0区域
+            buffer_pos_ = buffer_.size();
+            return BAD_RECORD;
+        }
+
+        const uint32_t expected_crc = codec::decodeFixed32(std::string(header, 4));
+        const uint32_t actual_crc = crc32(crc32(header + 6, 1), header + HEADER_SIZE, length);
+        if (expected_crc != actual_crc) {
+            // 长度字段也可能已经损坏, 丢弃整个block剩余部分
+            dropBuffer();
+            return BAD_RECORD;
+        }
+
+        fragment.assign(header + HEADER_SIZE, length);
+        buffer_pos_ += HEADER_SIZE + length;
+        if (type < FULL || type > LAST) {
+            dropped_bytes_ += HEADER_SIZE + length;
+            return BAD_RECORD;
+        }
+        return type;
+    }
+}
+
+void LogReader::dropBuffer() {
+    dropped_bytes_ += buffer_.size() - buffer_pos_;
+    buffer_pos_ = buffer_.size();
+}
+
+}
+}
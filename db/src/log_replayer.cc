@@ -0,0 +1,150 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 13:40:52
+ * @LastEditTime: 2026-10-18 13:40:52
+ */
+#include <tomato_db/log_replayer.h>
+#include <tomato_db/log_reader.h>
+#include <tomato_db/write_batch.h>
+
+#include <algorithm>
+#include <thread>
+
+namespace tomato {
+namespace log {
+
+LogReplayer::LogReplayer(const ReplayOptions& options, FlushFunction flush)
+    : options_(options),
+      flush_(std::move(flush)),
+      busy_decoders_(0),
+      finished_(false),
+      max_sequence_(0),
+      status_(OperatorResult::success()),
+      record_count_(0),
+      dropped_bytes_(0) {}
+
+OperatorResult LogReplayer::replay(const std::vector<std::string>& filenames,
+                                   std::shared_ptr<MemoryTable>& memtable,
+                                   uint64_t& max_sequence) {
+    memtable_ = memtable;
+    finished_ = false;
+    std::vector<std::thread> decoders;
+    for (int i = 0; i < std::max(options_.decode_threads, 1); ++i) {
+        decoders.emplace_back(&LogReplayer::decodeLoop, this);
+    }
+    std::thread flusher(&LogReplayer::flushLoop, this);
+
+    for (const std::string& filename : filenames) {
+        std::shared_ptr<SequentialFile> file = createSequentialFile(filename, options_.file_options);
+        if (!file->isOpen()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            setError({errno, "open log file error, filename: " + filename});
+            break;
+        }
+
+        // 读取与crc校验都在当前线程完成
+        LogReader reader(file.get());
+        std::string record;
+        while (reader.readRecord(record)) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            space_cv_.wait(lock, [this] { return records_.size() < options_.max_pending_records; });
+            records_.push_back(std::move(record));
+            ++record_count_;
+            records_cv_.notify_one();
+
+            // 内存表写满后等待在途的记录写完再切换, 保证切换前后的序列号不交叉
+            if (memtable_->getMemoryUsage() >= options_.write_buffer_size) {
+                waitForIdle(lock);
+                immutables_.push_back(memtable_);
+                memtable_ = std::make_shared<MemoryTable>();
+                flush_cv_.notify_one();
+            }
+        }
+        dropped_bytes_ += reader.getDroppedBytes();
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        waitForIdle(lock);
+        finished_ = true;
+    }
+    records_cv_.notify_all();
+    flush_cv_.notify_all();
+    for (std::thread& decoder : decoders) {
+        decoder.join();
+    }
+    flusher.join();
+
+    memtable = memtable_;
+    memtable_.reset();
+    if (max_sequence_ > 0) {
+        max_sequence = max_sequence_;
+    }
+    return status_;
+}
+
+void LogReplayer::decodeLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        records_cv_.wait(lock, [this] { return !records_.empty() || finished_; });
+        if (records_.empty()) {
+            return;
+        }
+        std::string record = std::move(records_.front());
+        records_.pop_front();
+        std::shared_ptr<MemoryTable> table = memtable_;
+        ++busy_decoders_;
+        space_cv_.notify_one();
+        lock.unlock();
+
+        WriteBatch batch;
+        OperatorResult status = batch.setContent(record);
+        if (status.isSuccess()) {
+            status = batch.insertInto(table.get(), true, options_.sorted_run_threshold);
+        }
+
+        lock.lock();
+        if (!status.isSuccess()) {
+            setError(status);
+        } else if (batch.getCount() > 0) {
+            max_sequence_ = std::max(max_sequence_, batch.getSequence() + batch.getCount() - 1);
+        }
+        --busy_decoders_;
+        if (busy_decoders_ == 0 && records_.empty()) {
+            idle_cv_.notify_all();
+        }
+    }
+}
+
+void LogReplayer::flushLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        flush_cv_.wait(lock, [this] { return !immutables_.empty() || finished_; });
+        if (immutables_.empty()) {
+            return;
+        }
+        std::shared_ptr<MemoryTable> table = immutables_.front();
+        immutables_.pop_front();
+        lock.unlock();
+
+        OperatorResult status = flush_(table);
+
+        lock.lock();
+        if (!status.isSuccess()) {
+            setError(status);
+        }
+    }
+}
+
+void LogReplayer::waitForIdle(std::unique_lock<std::mutex>& lock) {
+    idle_cv_.wait(lock, [this] { return records_.empty() && busy_decoders_ == 0; });
+}
+
+void LogReplayer::setError(const OperatorResult& status) {
+    if (status_.isSuccess()) {
+        status_ = status;
+    }
+}
+
+}
+}
@@ -0,0 +1,110 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 10:20:05
+ * @LastEditTime: 2026-10-19 00:17:45
+ */
+#include <tomato_db/log_writer.h>
+#include <tomato_common/codec.h>
+#include <tomato_common/crc32.h>
+
+#include <algorithm>
+#include <cassert>
+
+namespace tomato {
+namespace log {
+
+LogWriter::LogWriter(AppendOnlyFile* file)
+    : file_(file),
+      block_offset_(0),
+      encoded_offset_(0),
+      status_(OperatorResult::success()) {}
+
+OperatorResult LogWriter::addRecord(const std::string& record) {
+    std::string encoded;
+    encodeRecord(record, encoded);
+    return appendEncoded(encoded);
+}
+
+void LogWriter::encodeRecord(const std::string& record, std::string& output) {
+    const char* ptr = record.c_str();
+    size_t left = record.size();
+
+    // 空记录也需要写入一个FULL类型的物理记录
+    bool begin = true;
+    do {
+        // block剩余空间放不下记录头时用0填充, 换到下一个block
+        const size_t leftover = BLOCK_SIZE - encoded_offset_;
+        if (leftover < HEADER_SIZE) {
+            output.append(leftover, '\0');
+            encoded_offset_ = 0;
+        }
+
+        const size_t avail = BLOCK_SIZE - encoded_offset_ - HEADER_SIZE;
+        const size_t fragment_size = std::min(left, avail);
+        const bool end = (left == fragment_size);
+        RecordType type;
+        if (begin && end) {
+            type = FULL;
+        } else if (begin) {
+            type = FIRST;
+        } else if (end) {
+            type = LAST;
+        } else {
+            type = MIDDLE;
+        }
+
+        encodePhysicalRecord(type, ptr, fragment_size, output);
+        ptr += fragment_size;
+        left -= fragment_size;
+        begin = false;
+    } while (left > 0);
+}
+
+OperatorResult LogWriter::appendEncoded(const std::string& encoded) {
+    if (!status_.isSuccess()) {
+        return status_;
+    }
+    OperatorResult status = file_->append(encoded);
+    if (status.isSuccess()) {
+        status = file_->flush();
+    }
+    if (!status.isSuccess()) {
+        // 可能只写入了一部分, 之后的记录无法在文件中正确分块
+        status_ = status;
+        encoded_offset_ = block_offset_;
+        return status;
+    }
+    block_offset_ = encoded_offset_;
+    return status;
+}
+
+OperatorResult LogWriter::sync() {
+    if (!status_.isSuccess()) {
+        return status_;
+    }
+    OperatorResult status = file_->sync();
+    if (!status.isSuccess()) {
+        status_ = status;
+    }
+    return status;
+}
+
+void LogWriter::encodePhysicalRecord(RecordType type, const char* data, size_t size, std::string& output) {
+    assert(size <= 0xffff);
+    assert(encoded_offset_ + HEADER_SIZE + size <= BLOCK_SIZE);
+
+    // crc覆盖类型字节与数据
+    const char type_byte = static_cast<char>(type);
+    uint32_t crc = crc32(&type_byte, 1);
+    crc = crc32(crc, data, size);
+
+    output.append(codec::encodeFixed32(crc));
+    output.push_back(static_cast<char>(size & 0xff));
+    output.push_back(static_cast<char>(size >> 8));
+    output.push_back(type_byte);
+    output.append(data, size);
+    encoded_offset_ += HEADER_SIZE + size;
+}
+
+}
+}
@@ -1,9 +1,10 @@
 /*
  * @Author: Tomato
  * @Date: 2021-12-27 16:31:45
- * @LastEditTime: 2022-11-24 10:58:20
+ * @LastEditTime: 2026-10-18 23:48:43
  */
 #include <tomato_db/memory_table.h>
+#include <tomato_common/codec.h>
 
 #include <cstring>
 #include <climits>
@@ -30,55 +31,191 @@ int TableItemComparator::operator()(const TableItem& v1, const TableItem& v2) co
         return 1;
     }
 
-    // key 相等的情况，比较seq
-    assert(v1.seq_id != v2.seq_id);
+    // key 相等的情况，比较seq, 序列号大的排在前面; 同一个序列号只会出现在按快照查找的条件中
     if (v1.seq_id > v2.seq_id) {
         return -1;
-    } else {
+    } else if (v1.seq_id < v2.seq_id) {
         return 1;
     }
+    return 0;
 }
 
 MemoryTable::MemoryTable()
     : allocator_(),
       comparator_(),
-      table_(&allocator_, comparator_) {}
+      table_(&allocator_, comparator_),
+      range_del_table_(&allocator_, comparator_) {}
+
+MemoryTable::MemoryTable(std::shared_ptr<AllocationTracker> tracker)
+    : allocator_(std::move(tracker)),
+      comparator_(),
+      table_(&allocator_, comparator_),
+      range_del_table_(&allocator_, comparator_) {}
     
 void MemoryTable::add(const uint64_t seq, ItemType type, 
                       const std::string& key, const std::string& value) {
-    table_.insert(createItem(seq, type, key, value));
+    Table& table = (type == ItemType::RANGE_DELETION ? range_del_table_ : table_);
+    table.insert(createItem(seq, type, key, value));
+}
+
+void MemoryTable::addConcurrently(const uint64_t seq, ItemType type, 
+                                  const std::string& key, const std::string& value) {
+    Table& table = (type == ItemType::RANGE_DELETION ? range_del_table_ : table_);
+    table.insertConcurrently(createItem(seq, type, key, value, true));
+}
+
+void MemoryTable::addSortedRunConcurrently(const std::vector<Entry>& entries) {
+    std::vector<TableItem> items;
+    items.reserve(entries.size());
+    for (const Entry& entry : entries) {
+        items.push_back(createItem(entry.seq, entry.type, entry.key, entry.value, true));
+    }
+    table_.insertSortedConcurrently(items);
 }
 
 std::shared_ptr<std::string> MemoryTable::get(const std::string& key) {
-    // 构建查找条件，seq传最大值(因为memtable会有多版本的值，并且以最新版本的值为准)
-    TableItem item = createItem(UINT64_MAX, ItemType::VALUE, key, "");
+    std::string value;
+    bool deleted = false;
+    // 未找到值, 或者值被删除, 返回空
+    if (!lookup(key, value, deleted) || deleted) {
+        return std::shared_ptr<std::string>(nullptr);
+    }
+    return std::make_shared<std::string>(std::move(value));
+}
+
+bool MemoryTable::lookup(const std::string& key, std::string& value, bool& deleted, uint64_t seq) {
+    std::vector<std::string> operands;
+    return lookup(key, seq, value, deleted, operands) && operands.empty();
+}
+
+bool MemoryTable::lookup(const std::string& key, uint64_t seq, std::string& value, bool& deleted, 
+                         std::vector<std::string>& operands) {
+    const uint64_t tombstone_seq = getMaxCoveringTombstoneSeq(key, seq);
+
+    // 构建查找条件，定位到序列号不大于seq的最新版本(memtable会有多版本的值)
+    TableItem item(seq, ItemType::VALUE, key.size(), key.c_str(), 0, nullptr);
  
-    // 为找到值, 或者值被删除, 或者值与key对不上,返回空
     auto it = Table::Iterator(&table_);
-    it.seek(item);
-    if (!it.valid()) {
-        return std::shared_ptr<std::string>(nullptr);
+    for (it.seek(item); it.valid(); it.next()) {
+        const TableItem& target_item = it.key();
+        if (target_item.key_len != key.size() || ::memcmp(target_item.key, key.c_str(), key.size()) != 0) {
+            break;
+        }
+        // 范围删除标记比这个版本更新
+        if (target_item.seq_id < tombstone_seq) {
+            break;
+        }
+        if (target_item.type == ItemType::MERGE) {
+            operands.emplace_back(target_item.value, target_item.value_len);
+            continue;
+        }
+        deleted = (target_item.type == ItemType::DELETION);
+        if (!deleted) {
+            value.assign(target_item.value, target_item.value_len);
+        }
+        return true;
     }
 
-    const TableItem& target_item = it.key();
-    if (target_item.type == ItemType::DELETION) {
-        return std::shared_ptr<std::string>(nullptr);
+    if (tombstone_seq > 0) {
+        deleted = true;
+        return true;
+    }
+    return false;
+}
+
+uint64_t MemoryTable::getMaxCoveringTombstoneSeq(const std::string& key, uint64_t seq) const {
+    uint64_t max_seq = 0;
+    Table::Iterator it(&range_del_table_);
+    for (it.seekToFirst(); it.valid(); it.next()) {
+        const TableItem& item = it.key();
+        // 范围起点有序, 起点大于key之后的标记都不会覆盖key
+        if (key.compare(0, std::string::npos, item.key, item.key_len) < 0) {
+            break;
+        }
+        if (item.seq_id <= seq && item.seq_id > max_seq &&
+                key.compare(0, std::string::npos, item.value, item.value_len) < 0) {
+            max_seq = item.seq_id;
+        }
     }
+    return max_seq;
+}
+
+void MemoryTable::getRangeTombstones(std::vector<RangeTombstone>& tombstones) const {
+    Table::Iterator it(&range_del_table_);
+    for (it.seekToFirst(); it.valid(); it.next()) {
+        const TableItem& item = it.key();
+        tombstones.push_back(RangeTombstone{std::string(item.key, item.key_len), 
+                                            std::string(item.value, item.value_len), 
+                                            item.seq_id});
+    }
+}
+
+bool MemoryTable::empty() const {
+    Table::Iterator it(&table_);
+    it.seekToFirst();
+    Table::Iterator range_del_it(&range_del_table_);
+    range_del_it.seekToFirst();
+    return !it.valid() && !range_del_it.valid();
+}
+
+void MemoryTable::Iterator::seek(const std::string& key, uint64_t seq) {
+    iter_.seek(TableItem(seq, ItemType::VALUE, key.size(), key.c_str(), 0, nullptr));
+}
+
+MemoryTableIterator::MemoryTableIterator(std::shared_ptr<const MemoryTable> table)
+    : table_(std::move(table)),
+      iter_(table_.get()),
+      key_(),
+      value_() {}
+
+void MemoryTableIterator::seekToFirst() {
+    iter_.seekToFirst();
+    update();
+}
+
+void MemoryTableIterator::seekToLast() {
+    iter_.seekToLast();
+    update();
+}
 
-    if (::memcmp(target_item.key, key.c_str(), 
-            key.size() > target_item.key_len ? target_item.key_len : key.size())) {
-        return std::shared_ptr<std::string>(nullptr);            
+void MemoryTableIterator::seek(const std::string& target) {
+    ParsedInternalKey parsed_key;
+    if (!parseInternalKey(target, parsed_key)) {
+        parsed_key.user_key = target;
+        parsed_key.seq = UINT64_MAX;
     }
+    iter_.seek(parsed_key.user_key, parsed_key.seq);
+    update();
+}
+
+void MemoryTableIterator::next() {
+    iter_.next();
+    update();
+}
 
-    return std::make_shared<std::string>(target_item.value, target_item.value_len);
+void MemoryTableIterator::prev() {
+    iter_.prev();
+    update();
+}
+
+void MemoryTableIterator::update() {
+    if (!iter_.valid()) {
+        return;
+    }
+    const TableItem& item = iter_.item();
+    key_.assign(item.key, item.key_len);
+    key_.append(codec::encodeFixed64((item.seq_id << 8) | static_cast<uint64_t>(item.type)));
+    value_.assign(item.value, item.value_len);
 }
 
 TableItem MemoryTable::createItem(const uint64_t seq, ItemType type, 
-                                  const std::string& key, const std::string& value) {
+                                  const std::string& key, const std::string& value,
+                                  bool concurrent) {
     uint64_t key_len = 0;
     char* key_ptr = nullptr;
     if (key.size() > 0) {
-        char* buffer = allocator_.allocateAligned(key.size());
+        char* buffer = concurrent ? allocator_.allocateAlignedConcurrently(key.size())
+                                  : allocator_.allocateAligned(key.size());
         std::memcpy(buffer, key.c_str(), key.size());
         key_ptr = buffer;
         key_len = key.size();
@@ -87,12 +224,13 @@ TableItem MemoryTable::createItem(const uint64_t seq, ItemType type,
     uint64_t value_len = 0;
     char* value_ptr = nullptr;
     if (value.size() > 0) {
-        char* buffer = allocator_.allocateAligned(value.size());
+        char* buffer = concurrent ? allocator_.allocateAlignedConcurrently(value.size())
+                                  : allocator_.allocateAligned(value.size());
         std::memcpy(buffer, value.c_str(), value.size());
         value_ptr = buffer;
         value_len = value.size();
     }
-    return TableItem(seq, ItemType::VALUE, key_len, key_ptr, value_len, value_ptr);
+    return TableItem(seq, type, key_len, key_ptr, value_len, value_ptr);
 }
 
 }
\ No newline at end of file
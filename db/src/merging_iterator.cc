@@ -0,0 +1,138 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 19:04:51
+ * @LastEditTime: 2026-10-18 19:04:51
+ */
+#include <tomato_db/merging_iterator.h>
+#include <tomato_db/table_meta.h>
+
+#include <algorithm>
+
+namespace tomato {
+
+/**
+ * @brief 最小堆: 键大的优先级低
+ * 
+ */
+static bool greaterKey(const InternalIterator* a, const InternalIterator* b) {
+    return compareInternalKey(a->key(), b->key()) > 0;
+}
+
+/**
+ * @brief 最大堆: 键小的优先级低
+ * 
+ */
+static bool lessKey(const InternalIterator* a, const InternalIterator* b) {
+    return compareInternalKey(a->key(), b->key()) < 0;
+}
+
+MergingIterator::MergingIterator(std::vector<std::unique_ptr<InternalIterator>> children)
+    : children_(std::move(children)),
+      heap_(),
+      direction_(Direction::FORWARD) {
+    heap_.reserve(children_.size());
+}
+
+void MergingIterator::seekToFirst() {
+    for (std::unique_ptr<InternalIterator>& child : children_) {
+        child->seekToFirst();
+    }
+    rebuildHeap(Direction::FORWARD);
+}
+
+void MergingIterator::seekToLast() {
+    for (std::unique_ptr<InternalIterator>& child : children_) {
+        child->seekToLast();
+    }
+    rebuildHeap(Direction::REVERSE);
+}
+
+void MergingIterator::seek(const std::string& target) {
+    for (std::unique_ptr<InternalIterator>& child : children_) {
+        child->seek(target);
+    }
+    rebuildHeap(Direction::FORWARD);
+}
+
+void MergingIterator::next() {
+    if (direction_ != Direction::FORWARD) {
+        // 反向遍历时其他子迭代器停在当前键之前, 需要全部移到当前键之后
+        InternalIterator* current = heap_.front();
+        const std::string target = current->key();
+        for (std::unique_ptr<InternalIterator>& child : children_) {
+            if (child.get() == current) {
+                continue;
+            }
+            child->seek(target);
+            if (child->valid() && compareInternalKey(child->key(), target) == 0) {
+                child->next();
+            }
+        }
+        current->next();
+        rebuildHeap(Direction::FORWARD);
+        return;
+    }
+    advanceTop(true);
+}
+
+void MergingIterator::prev() {
+    if (direction_ != Direction::REVERSE) {
+        // 正向遍历时其他子迭代器停在当前键之后, 需要全部移到当前键之前
+        InternalIterator* current = heap_.front();
+        const std::string target = current->key();
+        for (std::unique_ptr<InternalIterator>& child : children_) {
+            if (child.get() == current) {
+                continue;
+            }
+            child->seek(target);
+            if (child->valid()) {
+                child->prev();
+            } else {
+                child->seekToLast();
+            }
+        }
+        current->prev();
+        rebuildHeap(Direction::REVERSE);
+        return;
+    }
+    advanceTop(false);
+}
+
+OperatorResult MergingIterator::getStatus() const {
+    for (const std::unique_ptr<InternalIterator>& child : children_) {
+        OperatorResult status = child->getStatus();
+        if (!status.isSuccess()) {
+            return status;
+        }
+    }
+    return OperatorResult::success();
+}
+
+void MergingIterator::rebuildHeap(Direction direction) {
+    direction_ = direction;
+    heap_.clear();
+    for (std::unique_ptr<InternalIterator>& child : children_) {
+        if (child->valid()) {
+            heap_.push_back(child.get());
+        }
+    }
+    std::make_heap(heap_.begin(), heap_.end(), direction == Direction::FORWARD ? greaterKey : lessKey);
+}
+
+void MergingIterator::advanceTop(bool forward) {
+    bool (*comparator)(const InternalIterator*, const InternalIterator*) = forward ? greaterKey : lessKey;
+    std::pop_heap(heap_.begin(), heap_.end(), comparator);
+    InternalIterator* top = heap_.back();
+    if (forward) {
+        top->next();
+    } else {
+        top->prev();
+    }
+    if (top->valid()) {
+        std::push_heap(heap_.begin(), heap_.end(), comparator);
+    } else {
+        heap_.pop_back();
+    }
+}
+
+}
@@ -0,0 +1,81 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 23:40:16
+ * @LastEditTime: 2026-10-18 22:29:05
+ */
+#include <tomato_db/prefix_extractor.h>
+
+namespace tomato {
+
+class FixedPrefixExtractor final : public PrefixExtractor {
+public:
+    explicit FixedPrefixExtractor(size_t length)
+        : length_(length),
+          name_("tomato.FixedPrefix." + std::to_string(length)) {}
+
+    bool inDomain(const std::string& key) const override {
+        return key.size() >= length_;
+    }
+
+    std::string transform(const std::string& key) const override {
+        return key.substr(0, length_);
+    }
+
+    const char* name() const override {
+        return name_.c_str();
+    }
+private:
+    const size_t length_;
+    const std::string name_;
+};
+
+class DelimitedPrefixExtractor final : public PrefixExtractor {
+public:
+    DelimitedPrefixExtractor(char delimiter, int count)
+        : delimiter_(delimiter),
+          count_(count),
+          name_("tomato.DelimitedPrefix." + std::to_string(static_cast<unsigned char>(delimiter)) +
+                "." + std::to_string(count)) {}
+
+    bool inDomain(const std::string& key) const override {
+        return prefixLength(key) != std::string::npos;
+    }
+
+    std::string transform(const std::string& key) const override {
+        return key.substr(0, prefixLength(key));
+    }
+
+    const char* name() const override {
+        return name_.c_str();
+    }
+private:
+    /**
+     * @brief 到第count_个分隔符为止的长度, 分隔符不足时返回npos
+     * 
+     */
+    size_t prefixLength(const std::string& key) const {
+        size_t pos = 0;
+        for (int i = 0; i < count_; ++i) {
+            pos = key.find(delimiter_, pos);
+            if (pos == std::string::npos) {
+                return pos;
+            }
+            ++pos;
+        }
+        return pos;
+    }
+private:
+    const char delimiter_;
+    const int count_;
+    const std::string name_;
+};
+
+std::shared_ptr<const PrefixExtractor> newFixedPrefixExtractor(size_t length) {
+    return std::make_shared<FixedPrefixExtractor>(length);
+}
+
+std::shared_ptr<const PrefixExtractor> newDelimitedPrefixExtractor(char delimiter, int count) {
+    return std::make_shared<DelimitedPrefixExtractor>(delimiter, count);
+}
+
+}
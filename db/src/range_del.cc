@@ -0,0 +1,106 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 19:48:30
+ * @LastEditTime: 2026-10-18 22:13:35
+ */
+#include <tomato_db/range_del.h>
+
+#include <algorithm>
+#include <set>
+
+namespace tomato {
+
+RangeDelAggregator::RangeDelAggregator(uint64_t max_seq)
+    : max_seq_(max_seq),
+      tombstones_(),
+      fragments_() {}
+
+void RangeDelAggregator::add(const RangeTombstone& tombstone) {
+    if (tombstone.seq <= max_seq_ && tombstone.begin < tombstone.end) {
+        tombstones_.push_back(tombstone);
+    }
+}
+
+void RangeDelAggregator::finish() {
+    fragments_.clear();
+    if (tombstones_.empty()) {
+        return;
+    }
+
+    // 扫描线: 起点处加入标记, 终点处移除标记, 每个边界处记录当前覆盖的最大序列号
+    std::vector<std::pair<std::string, size_t>> begins;
+    std::vector<std::pair<std::string, size_t>> ends;
+    for (size_t i = 0; i < tombstones_.size(); ++i) {
+        begins.emplace_back(tombstones_[i].begin, i);
+        ends.emplace_back(tombstones_[i].end, i);
+    }
+    std::sort(begins.begin(), begins.end());
+    std::sort(ends.begin(), ends.end());
+
+    std::multiset<uint64_t> active;
+    size_t begin_pos = 0;
+    size_t end_pos = 0;
+    while (begin_pos < begins.size() || end_pos < ends.size()) {
+        // 下一个边界
+        std::string boundary;
+        if (end_pos >= ends.size() || (begin_pos < begins.size() && begins[begin_pos].first < ends[end_pos].first)) {
+            boundary = begins[begin_pos].first;
+        } else {
+            boundary = ends[end_pos].first;
+        }
+        while (end_pos < ends.size() && ends[end_pos].first == boundary) {
+            active.erase(active.find(tombstones_[ends[end_pos].second].seq));
+            ++end_pos;
+        }
+        while (begin_pos < begins.size() && begins[begin_pos].first == boundary) {
+            active.insert(tombstones_[begins[begin_pos].second].seq);
+            ++begin_pos;
+        }
+        const uint64_t seq = active.empty() ? 0 : *active.rbegin();
+        if (!fragments_.empty() && fragments_.back().seq == seq) {
+            continue;
+        }
+        fragments_.push_back(Fragment{boundary, seq});
+    }
+}
+
+size_t RangeDelAggregator::findFragment(const std::string& user_key) const {
+    auto it = std::upper_bound(fragments_.begin(), fragments_.end(), user_key, 
+        [](const std::string& key, const Fragment& fragment) {
+            return key < fragment.begin;
+        });
+    if (it == fragments_.begin()) {
+        return fragments_.size();
+    }
+    return static_cast<size_t>(it - fragments_.begin()) - 1;
+}
+
+uint64_t RangeDelAggregator::getMaxCoveringSeq(const std::string& user_key) const {
+    size_t index = findFragment(user_key);
+    return index == fragments_.size() ? 0 : fragments_[index].seq;
+}
+
+bool RangeDelAggregator::isRangeDeleted(const std::string& begin, const std::string& end, 
+                                        bool end_exclusive, uint64_t seq) const {
+    size_t index = findFragment(begin);
+    if (index == fragments_.size()) {
+        return false;
+    }
+    // 从begin所在的片段开始, 每个片段都要被更新的标记覆盖, 直到片段超出范围
+    for (; index < fragments_.size(); ++index) {
+        if (fragments_[index].seq <= seq) {
+            return false;
+        }
+        if (index + 1 == fragments_.size()) {
+            // 最后一个片段的序列号总是0
+            return false;
+        }
+        const std::string& next_begin = fragments_[index + 1].begin;
+        if (end < next_begin || (end_exclusive && end == next_begin)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}
@@ -0,0 +1,930 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 17:52:19
+ * @LastEditTime: 2026-10-18 23:18:25
+ */
+#include <tomato_db/sstable.h>
+#include <tomato_db/compression.h>
+#include <tomato_common/codec.h>
+#include <tomato_common/crc32.h>
+
+#include <cerrno>
+#include <future>
+
+namespace tomato {
+
+OperatorResult SSTable::open(std::shared_ptr<RandomAccessFile> file, uint64_t file_size,
+                             std::shared_ptr<SSTable>& table, BlockCache* block_cache) {
+    if (!file->isOpen()) {
+        return {EIO, "open table error, filename: " + file->getFileName()};
+    }
+    if (file_size < Footer::ENCODED_LENGTH) {
+        return {EINVAL, "table file too short, filename: " + file->getFileName()};
+    }
+    std::string encoded_footer;
+    OperatorResult status = file->read(file_size - Footer::ENCODED_LENGTH, Footer::ENCODED_LENGTH, encoded_footer);
+    if (!status.isSuccess()) {
+        return status;
+    }
+    Footer footer;
+    if (!footer.decodeFrom(encoded_footer)) {
+        return {EINVAL, "bad table footer, filename: " + file->getFileName()};
+    }
+
+    table.reset(new SSTable(std::move(file), footer.block_trailer, block_cache));
+    status = table->readBlock(footer.index_handle, table->index_block_);
+    if (status.isSuccess()) {
+        status = table->readMetaBlocks(footer.metaindex_handle);
+    }
+    if (!status.isSuccess()) {
+        table.reset();
+    }
+    return status;
+}
+
+OperatorResult SSTable::readMetaBlocks(const BlockHandle& handle) {
+    std::shared_ptr<Block> metaindex_block;
+    OperatorResult status = readBlock(handle, metaindex_block);
+    if (!status.isSuccess()) {
+        return status;
+    }
+    const std::string filter_prefix = PREFIX_FILTER_BLOCK_PREFIX;
+    const std::string partitioned_filter_prefix = PARTITIONED_PREFIX_FILTER_BLOCK_PREFIX;
+    Block::Iterator meta_iter(metaindex_block.get(), compareBytewise);
+    for (meta_iter.seekToFirst(); meta_iter.valid() && status.isSuccess(); meta_iter.next()) {
+        BlockHandle meta_handle;
+        if (!meta_handle.decodeFrom(meta_iter.value())) {
+            return {EINVAL, "bad metaindex entry, filename: " + file_->getFileName()};
+        }
+        const std::string& name = meta_iter.key();
+        if (name == COMPRESSION_DICT_BLOCK_NAME) {
+            status = readBlockContents(meta_handle, std::string(), compression_dict_);
+        } else if (name == CUCKOO_INDEX_BLOCK_NAME) {
+            status = readCuckooIndexBlock(meta_handle, handle.offset);
+        } else if (name == INDEX_PARTITIONS_BLOCK_NAME) {
+            partitioned_index_ = true;
+        } else if (name == LEARNED_INDEX_BLOCK_NAME) {
+            status = readLearnedIndexBlock(meta_handle);
+        } else if (name.compare(0, partitioned_filter_prefix.size(), partitioned_filter_prefix) == 0) {
+            status = readBlock(meta_handle, filter_index_);
+            prefix_filter_name_ = name.substr(partitioned_filter_prefix.size());
+        } else if (name == PLAIN_TABLE_BLOCK_NAME) {
+            enablePlainTable(handle.offset);
+        } else if (name == RANGE_DEL_BLOCK_NAME) {
+            status = readRangeDelBlock(meta_handle);
+        } else if (name == RANGE_FILTER_BLOCK_NAME) {
+            status = readBlock(meta_handle, range_filter_);
+        } else if (name.compare(0, filter_prefix.size(), filter_prefix) == 0) {
+            status = readPrefixFilterBlock(meta_handle, name.substr(filter_prefix.size()));
+        }
+    }
+    if (status.isSuccess() && meta_iter.isCorrupted()) {
+        return {EINVAL, "bad metaindex block, filename: " + file_->getFileName()};
+    }
+    return status;
+}
+
+OperatorResult SSTable::readRangeDelBlock(const BlockHandle& handle) {
+    std::shared_ptr<Block> range_del_block;
+    OperatorResult status = readBlock(handle, range_del_block);
+    if (!status.isSuccess()) {
+        return status;
+    }
+    Block::Iterator iter(range_del_block.get(), compareInternalKey);
+    ParsedInternalKey parsed_key;
+    for (iter.seekToFirst(); iter.valid(); iter.next()) {
+        if (!parseInternalKey(iter.key(), parsed_key)) {
+            return {EINVAL, "bad range tombstone, filename: " + file_->getFileName()};
+        }
+        range_tombstones_.push_back(RangeTombstone{parsed_key.user_key, iter.value(), parsed_key.seq});
+    }
+    if (iter.isCorrupted()) {
+        return {EINVAL, "bad range tombstone block, filename: " + file_->getFileName()};
+    }
+    return OperatorResult::success();
+}
+
+OperatorResult SSTable::readPrefixFilterBlock(const BlockHandle& handle, std::string extractor_name) {
+    // 过滤器block不是键值对格式, 直接使用原始内容
+    std::string contents;
+    OperatorResult status = readBlockContents(handle, std::string(), contents);
+    if (!status.isSuccess()) {
+        return status;
+    }
+    std::unique_ptr<FilterBlockReader> reader(new FilterBlockReader());
+    if (!reader->init(std::move(contents))) {
+        return {EINVAL, "bad prefix filter block, filename: " + file_->getFileName()};
+    }
+    prefix_filter_ = std::move(reader);
+    prefix_filter_name_ = std::move(extractor_name);
+    return OperatorResult::success();
+}
+
+OperatorResult SSTable::readCuckooIndexBlock(const BlockHandle& handle, uint64_t limit) {
+    const char* mapped_data = file_->getMappedData();
+    if (mapped_data == nullptr || !block_trailer_) {
+        return OperatorResult::success();
+    }
+    if (handle.offset > limit || handle.size + BLOCK_TRAILER_SIZE > limit - handle.offset) {
+        return {EINVAL, "bad cuckoo index handle, filename: " + file_->getFileName()};
+    }
+    const char* data = mapped_data + handle.offset;
+    const size_t size = static_cast<size_t>(handle.size);
+    if (data[size] != static_cast<char>(CompressionType::NO_COMPRESSION) || 
+            codec::decodeFixed32(data + size + 1) != crc32(data, size + 1)) {
+        return {EINVAL, "block checksum mismatch, filename: " + file_->getFileName()};
+    }
+    std::unique_ptr<CuckooIndexReader> reader(new CuckooIndexReader());
+    if (!reader->init(data, size)) {
+        return {EINVAL, "bad cuckoo index block, filename: " + file_->getFileName()};
+    }
+    cuckoo_index_ = std::move(reader);
+    mapped_data_ = mapped_data;
+    mapped_limit_ = handle.offset;
+    return OperatorResult::success();
+}
+
+void SSTable::enablePlainTable(uint64_t limit) {
+    const char* mapped_data = file_->getMappedData();
+    if (mapped_data == nullptr || !block_trailer_) {
+        return;
+    }
+    plain_table_ = true;
+    if (mapped_data_ == nullptr) {
+        mapped_data_ = mapped_data;
+        mapped_limit_ = limit;
+    }
+}
+
+OperatorResult SSTable::getFromHashIndex(const std::string& lookup_key, LookupResult& result, bool& finished) const {
+    finished = false;
+    ParsedInternalKey lookup;
+    if (!parseInternalKey(lookup_key, lookup)) {
+        return {EINVAL, "bad lookup key"};
+    }
+    uint64_t offsets[CuckooIndexReader::MAX_CANDIDATES];
+    const size_t count = cuckoo_index_->getCandidates(lookup.user_key, offsets);
+    const char* end = mapped_data_ + mapped_limit_;
+    ParsedInternalKey parsed_key;
+    for (size_t i = 0; i < count; ++i) {
+        // 每个用户键的第一个版本都在组的起点, 与前一个键没有共享前缀
+        if (offsets[i] >= mapped_limit_) {
+            return {EINVAL, "bad cuckoo index entry, filename: " + file_->getFileName()};
+        }
+        const char* p = mapped_data_ + offsets[i];
+        uint64_t lengths[3];
+        for (uint64_t& length : lengths) {
+            std::pair<uint64_t, int> res = codec::decodeVar64(p, end);
+            if (res.second == 0) {
+                return {EINVAL, "bad cuckoo index entry, filename: " + file_->getFileName()};
+            }
+            length = res.first;
+            p += res.second;
+        }
+        if (lengths[0] != 0 || static_cast<uint64_t>(end - p) < lengths[1] + lengths[2] ||
+                !parseInternalKey(std::string(p, static_cast<size_t>(lengths[1])), parsed_key)) {
+            return {EINVAL, "bad cuckoo index entry, filename: " + file_->getFileName()};
+        }
+        if (parsed_key.user_key != lookup.user_key) {
+            // 标签相同的其他用户键
+            continue;
+        }
+        if (parsed_key.seq > lookup.seq || parsed_key.type == ItemType::MERGE) {
+            return OperatorResult::success();
+        }
+        finished = true;
+        const uint64_t tombstone_seq = range_tombstones_.empty() ? 0 : 
+                                       getMaxCoveringTombstoneSeq(lookup.user_key, lookup.seq);
+        if (parsed_key.seq < tombstone_seq) {
+            // 由finishLookup按范围删除处理
+            return OperatorResult::success();
+        }
+        result.found = true;
+        result.seq = parsed_key.seq;
+        result.deleted = parsed_key.type == ItemType::DELETION;
+        if (!result.deleted) {
+            result.value.assign(p + lengths[1], static_cast<size_t>(lengths[2]));
+            result.blob_index = parsed_key.type == ItemType::BLOB_INDEX;
+        }
+        return OperatorResult::success();
+    }
+    // 哈希索引中有表内所有的用户键
+    finished = true;
+    return OperatorResult::success();
+}
+
+OperatorResult SSTable::readLearnedIndexBlock(const BlockHandle& handle) {
+    std::string contents;
+    OperatorResult status = readBlockContents(handle, std::string(), contents);
+    if (!status.isSuccess()) {
+        return status;
+    }
+    std::unique_ptr<LearnedIndexReader> reader(new LearnedIndexReader());
+    if (!reader->init(contents)) {
+        return {EINVAL, "bad learned index block, filename: " + file_->getFileName()};
+    }
+    learned_index_ = std::move(reader);
+    return OperatorResult::success();
+}
+
+bool SSTable::prefixMayMatch(const PrefixExtractor& extractor, const std::string& prefix) const {
+    if (prefix_filter_name_ != extractor.name()) {
+        return true;
+    }
+    if (prefix_filter_) {
+        return prefix_filter_->tableMayMatch(prefix);
+    }
+    if (!filter_index_) {
+        return true;
+    }
+    // 表中有这个前缀的键时, 第一个不小于前缀的键就有这个前缀, 只需要检查它所在的分区
+    return partitionPrefixMayMatch(encodeLookupKey(prefix, MAX_SEQUENCE), nullptr, prefix);
+}
+
+bool SSTable::partitionPrefixMayMatch(const std::string& key, const uint64_t* block_offset, 
+                                      const std::string& prefix) const {
+    Block::Iterator iter(filter_index_.get(), compareInternalKey);
+    iter.seek(key);
+    if (!iter.valid()) {
+        // 格式错误时当作可能存在
+        return iter.isCorrupted();
+    }
+    const char* begin = iter.value().data();
+    const char* end = begin + iter.value().size();
+    BlockHandle handle;
+    if (!handle.decodeFrom(begin, end)) {
+        return true;
+    }
+    std::pair<uint64_t, int> base = codec::decodeVar64(begin, end);
+    if (base.second == 0) {
+        return true;
+    }
+    std::shared_ptr<Block> partition;
+    FilterBlockReader reader;
+    if (!readCachedBlock(handle, std::string(), true, partition).isSuccess() ||
+            !reader.init(partition->getContents().data(), partition->getContents().size())) {
+        return true;
+    }
+    if (block_offset == nullptr) {
+        return reader.tableMayMatch(prefix);
+    }
+    return *block_offset < base.first || reader.blockMayMatch(*block_offset - base.first, prefix);
+}
+
+bool SSTable::rangeMayMatch(const std::string& begin, const std::string& end) const {
+    if (!range_filter_) {
+        return true;
+    }
+    // 第一个不小于begin的截断键对应的用户键不小于它, 截断键小于end时可能落在范围内;
+    // 前一个截断键是begin的前缀时, 它对应的用户键可能不小于begin
+    Block::Iterator iter(range_filter_.get(), compareBytewise);
+    iter.seek(begin);
+    if (iter.valid()) {
+        if (end.empty() || iter.key() < end) {
+            return true;
+        }
+        iter.prev();
+    } else {
+        iter.seekToLast();
+    }
+    if (iter.isCorrupted()) {
+        return true;
+    }
+    return iter.valid() && begin.compare(0, iter.key().size(), iter.key()) == 0;
+}
+
+bool SSTable::blockPrefixMayMatch(const PrefixExtractor& extractor, uint64_t block_offset, 
+                                  const std::string& block_last_key, const std::string& prefix) const {
+    if (prefix_filter_name_ != extractor.name()) {
+        return true;
+    }
+    if (prefix_filter_) {
+        return prefix_filter_->blockMayMatch(block_offset, prefix);
+    }
+    if (!filter_index_) {
+        return true;
+    }
+    // 过滤器分区与index分区一一对应, data block在最后一个键不小于它的最后一个键的第一个分区中
+    return partitionPrefixMayMatch(block_last_key, &block_offset, prefix);
+}
+
+uint64_t SSTable::getMaxCoveringTombstoneSeq(const std::string& user_key, uint64_t seq) const {
+    uint64_t max_seq = 0;
+    for (const RangeTombstone& tombstone : range_tombstones_) {
+        if (tombstone.seq <= seq && tombstone.seq > max_seq &&
+                tombstone.begin <= user_key && user_key < tombstone.end) {
+            max_seq = tombstone.seq;
+        }
+    }
+    return max_seq;
+}
+
+/**
+ * @brief 从data block迭代器的当前位置开始收集用户键的版本: 合并操作数追加到result.operands, 
+ *        直到遇到值、删除标记或比范围删除标记旧的版本
+ * 
+ * @return true 查找结束; false 到达block末尾, 下一个data block中可能还有这个键的版本
+ */
+static bool collectVersions(Block::Iterator& iter, const std::string& user_key, uint64_t tombstone_seq,
+                            SSTable::LookupResult& result, bool& corrupted) {
+    ParsedInternalKey parsed_key;
+    for (; iter.valid(); iter.next()) {
+        if (!parseInternalKey(iter.key(), parsed_key)) {
+            corrupted = true;
+            return true;
+        }
+        if (parsed_key.user_key != user_key) {
+            return true;
+        }
+        if (parsed_key.seq < tombstone_seq) {
+            // 由调用者按范围删除处理
+            return true;
+        }
+        if (parsed_key.type == ItemType::MERGE) {
+            result.operands.push_back(iter.value());
+            continue;
+        }
+        result.found = true;
+        result.seq = parsed_key.seq;
+        result.deleted = parsed_key.type == ItemType::DELETION;
+        if (!result.deleted) {
+            result.value = iter.value();
+            result.blob_index = parsed_key.type == ItemType::BLOB_INDEX;
+        }
+        return true;
+    }
+    return false;
+}
+
+void SSTable::finishLookup(const std::string& lookup_key, LookupResult& result) const {
+    ParsedInternalKey parsed_key;
+    if (result.found || range_tombstones_.empty() || !parseInternalKey(lookup_key, parsed_key)) {
+        return;
+    }
+    const uint64_t tombstone_seq = getMaxCoveringTombstoneSeq(parsed_key.user_key, parsed_key.seq);
+    if (tombstone_seq > 0) {
+        result.found = true;
+        result.deleted = true;
+        result.seq = tombstone_seq;
+        result.value.clear();
+    }
+}
+
+SSTable::SSTable(std::shared_ptr<RandomAccessFile> file, bool block_trailer, BlockCache* block_cache)
+    : file_(std::move(file)),
+      block_trailer_(block_trailer),
+      block_cache_(block_cache),
+      cache_id_(block_cache ? block_cache->newId() : 0),
+      index_block_(),
+      partitioned_index_(false),
+      mapped_data_(nullptr),
+      mapped_limit_(0),
+      plain_table_(false) {}
+
+OperatorResult SSTable::readBlockContents(const BlockHandle& handle, const std::string& dict, 
+                                          std::string& contents) const {
+    const size_t size = static_cast<size_t>(handle.size);
+    if (!block_trailer_) {
+        return file_->read(handle.offset, size, contents);
+    }
+    std::string raw;
+    OperatorResult status = file_->read(handle.offset, size + BLOCK_TRAILER_SIZE, raw);
+    if (!status.isSuccess()) {
+        return status;
+    }
+    if (raw.size() != size + BLOCK_TRAILER_SIZE) {
+        return {EINVAL, "truncated block, filename: " + file_->getFileName()};
+    }
+    const uint32_t crc = codec::decodeFixed32(raw.data() + size + 1);
+    if (crc != crc32(raw.data(), size + 1)) {
+        return {EINVAL, "block checksum mismatch, filename: " + file_->getFileName()};
+    }
+    const CompressionType type = static_cast<CompressionType>(static_cast<unsigned char>(raw[size]));
+    if (type == CompressionType::NO_COMPRESSION) {
+        raw.resize(size);
+        contents.swap(raw);
+        return OperatorResult::success();
+    }
+    if (!uncompressBlock(type, raw.data(), size, dict, contents)) {
+        return {EINVAL, "bad compressed block, filename: " + file_->getFileName()};
+    }
+    return OperatorResult::success();
+}
+
+OperatorResult SSTable::readBlock(const BlockHandle& handle, std::shared_ptr<Block>& block) const {
+    std::string contents;
+    OperatorResult status = readBlockContents(handle, std::string(), contents);
+    if (!status.isSuccess()) {
+        return status;
+    }
+    block = std::make_shared<Block>(std::move(contents));
+    if (!block->isValid()) {
+        return {EINVAL, "bad block, filename: " + file_->getFileName()};
+    }
+    return OperatorResult::success();
+}
+
+OperatorResult SSTable::readDataBlock(const BlockHandle& handle, std::shared_ptr<Block>& block, 
+                                      bool fill_cache) const {
+    if (plain_table_) {
+        // 直接引用文件映射, 不校验crc, 也不放入缓存
+        if (handle.offset > mapped_limit_ || handle.size + BLOCK_TRAILER_SIZE > mapped_limit_ - handle.offset) {
+            return {EINVAL, "bad block handle, filename: " + file_->getFileName()};
+        }
+        const char* data = mapped_data_ + handle.offset;
+        const size_t size = static_cast<size_t>(handle.size);
+        if (data[size] != static_cast<char>(CompressionType::NO_COMPRESSION)) {
+            return {EINVAL, "compressed block in plain table, filename: " + file_->getFileName()};
+        }
+        block = std::make_shared<Block>(data, size);
+        if (!block->isValid()) {
+            return {EINVAL, "bad block, filename: " + file_->getFileName()};
+        }
+        return OperatorResult::success();
+    }
+    OperatorResult status = readCachedBlock(handle, compression_dict_, fill_cache, block);
+    if (status.isSuccess() && !block->isValid()) {
+        return {EINVAL, "bad block, filename: " + file_->getFileName()};
+    }
+    return status;
+}
+
+OperatorResult SSTable::readCachedBlock(const BlockHandle& handle, const std::string& dict, bool fill_cache,
+                                        std::shared_ptr<Block>& block) const {
+    if (block_cache_ != nullptr) {
+        block = block_cache_->lookup(cache_id_, handle.offset);
+        if (block) {
+            return OperatorResult::success();
+        }
+    }
+    std::string contents;
+    OperatorResult status = readBlockContents(handle, dict, contents);
+    if (!status.isSuccess()) {
+        return status;
+    }
+    block = std::make_shared<Block>(std::move(contents));
+    if (block_cache_ != nullptr && fill_cache) {
+        block_cache_->insert(cache_id_, handle.offset, block);
+    }
+    return OperatorResult::success();
+}
+
+OperatorResult SSTable::get(const std::string& lookup_key, LookupResult& result) const {
+    std::vector<std::string> lookup_keys(1, lookup_key);
+    std::vector<LookupResult> results(1);
+    OperatorResult status = multiGet(lookup_keys, results, nullptr);
+    result = std::move(results[0]);
+    return status;
+}
+
+OperatorResult SSTable::multiGet(const std::vector<std::string>& lookup_keys,
+                                 std::vector<LookupResult>& results, ThreadPool* pool) const {
+    // 有布谷鸟哈希索引时先直接在文件映射中查找
+    std::vector<char> skipped(lookup_keys.size(), 0);
+    if (cuckoo_index_) {
+        for (size_t i = 0; i < lookup_keys.size(); ++i) {
+            bool finished = false;
+            OperatorResult status = getFromHashIndex(lookup_keys[i], results[i], finished);
+            if (!status.isSuccess()) {
+                return status;
+            }
+            skipped[i] = finished ? 1 : 0;
+        }
+    }
+
+    // 查找键有序, 顺着index block前进即可得到每个键所在的data block
+    std::vector<BlockHandle> handles;
+    std::vector<std::vector<size_t>> groups;
+    IndexIterator index_iter(this, true);
+    for (size_t i = 0; i < lookup_keys.size(); ++i) {
+        if (skipped[i]) {
+            continue;
+        }
+        if (!index_iter.valid() || compareInternalKey(index_iter.key(), lookup_keys[i]) < 0) {
+            index_iter.seek(lookup_keys[i]);
+            if (!index_iter.valid()) {
+                // 剩余的键都大于最后一个键
+                break;
+            }
+            BlockHandle handle;
+            if (!handle.decodeFrom(index_iter.value())) {
+                return {EINVAL, "bad index entry, filename: " + file_->getFileName()};
+            }
+            handles.push_back(handle);
+            groups.emplace_back();
+        }
+        groups.back().push_back(i);
+    }
+    OperatorResult status = index_iter.getStatus();
+    if (!status.isSuccess()) {
+        return status;
+    }
+
+    std::vector<char> unfinished(lookup_keys.size(), 0);
+    if (pool == nullptr || pool->getThreadCount() == 0 || handles.size() <= 1) {
+        for (size_t i = 0; i < handles.size() && status.isSuccess(); ++i) {
+            status = searchBlock(handles[i], lookup_keys, groups[i], results, unfinished);
+        }
+    } else {
+        status = searchBlocksInParallel(handles, groups, lookup_keys, results, unfinished, pool);
+    }
+    for (size_t i = 0; i < lookup_keys.size() && status.isSuccess(); ++i) {
+        if (unfinished[i]) {
+            // 合并操作数跨越了data block, 很少发生, 单独从头查找
+            results[i] = LookupResult();
+            status = searchAcrossBlocks(lookup_keys[i], results[i]);
+        }
+        finishLookup(lookup_keys[i], results[i]);
+    }
+    return status;
+}
+
+OperatorResult SSTable::searchAcrossBlocks(const std::string& lookup_key, LookupResult& result) const {
+    ParsedInternalKey parsed_key;
+    if (!parseInternalKey(lookup_key, parsed_key)) {
+        return {EINVAL, "bad lookup key"};
+    }
+    const uint64_t tombstone_seq = getMaxCoveringTombstoneSeq(parsed_key.user_key, parsed_key.seq);
+    IndexIterator index_iter(this, true);
+    for (index_iter.seek(lookup_key); index_iter.valid(); index_iter.next()) {
+        BlockHandle handle;
+        std::shared_ptr<Block> block;
+        if (!handle.decodeFrom(index_iter.value())) {
+            return {EINVAL, "bad index entry, filename: " + file_->getFileName()};
+        }
+        OperatorResult status = readDataBlock(handle, block, true);
+        if (!status.isSuccess()) {
+            return status;
+        }
+        Block::Iterator iter(block.get(), compareInternalKey);
+        iter.seek(lookup_key);
+        bool corrupted = false;
+        bool finished = collectVersions(iter, parsed_key.user_key, tombstone_seq, result, corrupted);
+        if (corrupted || iter.isCorrupted()) {
+            return {EINVAL, "bad data block, filename: " + file_->getFileName()};
+        }
+        if (finished) {
+            break;
+        }
+    }
+    return index_iter.getStatus();
+}
+
+OperatorResult SSTable::searchBlocksInParallel(const std::vector<BlockHandle>& handles,
+                                               const std::vector<std::vector<size_t>>& groups,
+                                               const std::vector<std::string>& lookup_keys,
+                                               std::vector<LookupResult>& results, std::vector<char>& unfinished,
+                                               ThreadPool* pool) const {
+    // 每组写入results中互不相同的位置, 可以并行
+    std::vector<std::future<OperatorResult>> futures;
+    futures.reserve(handles.size());
+    for (size_t i = 0; i < handles.size(); ++i) {
+        const BlockHandle& handle = handles[i];
+        const std::vector<size_t>& indexes = groups[i];
+        futures.push_back(pool->submit([this, &handle, &lookup_keys, &indexes, &results, &unfinished]() {
+            return searchBlock(handle, lookup_keys, indexes, results, unfinished);
+        }));
+    }
+    OperatorResult status = OperatorResult::success();
+    for (std::future<OperatorResult>& future : futures) {
+        OperatorResult res = future.get();
+        if (status.isSuccess() && !res.isSuccess()) {
+            status = res;
+        }
+    }
+    return status;
+}
+
+OperatorResult SSTable::searchBlock(const BlockHandle& handle,
+                                    const std::vector<std::string>& lookup_keys,
+                                    const std::vector<size_t>& indexes,
+                                    std::vector<LookupResult>& results,
+                                    std::vector<char>& unfinished) const {
+    std::shared_ptr<Block> block;
+    OperatorResult status = readDataBlock(handle, block, true);
+    if (!status.isSuccess()) {
+        return status;
+    }
+    Block::Iterator iter(block.get(), compareInternalKey);
+    ParsedInternalKey lookup;
+    for (size_t index : indexes) {
+        const std::string& lookup_key = lookup_keys[index];
+        if (!parseInternalKey(lookup_key, lookup)) {
+            return {EINVAL, "bad lookup key"};
+        }
+        const uint64_t tombstone_seq = range_tombstones_.empty() ? 0 : 
+                                       getMaxCoveringTombstoneSeq(lookup.user_key, lookup.seq);
+        if (!iter.seekForGet(lookup_key)) {
+            // 哈希索引说明block中没有这个用户键
+            continue;
+        }
+        bool corrupted = false;
+        if (!collectVersions(iter, lookup.user_key, tombstone_seq, results[index], corrupted)) {
+            unfinished[index] = 1;
+        }
+        if (corrupted) {
+            return {EINVAL, "bad internal key, filename: " + file_->getFileName()};
+        }
+    }
+    if (iter.isCorrupted()) {
+        return {EINVAL, "bad data block, filename: " + file_->getFileName()};
+    }
+    return OperatorResult::success();
+}
+
+SSTable::IndexIterator::IndexIterator(const SSTable* table, bool fill_cache)
+    : table_(table),
+      fill_cache_(fill_cache),
+      top_iter_(table->index_block_.get(), compareInternalKey),
+      partition_(),
+      partition_iter_(),
+      status_(OperatorResult::success()) {}
+
+bool SSTable::IndexIterator::valid() const {
+    if (!table_->partitioned_index_) {
+        return top_iter_.valid();
+    }
+    return partition_iter_ && partition_iter_->valid();
+}
+
+void SSTable::IndexIterator::seekToFirst() {
+    top_iter_.seekToFirst();
+    if (!table_->partitioned_index_) {
+        return;
+    }
+    initPartition();
+    if (partition_iter_) {
+        partition_iter_->seekToFirst();
+    }
+    skipEmptyPartitionsForward();
+}
+
+void SSTable::IndexIterator::seekToLast() {
+    top_iter_.seekToLast();
+    if (!table_->partitioned_index_) {
+        return;
+    }
+    initPartition();
+    if (partition_iter_) {
+        partition_iter_->seekToLast();
+    }
+    skipEmptyPartitionsBackward();
+}
+
+void SSTable::IndexIterator::seek(const std::string& target) {
+    if (!table_->partitioned_index_) {
+        if (table_->learned_index_) {
+            // 学习索引预测的范围不超过几十个block, 范围两端不对时由seekWithHint退回完整的二分查找
+            uint64_t first = 0;
+            uint64_t last = 0;
+            table_->learned_index_->predict(extractUserKey(target), first, last);
+            top_iter_.seekWithHint(target, static_cast<uint32_t>(first), static_cast<uint32_t>(last));
+        } else {
+            top_iter_.seek(target);
+        }
+        return;
+    }
+    // 顶层index的键是每个分区的最后一个键, 第一个不小于目标的分区中才可能有不小于目标的data block
+    top_iter_.seek(target);
+    initPartition();
+    if (partition_iter_) {
+        partition_iter_->seek(target);
+    }
+    skipEmptyPartitionsForward();
+}
+
+void SSTable::IndexIterator::next() {
+    if (!table_->partitioned_index_) {
+        top_iter_.next();
+        return;
+    }
+    partition_iter_->next();
+    skipEmptyPartitionsForward();
+}
+
+void SSTable::IndexIterator::prev() {
+    if (!table_->partitioned_index_) {
+        top_iter_.prev();
+        return;
+    }
+    partition_iter_->prev();
+    skipEmptyPartitionsBackward();
+}
+
+OperatorResult SSTable::IndexIterator::getStatus() const {
+    if (!status_.isSuccess()) {
+        return status_;
+    }
+    if (top_iter_.isCorrupted()) {
+        return {EINVAL, "bad index block, filename: " + table_->file_->getFileName()};
+    }
+    return OperatorResult::success();
+}
+
+void SSTable::IndexIterator::initPartition() {
+    partition_iter_.reset();
+    partition_.reset();
+    if (!top_iter_.valid() || !status_.isSuccess()) {
+        return;
+    }
+    BlockHandle handle;
+    if (!handle.decodeFrom(top_iter_.value())) {
+        status_ = OperatorResult(EINVAL, "bad index entry, filename: " + table_->file_->getFileName());
+        return;
+    }
+    OperatorResult status = table_->readCachedBlock(handle, std::string(), fill_cache_, partition_);
+    if (status.isSuccess() && !partition_->isValid()) {
+        status = OperatorResult(EINVAL, "bad index partition, filename: " + table_->file_->getFileName());
+    }
+    if (!status.isSuccess()) {
+        status_ = status;
+        partition_.reset();
+        return;
+    }
+    partition_iter_.reset(new Block::Iterator(partition_.get(), compareInternalKey));
+}
+
+void SSTable::IndexIterator::skipEmptyPartitionsForward() {
+    while (partition_iter_ && !partition_iter_->valid()) {
+        if (partition_iter_->isCorrupted()) {
+            status_ = OperatorResult(EINVAL, "bad index partition, filename: " + table_->file_->getFileName());
+            partition_iter_.reset();
+            return;
+        }
+        top_iter_.next();
+        initPartition();
+        if (partition_iter_) {
+            partition_iter_->seekToFirst();
+        }
+    }
+}
+
+void SSTable::IndexIterator::skipEmptyPartitionsBackward() {
+    while (partition_iter_ && !partition_iter_->valid()) {
+        if (partition_iter_->isCorrupted()) {
+            status_ = OperatorResult(EINVAL, "bad index partition, filename: " + table_->file_->getFileName());
+            partition_iter_.reset();
+            return;
+        }
+        top_iter_.prev();
+        initPartition();
+        if (partition_iter_) {
+            partition_iter_->seekToLast();
+        }
+    }
+}
+
+SSTable::Iterator::Iterator(std::shared_ptr<const SSTable> table, TableIteratorOptions options)
+    : table_(std::move(table)),
+      options_(std::move(options)),
+      excluded_target_(),
+      index_iter_(table_.get(), options_.fill_cache),
+      data_block_(),
+      data_iter_(),
+      status_(OperatorResult::success()) {}
+
+void SSTable::Iterator::seekToFirst() {
+    excluded_target_.clear();
+    index_iter_.seekToFirst();
+    initDataBlock();
+    if (data_iter_) {
+        data_iter_->seekToFirst();
+    }
+    skipEmptyDataBlocksForward();
+}
+
+void SSTable::Iterator::seekToLast() {
+    if (!excluded_target_.empty()) {
+        // 上一次seek被前缀过滤器排除, 归并迭代器改为反向遍历时需要停在目标之前
+        const std::string target = excluded_target_;
+        excluded_target_.clear();
+        index_iter_.seek(target);
+        initDataBlock();
+        if (data_iter_) {
+            data_iter_->seek(target);
+            skipEmptyDataBlocksForward();
+        }
+        if (valid()) {
+            prev();
+            return;
+        }
+        if (!status_.isSuccess()) {
+            return;
+        }
+    }
+    index_iter_.seekToLast();
+    initDataBlock();
+    if (data_iter_) {
+        data_iter_->seekToLast();
+    }
+    skipEmptyDataBlocksBackward();
+}
+
+void SSTable::Iterator::seek(const std::string& target) {
+    excluded_target_.clear();
+    index_iter_.seek(target);
+    if (seekExcluded(target)) {
+        excluded_target_ = target;
+        data_iter_.reset();
+        data_block_.reset();
+        return;
+    }
+    initDataBlock();
+    if (data_iter_) {
+        data_iter_->seek(target);
+    }
+    skipEmptyDataBlocksForward();
+}
+
+void SSTable::Iterator::next() {
+    data_iter_->next();
+    skipEmptyDataBlocksForward();
+}
+
+void SSTable::Iterator::prev() {
+    data_iter_->prev();
+    skipEmptyDataBlocksBackward();
+}
+
+bool SSTable::Iterator::seekExcluded(const std::string& target) const {
+    if (!index_iter_.valid()) {
+        return false;
+    }
+    const std::string user_key = extractUserKey(target);
+    if (!options_.upper_bound.empty() && user_key < options_.upper_bound && 
+            !table_->rangeMayMatch(user_key, options_.upper_bound)) {
+        return true;
+    }
+    // 目标有这个前缀时, 它所在的data block的最后一个键不小于目标: 
+    // 这个data block中没有这个前缀的键, 说明之后的data block中也没有
+    if (options_.prefix_extractor == nullptr || 
+            user_key.compare(0, options_.prefix.size(), options_.prefix) != 0) {
+        return false;
+    }
+    BlockHandle handle;
+    if (!handle.decodeFrom(index_iter_.value())) {
+        return false;
+    }
+    return !table_->blockPrefixMayMatch(*options_.prefix_extractor, handle.offset, index_iter_.key(), 
+                                        options_.prefix);
+}
+
+void SSTable::Iterator::initDataBlock() {
+    data_iter_.reset();
+    data_block_.reset();
+    if (!index_iter_.valid()) {
+        OperatorResult status = index_iter_.getStatus();
+        if (!status.isSuccess() && status_.isSuccess()) {
+            status_ = status;
+        }
+        return;
+    }
+    BlockHandle handle;
+    if (!handle.decodeFrom(index_iter_.value())) {
+        status_ = OperatorResult(EINVAL, "bad index entry");
+        return;
+    }
+    OperatorResult status = table_->readDataBlock(handle, data_block_, options_.fill_cache);
+    if (!status.isSuccess()) {
+        status_ = status;
+        return;
+    }
+    data_iter_.reset(new Block::Iterator(data_block_.get(), compareInternalKey));
+}
+
+bool SSTable::Iterator::checkDataBlockCorruption() {
+    if (data_iter_->isCorrupted()) {
+        status_ = OperatorResult(EINVAL, "bad data block");
+        data_iter_.reset();
+        return true;
+    }
+    return false;
+}
+
+void SSTable::Iterator::skipEmptyDataBlocksForward() {
+    while (data_iter_ && !data_iter_->valid()) {
+        if (checkDataBlockCorruption()) {
+            return;
+        }
+        index_iter_.next();
+        initDataBlock();
+        if (data_iter_) {
+            data_iter_->seekToFirst();
+        }
+    }
+}
+
+void SSTable::Iterator::skipEmptyDataBlocksBackward() {
+    while (data_iter_ && !data_iter_->valid()) {
+        if (checkDataBlockCorruption()) {
+            return;
+        }
+        index_iter_.prev();
+        initDataBlock();
+        if (data_iter_) {
+            data_iter_->seekToLast();
+        }
+    }
+}
+
+}
@@ -1,22 +1,48 @@
 /*
  * @Author: Tomato
  * @Date: 2022-01-05 23:30:54
- * @LastEditTime: 2022-11-24 09:11:54
+ * @LastEditTime: 2026-10-18 23:42:59
  */
 
 #include <tomato_db/sstable_builder.h>
+#include <tomato_db/block.h>
+#include <tomato_db/compression.h>
 #include <tomato_common/codec.h>
+#include <tomato_common/crc32.h>
+#include <tomato_common/lz.h>
 
 #include <algorithm>
 
 namespace tomato {
 
+/**
+ * @brief index block中的每一项都作为组的起点, 便于二分查找
+ * 
+ */
+static TableConfig indexBlockConfig(const TableConfig& config) {
+    TableConfig index_config = config;
+    index_config.block_group_size = 1;
+    return index_config;
+}
+
+/**
+ * @brief 布谷鸟哈希格式的每个键值对都从组的起点开始, 键不与前一个键共享前缀, 可以直接从文件中解析
+ * 
+ */
+static TableConfig dataBlockConfig(const TableConfig& config) {
+    return config.format == TableFormat::CUCKOO_HASH_TABLE ? indexBlockConfig(config) : config;
+}
+
 BlockBuilder::BlockBuilder(const TableConfig& config)
     : contents_(""),
       last_key_(""),
-      restarts_(),
+      restarts_(1, 0),
       group_size_(config.block_group_size),
-      current_group_size_(0)
+      current_group_size_(0),
+      finished_(false),
+      hash_ratio_(0),
+      hash_entries_(),
+      varint_tag_(false)
     {}
 
 BlockBuilder::~BlockBuilder() {
@@ -25,12 +51,15 @@ BlockBuilder::~BlockBuilder() {
 
 void BlockBuilder::add(const std::string&key, const std::string& value) {    
     // 计算和前一个key相同的前缀字符长度
+    // 变长标签时只在用户键之间共享前缀
+    const size_t tag_size = varint_tag_ ? sizeof(uint64_t) : 0;
+    const size_t prefix_size = key.size() - tag_size;
     uint64_t shared = 0;
     if (current_group_size_ >= group_size_) {
-        group_size_ = 0;
+        current_group_size_ = 0;
         restarts_.push_back(contents_.size());
-    } else {
-        size_t min_size = std::min(key.size(), last_key_.size());
+    } else if (last_key_.size() >= tag_size) {
+        size_t min_size = std::min(prefix_size, last_key_.size() - tag_size);
         for (size_t i = 0; i < min_size; ++i) {
             if (key[i] == last_key_[i]) {
                 ++shared;
@@ -41,21 +70,72 @@ void BlockBuilder::add(const std::string&key, const std::string& value) {
     }
     
     // 编码规则 与前面key共享的字节数(64bit) + key非共享字节数(64bit) + value的长度(64bit) + key + value
-    uint64_t unshared = key.size() - shared;
+    uint64_t unshared = prefix_size - shared;
     contents_.append(codec::encodeVar64(shared));
     contents_.append(codec::encodeVar64(unshared));
     contents_.append(codec::encodeVar64(value.size()));
     contents_.append(key.c_str() + shared, unshared);
+    if (varint_tag_) {
+        contents_.append(codec::encodeVar64(codec::decodeFixed64(key.data() + prefix_size)));
+    }
     contents_.append(value);
 
     last_key_.resize(shared);
-    last_key_.append(key.c_str() + shared, unshared);
+    last_key_.append(key.c_str() + shared, key.size() - shared);
 
     ++current_group_size_;
+    if (hash_ratio_ > 0 && key.size() >= sizeof(uint64_t)) {
+        hash_entries_.emplace_back(Block::hashUserKey(key.data(), key.size()), 
+                                   static_cast<uint32_t>(restarts_.size() - 1));
+    }
 }
 
-void BlockBuilder::reset() {
+/**
+ * @brief 哈希索引的桶数
+ * 
+ */
+static size_t hashBucketCount(size_t entries, double ratio) {
+    const size_t buckets = static_cast<size_t>(static_cast<double>(entries) / ratio);
+    return buckets > 0 ? buckets : 1;
+}
+
+const std::string& BlockBuilder::finish() {
+    for (uint64_t restart : restarts_) {
+        contents_.append(codec::encodeFixed32(static_cast<uint32_t>(restart)));
+    }
+    uint32_t num_restarts = static_cast<uint32_t>(restarts_.size());
+    if (!hash_entries_.empty() && restarts_.size() <= Block::MAX_HASH_INDEX_RESTARTS) {
+        // 同一个用户键的版本跨越多个组时与冲突相同, 查找时退回二分查找
+        const size_t num_buckets = hashBucketCount(hash_entries_.size(), hash_ratio_);
+        std::string buckets(num_buckets, static_cast<char>(Block::HASH_BUCKET_EMPTY));
+        for (const std::pair<uint32_t, uint32_t>& entry : hash_entries_) {
+            char& bucket = buckets[entry.first % num_buckets];
+            const char restart = static_cast<char>(entry.second);
+            if (bucket == static_cast<char>(Block::HASH_BUCKET_EMPTY)) {
+                bucket = restart;
+            } else if (bucket != restart) {
+                bucket = static_cast<char>(Block::HASH_BUCKET_COLLISION);
+            }
+        }
+        contents_.append(buckets);
+        contents_.append(codec::encodeFixed32(static_cast<uint32_t>(num_buckets)));
+        num_restarts |= Block::HASH_INDEX_FLAG;
+    }
+    if (varint_tag_) {
+        num_restarts |= Block::VARINT_TAG_FLAG;
+    }
+    contents_.append(codec::encodeFixed32(num_restarts));
+    finished_ = true;
+    return contents_;
+}
 
+void BlockBuilder::reset() {
+    contents_.clear();
+    last_key_.clear();
+    restarts_.assign(1, 0);
+    current_group_size_ = 0;
+    finished_ = false;
+    hash_entries_.clear();
 }
 
 const std::string& BlockBuilder::getContent() {
@@ -64,25 +144,387 @@ const std::string& BlockBuilder::getContent() {
 }
 
 size_t BlockBuilder::getBlockSize() {
-    return contents_.size();
+    if (finished_) {
+        return contents_.size();
+    }
+    size_t size = contents_.size() + (restarts_.size() + 1) * sizeof(uint32_t);
+    if (!hash_entries_.empty()) {
+        size += hashBucketCount(hash_entries_.size(), hash_ratio_) + sizeof(uint32_t);
+    }
+    return size;
 }
 
 SSTableBuilder::SSTableBuilder(const TableConfig& tableConfig, AppendOnlyFile* file)
-    : data_block_builder_(tableConfig),
-      index_builder_(tableConfig),
+    : data_block_builder_(dataBlockConfig(tableConfig)),
+      index_builder_(indexBlockConfig(tableConfig)),
+      range_del_builder_(indexBlockConfig(tableConfig)),
+      prefix_extractor_(tableConfig.prefix_extractor),
+      filter_builder_(),
+      filter_bits_per_key_(tableConfig.filter_bits_per_key),
+      partition_index_(tableConfig.partition_index),
+      index_partition_size_(tableConfig.index_partition_size),
+      top_index_builder_(indexBlockConfig(tableConfig)),
+      filter_index_builder_(indexBlockConfig(tableConfig)),
+      filter_base_(0),
+      index_partition_count_(0),
+      learned_index_builder_(),
+      cuckoo_builder_(),
+      cuckoo_pending_keys_(),
+      range_filter_(tableConfig.range_filter),
+      range_filter_builder_(tableConfig),
+      pending_user_key_(),
+      pending_shared_(0),
+      has_pending_user_key_(false),
       file_(file),
       offset_(0),
-      block_threshold_(tableConfig.block_size_threshold)
-    {}
+      block_threshold_(tableConfig.block_size_threshold),
+      plain_table_(tableConfig.format == TableFormat::PLAIN_TABLE),
+      compression_(plain_table_ ? CompressionType::NO_COMPRESSION : tableConfig.compression),
+      encoded_(),
+      dict_bytes_(tableConfig.compression_dict_bytes),
+      dict_sample_bytes_(tableConfig.compression_dict_sample_bytes),
+      compression_dict_(),
+      buffering_(tableConfig.compression_dict_bytes > 0 && 
+                 compression_ != CompressionType::NO_COMPRESSION &&
+                 tableConfig.format != TableFormat::CUCKOO_HASH_TABLE),
+      buffered_blocks_(),
+      buffered_prefixes_(),
+      buffered_bytes_(0),
+      pending_blocks_(),
+      pending_bytes_(0),
+      last_key_(),
+      entry_count_(0),
+      range_tombstone_count_(0),
+      status_(OperatorResult::success()),
+      compression_pool_() {
+    if (tableConfig.format == TableFormat::CUCKOO_HASH_TABLE) {
+        cuckoo_builder_.reset(new CuckooIndexBuilder());
+    } else {
+        data_block_builder_.enableHashIndex(tableConfig.data_block_hash_ratio);
+        data_block_builder_.enableVarintTag();
+    }
+    if (prefix_extractor_) {
+        filter_builder_.reset(new FilterBlockBuilder(filter_bits_per_key_));
+        filter_builder_->startBlock(0);
+    }
+    if (tableConfig.learned_index && !partition_index_) {
+        learned_index_builder_.reset(new LearnedIndexBuilder(tableConfig.learned_index_error));
+    }
+    if (tableConfig.compression_threads > 0 && compression_ != CompressionType::NO_COMPRESSION && !cuckoo_builder_) {
+        compression_pool_.reset(new ThreadPool(tableConfig.compression_threads));
+    }
+}
 
 SSTableBuilder::~SSTableBuilder() {
 }
 
 void SSTableBuilder::add(const std::string&key, const std::string& value) {
+    if (filter_builder_ || range_filter_ || cuckoo_builder_) {
+        const std::string user_key = extractUserKey(key);
+        if (cuckoo_builder_ && (entry_count_ == 0 || extractUserKey(last_key_) != user_key)) {
+            cuckoo_pending_keys_.emplace_back(user_key, data_block_builder_.getContent().size());
+        }
+        if (filter_builder_ && prefix_extractor_->inDomain(user_key)) {
+            if (buffering_ || compression_pool_) {
+                buffered_prefixes_.push_back(prefix_extractor_->transform(user_key));
+            } else {
+                filter_builder_->addKey(prefix_extractor_->transform(user_key));
+            }
+        }
+        if (range_filter_) {
+            addRangeFilterKey(&user_key);
+        }
+    }
     data_block_builder_.add(key, value);
-    
+    last_key_ = key;
+    ++entry_count_;
+    if (data_block_builder_.getBlockSize() >= block_threshold_) {
+        flushDataBlock();
+    }
+}
+
+void SSTableBuilder::addRangeTombstone(const RangeTombstone& tombstone) {
+    range_del_builder_.add(encodeInternalKey(tombstone.begin, tombstone.seq, ItemType::RANGE_DELETION), tombstone.end);
+    ++range_tombstone_count_;
 }
 
+OperatorResult SSTableBuilder::finish() {
+    if (!data_block_builder_.empty()) {
+        flushDataBlock();
+    }
+    if (buffering_) {
+        trainDictionary();
+    }
+    while (!pending_blocks_.empty()) {
+        writePendingBlock();
+    }
+    if (partition_index_ && !index_builder_.empty()) {
+        flushIndexPartition(last_key_);
+    }
+
+    // meta block: 压缩字典、布谷鸟哈希索引、index分区数或学习索引、前缀过滤器、范围删除标记与范围过滤器, 
+    // metaindex block中的名字按升序添加
+    Footer footer;
+    BlockBuilder metaindex_builder(indexBlockConfig(TableConfig{}));
+    if (!compression_dict_.empty()) {
+        writeMetaBlock(COMPRESSION_DICT_BLOCK_NAME, compression_dict_, metaindex_builder);
+    }
+    if (cuckoo_builder_ && entry_count_ > 0) {
+        // 按缓存行对齐, 每个桶只占一个缓存行
+        const uint64_t padding = (CUCKOO_BUCKET_SIZE - offset_ % CUCKOO_BUCKET_SIZE) % CUCKOO_BUCKET_SIZE;
+        if (padding > 0 && status_.isSuccess()) {
+            status_ = file_->append(std::string(static_cast<size_t>(padding), '\0'));
+        }
+        offset_ += padding;
+        BlockHandle handle;
+        writeRawBlock(cuckoo_builder_->finish(), CompressionType::NO_COMPRESSION, handle);
+        std::string encoded_handle;
+        handle.encodeTo(encoded_handle);
+        metaindex_builder.add(CUCKOO_INDEX_BLOCK_NAME, encoded_handle);
+    }
+    if (learned_index_builder_ && entry_count_ > 0) {
+        writeMetaBlock(LEARNED_INDEX_BLOCK_NAME, learned_index_builder_->finish(), metaindex_builder);
+    }
+    if (partition_index_) {
+        writeMetaBlock(INDEX_PARTITIONS_BLOCK_NAME, codec::encodeVar64(index_partition_count_), metaindex_builder);
+        if (filter_builder_) {
+            writeMetaBlock(PARTITIONED_PREFIX_FILTER_BLOCK_PREFIX + std::string(prefix_extractor_->name()), 
+                           filter_index_builder_.finish(), metaindex_builder);
+        }
+    }
+    if (plain_table_) {
+        writeMetaBlock(PLAIN_TABLE_BLOCK_NAME, std::string(), metaindex_builder);
+    }
+    if (!partition_index_ && filter_builder_) {
+        writeMetaBlock(PREFIX_FILTER_BLOCK_PREFIX + std::string(prefix_extractor_->name()), 
+                       filter_builder_->finish(), metaindex_builder);
+    }
+    if (range_tombstone_count_ > 0) {
+        writeMetaBlock(RANGE_DEL_BLOCK_NAME, range_del_builder_.finish(), metaindex_builder);
+    }
+    if (range_filter_) {
+        addRangeFilterKey(nullptr);
+        writeMetaBlock(RANGE_FILTER_BLOCK_NAME, range_filter_builder_.finish(), metaindex_builder);
+    }
+    writeBlock(metaindex_builder, footer.metaindex_handle);
+    writeBlock(partition_index_ ? top_index_builder_ : index_builder_, footer.index_handle);
 
+    std::string encoded_footer;
+    footer.encodeTo(encoded_footer);
+    if (status_.isSuccess()) {
+        status_ = file_->append(encoded_footer);
+        offset_ += encoded_footer.size();
+    }
+    return status_;
+}
 
-}
\ No newline at end of file
+void SSTableBuilder::flushDataBlock() {
+    if (buffering_) {
+        BufferedBlock block;
+        block.contents = data_block_builder_.finish();
+        block.last_key = last_key_;
+        block.prefixes.swap(buffered_prefixes_);
+        buffered_bytes_ += block.contents.size();
+        buffered_blocks_.push_back(std::move(block));
+        data_block_builder_.reset();
+        if (buffered_bytes_ >= dict_sample_bytes_) {
+            trainDictionary();
+        }
+        return;
+    }
+    std::vector<std::string> prefixes;
+    prefixes.swap(buffered_prefixes_);
+    writeDataBlock(data_block_builder_.finish(), last_key_, std::move(prefixes));
+    data_block_builder_.reset();
+}
+
+void SSTableBuilder::writeDataBlock(const std::string& contents, const std::string& last_key, 
+                                    std::vector<std::string> prefixes) {
+    if (compression_pool_) {
+        // 字典训练后不再改变, 压缩任务可以直接引用
+        const CompressionType compression = compression_;
+        const std::string* dict = &compression_dict_;
+        std::string raw = contents;
+        PendingBlock block;
+        block.encoded = compression_pool_->submit([compression, raw, dict]() mutable { 
+            EncodedBlock encoded;
+            encodeBlock(compression, raw, *dict, encoded);
+            if (!encoded.compressed) {
+                encoded.contents.swap(raw);
+            }
+            return encoded;
+        });
+        block.last_key = last_key;
+        block.prefixes.swap(prefixes);
+        block.size = contents.size();
+        pending_bytes_ += block.size;
+        pending_blocks_.push_back(std::move(block));
+        // 限制正在压缩的block数, 超过时按顺序写入最早的block
+        while (pending_blocks_.size() > 2 * compression_pool_->getThreadCount()) {
+            writePendingBlock();
+        }
+        return;
+    }
+
+    if (filter_builder_) {
+        for (const std::string& prefix : prefixes) {
+            filter_builder_->addKey(prefix);
+        }
+    }
+    BlockHandle handle;
+    if (cuckoo_builder_) {
+        // 点查直接从文件中解析键值对, data block不压缩
+        writeRawBlock(contents, CompressionType::NO_COMPRESSION, handle);
+        for (const std::pair<std::string, uint64_t>& key : cuckoo_pending_keys_) {
+            cuckoo_builder_->add(key.first, handle.offset + key.second);
+        }
+        cuckoo_pending_keys_.clear();
+    } else {
+        writeBlockContents(contents, compression_dict_, handle);
+    }
+    addDataBlockHandle(handle, last_key);
+}
+
+void SSTableBuilder::writePendingBlock() {
+    PendingBlock& block = pending_blocks_.front();
+    const EncodedBlock encoded = block.encoded.get();
+    if (filter_builder_) {
+        for (const std::string& prefix : block.prefixes) {
+            filter_builder_->addKey(prefix);
+        }
+    }
+    BlockHandle handle;
+    writeEncodedBlock(encoded.contents, encoded.trailer, handle);
+    addDataBlockHandle(handle, block.last_key);
+    pending_bytes_ -= block.size;
+    pending_blocks_.pop_front();
+}
+
+void SSTableBuilder::addDataBlockHandle(const BlockHandle& handle, const std::string& last_key) {
+    std::string encoded_handle;
+    handle.encodeTo(encoded_handle);
+    index_builder_.add(last_key, encoded_handle);
+    if (learned_index_builder_) {
+        learned_index_builder_->addBlock(extractUserKey(last_key));
+    }
+    if (filter_builder_) {
+        filter_builder_->startBlock(offset_);
+    }
+    if (partition_index_ && index_builder_.getBlockSize() >= index_partition_size_) {
+        flushIndexPartition(last_key);
+    }
+}
+
+void SSTableBuilder::flushIndexPartition(const std::string& last_key) {
+    BlockHandle handle;
+    writeBlock(index_builder_, handle);
+    std::string encoded_handle;
+    handle.encodeTo(encoded_handle);
+    top_index_builder_.add(last_key, encoded_handle);
+    ++index_partition_count_;
+    if (filter_builder_) {
+        BlockHandle filter_handle;
+        writeBlockContents(filter_builder_->finish(), std::string(), filter_handle);
+        std::string encoded_filter;
+        filter_handle.encodeTo(encoded_filter);
+        encoded_filter.append(codec::encodeVar64(filter_base_));
+        filter_index_builder_.add(last_key, encoded_filter);
+        // 下一个分区从下一个data block开始
+        filter_base_ = offset_;
+        filter_builder_.reset(new FilterBlockBuilder(filter_bits_per_key_, filter_base_));
+        filter_builder_->startBlock(offset_);
+    }
+}
+
+void SSTableBuilder::trainDictionary() {
+    std::vector<std::string> samples;
+    samples.reserve(buffered_blocks_.size());
+    for (const BufferedBlock& block : buffered_blocks_) {
+        samples.push_back(block.contents);
+    }
+    compression_dict_ = lz::trainDictionary(samples, static_cast<size_t>(dict_bytes_));
+    buffering_ = false;
+    for (BufferedBlock& block : buffered_blocks_) {
+        writeDataBlock(block.contents, block.last_key, std::move(block.prefixes));
+    }
+    buffered_blocks_.clear();
+    buffered_bytes_ = 0;
+}
+
+void SSTableBuilder::addRangeFilterKey(const std::string* user_key) {
+    if (user_key && has_pending_user_key_ && *user_key == pending_user_key_) {
+        // 同一个用户键的其他版本
+        return;
+    }
+    size_t shared = 0;
+    if (user_key) {
+        const size_t min_size = std::min(user_key->size(), pending_user_key_.size());
+        while (shared < min_size && (*user_key)[shared] == pending_user_key_[shared]) {
+            ++shared;
+        }
+    }
+    if (has_pending_user_key_) {
+        // 比与前后两个用户键的公共前缀多一个字节, 足以区分相邻的键
+        const size_t length = std::min(pending_user_key_.size(), std::max(pending_shared_, shared) + 1);
+        range_filter_builder_.add(pending_user_key_.substr(0, length), std::string());
+    }
+    if (user_key) {
+        pending_user_key_ = *user_key;
+        pending_shared_ = shared;
+        has_pending_user_key_ = true;
+    } else {
+        has_pending_user_key_ = false;
+    }
+}
+
+void SSTableBuilder::writeMetaBlock(const std::string& name, const std::string& contents, 
+                                    BlockBuilder& metaindex_builder) {
+    BlockHandle handle;
+    writeBlockContents(contents, std::string(), handle);
+    std::string encoded_handle;
+    handle.encodeTo(encoded_handle);
+    metaindex_builder.add(name, encoded_handle);
+}
+
+void SSTableBuilder::writeBlock(BlockBuilder& builder, BlockHandle& handle) {
+    writeBlockContents(builder.finish(), std::string(), handle);
+    builder.reset();
+}
+
+void SSTableBuilder::writeBlockContents(const std::string& contents, const std::string& dict, BlockHandle& handle) {
+    encodeBlock(compression_, contents, dict, encoded_);
+    writeEncodedBlock(encoded_.compressed ? encoded_.contents : contents, encoded_.trailer, handle);
+}
+
+void SSTableBuilder::encodeBlock(CompressionType compression, const std::string& contents, const std::string& dict,
+                                 EncodedBlock& block) {
+    CompressionType type = compressBlock(compression, contents, dict, block.contents);
+    block.compressed = type != CompressionType::NO_COMPRESSION && 
+                       block.contents.size() < contents.size() - contents.size() / 8;
+    if (!block.compressed) {
+        type = CompressionType::NO_COMPRESSION;
+    }
+    const std::string& output = block.compressed ? block.contents : contents;
+    block.trailer.assign(1, static_cast<char>(type));
+    block.trailer.append(codec::encodeFixed32(crc32(crc32(output.data(), output.size()), block.trailer.data(), 1)));
+}
+
+void SSTableBuilder::writeRawBlock(const std::string& contents, CompressionType type, BlockHandle& handle) {
+    std::string trailer(1, static_cast<char>(type));
+    trailer.append(codec::encodeFixed32(crc32(crc32(contents.data(), contents.size()), trailer.data(), 1)));
+    writeEncodedBlock(contents, trailer, handle);
+}
+
+void SSTableBuilder::writeEncodedBlock(const std::string& contents, const std::string& trailer, BlockHandle& handle) {
+    handle.offset = offset_;
+    handle.size = contents.size();
+    if (status_.isSuccess()) {
+        status_ = file_->append(contents);
+    }
+    if (status_.isSuccess()) {
+        status_ = file_->append(trailer);
+    }
+    offset_ += contents.size() + BLOCK_TRAILER_SIZE;
+}
+
+}
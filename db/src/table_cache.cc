@@ -0,0 +1,37 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 18:10:27
+ * @LastEditTime: 2026-10-18 22:47:45
+ */
+#include <tomato_db/table_cache.h>
+#include <tomato_db/filename.h>
+
+namespace tomato {
+
+TableCache::TableCache(std::string db_path, BlockCache* block_cache)
+    : db_path_(std::move(db_path)),
+      block_cache_(block_cache),
+      mutex_(),
+      tables_() {}
+
+OperatorResult TableCache::findTable(uint64_t number, uint64_t file_size, std::shared_ptr<SSTable>& table) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = tables_.find(number);
+    if (it != tables_.end()) {
+        table = it->second;
+        return OperatorResult::success();
+    }
+    OperatorResult status = SSTable::open(createRandomAccessFile(tableFileName(db_path_, number)), file_size, table,
+                                          block_cache_);
+    if (status.isSuccess()) {
+        tables_[number] = table;
+    }
+    return status;
+}
+
+void TableCache::evict(uint64_t number) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tables_.erase(number);
+}
+
+}
@@ -0,0 +1,59 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 16:55:02
+ * @LastEditTime: 2026-10-18 22:47:45
+ */
+#include <tomato_db/table_format.h>
+#include <tomato_common/codec.h>
+
+namespace tomato {
+
+void BlockHandle::encodeTo(std::string& output) const {
+    output.append(codec::encodeVar64(offset));
+    output.append(codec::encodeVar64(size));
+}
+
+bool BlockHandle::decodeFrom(const char*& begin, const char* end) {
+    std::pair<uint64_t, int> res = codec::decodeVar64(begin, end);
+    if (res.second == 0) {
+        return false;
+    }
+    offset = res.first;
+    begin += res.second;
+    res = codec::decodeVar64(begin, end);
+    if (res.second == 0) {
+        return false;
+    }
+    size = res.first;
+    begin += res.second;
+    return true;
+}
+
+bool BlockHandle::decodeFrom(const std::string& input) {
+    const char* begin = input.data();
+    return decodeFrom(begin, input.data() + input.size());
+}
+
+void Footer::encodeTo(std::string& output) const {
+    const size_t origin_size = output.size();
+    metaindex_handle.encodeTo(output);
+    index_handle.encodeTo(output);
+    output.resize(origin_size + 2 * BlockHandle::MAX_ENCODED_LENGTH, '\0');
+    output.append(codec::encodeFixed64(block_trailer ? TABLE_MAGIC_NUMBER : LEGACY_TABLE_MAGIC_NUMBER));
+}
+
+bool Footer::decodeFrom(const std::string& input) {
+    if (input.size() < ENCODED_LENGTH) {
+        return false;
+    }
+    const char* begin = input.data() + input.size() - ENCODED_LENGTH;
+    const char* magic = input.data() + input.size() - 8;
+    const uint64_t magic_number = codec::decodeFixed64(magic);
+    if (magic_number != TABLE_MAGIC_NUMBER && magic_number != LEGACY_TABLE_MAGIC_NUMBER) {
+        return false;
+    }
+    block_trailer = magic_number == TABLE_MAGIC_NUMBER;
+    return metaindex_handle.decodeFrom(begin, magic) && index_handle.decodeFrom(begin, magic);
+}
+
+}
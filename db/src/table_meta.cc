@@ -0,0 +1,84 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 16:48:21
+ * @LastEditTime: 2026-10-18 22:13:35
+ */
+#include <tomato_db/table_meta.h>
+#include <tomato_common/codec.h>
+
+#include <cstring>
+
+namespace tomato {
+
+std::string encodeInternalKey(const std::string& user_key, uint64_t seq, ItemType type) {
+    std::string result;
+    result.reserve(user_key.size() + 8);
+    result.append(user_key);
+    result.append(codec::encodeFixed64((seq << 8) | static_cast<uint64_t>(type)));
+    return result;
+}
+
+std::string encodeLookupKey(const std::string& user_key, uint64_t seq) {
+    // 同一序列号下类型字节取最大值, 使查找键排在该序列号的所有类型之前
+    std::string result;
+    result.reserve(user_key.size() + 8);
+    result.append(user_key);
+    result.append(codec::encodeFixed64((seq << 8) | 0xff));
+    return result;
+}
+
+std::string encodeRangeEndKey(const std::string& user_key) {
+    std::string result;
+    result.reserve(user_key.size() + 8);
+    result.append(user_key);
+    result.append(8, static_cast<char>(0xff));
+    return result;
+}
+
+bool isRangeEndKey(const std::string& internal_key) {
+    return internal_key.size() >= 8 && 
+           codec::decodeFixed64(internal_key.data() + internal_key.size() - 8) == UINT64_MAX;
+}
+
+bool parseInternalKey(const std::string& internal_key, ParsedInternalKey& result) {
+    if (internal_key.size() < 8) {
+        return false;
+    }
+    const size_t user_key_size = internal_key.size() - 8;
+    uint64_t tag = codec::decodeFixed64(internal_key.data() + user_key_size);
+    result.user_key.assign(internal_key.data(), user_key_size);
+    result.seq = tag >> 8;
+    result.type = static_cast<ItemType>(tag & 0xff);
+    return true;
+}
+
+std::string extractUserKey(const std::string& internal_key) {
+    return internal_key.substr(0, internal_key.size() < 8 ? 0 : internal_key.size() - 8);
+}
+
+int compareBytewise(const std::string& a, const std::string& b) {
+    return a.compare(b);
+}
+
+int compareInternalKey(const std::string& a, const std::string& b) {
+    const size_t a_size = a.size() - 8;
+    const size_t b_size = b.size() - 8;
+    int res = ::memcmp(a.data(), b.data(), a_size < b_size ? a_size : b_size);
+    if (res != 0) {
+        return res;
+    }
+    if (a_size != b_size) {
+        return a_size < b_size ? -1 : 1;
+    }
+    // tag大的(序列号大的)排在前面
+    uint64_t a_tag = codec::decodeFixed64(a.data() + a_size);
+    uint64_t b_tag = codec::decodeFixed64(b.data() + b_size);
+    if (a_tag > b_tag) {
+        return -1;
+    } else if (a_tag < b_tag) {
+        return 1;
+    }
+    return 0;
+}
+
+}
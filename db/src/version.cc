@@ -0,0 +1,485 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 18:16:40
+ * @LastEditTime: 2026-10-19 00:43:08
+ */
+#include <tomato_db/version.h>
+#include <tomato_db/filename.h>
+#include <tomato_db/log_reader.h>
+#include <tomato_db/log_writer.h>
+#include <tomato_db/table_meta.h>
+#include <tomato_common/codec.h>
+
+#include <algorithm>
+#include <cerrno>
+
+namespace tomato {
+
+bool fileBeforeKey(const FileMeta& file, const std::string& user_key) {
+    const std::string largest = extractUserKey(file.largest);
+    return largest < user_key || (largest == user_key && isRangeEndKey(file.largest));
+}
+
+void extendFileRange(FileMeta& file, const std::string& internal_key, uint64_t seq) {
+    if (file.smallest.empty()) {
+        file.smallest = internal_key;
+        file.largest = internal_key;
+        file.smallest_seq = seq;
+        file.largest_seq = seq;
+        return;
+    }
+    if (compareInternalKey(internal_key, file.smallest) < 0) {
+        file.smallest = internal_key;
+    }
+    if (compareInternalKey(internal_key, file.largest) > 0) {
+        file.largest = internal_key;
+    }
+    file.smallest_seq = std::min(file.smallest_seq, seq);
+    file.largest_seq = std::max(file.largest_seq, seq);
+}
+
+bool fileContainsKey(const FileMeta& file, const std::string& user_key) {
+    return !fileBeforeKey(file, user_key) && extractUserKey(file.smallest) <= user_key;
+}
+
+bool fileOverlapsRange(const FileMeta& file, const std::string& begin, const std::string& end) {
+    if (fileBeforeKey(file, begin)) {
+        return false;
+    }
+    return end.empty() || extractUserKey(file.smallest) <= end;
+}
+
+void Version::getOverlappingFiles(const std::string& user_key, std::vector<const FileMeta*>& files) const {
+    files.clear();
+    for (const FileMeta& file : files_[0]) {
+        if (fileContainsKey(file, user_key)) {
+            files.push_back(&file);
+        }
+    }
+    for (int level = 1; level < NUM_LEVELS; ++level) {
+        const std::vector<FileMeta>& level_files = files_[level];
+        // 第一个没有完全位于user_key之前的文件
+        auto it = std::lower_bound(level_files.begin(), level_files.end(), user_key, 
+            [](const FileMeta& file, const std::string& key) {
+                return fileBeforeKey(file, key);
+            });
+        if (it != level_files.end() && fileContainsKey(*it, user_key)) {
+            files.push_back(&*it);
+        }
+    }
+}
+
+void Version::getOverlappingInputs(int level, const std::string& begin, const std::string& end, 
+                                   std::vector<FileMeta>& files) const {
+    files.clear();
+    std::string range_begin = begin;
+    std::string range_end = end;
+    for (size_t i = 0; i < files_[level].size(); ++i) {
+        const FileMeta& file = files_[level][i];
+        if (!fileOverlapsRange(file, range_begin, range_end)) {
+            continue;
+        }
+        files.push_back(file);
+        if (level != 0) {
+            continue;
+        }
+        // 第0层的文件互相重叠, 范围扩大后需要重新检查所有文件
+        const std::string smallest = extractUserKey(file.smallest);
+        const std::string largest = extractUserKey(file.largest);
+        bool expanded = false;
+        if (smallest < range_begin) {
+            range_begin = smallest;
+            expanded = true;
+        }
+        if (!range_end.empty() && largest > range_end) {
+            range_end = largest;
+            expanded = true;
+        }
+        if (expanded) {
+            files.clear();
+            i = static_cast<size_t>(-1);
+        }
+    }
+}
+
+uint64_t Version::getLevelBytes(int level) const {
+    uint64_t bytes = 0;
+    for (const FileMeta& file : files_[level]) {
+        bytes += file.file_size;
+    }
+    return bytes;
+}
+
+uint64_t Version::estimateCompactionDebt(int l0_trigger, uint64_t level_base_bytes) const {
+    uint64_t debt = 0;
+    // 合并进下一层的字节数, 会使下一层超出得更多
+    uint64_t carried = 0;
+    if (l0_trigger > 0 && files_[0].size() >= static_cast<size_t>(l0_trigger)) {
+        carried = getLevelBytes(0);
+        debt += carried + getLevelBytes(1);
+    }
+    uint64_t level_limit = level_base_bytes;
+    for (int level = 1; level + 1 < NUM_LEVELS; ++level) {
+        const uint64_t level_bytes = getLevelBytes(level) + carried;
+        carried = 0;
+        if (level_bytes > level_limit) {
+            carried = level_bytes - level_limit;
+            debt += carried * 11;
+        }
+        level_limit *= 10;
+    }
+    return debt;
+}
+
+const BlobFileMeta* Version::getBlobFile(uint64_t number) const {
+    auto it = std::lower_bound(blob_files_.begin(), blob_files_.end(), number, 
+        [](const BlobFileMeta& file, uint64_t target) {
+            return file.number < target;
+        });
+    return it != blob_files_.end() && it->number == number ? &*it : nullptr;
+}
+
+VersionSet::VersionSet(std::string db_path)
+    : db_path_(std::move(db_path)),
+      apply_mutex_(),
+      mutex_(),
+      current_(std::make_shared<Version>()),
+      next_file_number_(1),
+      log_number_(0),
+      last_sequence_(0) {}
+
+OperatorResult VersionSet::recover() {
+    std::shared_ptr<SequentialFile> file = createSequentialFile(manifestFileName(db_path_));
+    if (!file->isOpen()) {
+        // 新数据库
+        return OperatorResult::success();
+    }
+    log::LogReader reader(file.get());
+    std::string record;
+    if (!reader.readRecord(record)) {
+        return {EINVAL, "read manifest error, filename: " + file->getFileName()};
+    }
+    std::shared_ptr<Version> version = std::make_shared<Version>();
+    if (!decodeManifest(record, *version)) {
+        return {EINVAL, "bad manifest, filename: " + file->getFileName()};
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    current_ = version;
+    versions_.push_back(version);
+    return OperatorResult::success();
+}
+
+OperatorResult VersionSet::logAndApply(const VersionEdit& edit) {
+    std::lock_guard<std::mutex> apply_lock(apply_mutex_);
+    std::shared_ptr<Version> version = std::make_shared<Version>(*current());
+    for (const std::pair<int, uint64_t>& deleted : edit.deleted_files) {
+        std::vector<FileMeta>& files = version->files_[deleted.first];
+        files.erase(std::remove_if(files.begin(), files.end(), [&deleted](const FileMeta& file) {
+            return file.number == deleted.second;
+        }), files.end());
+    }
+    for (const std::pair<int, FileMeta>& added : edit.new_files) {
+        version->files_[added.first].push_back(added.second);
+    }
+    std::sort(version->files_[0].begin(), version->files_[0].end(), [](const FileMeta& a, const FileMeta& b) {
+        return a.number > b.number;
+    });
+    for (int level = 1; level < NUM_LEVELS; ++level) {
+        std::sort(version->files_[level].begin(), version->files_[level].end(), 
+            [](const FileMeta& a, const FileMeta& b) {
+                return compareInternalKey(a.smallest, b.smallest) < 0;
+            });
+    }
+
+    // 值全部成为垃圾的blob文件不会再被读到
+    std::vector<BlobFileMeta>& blob_files = version->blob_files_;
+    blob_files.insert(blob_files.end(), edit.new_blob_files.begin(), edit.new_blob_files.end());
+    std::sort(blob_files.begin(), blob_files.end(), [](const BlobFileMeta& a, const BlobFileMeta& b) {
+        return a.number < b.number;
+    });
+    for (const std::pair<uint64_t, uint64_t>& garbage : edit.blob_garbage) {
+        auto it = std::lower_bound(blob_files.begin(), blob_files.end(), garbage.first, 
+            [](const BlobFileMeta& file, uint64_t target) {
+                return file.number < target;
+            });
+        if (it != blob_files.end() && it->number == garbage.first) {
+            it->garbage_bytes += garbage.second;
+        }
+    }
+    blob_files.erase(std::remove_if(blob_files.begin(), blob_files.end(), [](const BlobFileMeta& file) {
+        return file.garbage_bytes >= file.total_bytes;
+    }), blob_files.end());
+
+    uint64_t log_number = edit.has_log_number ? edit.log_number : getLogNumber();
+    uint64_t last_sequence = edit.has_last_sequence ? edit.last_sequence : getLastSequence();
+    OperatorResult status = writeManifest(encodeManifest(*version, log_number, next_file_number_.load(), last_sequence));
+    if (!status.isSuccess()) {
+        return status;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    current_ = version;
+    versions_.push_back(version);
+    log_number_ = log_number;
+    last_sequence_ = last_sequence;
+    return OperatorResult::success();
+}
+
+std::unique_ptr<Compaction> VersionSet::pickCompaction(int l0_trigger, uint64_t level_base_bytes) {
+    std::shared_ptr<const Version> version = current();
+
+    // 选出超出上限最多的一层, 最后一层不再向下合并
+    int best_level = -1;
+    double best_score = 1;
+    double level_limit = static_cast<double>(level_base_bytes);
+    for (int level = 0; level + 1 < NUM_LEVELS; ++level) {
+        double score = 0;
+        if (level == 0) {
+            score = static_cast<double>(version->getFiles(0).size()) / l0_trigger;
+        } else {
+            score = static_cast<double>(version->getLevelBytes(level)) / level_limit;
+            level_limit *= 10;
+        }
+        if (score >= best_score) {
+            best_score = score;
+            best_level = level;
+        }
+    }
+    if (best_level < 0) {
+        return std::unique_ptr<Compaction>();
+    }
+
+    std::unique_ptr<Compaction> compaction(new Compaction());
+    compaction->level = best_level;
+    const std::vector<FileMeta>& files = version->getFiles(best_level);
+    if (best_level == 0) {
+        // 第0层的文件互相重叠, 全部参与合并
+        compaction->inputs[0] = files;
+    } else {
+        const FileMeta* picked = &files.front();
+        for (const FileMeta& file : files) {
+            if (compact_pointer_[best_level].empty() || 
+                    compareInternalKey(file.largest, compact_pointer_[best_level]) > 0) {
+                picked = &file;
+                break;
+            }
+        }
+        compaction->inputs[0].push_back(*picked);
+        compact_pointer_[best_level] = picked->largest;
+    }
+    setupOtherInputs(*version, *compaction);
+    return compaction;
+}
+
+std::unique_ptr<Compaction> VersionSet::compactRange(int level, const std::string& begin, const std::string& end) {
+    std::shared_ptr<const Version> version = current();
+    std::unique_ptr<Compaction> compaction(new Compaction());
+    compaction->level = level;
+    compaction->manual = true;
+    version->getOverlappingInputs(level, begin, end, compaction->inputs[0]);
+    if (compaction->inputs[0].empty()) {
+        return std::unique_ptr<Compaction>();
+    }
+    setupOtherInputs(*version, *compaction);
+    return compaction;
+}
+
+void VersionSet::setupOtherInputs(const Version& version, Compaction& compaction) {
+    std::string begin = extractUserKey(compaction.inputs[0].front().smallest);
+    std::string end = extractUserKey(compaction.inputs[0].front().largest);
+    for (const FileMeta& file : compaction.inputs[0]) {
+        begin = std::min(begin, extractUserKey(file.smallest));
+        end = std::max(end, extractUserKey(file.largest));
+    }
+    version.getOverlappingInputs(compaction.level + 1, begin, end, compaction.inputs[1]);
+}
+
+void VersionSet::getLiveFiles(std::vector<uint64_t>& numbers) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::weak_ptr<const Version>> alive;
+    for (const std::weak_ptr<const Version>& weak_version : versions_) {
+        std::shared_ptr<const Version> version = weak_version.lock();
+        if (!version) {
+            continue;
+        }
+        alive.push_back(version);
+        for (int level = 0; level < NUM_LEVELS; ++level) {
+            for (const FileMeta& file : version->getFiles(level)) {
+                numbers.push_back(file.number);
+            }
+        }
+        for (const BlobFileMeta& file : version->getBlobFiles()) {
+            numbers.push_back(file.number);
+        }
+    }
+    versions_.swap(alive);
+}
+
+std::shared_ptr<const Version> VersionSet::current() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return current_;
+}
+
+std::shared_ptr<const Version> VersionSet::current(uint64_t& log_number) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    log_number = log_number_;
+    return current_;
+}
+
+void VersionSet::markFileNumberUsed(uint64_t number) {
+    uint64_t next = next_file_number_.load();
+    while (next <= number && !next_file_number_.compare_exchange_weak(next, number + 1)) {
+    }
+}
+
+uint64_t VersionSet::getLogNumber() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return log_number_;
+}
+
+uint64_t VersionSet::getLastSequence() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return last_sequence_;
+}
+
+/**
+ * @brief 追加变长长度 + 字符串
+ * 
+ */
+static void appendLengthPrefixed(const std::string& value, std::string& output) {
+    output.append(codec::encodeVar64(value.size()));
+    output.append(value);
+}
+
+/**
+ * @brief 解码变长整数, 成功后begin向后移动
+ * 
+ */
+static bool consumeVar64(const char*& begin, const char* end, uint64_t& value) {
+    std::pair<uint64_t, int> res = codec::decodeVar64(begin, end);
+    if (res.second == 0) {
+        return false;
+    }
+    value = res.first;
+    begin += res.second;
+    return true;
+}
+
+/**
+ * @brief 解码变长长度 + 字符串, 成功后begin向后移动
+ * 
+ */
+static bool consumeLengthPrefixed(const char*& begin, const char* end, std::string& value) {
+    uint64_t size = 0;
+    if (!consumeVar64(begin, end, size) || static_cast<uint64_t>(end - begin) < size) {
+        return false;
+    }
+    value.assign(begin, size);
+    begin += size;
+    return true;
+}
+
+std::string VersionSet::encodeManifest(const Version& version, uint64_t log_number,
+                                       uint64_t next_file_number, uint64_t last_sequence) const {
+    // 日志编号 + 下一个文件编号 + 最大序列号 + 每层[文件数 + 文件(编号, 大小, 最小键, 最大键, 最小序列号, 最大序列号)] +
+    // blob文件数 + blob文件(编号, 总字节数, 垃圾字节数), 均为变长编码
+    std::string record;
+    record.append(codec::encodeVar64(log_number));
+    record.append(codec::encodeVar64(next_file_number));
+    record.append(codec::encodeVar64(last_sequence));
+    for (int level = 0; level < NUM_LEVELS; ++level) {
+        record.append(codec::encodeVar64(version.files_[level].size()));
+        for (const FileMeta& file : version.files_[level]) {
+            record.append(codec::encodeVar64(file.number));
+            record.append(codec::encodeVar64(file.file_size));
+            appendLengthPrefixed(file.smallest, record);
+            appendLengthPrefixed(file.largest, record);
+            record.append(codec::encodeVar64(file.smallest_seq));
+            record.append(codec::encodeVar64(file.largest_seq));
+        }
+    }
+    record.append(codec::encodeVar64(version.blob_files_.size()));
+    for (const BlobFileMeta& file : version.blob_files_) {
+        record.append(codec::encodeVar64(file.number));
+        record.append(codec::encodeVar64(file.total_bytes));
+        record.append(codec::encodeVar64(file.garbage_bytes));
+    }
+    return record;
+}
+
+bool VersionSet::decodeManifest(const std::string& record, Version& version) {
+    const char* begin = record.data();
+    const char* end = record.data() + record.size();
+    uint64_t next_file_number = 0;
+    if (!consumeVar64(begin, end, log_number_) || 
+        !consumeVar64(begin, end, next_file_number) ||
+        !consumeVar64(begin, end, last_sequence_)) {
+        return false;
+    }
+    next_file_number_.store(next_file_number);
+    for (int level = 0; level < NUM_LEVELS; ++level) {
+        uint64_t count = 0;
+        if (!consumeVar64(begin, end, count)) {
+            return false;
+        }
+        for (uint64_t i = 0; i < count; ++i) {
+            FileMeta file;
+            if (!consumeVar64(begin, end, file.number) ||
+                !consumeVar64(begin, end, file.file_size) ||
+                !consumeLengthPrefixed(begin, end, file.smallest) ||
+                !consumeLengthPrefixed(begin, end, file.largest) ||
+                !consumeVar64(begin, end, file.smallest_seq) ||
+                !consumeVar64(begin, end, file.largest_seq)) {
+                return false;
+            }
+            version.files_[level].push_back(std::move(file));
+        }
+    }
+    if (begin == end) {
+        // 没有blob文件列表的旧格式
+        return true;
+    }
+    uint64_t blob_count = 0;
+    if (!consumeVar64(begin, end, blob_count)) {
+        return false;
+    }
+    for (uint64_t i = 0; i < blob_count; ++i) {
+        BlobFileMeta file;
+        if (!consumeVar64(begin, end, file.number) ||
+            !consumeVar64(begin, end, file.total_bytes) ||
+            !consumeVar64(begin, end, file.garbage_bytes)) {
+            return false;
+        }
+        version.blob_files_.push_back(file);
+    }
+    return begin == end;
+}
+
+OperatorResult VersionSet::writeManifest(const std::string& record) {
+    const std::string manifest = manifestFileName(db_path_);
+    const std::string temp = tempFileName(manifest);
+    std::shared_ptr<AppendOnlyFile> file = createAppendOnlyFile(temp);
+    if (!file->isOpen()) {
+        return {errno, "create manifest error, filename: " + temp};
+    }
+    log::LogWriter writer(file.get());
+    OperatorResult status = writer.addRecord(record);
+    if (status.isSuccess()) {
+        status = writer.sync();
+    }
+    if (status.isSuccess()) {
+        status = file->close();
+    }
+    if (!status.isSuccess()) {
+        removeFile(temp);
+        return status;
+    }
+    status = renameFile(temp, manifest);
+    if (!status.isSuccess()) {
+        return status;
+    }
+    // 重命名与之前写出的SSTable、blob文件的目录项一起落盘, 之后才能删除新清单不再引用的日志
+    return syncDir(db_path_);
+}
+
+}
@@ -0,0 +1,248 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 13:02:18
+ * @LastEditTime: 2026-10-18 22:20:54
+ */
+#include <tomato_db/write_batch.h>
+#include <tomato_db/memory_table.h>
+#include <tomato_common/codec.h>
+
+#include <cerrno>
+#include <vector>
+
+namespace tomato {
+
+namespace {
+
+/**
+ * @brief 逐条写入内存表
+ * 
+ */
+class MemoryTableInserter : public WriteBatch::Handler {
+public:
+    MemoryTableInserter(MemoryTable* table, uint64_t seq, bool concurrent)
+        : table_(table), seq_(seq), concurrent_(concurrent) {}
+
+    void put(const std::string& key, const std::string& value) override {
+        add(ItemType::VALUE, key, value);
+    }
+
+    void del(const std::string& key) override {
+        add(ItemType::DELETION, key, "");
+    }
+
+    void deleteRange(const std::string& begin, const std::string& end) override {
+        add(ItemType::RANGE_DELETION, begin, end);
+    }
+
+    void merge(const std::string& key, const std::string& operand) override {
+        add(ItemType::MERGE, key, operand);
+    }
+private:
+    void add(ItemType type, const std::string& key, const std::string& value) {
+        if (concurrent_) {
+            table_->addConcurrently(seq_++, type, key, value);
+        } else {
+            table_->add(seq_++, type, key, value);
+        }
+    }
+private:
+    MemoryTable* table_;
+    uint64_t seq_;
+    bool concurrent_;
+};
+
+/**
+ * @brief 收集所有操作并判断是否已经按内存表的顺序排好
+ * 
+ */
+class SortedRunCollector : public WriteBatch::Handler {
+public:
+    explicit SortedRunCollector(uint64_t seq): seq_(seq), sorted_(true) {}
+
+    void put(const std::string& key, const std::string& value) override {
+        add(ItemType::VALUE, key, value);
+    }
+
+    void del(const std::string& key) override {
+        add(ItemType::DELETION, key, "");
+    }
+
+    void deleteRange(const std::string& begin, const std::string& end) override {
+        // 范围删除不进入点数据的跳表, 不能走有序批量插入
+        sorted_ = false;
+        add(ItemType::RANGE_DELETION, begin, end);
+    }
+
+    void merge(const std::string& key, const std::string& operand) override {
+        add(ItemType::MERGE, key, operand);
+    }
+
+    bool isSorted() const {
+        return sorted_;
+    }
+
+    const std::vector<MemoryTable::Entry>& getEntries() const {
+        return entries_;
+    }
+private:
+    void add(ItemType type, const std::string& key, const std::string& value) {
+        // 同一个键的后续版本序列号更大, 在内存表中排在前面, 因此只有严格递增的键才算有序
+        if (!entries_.empty() && entries_.back().key >= key) {
+            sorted_ = false;
+        }
+        entries_.push_back(MemoryTable::Entry{seq_++, type, key, value});
+    }
+private:
+    uint64_t seq_;
+    bool sorted_;
+    std::vector<MemoryTable::Entry> entries_;
+};
+
+}
+
+WriteBatch::WriteBatch() {
+    clear();
+}
+
+void WriteBatch::put(const std::string& key, const std::string& value) {
+    setCount(getCount() + 1);
+    rep_.push_back(static_cast<char>(ItemType::VALUE));
+    rep_.append(codec::encodeVar64(key.size()));
+    rep_.append(key);
+    rep_.append(codec::encodeVar64(value.size()));
+    rep_.append(value);
+}
+
+void WriteBatch::del(const std::string& key) {
+    setCount(getCount() + 1);
+    rep_.push_back(static_cast<char>(ItemType::DELETION));
+    rep_.append(codec::encodeVar64(key.size()));
+    rep_.append(key);
+}
+
+void WriteBatch::deleteRange(const std::string& begin, const std::string& end) {
+    setCount(getCount() + 1);
+    rep_.push_back(static_cast<char>(ItemType::RANGE_DELETION));
+    rep_.append(codec::encodeVar64(begin.size()));
+    rep_.append(begin);
+    rep_.append(codec::encodeVar64(end.size()));
+    rep_.append(end);
+}
+
+void WriteBatch::merge(const std::string& key, const std::string& operand) {
+    setCount(getCount() + 1);
+    rep_.push_back(static_cast<char>(ItemType::MERGE));
+    rep_.append(codec::encodeVar64(key.size()));
+    rep_.append(key);
+    rep_.append(codec::encodeVar64(operand.size()));
+    rep_.append(operand);
+}
+
+void WriteBatch::clear() {
+    rep_.assign(HEADER_SIZE, '\0');
+}
+
+void WriteBatch::append(const WriteBatch& other) {
+    setCount(getCount() + other.getCount());
+    rep_.append(other.rep_, HEADER_SIZE, std::string::npos);
+}
+
+uint32_t WriteBatch::getCount() const {
+    return codec::decodeFixed32(rep_.data() + 8);
+}
+
+uint64_t WriteBatch::getSequence() const {
+    return codec::decodeFixed64(rep_.data());
+}
+
+void WriteBatch::setSequence(uint64_t seq) {
+    rep_.replace(0, 8, codec::encodeFixed64(seq));
+}
+
+void WriteBatch::setCount(uint32_t count) {
+    rep_.replace(8, 4, codec::encodeFixed32(count));
+}
+
+OperatorResult WriteBatch::setContent(const std::string& content) {
+    if (content.size() < HEADER_SIZE) {
+        return {EINVAL, "write batch too small"};
+    }
+    rep_ = content;
+    return OperatorResult::success();
+}
+
+OperatorResult WriteBatch::iterate(Handler* handler) const {
+    const char* ptr = rep_.data() + HEADER_SIZE;
+    const char* end = rep_.data() + rep_.size();
+    std::string key;
+    std::string value;
+    uint32_t found = 0;
+
+    // 解码一个长度前缀的字符串
+    auto decodeString = [&ptr, end](std::string& output) {
+        std::pair<uint64_t, int> len = codec::decodeVar64(ptr, end);
+        if (len.second == 0 || len.first > static_cast<uint64_t>(end - ptr - len.second)) {
+            return false;
+        }
+        ptr += len.second;
+        output.assign(ptr, static_cast<size_t>(len.first));
+        ptr += len.first;
+        return true;
+    };
+
+    while (ptr < end) {
+        const char type = *ptr++;
+        if (!decodeString(key)) {
+            return {EINVAL, "bad write batch key"};
+        }
+        if (type == static_cast<char>(ItemType::VALUE)) {
+            if (!decodeString(value)) {
+                return {EINVAL, "bad write batch value"};
+            }
+            handler->put(key, value);
+        } else if (type == static_cast<char>(ItemType::DELETION)) {
+            handler->del(key);
+        } else if (type == static_cast<char>(ItemType::RANGE_DELETION)) {
+            if (!decodeString(value)) {
+                return {EINVAL, "bad write batch range end"};
+            }
+            handler->deleteRange(key, value);
+        } else if (type == static_cast<char>(ItemType::MERGE)) {
+            if (!decodeString(value)) {
+                return {EINVAL, "bad write batch merge operand"};
+            }
+            handler->merge(key, value);
+        } else {
+            return {EINVAL, "unknown write batch type"};
+        }
+        ++found;
+    }
+    if (found != getCount()) {
+        return {EINVAL, "write batch has wrong count"};
+    }
+    return OperatorResult::success();
+}
+
+OperatorResult WriteBatch::insertInto(MemoryTable* table, bool concurrent, uint32_t sorted_run_threshold) const {
+    // 大批量的有序数据(如批量导入)走有序插入, 不需要每条都从跳表头部查找
+    if (concurrent && getCount() >= sorted_run_threshold) {
+        SortedRunCollector collector(getSequence());
+        OperatorResult status = iterate(&collector);
+        if (!status.isSuccess()) {
+            return status;
+        }
+        if (collector.isSorted()) {
+            table->addSortedRunConcurrently(collector.getEntries());
+        } else {
+            for (const MemoryTable::Entry& entry : collector.getEntries()) {
+                table->addConcurrently(entry.seq, entry.type, entry.key, entry.value);
+            }
+        }
+        return OperatorResult::success();
+    }
+    MemoryTableInserter inserter(table, getSequence(), concurrent);
+    return iterate(&inserter);
+}
+
+}
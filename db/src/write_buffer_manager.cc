@@ -0,0 +1,145 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 23:48:43
+ * @LastEditTime: 2026-10-19 00:44:39
+ */
+#include <tomato_db/write_buffer_manager.h>
+
+#include <vector>
+
+namespace tomato {
+
+const size_t WriteBufferManager::CACHE_RESERVE_UNIT = 1 << 20;
+
+WriteBufferManager::WriteBufferManager(size_t buffer_size, std::shared_ptr<BlockCache> block_cache)
+    : buffer_size_(buffer_size),
+      memory_used_(0),
+      memory_active_(0),
+      block_cache_(std::move(block_cache)),
+      cache_mutex_(),
+      cache_reserved_(0),
+      owners_mutex_(),
+      owners_cv_(),
+      owners_(),
+      flushing_(false),
+      next_owner_id_(1) {}
+
+WriteBufferManager::~WriteBufferManager() {
+    if (block_cache_ && cache_reserved_.load() > 0) {
+        block_cache_->release(cache_reserved_.load());
+    }
+}
+
+void WriteBufferManager::reserveMemory(size_t bytes) {
+    memory_used_.fetch_add(bytes, std::memory_order_relaxed);
+    memory_active_.fetch_add(bytes, std::memory_order_relaxed);
+    if (block_cache_) {
+        updateCacheReservation();
+    }
+}
+
+void WriteBufferManager::scheduleFreeMemory(size_t bytes) {
+    memory_active_.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void WriteBufferManager::freeMemory(size_t bytes) {
+    memory_used_.fetch_sub(bytes, std::memory_order_relaxed);
+    if (block_cache_) {
+        updateCacheReservation();
+    }
+}
+
+void WriteBufferManager::updateCacheReservation() {
+    // 大多数调用不跨过预留的边界, 不加锁直接返回
+    const size_t used = memory_used_.load(std::memory_order_relaxed);
+    const size_t reserved = cache_reserved_.load(std::memory_order_relaxed);
+    if (used <= reserved && used + CACHE_RESERVE_UNIT > reserved) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(cache_mutex_);
+    const size_t target = (memory_used_.load(std::memory_order_relaxed) + CACHE_RESERVE_UNIT - 1) /
+                          CACHE_RESERVE_UNIT * CACHE_RESERVE_UNIT;
+    const size_t current = cache_reserved_.load(std::memory_order_relaxed);
+    if (target > current) {
+        block_cache_->reserve(target - current);
+    } else if (target < current) {
+        block_cache_->release(current - target);
+    }
+    cache_reserved_.store(target, std::memory_order_relaxed);
+}
+
+bool WriteBufferManager::shouldFlush() const {
+    if (buffer_size_ == 0) {
+        return false;
+    }
+    const size_t active = getActiveMemoryUsage();
+    if (active > buffer_size_ - buffer_size_ / 8) {
+        return true;
+    }
+    return getMemoryUsage() >= buffer_size_ && active >= buffer_size_ / 2;
+}
+
+void WriteBufferManager::flushLargest() {
+    std::vector<std::shared_ptr<Owner>> owners;
+    {
+        std::lock_guard<std::mutex> lock(owners_mutex_);
+        // 已经有写入在请求刷写时直接返回, 不等待它; 其他写入可能已经触发了刷写
+        if (flushing_ || !shouldFlush()) {
+            return;
+        }
+        flushing_ = true;
+        for (const auto& entry : owners_) {
+            ++entry.second->in_flight;
+            owners.push_back(entry.second);
+        }
+    }
+
+    // 回调会获取数据库的锁, 刷写请求还可能等待刷写完成, 都在锁外调用
+    std::shared_ptr<Owner> largest;
+    size_t largest_usage = 0;
+    for (const std::shared_ptr<Owner>& owner : owners) {
+        const size_t usage = owner->active_usage();
+        if (usage > largest_usage) {
+            largest = owner;
+            largest_usage = usage;
+        }
+    }
+    if (largest) {
+        largest->flush();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(owners_mutex_);
+        flushing_ = false;
+        for (const std::shared_ptr<Owner>& owner : owners) {
+            --owner->in_flight;
+        }
+    }
+    owners_cv_.notify_all();
+}
+
+uint64_t WriteBufferManager::addOwner(ActiveUsageFunction active_usage, FlushFunction flush) {
+    std::lock_guard<std::mutex> lock(owners_mutex_);
+    const uint64_t id = next_owner_id_++;
+    std::shared_ptr<Owner> owner = std::make_shared<Owner>();
+    owner->active_usage = std::move(active_usage);
+    owner->flush = std::move(flush);
+    owners_[id] = owner;
+    return id;
+}
+
+void WriteBufferManager::removeOwner(uint64_t id) {
+    std::unique_lock<std::mutex> lock(owners_mutex_);
+    auto it = owners_.find(id);
+    if (it == owners_.end()) {
+        return;
+    }
+    std::shared_ptr<Owner> owner = it->second;
+    owners_.erase(it);
+    // 注销后回调可能仍在锁外执行, 等它们返回后数据库才能析构
+    owners_cv_.wait(lock, [&owner] {
+        return owner->in_flight == 0;
+    });
+}
+
+}
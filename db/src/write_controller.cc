@@ -0,0 +1,99 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 23:58:05
+ * @LastEditTime: 2026-10-18 23:58:05
+ */
+#include <tomato_db/write_controller.h>
+
+#include <algorithm>
+#include <chrono>
+
+namespace tomato {
+
+const uint64_t WriteController::MIN_DELAYED_WRITE_RATE = 16 << 10;
+const uint64_t WriteController::MAX_BURST_MICROS = 1000;
+
+WriteController::WriteController(uint64_t max_delayed_write_rate)
+    : max_delayed_write_rate_(std::max(max_delayed_write_rate, MIN_DELAYED_WRITE_RATE)),
+      condition_(WriteStallCondition::NORMAL),
+      mutex_(),
+      resume_cv_(),
+      delayed_write_rate_(max_delayed_write_rate_),
+      available_bytes_(0),
+      last_refill_micros_(0),
+      stats_() {}
+
+uint64_t WriteController::nowMicros() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void WriteController::setCondition(WriteStallCondition condition, double pressure) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (condition == WriteStallCondition::DELAYED) {
+        pressure = std::min(std::max(pressure, 0.0), 1.0);
+        const double rate = static_cast<double>(max_delayed_write_rate_) * (1 - pressure);
+        delayed_write_rate_ = std::max(static_cast<uint64_t>(rate), MIN_DELAYED_WRITE_RATE);
+        if (condition_.load(std::memory_order_relaxed) != WriteStallCondition::DELAYED) {
+            // 刚开始限速时令牌桶为空, 之前没有限速的写入不能换成令牌
+            available_bytes_ = 0;
+            last_refill_micros_ = nowMicros();
+        }
+    }
+    condition_.store(condition, std::memory_order_release);
+    if (condition != WriteStallCondition::STOPPED) {
+        resume_cv_.notify_all();
+    }
+}
+
+uint64_t WriteController::getDelay(size_t bytes) {
+    if (getCondition() != WriteStallCondition::DELAYED) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (condition_.load(std::memory_order_relaxed) != WriteStallCondition::DELAYED) {
+        return 0;
+    }
+    const uint64_t now = nowMicros();
+    if (now > last_refill_micros_) {
+        const uint64_t refill = delayed_write_rate_ * (now - last_refill_micros_) / 1000000;
+        const uint64_t burst = delayed_write_rate_ * MAX_BURST_MICROS / 1000000;
+        available_bytes_ = std::min(available_bytes_ + static_cast<int64_t>(refill), static_cast<int64_t>(burst));
+        last_refill_micros_ = now;
+    }
+    available_bytes_ -= static_cast<int64_t>(bytes);
+    if (available_bytes_ >= 0) {
+        return 0;
+    }
+    // 透支的令牌补足之前不能写入
+    return static_cast<uint64_t>(-available_bytes_) * 1000000 / delayed_write_rate_;
+}
+
+void WriteController::waitWhileStopped(uint64_t timeout_micros) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    resume_cv_.wait_for(lock, std::chrono::microseconds(timeout_micros), [this] {
+        return condition_.load(std::memory_order_relaxed) != WriteStallCondition::STOPPED;
+    });
+}
+
+void WriteController::recordDelay(uint64_t micros) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.delayed_writes;
+    stats_.delayed_micros += micros;
+}
+
+void WriteController::recordStop(uint64_t micros) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.stopped_writes;
+    stats_.stopped_micros += micros;
+}
+
+WriteStallStats WriteController::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    WriteStallStats stats = stats_;
+    stats.condition = condition_.load(std::memory_order_relaxed);
+    stats.delayed_write_rate = delayed_write_rate_;
+    return stats;
+}
+
+}
@@ -0,0 +1,167 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 15:20:44
+ * @LastEditTime: 2026-10-18 00:09:26
+ */
+#include <tomato_db/write_pipeline.h>
+
+#include <cassert>
+
+namespace tomato {
+
+struct WritePipeline::Writer {
+    enum State {
+        // 等待写日志
+        WAITING_LOG,
+        // 日志已写完, 需要写内存表
+        WRITING_MEMTABLE,
+        // 所在的组已经发布
+        COMPLETED,
+    };
+
+    Writer(WriteBatch* batch_, bool sync_)
+        : batch(batch_), sync(sync_), state(WAITING_LOG), 
+          status(OperatorResult::success()), group(nullptr) {}
+
+    WriteBatch* batch;
+    bool sync;
+    State state;
+    OperatorResult status;
+    WriteGroup* group;
+    std::condition_variable cv;
+};
+
+struct WritePipeline::WriteGroup {
+    std::vector<Writer*> members;
+
+    /**
+     * @brief 组内最大的序列号
+     * 
+     */
+    uint64_t last_sequence;
+
+    /**
+     * @brief 还没有写完内存表的成员数
+     * 
+     */
+    size_t pending;
+};
+
+WritePipeline::WritePipeline(LogFunction log_function, MemoryTableFunction memtable_function, 
+                             size_t max_group_bytes)
+    : log_function_(std::move(log_function)),
+      memtable_function_(std::move(memtable_function)),
+      max_group_bytes_(max_group_bytes),
+      allocated_sequence_(0),
+      published_sequence_(0),
+      group_count_(0) {}
+
+void WritePipeline::setLastSequence(uint64_t seq) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    assert(log_writers_.empty() && memtable_groups_.empty());
+    allocated_sequence_ = seq;
+    published_sequence_.store(seq, std::memory_order_release);
+}
+
+void WritePipeline::waitForPublished(uint64_t seq) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    published_cv_.wait(lock, [&] { return published_sequence_.load(std::memory_order_relaxed) >= seq; });
+}
+
+uint64_t WritePipeline::getGroupCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return group_count_;
+}
+
+OperatorResult WritePipeline::write(WriteBatch* batch, bool sync) {
+    Writer writer(batch, sync);
+    std::unique_lock<std::mutex> lock(mutex_);
+    log_writers_.push_back(&writer);
+    writer.cv.wait(lock, [&] { 
+        return writer.state != Writer::WAITING_LOG || log_writers_.front() == &writer; 
+    });
+
+    // 组的生命周期: leader要等到组发布后才会返回, 发布前组一直在leader的栈上有效
+    WriteGroup group;
+    if (writer.state == Writer::WAITING_LOG) {
+        // leader收集排队的批次, 一次性分配整组的序列号
+        const uint64_t first_sequence = allocated_sequence_ + 1;
+        size_t group_bytes = 0;
+        bool need_sync = false;
+        std::vector<WriteBatch*> batches;
+        for (Writer* member : log_writers_) {
+            size_t size = member->batch->getContent().size();
+            if (!group.members.empty() && group_bytes + size > max_group_bytes_) {
+                break;
+            }
+            group_bytes += size;
+            need_sync = need_sync || member->sync;
+            member->batch->setSequence(allocated_sequence_ + 1);
+            allocated_sequence_ += member->batch->getCount();
+            group.members.push_back(member);
+            batches.push_back(member->batch);
+        }
+        group.last_sequence = allocated_sequence_;
+        group.pending = group.members.size();
+        ++group_count_;
+        lock.unlock();
+
+        OperatorResult status = log_function_(batches, need_sync);
+
+        lock.lock();
+        if (!status.isSuccess()) {
+            // 日志写失败的组不写内存表, 下一组还没有分配序列号, 收回本组的序列号, 发布时不会越过它们
+            allocated_sequence_ = first_sequence - 1;
+            group.last_sequence = allocated_sequence_;
+        }
+        for (Writer* member : group.members) {
+            assert(log_writers_.front() == member);
+            log_writers_.pop_front();
+            member->status = status;
+            member->group = &group;
+            member->state = Writer::WRITING_MEMTABLE;
+            if (member != &writer) {
+                member->cv.notify_one();
+            }
+        }
+        memtable_groups_.push_back(&group);
+
+        // 下一组可以开始写日志, 与本组写内存表并行
+        if (!log_writers_.empty()) {
+            log_writers_.front()->cv.notify_one();
+        }
+    }
+
+    // 每个成员写自己的批次, 日志写失败的批次不写内存表
+    if (writer.status.isSuccess()) {
+        lock.unlock();
+        OperatorResult status = memtable_function_(*writer.batch);
+        lock.lock();
+        writer.status = status;
+    }
+    if (--writer.group->pending == 0) {
+        publishGroups();
+    }
+    writer.cv.wait(lock, [&] { return writer.state == Writer::COMPLETED; });
+    return writer.status;
+}
+
+void WritePipeline::publishGroups() {
+    // 前面的组没写完时后面的组不能发布, 否则读者会看到序列号不连续的数据
+    bool published = false;
+    while (!memtable_groups_.empty() && memtable_groups_.front()->pending == 0) {
+        WriteGroup* group = memtable_groups_.front();
+        memtable_groups_.pop_front();
+        published_sequence_.store(group->last_sequence, std::memory_order_release);
+        for (Writer* member : group->members) {
+            member->state = Writer::COMPLETED;
+            member->cv.notify_one();
+        }
+        published = true;
+    }
+    if (published) {
+        published_cv_.notify_all();
+    }
+}
+
+}
@@ -0,0 +1,1379 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 16:10:37
+ * @LastEditTime: 2026-10-19 00:48:18
+ */
+#include <tomato_db/db_impl.h>
+#include <tomato_db/filename.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <set>
+#include <thread>
+
+namespace tomato {
+
+/**
+ * @brief 清空测试用的数据库目录, 返回对应的配置
+ * 
+ */
+DataBaseConfig cleanDataBase(const std::string& db_path) {
+    std::vector<std::string> children;
+    if (listDir(db_path, children).isSuccess()) {
+        for (const std::string& child : children) {
+            removeFile(db_path + "/" + child);
+        }
+    }
+    DataBaseConfig config;
+    config.db_path = db_path;
+    return config;
+}
+
+TEST(DATA_BASE, putGetDel) {
+    DataBaseConfig config = cleanDataBase("test-db-1");
+    std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+    ASSERT_TRUE(db);
+    EXPECT_FALSE(db->get("key"));
+    EXPECT_TRUE(db->put("key", "value").isSuccess());
+    EXPECT_TRUE(db->put("key2", "value2").isSuccess());
+    EXPECT_TRUE(db->put("key", "value1").isSuccess());
+    ASSERT_TRUE(db->get("key"));
+    EXPECT_EQ(*db->get("key"), "value1");
+    EXPECT_FALSE(db->get("ke"));
+
+    EXPECT_TRUE(db->del("key").isSuccess());
+    EXPECT_FALSE(db->get("key"));
+    ASSERT_TRUE(db->get("key2"));
+    EXPECT_EQ(*db->get("key2"), "value2");
+
+    EXPECT_TRUE(db->put("key3", "value3").isSuccess());
+    EXPECT_TRUE(db->put("key4", "value4").isSuccess());
+    std::vector<std::string> expect = {"value2", "value3"};
+    EXPECT_EQ(db->scan("key", "key4"), expect);
+}
+
+TEST(DATA_BASE, recover) {
+    DataBaseConfig config = cleanDataBase("test-db-2");
+    {
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+        for (int i = 0; i < 1000; ++i) {
+            EXPECT_TRUE(db->put("key" + std::to_string(i), "value" + std::to_string(i)).isSuccess());
+        }
+        EXPECT_TRUE(db->del("key7").isSuccess());
+    }
+
+    // 重启两次, 第二次需要回放两个日志文件
+    for (int round = 0; round < 2; ++round) {
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+        EXPECT_EQ(std::dynamic_pointer_cast<DBImpl>(db)->getLastSequence(), 1001 + round);
+        EXPECT_FALSE(db->get("key7"));
+        for (int i = 0; i < 1000; ++i) {
+            if (i != 7) {
+                ASSERT_TRUE(db->get("key" + std::to_string(i)));
+                EXPECT_EQ(*db->get("key" + std::to_string(i)), "value" + std::to_string(i));
+            }
+        }
+        EXPECT_TRUE(db->put("round" + std::to_string(round), "").isSuccess());
+    }
+}
+
+TEST(DATA_BASE, concurrentWrite) {
+    DataBaseConfig config = cleanDataBase("test-db-3");
+    config.sync_write = true;
+    const int thread_count = 8;
+    const int write_per_thread = 300;
+    {
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < thread_count; ++t) {
+            threads.emplace_back([&db, t] {
+                for (int i = 0; i < write_per_thread; ++i) {
+                    std::string key = std::to_string(t) + "-" + std::to_string(i);
+                    EXPECT_TRUE(db->put(key, key).isSuccess());
+                    // 写入返回后立即可见
+                    std::shared_ptr<std::string> value = db->get(key);
+                    ASSERT_TRUE(value);
+                    EXPECT_EQ(*value, key);
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        std::shared_ptr<DBImpl> impl = std::dynamic_pointer_cast<DBImpl>(db);
+        EXPECT_EQ(impl->getLastSequence(), thread_count * write_per_thread);
+        // 每次写入都要落盘, 落盘期间排队的写入合并成一组
+        EXPECT_LT(impl->getWriteGroupCount(), thread_count * write_per_thread);
+    }
+
+    std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+    ASSERT_TRUE(db);
+    for (int t = 0; t < thread_count; ++t) {
+        for (int i = 0; i < write_per_thread; ++i) {
+            std::string key = std::to_string(t) + "-" + std::to_string(i);
+            ASSERT_TRUE(db->get(key));
+            EXPECT_EQ(*db->get(key), key);
+        }
+    }
+}
+
+TEST(DATA_BASE, atomicWriteBatch) {
+    DataBaseConfig config = cleanDataBase("test-db-4");
+    const int key_count = 20;
+    const int round_count = 500;
+    {
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+
+        // 读线程在同一个快照中读到的所有键的值必须来自同一个批次
+        std::atomic<bool> stop(false);
+        std::thread reader([&db, &stop] {
+            while (!stop.load()) {
+                std::vector<std::string> values = db->scan("key", "kez");
+                for (const std::string& value : values) {
+                    ASSERT_EQ(value, values.front());
+                }
+            }
+        });
+        for (int round = 0; round < round_count; ++round) {
+            WriteBatch batch;
+            for (int i = 0; i < key_count; ++i) {
+                batch.put("key" + std::to_string(i), std::to_string(round));
+            }
+            // 删除后重新写入, 同一个批次内后写的操作生效
+            batch.del("key0");
+            batch.put("key0", std::to_string(round));
+            EXPECT_TRUE(db->write(batch).isSuccess());
+            EXPECT_EQ(batch.getSequence() + batch.getCount() - 1, 
+                      std::dynamic_pointer_cast<DBImpl>(db)->getLastSequence());
+        }
+        stop.store(true);
+        reader.join();
+
+        WriteBatch batch;
+        batch.put("other", "value");
+        WriteBatch deletes;
+        for (int i = 0; i < key_count; i += 2) {
+            deletes.del("key" + std::to_string(i));
+        }
+        batch.append(deletes);
+        EXPECT_EQ(batch.getCount(), 1 + key_count / 2);
+        EXPECT_TRUE(db->write(batch).isSuccess());
+    }
+
+    std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+    ASSERT_TRUE(db);
+    ASSERT_TRUE(db->get("other"));
+    EXPECT_EQ(db->scan("key", "kez"), std::vector<std::string>(key_count / 2, std::to_string(round_count - 1)));
+}
+
+TEST(DATA_BASE, multiGet) {
+    DataBaseConfig config = cleanDataBase("test-db-5");
+    // 很小的内存表与block, 让回放产生多个SSTable与data block
+    config.write_buffer_size = 16 << 10;
+    config.table_config.block_size_threshold = 512;
+    {
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+        for (int i = 0; i < 2000; ++i) {
+            EXPECT_TRUE(db->put("key" + std::to_string(i), "value" + std::to_string(i)).isSuccess());
+        }
+        for (int i = 0; i < 2000; i += 10) {
+            EXPECT_TRUE(db->put("key" + std::to_string(i), "updated" + std::to_string(i)).isSuccess());
+        }
+        EXPECT_TRUE(db->del("key5").isSuccess());
+    }
+
+    std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+    ASSERT_TRUE(db);
+    // 内存表中的新版本覆盖SSTable中的旧版本
+    EXPECT_TRUE(db->put("key1", "memtable1").isSuccess());
+    EXPECT_TRUE(db->del("key2").isSuccess());
+
+    std::vector<std::string> keys = {"key3", "key10", "missing", "key1", "key5", "key2", "key1999", "key3", "key20"};
+    std::vector<std::shared_ptr<std::string>> values = db->multiGet(keys);
+    ASSERT_EQ(values.size(), keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+        std::shared_ptr<std::string> expect = db->get(keys[i]);
+        EXPECT_EQ(static_cast<bool>(values[i]), static_cast<bool>(expect)) << keys[i];
+        if (values[i] && expect) {
+            EXPECT_EQ(*values[i], *expect) << keys[i];
+        }
+    }
+    ASSERT_TRUE(values[0] && values[1] && values[3] && values[6] && values[7] && values[8]);
+    EXPECT_EQ(*values[0], "value3");
+    EXPECT_EQ(*values[1], "updated10");
+    EXPECT_FALSE(values[2]);
+    EXPECT_EQ(*values[3], "memtable1");
+    EXPECT_FALSE(values[4]);
+    EXPECT_FALSE(values[5]);
+    EXPECT_EQ(*values[6], "value1999");
+    EXPECT_EQ(*values[7], "value3");
+    EXPECT_EQ(*values[8], "updated20");
+
+    std::vector<std::string> all_keys;
+    for (int i = 0; i < 2000; ++i) {
+        all_keys.push_back("key" + std::to_string(i));
+    }
+    values = db->multiGet(all_keys);
+    size_t found = 0;
+    for (size_t i = 0; i < all_keys.size(); ++i) {
+        if (values[i]) {
+            ++found;
+        }
+    }
+    EXPECT_EQ(found, 1998u);
+    EXPECT_EQ(db->scan("key100", "key1001").size(), 2u);
+}
+
+TEST(DATA_BASE, iterator) {
+    DataBaseConfig config = cleanDataBase("test-db-6");
+    config.write_buffer_size = 8 << 10;
+    config.table_config.block_size_threshold = 256;
+    std::map<std::string, std::string> expect;
+    {
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+        for (int i = 0; i < 1000; ++i) {
+            char key[16];
+            snprintf(key, sizeof(key), "key%04d", i);
+            EXPECT_TRUE(db->put(key, "value" + std::to_string(i)).isSuccess());
+            expect[key] = "value" + std::to_string(i);
+        }
+    }
+
+    // 一部分数据在SSTable中, 一部分在内存表中
+    std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+    ASSERT_TRUE(db);
+    for (int i = 0; i < 1000; i += 3) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%04d", i);
+        if (i % 2 == 0) {
+            EXPECT_TRUE(db->del(key).isSuccess());
+            expect.erase(key);
+        } else {
+            EXPECT_TRUE(db->put(key, "updated").isSuccess());
+            expect[key] = "updated";
+        }
+    }
+    std::shared_ptr<const Snapshot> snapshot = db->getSnapshot();
+    const std::map<std::string, std::string> snapshot_expect = expect;
+    EXPECT_TRUE(db->put("key0001", "after snapshot").isSuccess());
+    EXPECT_TRUE(db->del("key0002").isSuccess());
+    EXPECT_TRUE(db->put("key9999", "new").isSuccess());
+
+    ReadOptions options;
+    options.snapshot = snapshot;
+    std::unique_ptr<Iterator> it = db->newIterator(options);
+    auto expect_it = snapshot_expect.begin();
+    for (it->seekToFirst(); it->valid(); it->next(), ++expect_it) {
+        ASSERT_TRUE(expect_it != snapshot_expect.end());
+        EXPECT_EQ(it->key(), expect_it->first);
+        EXPECT_EQ(it->value(), expect_it->second);
+    }
+    EXPECT_TRUE(expect_it == snapshot_expect.end());
+    EXPECT_TRUE(it->getStatus().isSuccess());
+
+    auto reverse_it = snapshot_expect.rbegin();
+    for (it->seekToLast(); it->valid(); it->prev(), ++reverse_it) {
+        ASSERT_TRUE(reverse_it != snapshot_expect.rend());
+        EXPECT_EQ(it->key(), reverse_it->first);
+        EXPECT_EQ(it->value(), reverse_it->second);
+    }
+    EXPECT_TRUE(reverse_it == snapshot_expect.rend());
+
+    // 改变方向
+    it->seek("key0498");
+    ASSERT_TRUE(it->valid());
+    EXPECT_EQ(it->key(), "key0499");
+    it->prev();
+    ASSERT_TRUE(it->valid());
+    EXPECT_EQ(it->key(), "key0497");
+    it->next();
+    ASSERT_TRUE(it->valid());
+    EXPECT_EQ(it->key(), "key0499");
+    snapshot.reset();
+
+    // 上界与最新数据
+    options = ReadOptions();
+    options.upper_bound = "key0010";
+    it = db->newIterator(options);
+    std::vector<std::string> keys;
+    for (it->seekToFirst(); it->valid(); it->next()) {
+        keys.push_back(it->key());
+    }
+    std::vector<std::string> expect_keys = {"key0001", "key0003", "key0004", "key0005", "key0007", "key0008", "key0009"};
+    EXPECT_EQ(keys, expect_keys);
+    it->seekToLast();
+    ASSERT_TRUE(it->valid());
+    EXPECT_EQ(it->key(), "key0009");
+    it->seek("key0001");
+    ASSERT_TRUE(it->valid());
+    EXPECT_EQ(it->value(), "after snapshot");
+    it->seek("key0010");
+    EXPECT_FALSE(it->valid());
+
+    it = db->newIterator(ReadOptions());
+    it->seekToLast();
+    ASSERT_TRUE(it->valid());
+    EXPECT_EQ(it->key(), "key9999");
+}
+
+/**
+ * @brief 遍历数据库中的所有键
+ * 
+ */
+std::vector<std::string> collectKeys(DataBase* db) {
+    std::vector<std::string> keys;
+    std::unique_ptr<Iterator> it = db->newIterator(ReadOptions());
+    for (it->seekToFirst(); it->valid(); it->next()) {
+        keys.push_back(it->key());
+    }
+    return keys;
+}
+
+TEST(DATA_BASE, deleteRange) {
+    DataBaseConfig config = cleanDataBase("test-db-7");
+    config.write_buffer_size = 8 << 10;
+    config.table_config.block_size_threshold = 256;
+    {
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+        for (int i = 0; i < 1000; ++i) {
+            char key[16];
+            snprintf(key, sizeof(key), "key%04d", i);
+            EXPECT_TRUE(db->put(key, "value" + std::to_string(i)).isSuccess());
+        }
+    }
+
+    std::vector<std::string> expect_keys;
+    for (int i = 0; i < 1000; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%04d", i);
+        if (i < 100 || i >= 200) {
+            expect_keys.push_back(key);
+        }
+    }
+    {
+        // 标记在内存表中, 被遮住的数据在SSTable中
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+        std::shared_ptr<const Snapshot> snapshot = db->getSnapshot();
+        EXPECT_TRUE(db->deleteRange("key0100", "key0200").isSuccess());
+        EXPECT_TRUE(db->put("key0150", "rewritten").isSuccess());
+        EXPECT_FALSE(db->get("key0100"));
+        EXPECT_FALSE(db->get("key0199"));
+        ASSERT_TRUE(db->get("key0150"));
+        EXPECT_EQ(*db->get("key0150"), "rewritten");
+        ASSERT_TRUE(db->get("key0200"));
+        ASSERT_TRUE(db->get("key0099"));
+
+        std::vector<std::shared_ptr<std::string>> values = db->multiGet({"key0099", "key0120", "key0150", "key0200"});
+        EXPECT_TRUE(values[0]);
+        EXPECT_FALSE(values[1]);
+        ASSERT_TRUE(values[2]);
+        EXPECT_EQ(*values[2], "rewritten");
+        EXPECT_TRUE(values[3]);
+
+        std::vector<std::string> keys = collectKeys(db.get());
+        EXPECT_EQ(keys.size(), 901u);
+        std::unique_ptr<Iterator> it = db->newIterator(ReadOptions());
+        it->seek("key0100");
+        ASSERT_TRUE(it->valid());
+        EXPECT_EQ(it->key(), "key0150");
+        it->prev();
+        ASSERT_TRUE(it->valid());
+        EXPECT_EQ(it->key(), "key0099");
+
+        // 快照看不到之后的范围删除
+        ReadOptions options;
+        options.snapshot = snapshot;
+        it = db->newIterator(options);
+        it->seek("key0120");
+        ASSERT_TRUE(it->valid());
+        EXPECT_EQ(it->key(), "key0120");
+        snapshot.reset();
+        EXPECT_TRUE(db->del("key0150").isSuccess());
+    }
+
+    {
+        // 标记与数据都在SSTable中, 合并后被遮住的数据被清理
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+        EXPECT_FALSE(db->get("key0150"));
+        EXPECT_FALSE(db->get("key0123"));
+        EXPECT_EQ(collectKeys(db.get()), expect_keys);
+        EXPECT_TRUE(db->compactRange("", "").isSuccess());
+        EXPECT_FALSE(db->get("key0123"));
+        ASSERT_TRUE(db->get("key0200"));
+        EXPECT_EQ(*db->get("key0200"), "value200");
+        EXPECT_EQ(collectKeys(db.get()), expect_keys);
+    }
+
+    {
+        // 删除全部数据后, 被完全遮住的文件直接删除, 最底层的标记也被清理
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+        EXPECT_EQ(collectKeys(db.get()), expect_keys);
+        EXPECT_TRUE(db->deleteRange("key", "key9999").isSuccess());
+        EXPECT_TRUE(collectKeys(db.get()).empty());
+    }
+    std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+    ASSERT_TRUE(db);
+    EXPECT_TRUE(collectKeys(db.get()).empty());
+    EXPECT_TRUE(db->compactRange("", "").isSuccess());
+    EXPECT_TRUE(collectKeys(db.get()).empty());
+    EXPECT_FALSE(db->get("key0500"));
+    std::vector<std::string> children;
+    ASSERT_TRUE(listDir(config.db_path, children).isSuccess());
+    uint64_t number = 0;
+    for (const std::string& child : children) {
+        EXPECT_NE(parseFileName(child, number), FileType::TABLE_FILE);
+    }
+}
+
+/**
+ * @brief 测试用的计数器: 值与操作数都是十进制整数, 合并结果为它们的和
+ * 
+ */
+class CounterMergeOperator : public MergeOperator {
+public:
+    bool fullMerge(const std::string& /* key */, const std::string* existing_value,
+                   const std::vector<std::string>& operands, std::string& result) const override {
+        long long sum = existing_value ? std::stoll(*existing_value) : 0;
+        for (const std::string& operand : operands) {
+            sum += std::stoll(operand);
+        }
+        result = std::to_string(sum);
+        return true;
+    }
+
+    bool partialMerge(const std::string& /* key */, const std::string& left, const std::string& right,
+                      std::string& result) const override {
+        result = std::to_string(std::stoll(left) + std::stoll(right));
+        return true;
+    }
+
+    const char* name() const override {
+        return "CounterMergeOperator";
+    }
+};
+
+TEST(DATA_BASE, merge) {
+    DataBaseConfig config = cleanDataBase("test-db-8");
+    {
+        // 没有合并算子时不能写入操作数
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+        EXPECT_FALSE(db->merge("counter", "1").isSuccess());
+    }
+
+    config.merge_operator = std::make_shared<CounterMergeOperator>();
+    config.write_buffer_size = 8 << 10;
+    config.table_config.block_size_threshold = 256;
+    {
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+        for (int i = 0; i < 10; ++i) {
+            EXPECT_TRUE(db->merge("counter", "1").isSuccess());
+        }
+        ASSERT_TRUE(db->get("counter"));
+        EXPECT_EQ(*db->get("counter"), "10");
+
+        EXPECT_TRUE(db->put("base", "100").isSuccess());
+        EXPECT_TRUE(db->merge("base", "5").isSuccess());
+        std::shared_ptr<const Snapshot> snapshot = db->getSnapshot();
+        EXPECT_TRUE(db->merge("base", "-20").isSuccess());
+        ASSERT_TRUE(db->get("base"));
+        EXPECT_EQ(*db->get("base"), "85");
+
+        // 删除与范围删除之后的操作数从空值开始合并
+        EXPECT_TRUE(db->put("deleted", "7").isSuccess());
+        EXPECT_TRUE(db->del("deleted").isSuccess());
+        EXPECT_TRUE(db->merge("deleted", "3").isSuccess());
+        EXPECT_TRUE(db->put("range", "7").isSuccess());
+        EXPECT_TRUE(db->deleteRange("range", "rangf").isSuccess());
+        EXPECT_TRUE(db->merge("range", "4").isSuccess());
+
+        std::vector<std::shared_ptr<std::string>> values = db->multiGet({"base", "counter", "deleted", "none", "range"});
+        ASSERT_TRUE(values[0]);
+        EXPECT_EQ(*values[0], "85");
+        ASSERT_TRUE(values[1]);
+        EXPECT_EQ(*values[1], "10");
+        ASSERT_TRUE(values[2]);
+        EXPECT_EQ(*values[2], "3");
+        EXPECT_FALSE(values[3]);
+        ASSERT_TRUE(values[4]);
+        EXPECT_EQ(*values[4], "4");
+
+        ReadOptions options;
+        options.snapshot = snapshot;
+        std::unique_ptr<Iterator> it = db->newIterator(options);
+        it->seek("base");
+        ASSERT_TRUE(it->valid());
+        EXPECT_EQ(it->key(), "base");
+        EXPECT_EQ(it->value(), "105");
+
+        std::vector<std::pair<std::string, std::string>> expect = {
+            {"base", "85"}, {"counter", "10"}, {"deleted", "3"}, {"range", "4"}};
+        std::vector<std::pair<std::string, std::string>> forward;
+        it = db->newIterator(ReadOptions());
+        for (it->seekToFirst(); it->valid(); it->next()) {
+            forward.emplace_back(it->key(), it->value());
+        }
+        EXPECT_TRUE(it->getStatus().isSuccess());
+        EXPECT_EQ(forward, expect);
+        std::vector<std::pair<std::string, std::string>> backward;
+        for (it->seekToLast(); it->valid(); it->prev()) {
+            backward.emplace_back(it->key(), it->value());
+        }
+        std::reverse(backward.begin(), backward.end());
+        EXPECT_EQ(backward, expect);
+    }
+
+    {
+        // 重新打开时内存表中的操作数在刷写时合并
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+        ASSERT_TRUE(db->get("base"));
+        EXPECT_EQ(*db->get("base"), "85");
+        EXPECT_TRUE(db->merge("base", "15").isSuccess());
+        for (int i = 0; i < 1000; ++i) {
+            char key[16];
+            snprintf(key, sizeof(key), "key%04d", i);
+            EXPECT_TRUE(db->merge(key, std::to_string(i)).isSuccess());
+            EXPECT_TRUE(db->merge(key, "1").isSuccess());
+        }
+        ASSERT_TRUE(db->get("base"));
+        EXPECT_EQ(*db->get("base"), "100");
+        ASSERT_TRUE(db->get("key0500"));
+        EXPECT_EQ(*db->get("key0500"), "501");
+    }
+
+    std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+    ASSERT_TRUE(db);
+    for (int i = 0; i < 1000; i += 3) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%04d", i);
+        EXPECT_TRUE(db->merge(key, "1000").isSuccess());
+    }
+    EXPECT_TRUE(db->compactRange("", "").isSuccess());
+    for (int i = 0; i < 1000; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%04d", i);
+        ASSERT_TRUE(db->get(key));
+        EXPECT_EQ(*db->get(key), std::to_string(i + 1 + (i % 3 == 0 ? 1000 : 0)));
+    }
+    ASSERT_TRUE(db->get("counter"));
+    EXPECT_EQ(*db->get("counter"), "10");
+}
+
+TEST(DATA_BASE, prefixSeek) {
+    DataBaseConfig config = cleanDataBase("test-db-9");
+    config.write_buffer_size = 8 << 10;
+    config.table_config.block_size_threshold = 256;
+    config.table_config.prefix_extractor = newDelimitedPrefixExtractor(':', 2);
+    std::map<std::string, std::string> expect;
+    {
+        // 按用户依次写入, 每个SSTable只包含少数几个用户
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+        for (int user = 0; user < 40; ++user) {
+            for (int item = 0; item < 30; ++item) {
+                char key[32];
+                snprintf(key, sizeof(key), "tenant:u%02d:item%03d", user, item);
+                EXPECT_TRUE(db->put(key, "v" + std::to_string(item)).isSuccess());
+                expect[key] = "v" + std::to_string(item);
+            }
+        }
+    }
+    std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+    ASSERT_TRUE(db);
+    EXPECT_TRUE(db->put("tenant:u07:item005", "rewritten").isSuccess());
+    expect["tenant:u07:item005"] = "rewritten";
+    EXPECT_TRUE(db->del("tenant:u07:item000").isSuccess());
+    expect.erase("tenant:u07:item000");
+    EXPECT_TRUE(db->deleteRange("tenant:u08:item010", "tenant:u08:item020").isSuccess());
+    expect.erase(expect.find("tenant:u08:item010"), expect.find("tenant:u08:item020"));
+    EXPECT_TRUE(db->put("tenant:u99:item000", "new user").isSuccess());
+    expect["tenant:u99:item000"] = "new user";
+    EXPECT_TRUE(db->put("tenant", "no prefix").isSuccess());
+    expect["tenant"] = "no prefix";
+
+    ReadOptions options;
+    options.prefix_seek = true;
+    std::unique_ptr<Iterator> it = db->newIterator(options);
+    for (int user = 0; user < 100; ++user) {
+        char prefix[16];
+        snprintf(prefix, sizeof(prefix), "tenant:u%02d:", user);
+        std::vector<std::pair<std::string, std::string>> prefix_expect;
+        for (auto iter = expect.lower_bound(prefix); iter != expect.end() && iter->first.find(prefix) == 0; ++iter) {
+            prefix_expect.push_back(*iter);
+        }
+
+        std::vector<std::pair<std::string, std::string>> forward;
+        for (it->seek(prefix); it->valid(); it->next()) {
+            forward.emplace_back(it->key(), it->value());
+        }
+        EXPECT_TRUE(it->getStatus().isSuccess());
+        EXPECT_EQ(forward, prefix_expect);
+        if (prefix_expect.empty()) {
+            continue;
+        }
+
+        // 反向遍历同样停在前缀的边界上
+        std::vector<std::pair<std::string, std::string>> backward;
+        for (it->seek(prefix_expect.back().first); it->valid(); it->prev()) {
+            backward.emplace_back(it->key(), it->value());
+        }
+        std::reverse(backward.begin(), backward.end());
+        EXPECT_EQ(backward, prefix_expect);
+    }
+
+    // 改变方向后仍在前缀内
+    it->seek("tenant:u07:item003");
+    ASSERT_TRUE(it->valid());
+    EXPECT_EQ(it->key(), "tenant:u07:item003");
+    it->prev();
+    ASSERT_TRUE(it->valid());
+    EXPECT_EQ(it->key(), "tenant:u07:item002");
+    it->next();
+    it->next();
+    ASSERT_TRUE(it->valid());
+    EXPECT_EQ(it->key(), "tenant:u07:item004");
+    it->next();
+    ASSERT_TRUE(it->valid());
+    EXPECT_EQ(it->value(), "rewritten");
+    it->seek("tenant:u07:item001");
+    it->prev();
+    EXPECT_FALSE(it->valid());
+
+    // 没有前缀的目标与seekToFirst按全序遍历
+    it->seek("tenant");
+    ASSERT_TRUE(it->valid());
+    EXPECT_EQ(it->value(), "no prefix");
+    it->next();
+    ASSERT_TRUE(it->valid());
+    EXPECT_EQ(it->key(), "tenant:u00:item000");
+    size_t count = 0;
+    for (it->seekToFirst(); it->valid(); it->next()) {
+        ++count;
+    }
+    EXPECT_EQ(count, expect.size());
+}
+
+TEST(DATA_BASE, rangeFilter) {
+    DataBaseConfig config = cleanDataBase("test-db-10");
+    config.write_buffer_size = 4 << 10;
+    config.table_config.block_size_threshold = 256;
+    config.table_config.range_filter = true;
+    std::map<std::string, std::string> expect;
+    {
+        // 每一轮的键散布在所有键簇中, 不同SSTable的键范围互相穿插, 范围内的键却很稀疏
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+        for (int round = 0; round < 4; ++round) {
+            for (int i = 0; i < 100; ++i) {
+                char key[16];
+                snprintf(key, sizeof(key), "c%02d:%03d", i % 10 * 10 + round, i / 10);
+                EXPECT_TRUE(db->put(key, std::string(40, static_cast<char>('a' + round))).isSuccess());
+                expect[key] = std::string(40, static_cast<char>('a' + round));
+            }
+        }
+        EXPECT_TRUE(db->del("c31:005").isSuccess());
+        expect.erase("c31:005");
+    }
+
+    std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+    ASSERT_TRUE(db);
+    for (int begin = 0; begin < 100; begin += 3) {
+        for (int width = 1; width < 30; width += 4) {
+            char begin_key[16];
+            char end_key[16];
+            snprintf(begin_key, sizeof(begin_key), "c%02d:", begin);
+            snprintf(end_key, sizeof(end_key), "c%02d:%03d", begin + width / 10, width % 10);
+            std::vector<std::string> expect_values;
+            std::vector<std::string> expect_keys;
+            for (auto iter = expect.lower_bound(begin_key); iter != expect.end() && iter->first < end_key; ++iter) {
+                expect_values.push_back(iter->second);
+                expect_keys.push_back(iter->first);
+            }
+            EXPECT_EQ(db->scan(begin_key, end_key), expect_values);
+
+            ReadOptions options;
+            options.upper_bound = end_key;
+            std::unique_ptr<Iterator> it = db->newIterator(options);
+            std::vector<std::string> keys;
+            for (it->seekToLast(); it->valid(); it->prev()) {
+                if (it->key() < begin_key) {
+                    break;
+                }
+                keys.push_back(it->key());
+            }
+            EXPECT_TRUE(it->getStatus().isSuccess());
+            std::reverse(keys.begin(), keys.end());
+            EXPECT_EQ(keys, expect_keys);
+        }
+    }
+
+    // 空隙中的seek越过上界后改变方向
+    ReadOptions options;
+    options.upper_bound = "c05:";
+    std::unique_ptr<Iterator> it = db->newIterator(options);
+    it->seek("c04:");
+    EXPECT_FALSE(it->valid());
+    it->seek("c03:009");
+    ASSERT_TRUE(it->valid());
+    it->prev();
+    ASSERT_TRUE(it->valid());
+    EXPECT_EQ(it->key(), "c03:008");
+    it->next();
+    it->next();
+    EXPECT_FALSE(it->valid());
+}
+
+
+/**
+ * @brief 数据库目录下的blob文件编号
+ * 
+ */
+static std::set<uint64_t> listBlobFiles(const std::string& db_path) {
+    std::vector<std::string> children;
+    listDir(db_path, children);
+    std::set<uint64_t> numbers;
+    for (const std::string& child : children) {
+        uint64_t number = 0;
+        if (parseFileName(child, number) == FileType::BLOB_FILE) {
+            numbers.insert(number);
+        }
+    }
+    return numbers;
+}
+
+/**
+ * @brief 数据库目录下的SSTable个数
+ * 
+ */
+static size_t countTableFiles(const std::string& db_path) {
+    std::vector<std::string> children;
+    listDir(db_path, children);
+    size_t count = 0;
+    for (const std::string& child : children) {
+        uint64_t number = 0;
+        if (parseFileName(child, number) == FileType::TABLE_FILE) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+TEST(DATA_BASE, blobFiles) {
+    DataBaseConfig config = cleanDataBase("test-db-11");
+    config.blob_options.min_blob_size = 1024;
+    config.blob_options.blob_file_size = 32 << 10;
+    config.blob_options.garbage_ratio = 0.4;
+    config.merge_operator = std::make_shared<CounterMergeOperator>();
+    std::map<std::string, std::string> expect;
+    auto check = [&expect](DataBase* db) {
+        for (const auto& entry : expect) {
+            std::shared_ptr<std::string> value = db->get(entry.first);
+            ASSERT_TRUE(value) << entry.first;
+            EXPECT_EQ(*value, entry.second);
+        }
+        std::vector<std::string> keys;
+        std::vector<std::string> expect_values;
+        for (const auto& entry : expect) {
+            keys.push_back(entry.first);
+            expect_values.push_back(entry.second);
+        }
+        std::vector<std::shared_ptr<std::string>> values = db->multiGet(keys);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            ASSERT_TRUE(values[i]) << keys[i];
+            EXPECT_EQ(*values[i], expect_values[i]);
+        }
+        std::unique_ptr<Iterator> it = db->newIterator(ReadOptions());
+        auto expect_iter = expect.begin();
+        for (it->seekToFirst(); it->valid(); it->next(), ++expect_iter) {
+            ASSERT_NE(expect_iter, expect.end());
+            EXPECT_EQ(it->key(), expect_iter->first);
+            EXPECT_EQ(it->value(), expect_iter->second);
+        }
+        EXPECT_EQ(expect_iter, expect.end());
+        auto reverse_iter = expect.rbegin();
+        for (it->seekToLast(); it->valid(); it->prev(), ++reverse_iter) {
+            ASSERT_NE(reverse_iter, expect.rend());
+            EXPECT_EQ(it->key(), reverse_iter->first);
+            EXPECT_EQ(it->value(), reverse_iter->second);
+        }
+        EXPECT_EQ(reverse_iter, expect.rend());
+        EXPECT_TRUE(it->getStatus().isSuccess());
+    };
+    auto write_round = [&expect](DataBase* db, int round, int step) {
+        for (int i = 0; i < 40; i += step) {
+            const std::string key = "key" + std::to_string(100 + i);
+            const std::string value = std::string(2000, static_cast<char>('a' + round)) + key;
+            EXPECT_TRUE(db->put(key, value).isSuccess());
+            expect[key] = value;
+        }
+    };
+
+    std::set<uint64_t> first_files;
+    {
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+        write_round(db.get(), 0, 1);
+        EXPECT_TRUE(db->put("small", "value").isSuccess());
+        expect["small"] = "value";
+        EXPECT_TRUE(db->put("counter", std::string(1999, '0') + "5").isSuccess());
+        expect["counter"] = std::string(1999, '0') + "5";
+    }
+    {
+        // 重启时刷写内存表, 大值写入多个blob文件
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+        first_files = listBlobFiles(config.db_path);
+        EXPECT_GT(first_files.size(), 1);
+        check(db.get());
+
+        // 合并操作数的旧值在blob文件中
+        EXPECT_TRUE(db->merge("counter", "3").isSuccess());
+        expect["counter"] = "8";
+        check(db.get());
+
+        // 覆盖所有大值后合并, 第一批blob文件全部成为垃圾
+        write_round(db.get(), 1, 1);
+        EXPECT_TRUE(db->del("key105").isSuccess());
+        expect.erase("key105");
+    }
+    {
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+        check(db.get());
+        EXPECT_TRUE(db->compactRange("", "").isSuccess());
+        check(db.get());
+        std::set<uint64_t> files = listBlobFiles(config.db_path);
+        for (uint64_t number : first_files) {
+            EXPECT_EQ(files.count(number), 0);
+        }
+        first_files = files;
+        EXPECT_FALSE(first_files.empty());
+
+        // 覆盖一半的大值, 剩下的一半在下一次合并时搬到新的blob文件
+        write_round(db.get(), 2, 2);
+    }
+    {
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+        EXPECT_TRUE(db->compactRange("", "").isSuccess());
+        check(db.get());
+        // 下一次合并的范围覆盖所有文件
+        EXPECT_TRUE(db->put("key0", "small").isSuccess());
+        expect["key0"] = "small";
+        EXPECT_TRUE(db->put("key999", "small").isSuccess());
+        expect["key999"] = "small";
+    }
+    {
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+        EXPECT_TRUE(db->compactRange("", "").isSuccess());
+        check(db.get());
+        std::set<uint64_t> files = listBlobFiles(config.db_path);
+        for (uint64_t number : first_files) {
+            EXPECT_EQ(files.count(number), 0);
+        }
+    }
+
+    // 清单文件记录了blob文件列表
+    std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+    ASSERT_TRUE(db);
+    check(db.get());
+}
+
+TEST(DATA_BASE, flushImmutableMemoryTable) {
+    DataBaseConfig config = cleanDataBase("test-db-12");
+    config.write_buffer_size = 64 << 10;
+    config.l0_compaction_trigger = 100;
+    const int thread_count = 4;
+    const int write_per_thread = 2000;
+    auto make_value = [](const std::string& key) { return std::string(100, 'v') + key; };
+    {
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+        std::atomic<bool> stop(false);
+        // 刷写期间读者始终能读到已经写入的键
+        std::thread reader([&db, &stop, &make_value] {
+            while (!stop.load()) {
+                std::shared_ptr<std::string> value = db->get("0-0");
+                if (value) {
+                    EXPECT_EQ(*value, make_value("0-0"));
+                }
+            }
+        });
+        std::vector<std::thread> threads;
+        for (int t = 0; t < thread_count; ++t) {
+            threads.emplace_back([&db, &make_value, t] {
+                for (int i = 0; i < write_per_thread; ++i) {
+                    std::string key = std::to_string(t) + "-" + std::to_string(i);
+                    EXPECT_TRUE(db->put(key, make_value(key)).isSuccess());
+                    std::shared_ptr<std::string> value = db->get(key);
+                    ASSERT_TRUE(value);
+                    EXPECT_EQ(*value, make_value(key));
+                }
+            });
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        stop.store(true);
+        reader.join();
+
+        // 不需要重新打开, 写满的内存表已经在后台写成SSTable
+        EXPECT_GT(countTableFiles(config.db_path), 1);
+        size_t count = 0;
+        std::unique_ptr<Iterator> it = db->newIterator(ReadOptions());
+        for (it->seekToFirst(); it->valid(); it->next()) {
+            EXPECT_EQ(it->value(), make_value(it->key()));
+            ++count;
+        }
+        EXPECT_EQ(count, thread_count * write_per_thread);
+    }
+
+    // 只允许一个不可变内存表时写入等待刷写, 数据不会丢失
+    config.max_immutable_memtables = 1;
+    config.flush_threads = 1;
+    {
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+        for (int i = 0; i < write_per_thread; ++i) {
+            std::string key = "single-" + std::to_string(i);
+            EXPECT_TRUE(db->put(key, make_value(key)).isSuccess());
+        }
+        EXPECT_TRUE(db->del("single-0").isSuccess());
+    }
+
+    std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+    ASSERT_TRUE(db);
+    for (int t = 0; t < thread_count; ++t) {
+        for (int i = 0; i < write_per_thread; ++i) {
+            std::string key = std::to_string(t) + "-" + std::to_string(i);
+            std::shared_ptr<std::string> value = db->get(key);
+            ASSERT_TRUE(value) << key;
+            EXPECT_EQ(*value, make_value(key));
+        }
+    }
+    EXPECT_FALSE(db->get("single-0"));
+    for (int i = 1; i < write_per_thread; ++i) {
+        std::string key = "single-" + std::to_string(i);
+        std::shared_ptr<std::string> value = db->get(key);
+        ASSERT_TRUE(value) << key;
+        EXPECT_EQ(*value, make_value(key));
+    }
+}
+
+TEST(DATA_BASE, writeBufferManager) {
+    // 两个数据库共用256KB的写缓冲区预算, 各自的内存表上限都远大于预算
+    std::shared_ptr<BlockCache> block_cache = std::make_shared<BlockCache>(4 << 20);
+    std::shared_ptr<WriteBufferManager> manager = std::make_shared<WriteBufferManager>(256 << 10, block_cache);
+    DataBaseConfig config_a = cleanDataBase("test-db-13");
+    DataBaseConfig config_b = cleanDataBase("test-db-14");
+    for (DataBaseConfig* config : {&config_a, &config_b}) {
+        config->write_buffer_size = 64 << 20;
+        config->write_buffer_manager = manager;
+        config->block_cache = block_cache;
+    }
+    auto make_value = [](const std::string& key) { return std::string(200, 'v') + key; };
+    {
+        std::shared_ptr<DataBase> db_a = createDataBaseInstance(config_a);
+        std::shared_ptr<DataBase> db_b = createDataBaseInstance(config_b);
+        ASSERT_TRUE(db_a && db_b);
+
+        // b写入接近预算后不再写入, a的写入使总内存超出预算时b的内存表最大, 由a的写入触发b刷写
+        for (int i = 0; i < 700; ++i) {
+            const std::string key = "b" + std::to_string(i);
+            ASSERT_TRUE(db_b->put(key, make_value(key)).isSuccess());
+        }
+        EXPECT_EQ(countTableFiles(config_b.db_path), 0);
+        EXPECT_GT(manager->getMemoryUsage(), 0);
+        EXPECT_GE(block_cache->getReservedUsage(), manager->getMemoryUsage());
+        for (int i = 0; i < 5000; ++i) {
+            const std::string key = "a" + std::to_string(i);
+            ASSERT_TRUE(db_a->put(key, make_value(key)).isSuccess());
+            EXPECT_LT(manager->getActiveMemoryUsage(), 2 * manager->getBufferSize());
+        }
+        EXPECT_GT(countTableFiles(config_b.db_path), 0);
+        EXPECT_GT(countTableFiles(config_a.db_path), 1);
+        for (int i = 0; i < 700; ++i) {
+            const std::string key = "b" + std::to_string(i);
+            std::shared_ptr<std::string> value = db_b->get(key);
+            ASSERT_TRUE(value) << key;
+            EXPECT_EQ(*value, make_value(key));
+        }
+        for (int i = 0; i < 5000; ++i) {
+            const std::string key = "a" + std::to_string(i);
+            std::shared_ptr<std::string> value = db_a->get(key);
+            ASSERT_TRUE(value) << key;
+            EXPECT_EQ(*value, make_value(key));
+        }
+        // block缓存扣除预留的内存后仍不超出容量
+        EXPECT_LE(block_cache->getUsage() + block_cache->getReservedUsage(), (4 << 20) + (1 << 20));
+    }
+    // 数据库关闭后所有内存表的内存都已释放
+    EXPECT_EQ(manager->getMemoryUsage(), 0);
+    EXPECT_EQ(manager->getActiveMemoryUsage(), 0);
+    EXPECT_EQ(block_cache->getReservedUsage(), 0);
+}
+
+TEST(DATA_BASE, writeStallDelay) {
+    // 第0层不会自动合并, 文件数达到2后一直限速; 停止阈值低于合并阈值时按合并阈值停止, 这里不会停止
+    DataBaseConfig config = cleanDataBase("test-db-15");
+    config.write_buffer_size = 16 << 10;
+    config.l0_compaction_trigger = 100;
+    config.level0_slowdown_writes_trigger = 2;
+    config.level0_stop_writes_trigger = 3;
+    config.delayed_write_rate = 256 << 10;
+    auto make_value = [](int i) { return std::string(200, 'v') + std::to_string(i); };
+    std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+    ASSERT_TRUE(db);
+    int count = 0;
+    while (db->getWriteStallStats().condition != WriteStallCondition::DELAYED) {
+        ASSERT_LT(count, 10000);
+        ASSERT_TRUE(db->put("key" + std::to_string(count), make_value(count)).isSuccess());
+        ++count;
+    }
+
+    // 限速后写入约64KB至少需要250ms, 写入本身的耗时也在补充令牌, 等待的时长少于总耗时
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 300; ++i) {
+        ASSERT_TRUE(db->put("key" + std::to_string(count), make_value(count)).isSuccess());
+        ++count;
+    }
+    const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    WriteStallStats stats = db->getWriteStallStats();
+    EXPECT_EQ(stats.condition, WriteStallCondition::DELAYED);
+    EXPECT_LE(stats.delayed_write_rate, 256u << 10);
+    EXPECT_GT(stats.delayed_writes, 0u);
+    EXPECT_GE(stats.delayed_micros, 100000u);
+    EXPECT_GE(elapsed, 200000);
+    for (int i = 0; i < count; ++i) {
+        std::shared_ptr<std::string> value = db->get("key" + std::to_string(i));
+        ASSERT_TRUE(value);
+        EXPECT_EQ(*value, make_value(i));
+    }
+}
+
+TEST(DATA_BASE, writeStallStop) {
+    // 任何待合并的数据都超过硬上限, 每次刷写后写入停止, 直到合并把数据推到最底层
+    DataBaseConfig config = cleanDataBase("test-db-16");
+    config.write_buffer_size = 16 << 10;
+    config.l0_compaction_trigger = 1;
+    config.max_bytes_for_level_base = 1;
+    config.soft_pending_compaction_bytes_limit = 1;
+    config.hard_pending_compaction_bytes_limit = 1;
+    auto make_value = [](int i) { return std::string(200, 'v') + std::to_string(i); };
+    std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+    ASSERT_TRUE(db);
+    const int count = 3000;
+    for (int i = 0; i < count; ++i) {
+        ASSERT_TRUE(db->put("key" + std::to_string(i), make_value(i)).isSuccess());
+    }
+    WriteStallStats stats = db->getWriteStallStats();
+    EXPECT_GT(stats.stopped_writes, 0u);
+    EXPECT_GT(stats.stopped_micros, 0u);
+    for (int i = 0; i < count; ++i) {
+        std::shared_ptr<std::string> value = db->get("key" + std::to_string(i));
+        ASSERT_TRUE(value);
+        EXPECT_EQ(*value, make_value(i));
+    }
+    // 全部合并到最底层后不再有待合并的数据
+    ASSERT_TRUE(db->compactRange("", "").isSuccess());
+    ASSERT_TRUE(db->put("last", "value").isSuccess());
+    EXPECT_NE(db->getWriteStallStats().condition, WriteStallCondition::STOPPED);
+}
+
+TEST(DATA_BASE, writePipelineGrouping) {
+    // 第一个leader写日志时阻塞, 直到其他写入都已排队, 之后排队的写入合并成一组
+    const int follower_count = 7;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool released = false;
+    size_t log_calls = 0;
+    size_t max_group_size = 0;
+    WritePipeline pipeline([&](const std::vector<WriteBatch*>& batches, bool) {
+                               std::unique_lock<std::mutex> lock(mutex);
+                               if (log_calls++ == 0) {
+                                   cv.wait(lock, [&released] { return released; });
+                               }
+                               max_group_size = std::max(max_group_size, batches.size());
+                               return OperatorResult::success();
+                           },
+                           [](const WriteBatch&) { return OperatorResult::success(); });
+    auto write = [&pipeline](int i) {
+        WriteBatch batch;
+        batch.put("key" + std::to_string(i), "value");
+        EXPECT_TRUE(pipeline.write(&batch, false).isSuccess());
+    };
+    std::thread leader(write, 0);
+    while (true) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (log_calls > 0) {
+            break;
+        }
+    }
+    std::vector<std::thread> followers;
+    for (int i = 1; i <= follower_count; ++i) {
+        followers.emplace_back(write, i);
+    }
+    // 写入线程排队后只能等待leader, 等待一段时间让它们都进入队列
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        released = true;
+    }
+    cv.notify_all();
+    leader.join();
+    for (std::thread& follower : followers) {
+        follower.join();
+    }
+    EXPECT_EQ(pipeline.getLastSequence(), follower_count + 1);
+    EXPECT_LT(pipeline.getGroupCount(), follower_count + 1);
+    EXPECT_GT(max_group_size, 1);
+}
+
+TEST(DATA_BASE, writePipelineLogError) {
+    bool fail = false;
+    size_t memtable_writes = 0;
+    WritePipeline pipeline([&fail](const std::vector<WriteBatch*>&, bool) {
+                               return fail ? OperatorResult{EIO, "injected log error"} : OperatorResult::success();
+                           },
+                           [&memtable_writes](const WriteBatch&) {
+                               ++memtable_writes;
+                               return OperatorResult::success();
+                           });
+    WriteBatch first;
+    first.put("a", "1");
+    ASSERT_TRUE(pipeline.write(&first, false).isSuccess());
+    EXPECT_EQ(pipeline.getLastSequence(), 1);
+
+    // 日志写失败的组不写内存表, 也不发布它的序列号
+    fail = true;
+    WriteBatch failed;
+    failed.put("b", "2");
+    failed.put("c", "3");
+    EXPECT_FALSE(pipeline.write(&failed, false).isSuccess());
+    EXPECT_EQ(pipeline.getLastSequence(), 1);
+    EXPECT_EQ(memtable_writes, 1);
+
+    fail = false;
+    WriteBatch next;
+    next.put("d", "4");
+    ASSERT_TRUE(pipeline.write(&next, false).isSuccess());
+    EXPECT_EQ(next.getSequence(), 2);
+    EXPECT_EQ(pipeline.getLastSequence(), 2);
+}
+
+TEST(DATA_BASE, multiGetError) {
+    DataBaseConfig config = cleanDataBase("test-db-17");
+    config.l0_compaction_trigger = 100;
+    // 每次打开时回放日志, 旧值与新值分别写成两个第0层文件
+    for (const std::string value : {"old", "new"}) {
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+        ASSERT_TRUE(db->put("key", value).isSuccess());
+        ASSERT_TRUE(db->put("other", value).isSuccess());
+    }
+    std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+    ASSERT_TRUE(db);
+    std::vector<OperatorResult> statuses;
+    std::vector<std::shared_ptr<std::string>> values = db->multiGet({"key", "other"}, statuses);
+    ASSERT_TRUE(values[0] && values[1]);
+    EXPECT_EQ(*values[0], "new");
+    EXPECT_TRUE(statuses[0].isSuccess() && statuses[1].isSuccess());
+    db.reset();
+
+    // 破坏较新文件的data block
+    std::vector<std::string> children;
+    ASSERT_TRUE(listDir(config.db_path, children).isSuccess());
+    uint64_t newest = 0;
+    for (const std::string& child : children) {
+        uint64_t number = 0;
+        if (parseFileName(child, number) == FileType::TABLE_FILE) {
+            newest = std::max(newest, number);
+        }
+    }
+    const std::string filename = tableFileName(config.db_path, newest);
+    std::string content;
+    {
+        std::shared_ptr<SequentialFile> file = createSequentialFile(filename);
+        ASSERT_TRUE(file->read(1 << 20, content).isSuccess());
+    }
+    content[0] ^= 0x1;
+    {
+        std::shared_ptr<AppendOnlyFile> file = createAppendOnlyFile(filename);
+        ASSERT_TRUE(file->append(content).isSuccess());
+        ASSERT_TRUE(file->close().isSuccess());
+    }
+
+    // 出错的键不会从较旧的文件中读到被覆盖的旧值
+    db = createDataBaseInstance(config);
+    ASSERT_TRUE(db);
+    values = db->multiGet({"key", "other", "key"}, statuses);
+    ASSERT_EQ(statuses.size(), 3);
+    for (size_t i = 0; i < values.size(); ++i) {
+        EXPECT_FALSE(values[i]);
+        EXPECT_FALSE(statuses[i].isSuccess());
+    }
+    EXPECT_FALSE(db->multiGet({"key"})[0]);
+}
+
+TEST(DATA_BASE, iteratorHoldsBlobFiles) {
+    DataBaseConfig config = cleanDataBase("test-db-18");
+    config.blob_options.min_blob_size = 1024;
+    config.blob_options.blob_file_size = 32 << 10;
+    config.write_buffer_size = 16 << 10;
+    // 切换内存表时同步刷写
+    config.flush_threads = 0;
+    std::map<std::string, std::string> old_values;
+    {
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+        for (int i = 0; i < 40; ++i) {
+            const std::string key = "key" + std::to_string(100 + i);
+            old_values[key] = std::string(2000, 'a') + key;
+            ASSERT_TRUE(db->put(key, old_values[key]).isSuccess());
+        }
+    }
+    std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+    ASSERT_TRUE(db);
+    const std::set<uint64_t> old_files = listBlobFiles(config.db_path);
+    ASSERT_FALSE(old_files.empty());
+    std::unique_ptr<Iterator> it = db->newIterator(ReadOptions());
+
+    // 覆盖所有大值并写满内存表使它们刷写, 合并后旧的blob文件全部成为垃圾
+    for (const auto& entry : old_values) {
+        ASSERT_TRUE(db->put(entry.first, std::string(2000, 'b')).isSuccess());
+    }
+    for (int i = 0; i < 200; ++i) {
+        ASSERT_TRUE(db->put("small" + std::to_string(i), std::string(100, 'c')).isSuccess());
+    }
+    ASSERT_TRUE(db->compactRange("", "").isSuccess());
+
+    // 迭代器持有旧版本, 旧的blob文件仍然可读
+    auto expect = old_values.begin();
+    for (it->seekToFirst(); it->valid(); it->next(), ++expect) {
+        ASSERT_NE(expect, old_values.end());
+        EXPECT_EQ(it->key(), expect->first);
+        EXPECT_EQ(it->value(), expect->second);
+    }
+    EXPECT_EQ(expect, old_values.end());
+    EXPECT_TRUE(it->getStatus().isSuccess());
+
+    // 迭代器释放后, 下一次刷写之后删除旧的blob文件
+    it.reset();
+    for (int i = 0; i < 200; ++i) {
+        ASSERT_TRUE(db->put("small" + std::to_string(i), std::string(100, 'd')).isSuccess());
+    }
+    std::set<uint64_t> files = listBlobFiles(config.db_path);
+    for (uint64_t number : old_files) {
+        EXPECT_EQ(files.count(number), 0);
+    }
+}
+
+TEST(DATA_BASE, dropCoveredFilesAfterCrash) {
+    DataBaseConfig config = cleanDataBase("test-db-19");
+    config.l0_compaction_trigger = 100;
+    {
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+        for (int i = 0; i < 100; ++i) {
+            ASSERT_TRUE(db->put("key" + std::to_string(i), "value").isSuccess());
+        }
+    }
+    {
+        // 打开时数据写入SSTable, 范围删除标记只在内存表与没有落盘的日志中
+        std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+        ASSERT_TRUE(db);
+        ASSERT_TRUE(db->deleteRange("key", "kez").isSuccess());
+        ASSERT_TRUE(db->compactRange("", "").isSuccess());
+        EXPECT_FALSE(db->get("key10"));
+
+        // 模拟崩溃: 复制清单与SSTable, 丢失日志中没有落盘的范围删除标记
+        DataBaseConfig crash_config = cleanDataBase("test-db-19-crash");
+        ASSERT_TRUE(createDir(crash_config.db_path).isSuccess());
+        std::vector<std::string> children;
+        ASSERT_TRUE(listDir(config.db_path, children).isSuccess());
+        for (const std::string& child : children) {
+            uint64_t number = 0;
+            if (parseFileName(child, number) == FileType::LOG_FILE) {
+                continue;
+            }
+            std::string content;
+            std::shared_ptr<SequentialFile> reader = createSequentialFile(config.db_path + "/" + child);
+            ASSERT_TRUE(reader->read(16 << 20, content).isSuccess());
+            std::shared_ptr<AppendOnlyFile> writer = createAppendOnlyFile(crash_config.db_path + "/" + child);
+            ASSERT_TRUE(writer->append(content).isSuccess());
+            ASSERT_TRUE(writer->close().isSuccess());
+        }
+    }
+
+    // 没有成功删除的数据仍然存在
+    DataBaseConfig crash_config = config;
+    crash_config.db_path = "test-db-19-crash";
+    std::shared_ptr<DataBase> db = createDataBaseInstance(crash_config);
+    ASSERT_TRUE(db);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_TRUE(db->get("key" + std::to_string(i))) << i;
+    }
+}
+
+
+TEST(DATA_BASE, mergeDuringFlush) {
+    DataBaseConfig config = cleanDataBase("test-db-20");
+    config.merge_operator = std::make_shared<CounterMergeOperator>();
+    config.write_buffer_size = 4 << 10;
+    config.max_immutable_memtables = 4;
+    std::shared_ptr<DataBase> db = createDataBaseInstance(config);
+    ASSERT_TRUE(db);
+
+    // 写入线程不断写满内存表使刷写频繁应用, 读取线程看到的计数不能超过已经写入的操作数
+    const long long total = 500;
+    std::atomic<long long> merged(0);
+    std::atomic<bool> done(false);
+    std::atomic<int> errors(0);
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 2; ++i) {
+        readers.emplace_back([&] {
+            long long last = 0;
+            while (!done.load()) {
+                std::shared_ptr<std::string> value = db->get("counter");
+                long long count = value ? std::stoll(*value) : 0;
+                if (count < last || count > merged.load() + 1) {
+                    ++errors;
+                }
+                last = count;
+            }
+        });
+    }
+    for (long long i = 0; i < total; ++i) {
+        ASSERT_TRUE(db->merge("counter", "1").isSuccess());
+        merged.store(i + 1);
+        ASSERT_TRUE(db->put("filler" + std::to_string(i), std::string(200, 'f')).isSuccess());
+    }
+    done.store(true);
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(errors.load(), 0);
+    ASSERT_TRUE(db->get("counter"));
+    EXPECT_EQ(*db->get("counter"), std::to_string(total));
+}
+
+}
@@ -0,0 +1,122 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 14:22:40
+ * @LastEditTime: 2026-10-18 14:22:40
+ */
+#include <tomato_db/log_replayer.h>
+#include <tomato_db/log_writer.h>
+#include <tomato_db/write_batch.h>
+#include <gtest/gtest.h>
+
+#include <map>
+#include <random>
+
+namespace tomato {
+namespace log {
+
+const std::string REPLAY_FILENAME_1 = "test-replay-1";
+const std::string REPLAY_FILENAME_2 = "test-replay-2";
+
+TEST(WRITE_BATCH, iterate) {
+    WriteBatch batch;
+    batch.put("k1", "v1");
+    batch.del("k2");
+    batch.put("", "");
+    batch.setSequence(100);
+    EXPECT_EQ(batch.getCount(), 3);
+    EXPECT_EQ(batch.getSequence(), 100);
+
+    MemoryTable table;
+    EXPECT_TRUE(batch.insertInto(&table, false).isSuccess());
+    std::string value;
+    bool deleted = false;
+    EXPECT_TRUE(table.lookup("k1", value, deleted));
+    EXPECT_FALSE(deleted);
+    EXPECT_EQ(value, "v1");
+    EXPECT_TRUE(table.lookup("k2", value, deleted));
+    EXPECT_TRUE(deleted);
+
+    // 损坏的内容无法解码
+    WriteBatch broken;
+    std::string content = batch.getContent();
+    EXPECT_TRUE(broken.setContent(content.substr(0, content.size() - 3)).isSuccess());
+    MemoryTable broken_table;
+    EXPECT_FALSE(broken.insertInto(&broken_table, false).isSuccess());
+}
+
+TEST(LOG_REPLAYER, replay) {
+    // 最新的值, 空字符串表示被删除
+    std::map<std::string, std::string> expect;
+    uint64_t seq = 1;
+    std::default_random_engine generator;
+    std::uniform_int_distribution<int> distribution(0, 20000);
+    const std::vector<std::string> filenames = {REPLAY_FILENAME_1, REPLAY_FILENAME_2};
+    for (const std::string& filename : filenames) {
+        std::shared_ptr<AppendOnlyFile> file = createAppendOnlyFile(filename);
+        LogWriter writer(file.get());
+        for (int i = 0; i < 2000; ++i) {
+            WriteBatch batch;
+            batch.setSequence(seq);
+            if (i % 100 == 0) {
+                // 有序的大批次
+                int begin = distribution(generator);
+                for (int k = begin; k < begin + 200; ++k) {
+                    std::string key = "key" + std::to_string(100000 + k);
+                    batch.put(key, "bulk" + std::to_string(seq));
+                    expect[key] = "bulk" + std::to_string(seq);
+                }
+            } else {
+                for (int k = 0; k < 5; ++k) {
+                    std::string key = "key" + std::to_string(100000 + distribution(generator));
+                    if (k == 4) {
+                        batch.del(key);
+                        expect[key] = "";
+                    } else {
+                        batch.put(key, "value" + std::to_string(seq + static_cast<uint64_t>(k)));
+                        expect[key] = "value" + std::to_string(seq + static_cast<uint64_t>(k));
+                    }
+                }
+            }
+            seq += batch.getCount();
+            EXPECT_TRUE(writer.addRecord(batch.getContent()).isSuccess());
+        }
+    }
+
+    std::mutex mutex;
+    std::vector<std::shared_ptr<MemoryTable>> flushed;
+    ReplayOptions options;
+    options.write_buffer_size = 256 << 10;
+    LogReplayer replayer(options, [&mutex, &flushed](std::shared_ptr<MemoryTable> table) {
+        std::lock_guard<std::mutex> lock(mutex);
+        flushed.push_back(table);
+        return OperatorResult::success();
+    });
+    std::shared_ptr<MemoryTable> memtable = std::make_shared<MemoryTable>();
+    uint64_t max_sequence = 0;
+    EXPECT_TRUE(replayer.replay(filenames, memtable, max_sequence).isSuccess());
+    EXPECT_EQ(max_sequence, seq - 1);
+    EXPECT_EQ(replayer.getRecordCount(), 4000);
+    EXPECT_EQ(replayer.getDroppedBytes(), 0);
+    EXPECT_GT(flushed.size(), 1);
+
+    // 按新到旧的顺序查找每个内存表
+    flushed.push_back(memtable);
+    for (const auto& kv : expect) {
+        std::string value;
+        bool deleted = false;
+        bool found = false;
+        for (auto it = flushed.rbegin(); it != flushed.rend() && !found; ++it) {
+            found = (*it)->lookup(kv.first, value, deleted);
+        }
+        ASSERT_TRUE(found);
+        if (kv.second.empty()) {
+            EXPECT_TRUE(deleted);
+        } else {
+            EXPECT_FALSE(deleted);
+            EXPECT_EQ(value, kv.second);
+        }
+    }
+}
+
+}
+}
@@ -0,0 +1,133 @@
+/*
+ * @Author: Tomato
+ * @Date: 2026-10-18 11:05:12
+ * @LastEditTime: 2026-10-19 00:17:45
+ */
+#include <tomato_db/log_writer.h>
+#include <tomato_db/log_reader.h>
+#include <gtest/gtest.h>
+
+#include <random>
+
+namespace tomato {
+namespace log {
+
+const std::string LOG_FILENAME_1 = "test-log-1";
+const std::string LOG_FILENAME_2 = "test-log-2";
+const std::string LOG_FILENAME_3 = "test-log-3";
+
+/**
+ * @brief 设置fail后只写入一半数据并返回错误, 模拟部分写入
+ * 
+ */
+class FailingFile final : public AppendOnlyFile {
+public:
+    explicit FailingFile(std::shared_ptr<AppendOnlyFile> file): file_(std::move(file)), fail(false) {}
+
+    bool isOpen() const override { return file_->isOpen(); }
+    OperatorResult append(const std::string& data) override {
+        if (fail) {
+            file_->append(data.substr(0, data.size() / 2));
+            return {EIO, "injected append error"};
+        }
+        return file_->append(data);
+    }
+    OperatorResult flush() override { return file_->flush(); }
+    OperatorResult sync() override { return file_->sync(); }
+    OperatorResult close() override { return file_->close(); }
+    std::string getFileName() const override { return file_->getFileName(); }
+    std::string getDirName() const override { return file_->getDirName(); }
+private:
+    std::shared_ptr<AppendOnlyFile> file_;
+public:
+    bool fail;
+};
+
+std::vector<std::string> readAll(const std::string& filename, uint64_t* dropped_bytes = nullptr) {
+    std::shared_ptr<SequentialFile> file = createSequentialFile(filename);
+    LogReader reader(file.get());
+    std::vector<std::string> records;
+    std::string record;
+    while (reader.readRecord(record)) {
+        records.push_back(record);
+    }
+    if (dropped_bytes) {
+        *dropped_bytes = reader.getDroppedBytes();
+    }
+    return records;
+}
+
+TEST(LOG, writeAndRead) {
+    std::vector<std::string> expect;
+    std::default_random_engine generator;
+    std::uniform_int_distribution<size_t> distribution(0, 3 * BLOCK_SIZE);
+    {
+        std::shared_ptr<AppendOnlyFile> file = createAppendOnlyFile(LOG_FILENAME_1);
+        LogWriter writer(file.get());
+        // 包含空记录、跨多个block的大记录以及刚好填满block的记录
+        expect.push_back("");
+        expect.push_back(std::string(BLOCK_SIZE - 2 * HEADER_SIZE, 'a'));
+        expect.push_back("small");
+        for (int i = 0; i < 200; ++i) {
+            expect.push_back(std::string(distribution(generator), static_cast<char>('a' + i % 26)));
+        }
+        for (const std::string& record : expect) {
+            EXPECT_TRUE(writer.addRecord(record).isSuccess());
+        }
+        EXPECT_TRUE(writer.sync().isSuccess());
+    }
+    uint64_t dropped_bytes = 0;
+    EXPECT_EQ(readAll(LOG_FILENAME_1, &dropped_bytes), expect);
+    EXPECT_EQ(dropped_bytes, 0);
+}
+
+TEST(LOG, corruption) {
+    {
+        std::shared_ptr<AppendOnlyFile> file = createAppendOnlyFile(LOG_FILENAME_2);
+        LogWriter writer(file.get());
+        EXPECT_TRUE(writer.addRecord("first").isSuccess());
+        EXPECT_TRUE(writer.addRecord("second").isSuccess());
+        EXPECT_TRUE(writer.addRecord(std::string(BLOCK_SIZE, 'x')).isSuccess());
+        EXPECT_TRUE(writer.addRecord("last").isSuccess());
+    }
+
+    // 篡改第二条记录的数据, 同一个block内的剩余记录都会被丢弃
+    std::shared_ptr<SequentialFile> reader = createSequentialFile(LOG_FILENAME_2);
+    std::string content;
+    EXPECT_TRUE(reader->read(4 * BLOCK_SIZE, content).isSuccess());
+    EXPECT_TRUE(reader->isEof());
+    content[2 * HEADER_SIZE + 5 + 1] ^= 0x1;
+    {
+        std::shared_ptr<AppendOnlyFile> file = createAppendOnlyFile(LOG_FILENAME_2);
+        file->append(content);
+    }
+
+    uint64_t dropped_bytes = 0;
+    std::vector<std::string> records = readAll(LOG_FILENAME_2, &dropped_bytes);
+    ASSERT_EQ(records.size(), 2);
+    EXPECT_EQ(records[0], "first");
+    EXPECT_EQ(records[1], "last");
+    EXPECT_GT(dropped_bytes, 0);
+}
+
+TEST(LOG, appendError) {
+    {
+        FailingFile file(createAppendOnlyFile(LOG_FILENAME_3));
+        LogWriter writer(&file);
+        EXPECT_TRUE(writer.addRecord("first").isSuccess());
+        file.fail = true;
+        EXPECT_FALSE(writer.addRecord(std::string(BLOCK_SIZE / 2, 'x')).isSuccess());
+
+        // 部分写入之后文件末尾的内容不确定, 之后的写入都返回错误, 不会在错位的block中写入记录
+        file.fail = false;
+        EXPECT_FALSE(writer.addRecord("after").isSuccess());
+        EXPECT_FALSE(writer.sync().isSuccess());
+        file.close();
+    }
+    std::vector<std::string> records = readAll(LOG_FILENAME_3);
+    ASSERT_EQ(records.size(), 1);
+    EXPECT_EQ(records[0], "first");
+}
+
+}
+}
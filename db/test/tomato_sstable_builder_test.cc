@@ -1,13 +1,23 @@
 /*
  * @Author: Tomato
  * @Date: 2022-01-06 23:42:04
- * @LastEditTime: 2023-02-01 22:14:04
+ * @LastEditTime: 2026-10-19 00:20:08
  */
 #include <tomato_common/codec.h>
 #include <tomato_db/table_meta.h>
 #include <tomato_db/sstable_builder.h>
+#include <tomato_db/sstable.h>
+#include <tomato_db/block.h>
+#include <tomato_db/block_cache.h>
+#include <tomato_db/learned_index.h>
+#include <tomato_db/prefix_extractor.h>
+#include <tomato_db/compression.h>
+#include <tomato_db/compaction_iterator.h>
+#include <tomato_db/memory_table.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
+
 namespace tomato {
 
 TEST(SSTABLE, blockBuilderAdd) {
@@ -45,6 +55,1037 @@ TEST(SSTABLE, blockBuilderAdd) {
     EXPECT_EQ(content, expect);
 }
 
+TEST(SSTABLE, blockIterator) {
+    TableConfig config;
+    config.block_group_size = 3;
+    BlockBuilder builder(config);
+    for (int i = 10; i < 50; ++i) {
+        builder.add("key" + std::to_string(i), "value" + std::to_string(i));
+    }
+    EXPECT_EQ(builder.getBlockSize(), builder.getContent().size() + 15 * sizeof(uint32_t));
+    Block block(builder.finish());
+    ASSERT_TRUE(block.isValid());
+
+    Block::Iterator it(&block, compareBytewise);
+    int i = 10;
+    for (it.seekToFirst(); it.valid(); it.next(), ++i) {
+        EXPECT_EQ(it.key(), "key" + std::to_string(i));
+        EXPECT_EQ(it.value(), "value" + std::to_string(i));
+    }
+    EXPECT_EQ(i, 50);
+
+    it.seek("key25");
+    ASSERT_TRUE(it.valid());
+    EXPECT_EQ(it.key(), "key25");
+    it.seek("key255");
+    ASSERT_TRUE(it.valid());
+    EXPECT_EQ(it.key(), "key26");
+    it.seek("a");
+    ASSERT_TRUE(it.valid());
+    EXPECT_EQ(it.key(), "key10");
+    it.seek("key50");
+    EXPECT_FALSE(it.valid());
+    EXPECT_FALSE(it.isCorrupted());
+
+    Block bad("ab");
+    EXPECT_FALSE(bad.isValid());
+}
+
+TEST(SSTABLE, blockVarintTag) {
+    TableConfig config;
+    config.block_group_size = 4;
+    BlockBuilder fixed_builder(config);
+    BlockBuilder varint_builder(config);
+    varint_builder.enableVarintTag();
+    std::vector<std::string> keys;
+    for (int i = 0; i < 100; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%04d", i / 2);
+        // 每个用户键两个版本, 较旧的版本序列号为0
+        keys.push_back(encodeInternalKey(key, i % 2 == 0 ? static_cast<uint64_t>(1000 + i) : 0, ItemType::VALUE));
+        fixed_builder.add(keys.back(), "value" + std::to_string(i));
+        varint_builder.add(keys.back(), "value" + std::to_string(i));
+    }
+    Block fixed_block(fixed_builder.finish());
+    Block varint_block(varint_builder.finish());
+    ASSERT_TRUE(varint_block.isValid());
+    EXPECT_LT(varint_block.size() + 100 * 5, fixed_block.size());
+
+    Block::Iterator it(&varint_block, compareInternalKey);
+    size_t i = 0;
+    for (it.seekToFirst(); it.valid(); it.next(), ++i) {
+        ASSERT_LT(i, keys.size());
+        EXPECT_EQ(it.key(), keys[i]);
+        EXPECT_EQ(it.value(), "value" + std::to_string(i));
+    }
+    EXPECT_EQ(i, keys.size());
+    EXPECT_FALSE(it.isCorrupted());
+
+    it.seek(encodeLookupKey("key0010", MAX_SEQUENCE));
+    ASSERT_TRUE(it.valid());
+    EXPECT_EQ(it.key(), keys[20]);
+    it.seek(encodeLookupKey("key0010", 5));
+    ASSERT_TRUE(it.valid());
+    EXPECT_EQ(it.key(), keys[21]);
+    it.prev();
+    ASSERT_TRUE(it.valid());
+    EXPECT_EQ(it.key(), keys[20]);
+    it.seekToLast();
+    ASSERT_TRUE(it.valid());
+    EXPECT_EQ(it.key(), keys.back());
+}
+
+TEST(SSTABLE, buildAndRead) {
+    const std::string filename = "test-sstable.sst";
+    TableConfig config;
+    config.block_size_threshold = 256;
+    {
+        std::shared_ptr<AppendOnlyFile> file = createAppendOnlyFile(filename);
+        SSTableBuilder builder(config, file.get());
+        // key0000 ~ key0999, 每个偶数键还有一个更旧的版本, key0500的最新版本是删除标记
+        for (int i = 0; i < 1000; ++i) {
+            char key[16];
+            snprintf(key, sizeof(key), "key%04d", i);
+            if (i == 500) {
+                builder.add(encodeInternalKey(key, 3000, ItemType::DELETION), "");
+            } else {
+                builder.add(encodeInternalKey(key, static_cast<uint64_t>(i + 1000), ItemType::VALUE), 
+                            "new" + std::to_string(i));
+            }
+            if (i % 2 == 0) {
+                builder.add(encodeInternalKey(key, static_cast<uint64_t>(i), ItemType::VALUE), 
+                            "old" + std::to_string(i));
+            }
+        }
+        ASSERT_TRUE(builder.finish().isSuccess());
+        EXPECT_EQ(builder.getEntryCount(), 1500u);
+        ASSERT_TRUE(file->close().isSuccess());
+    }
+
+    std::shared_ptr<SSTable> table;
+    std::shared_ptr<RandomAccessFile> file = createRandomAccessFile(filename);
+    std::string content;
+    ASSERT_TRUE(createSequentialFile(filename)->read(1 << 20, content).isSuccess());
+    ASSERT_TRUE(SSTable::open(file, content.size(), table).isSuccess());
+
+    SSTable::LookupResult result;
+    ASSERT_TRUE(table->get(encodeLookupKey("key0042", MAX_SEQUENCE), result).isSuccess());
+    EXPECT_TRUE(result.found);
+    EXPECT_EQ(result.value, "new42");
+    result = SSTable::LookupResult();
+    ASSERT_TRUE(table->get(encodeLookupKey("key0042", 1000), result).isSuccess());
+    EXPECT_TRUE(result.found);
+    EXPECT_EQ(result.value, "old42");
+    result = SSTable::LookupResult();
+    ASSERT_TRUE(table->get(encodeLookupKey("key0043", 1000), result).isSuccess());
+    EXPECT_FALSE(result.found);
+    result = SSTable::LookupResult();
+    ASSERT_TRUE(table->get(encodeLookupKey("key0500", MAX_SEQUENCE), result).isSuccess());
+    EXPECT_TRUE(result.found);
+    EXPECT_TRUE(result.deleted);
+    result = SSTable::LookupResult();
+    ASSERT_TRUE(table->get(encodeLookupKey("key9999", MAX_SEQUENCE), result).isSuccess());
+    EXPECT_FALSE(result.found);
+
+    // 批量查找跨越多个data block, 并行与串行结果一致
+    std::vector<std::string> lookup_keys;
+    for (int i = 0; i < 1100; i += 7) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%04d", i);
+        lookup_keys.push_back(encodeLookupKey(key, MAX_SEQUENCE));
+    }
+    ThreadPool pool(4);
+    std::vector<SSTable::LookupResult> parallel_results(lookup_keys.size());
+    std::vector<SSTable::LookupResult> serial_results(lookup_keys.size());
+    ASSERT_TRUE(table->multiGet(lookup_keys, parallel_results, &pool).isSuccess());
+    ASSERT_TRUE(table->multiGet(lookup_keys, serial_results, nullptr).isSuccess());
+    for (size_t i = 0; i < lookup_keys.size(); ++i) {
+        const int number = static_cast<int>(i) * 7;
+        EXPECT_EQ(parallel_results[i].found, number < 1000);
+        EXPECT_EQ(parallel_results[i].found, serial_results[i].found);
+        EXPECT_EQ(parallel_results[i].value, serial_results[i].value);
+        if (number < 1000) {
+            EXPECT_EQ(parallel_results[i].value, "new" + std::to_string(number));
+        }
+    }
+
+    SSTable::Iterator it(table);
+    size_t count = 0;
+    for (it.seekToFirst(); it.valid(); it.next()) {
+        ++count;
+    }
+    EXPECT_EQ(count, 1500u);
+    EXPECT_TRUE(it.getStatus().isSuccess());
+    for (it.seekToLast(); it.valid(); it.prev()) {
+        --count;
+    }
+    EXPECT_EQ(count, 0u);
+    it.seek(encodeLookupKey("key0998", MAX_SEQUENCE));
+    ASSERT_TRUE(it.valid());
+    EXPECT_EQ(extractUserKey(it.key()), "key0998");
+    EXPECT_EQ(it.value(), "new998");
+    removeFile(filename);
+}
+
+TEST(SSTABLE, bloomFilter) {
+    std::vector<std::string> keys;
+    for (int i = 0; i < 1000; ++i) {
+        keys.push_back("key" + std::to_string(i));
+    }
+    std::string filter;
+    BloomFilter::create(keys, 10, filter);
+    for (const std::string& key : keys) {
+        EXPECT_TRUE(BloomFilter::mayMatch(key, filter.data(), filter.size()));
+    }
+    // 每个键10位时误判率约为1%
+    int false_positives = 0;
+    for (int i = 0; i < 10000; ++i) {
+        if (BloomFilter::mayMatch("absent" + std::to_string(i), filter.data(), filter.size())) {
+            ++false_positives;
+        }
+    }
+    EXPECT_LT(false_positives, 300);
+
+    std::string empty_filter;
+    BloomFilter::create(std::vector<std::string>(), 10, empty_filter);
+    EXPECT_FALSE(BloomFilter::mayMatch("key", empty_filter.data(), empty_filter.size()));
+}
+
+TEST(SSTABLE, prefixFilter) {
+    const std::string filename = "test-sstable-prefix.sst";
+    TableConfig config;
+    config.block_size_threshold = 256;
+    config.prefix_extractor = newDelimitedPrefixExtractor(':', 1);
+    {
+        // 偶数前缀p00: ~ p98:, 每个前缀40个键; 没有分隔符的键不在前缀过滤器中
+        std::shared_ptr<AppendOnlyFile> file = createAppendOnlyFile(filename);
+        SSTableBuilder builder(config, file.get());
+        for (int p = 0; p < 100; p += 2) {
+            for (int i = 0; i < 40; ++i) {
+                char key[16];
+                snprintf(key, sizeof(key), "p%02d:%04d", p, i);
+                builder.add(encodeInternalKey(key, 1, ItemType::VALUE), "value");
+            }
+        }
+        builder.add(encodeInternalKey("zzz", 1, ItemType::VALUE), "value");
+        ASSERT_TRUE(builder.finish().isSuccess());
+        ASSERT_TRUE(file->close().isSuccess());
+    }
+
+    std::shared_ptr<SSTable> table;
+    std::string content;
+    ASSERT_TRUE(createSequentialFile(filename)->read(1 << 20, content).isSuccess());
+    ASSERT_TRUE(SSTable::open(createRandomAccessFile(filename), content.size(), table).isSuccess());
+
+    const PrefixExtractor& extractor = *config.prefix_extractor;
+    int table_false_positives = 0;
+    int excluded_seeks = 0;
+    for (int p = 0; p < 100; ++p) {
+        char prefix[8];
+        snprintf(prefix, sizeof(prefix), "p%02d:", p);
+        TableIteratorOptions options;
+        options.prefix_extractor = &extractor;
+        options.prefix = prefix;
+        SSTable::Iterator it(table, options);
+        it.seek(encodeLookupKey(prefix, MAX_SEQUENCE));
+        if (p % 2 == 0) {
+            EXPECT_TRUE(table->prefixMayMatch(extractor, prefix));
+            ASSERT_TRUE(it.valid());
+            EXPECT_EQ(extractUserKey(it.key()), std::string(prefix) + "0000");
+            continue;
+        }
+        if (table->prefixMayMatch(extractor, prefix)) {
+            ++table_false_positives;
+        }
+        EXPECT_TRUE(it.getStatus().isSuccess());
+        if (it.valid()) {
+            // 误判时正常定位到下一个前缀的第一个键
+            EXPECT_GT(extractUserKey(it.key()), prefix);
+            continue;
+        }
+        // data block被排除后, 反向遍历从目标之前的最后一个键开始
+        ++excluded_seeks;
+        it.seekToLast();
+        ASSERT_TRUE(it.valid());
+        char last_key[16];
+        snprintf(last_key, sizeof(last_key), "p%02d:0039", p - 1);
+        EXPECT_EQ(extractUserKey(it.key()), last_key);
+    }
+    EXPECT_LT(table_false_positives, 5);
+    EXPECT_GT(excluded_seeks, 45);
+
+    // 名字不同的前缀提取器不使用过滤器
+    std::shared_ptr<const PrefixExtractor> other = newFixedPrefixExtractor(4);
+    EXPECT_TRUE(table->prefixMayMatch(*other, "p01:"));
+    TableIteratorOptions options;
+    options.prefix_extractor = other.get();
+    options.prefix = "p01:";
+    SSTable::Iterator it(table, options);
+    it.seek(encodeLookupKey("p01:", MAX_SEQUENCE));
+    ASSERT_TRUE(it.valid());
+    EXPECT_EQ(extractUserKey(it.key()), "p02:0000");
+    removeFile(filename);
+}
+
+TEST(SSTABLE, rangeFilter) {
+    const std::string filename = "test-sstable-range.sst";
+    TableConfig config;
+    config.block_size_threshold = 256;
+    config.range_filter = true;
+    // 稀疏的键簇c10: ~ c90:, 每簇50个键, 每个键两个版本
+    std::vector<std::string> user_keys;
+    {
+        std::shared_ptr<AppendOnlyFile> file = createAppendOnlyFile(filename);
+        SSTableBuilder builder(config, file.get());
+        for (int c = 10; c < 100; c += 10) {
+            for (int i = 0; i < 50; ++i) {
+                char key[16];
+                snprintf(key, sizeof(key), "c%02d:%03d", c, i);
+                user_keys.push_back(key);
+                builder.add(encodeInternalKey(key, 2, ItemType::VALUE), "new");
+                builder.add(encodeInternalKey(key, 1, ItemType::VALUE), "old");
+            }
+        }
+        ASSERT_TRUE(builder.finish().isSuccess());
+        ASSERT_TRUE(file->close().isSuccess());
+    }
+
+    std::shared_ptr<SSTable> table;
+    std::string content;
+    ASSERT_TRUE(createSequentialFile(filename)->read(1 << 20, content).isSuccess());
+    ASSERT_TRUE(SSTable::open(createRandomAccessFile(filename), content.size(), table).isSuccess());
+
+    // 不会漏掉范围内存在的键
+    for (int begin = 0; begin < 1000; begin += 7) {
+        for (int width = 1; width < 100; width += 13) {
+            char begin_key[16];
+            char end_key[16];
+            snprintf(begin_key, sizeof(begin_key), "c%02d:%03d", begin / 10, begin % 10 * 10);
+            snprintf(end_key, sizeof(end_key), "c%02d:%03d", (begin + width) / 10, (begin + width) % 10 * 10);
+            auto iter = std::lower_bound(user_keys.begin(), user_keys.end(), std::string(begin_key));
+            if (iter != user_keys.end() && *iter < end_key) {
+                EXPECT_TRUE(table->rangeMayMatch(begin_key, end_key)) << begin_key << " " << end_key;
+            }
+        }
+    }
+    EXPECT_TRUE(table->rangeMayMatch("c10:049", "c10:050"));
+    EXPECT_TRUE(table->rangeMayMatch("c85:", ""));
+    EXPECT_TRUE(table->rangeMayMatch("", "c10:001"));
+
+    // 键簇之间的空隙
+    EXPECT_FALSE(table->rangeMayMatch("", "c10:"));
+    EXPECT_FALSE(table->rangeMayMatch("c15:", "c20:"));
+    EXPECT_FALSE(table->rangeMayMatch("c10:050", "c10:099"));
+    EXPECT_FALSE(table->rangeMayMatch("c95:", ""));
+
+    // 范围内没有键时不读取data block, 反向遍历从目标之前的最后一个键开始
+    TableIteratorOptions options;
+    options.upper_bound = "c20:";
+    SSTable::Iterator it(table, options);
+    it.seek(encodeLookupKey("c15:", MAX_SEQUENCE));
+    EXPECT_FALSE(it.valid());
+    EXPECT_TRUE(it.getStatus().isSuccess());
+    it.seekToLast();
+    ASSERT_TRUE(it.valid());
+    EXPECT_EQ(extractUserKey(it.key()), "c10:049");
+    it.seek(encodeLookupKey("c10:040", MAX_SEQUENCE));
+    ASSERT_TRUE(it.valid());
+    EXPECT_EQ(extractUserKey(it.key()), "c10:040");
+    removeFile(filename);
+}
+
+/**
+ * @brief 写入key0000 ~ key1999, 值有大量重复内容, 返回文件大小
+ * 
+ */
+static uint64_t buildCompressibleTable(const std::string& filename, CompressionType compression) {
+    TableConfig config;
+    config.block_size_threshold = 1024;
+    config.compression = compression;
+    std::shared_ptr<AppendOnlyFile> file = createAppendOnlyFile(filename);
+    SSTableBuilder builder(config, file.get());
+    for (int i = 0; i < 2000; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%04d", i);
+        builder.add(encodeInternalKey(key, 1, ItemType::VALUE), 
+                    "{\"id\": " + std::to_string(i) + ", \"name\": \"tomato\", \"tags\": [\"red\", \"round\"]}");
+    }
+    EXPECT_TRUE(builder.finish().isSuccess());
+    EXPECT_TRUE(file->close().isSuccess());
+    return builder.getFileSize();
+}
+
+TEST(SSTABLE, compression) {
+    const std::string raw_filename = "test-sstable-raw.sst";
+    const std::string filename = "test-sstable-lz.sst";
+    const uint64_t raw_size = buildCompressibleTable(raw_filename, CompressionType::NO_COMPRESSION);
+    const uint64_t size = buildCompressibleTable(filename, CompressionType::LZ_COMPRESSION);
+    EXPECT_LT(size * 2, raw_size);
+    if (!isCompressionSupported(CompressionType::ZSTD_COMPRESSION)) {
+        // 不可用的压缩方式退回内置的LZ压缩
+        EXPECT_EQ(buildCompressibleTable(filename, CompressionType::ZSTD_COMPRESSION), size);
+    }
+
+    BlockCache cache(1 << 20);
+    for (const std::string& name : {raw_filename, filename}) {
+        std::shared_ptr<SSTable> table;
+        std::string content;
+        ASSERT_TRUE(createSequentialFile(name)->read(1 << 20, content).isSuccess());
+        ASSERT_TRUE(SSTable::open(createRandomAccessFile(name), content.size(), table, &cache).isSuccess());
+        SSTable::Iterator it(table);
+        int i = 0;
+        for (it.seekToFirst(); it.valid(); it.next(), ++i) {
+            char key[16];
+            snprintf(key, sizeof(key), "key%04d", i);
+            EXPECT_EQ(extractUserKey(it.key()), key);
+        }
+        EXPECT_TRUE(it.getStatus().isSuccess());
+        EXPECT_EQ(i, 2000);
+    }
+
+    // 所有data block都已缓存, 再次查找不会增加缓存
+    const size_t usage = cache.getUsage();
+    EXPECT_GT(usage, 0u);
+    {
+        std::shared_ptr<SSTable> table;
+        ASSERT_TRUE(SSTable::open(createRandomAccessFile(filename), size, table).isSuccess());
+        SSTable::LookupResult result;
+        ASSERT_TRUE(table->get(encodeLookupKey("key1234", MAX_SEQUENCE), result).isSuccess());
+        EXPECT_TRUE(result.found);
+        EXPECT_EQ(result.value, "{\"id\": 1234, \"name\": \"tomato\", \"tags\": [\"red\", \"round\"]}");
+    }
+
+    // 篡改第一个data block中的一个字节, crc校验失败
+    std::string content;
+    ASSERT_TRUE(createSequentialFile(filename)->read(1 << 20, content).isSuccess());
+    content[10] = static_cast<char>(content[10] ^ 0x1);
+    {
+        std::shared_ptr<AppendOnlyFile> file = createAppendOnlyFile(filename + ".bad");
+        ASSERT_TRUE(file->append(content).isSuccess());
+        ASSERT_TRUE(file->close().isSuccess());
+    }
+    std::shared_ptr<SSTable> table;
+    ASSERT_TRUE(SSTable::open(createRandomAccessFile(filename + ".bad"), content.size(), table).isSuccess());
+    SSTable::LookupResult result;
+    EXPECT_FALSE(table->get(encodeLookupKey("key0000", MAX_SEQUENCE), result).isSuccess());
+    ASSERT_TRUE(table->get(encodeLookupKey("key1999", MAX_SEQUENCE), result).isSuccess());
+    EXPECT_TRUE(result.found);
+
+    removeFile(raw_filename);
+    removeFile(filename);
+    removeFile(filename + ".bad");
+}
+
+TEST(SSTABLE, blockCacheEviction) {
+    // 每个分片只能容纳一个block
+    BlockCache cache(16 * 300);
+    for (int i = 0; i < 100; ++i) {
+        BlockBuilder builder((TableConfig()));
+        builder.add("key" + std::to_string(i), std::string(200, 'v'));
+        cache.insert(1, static_cast<uint64_t>(i), std::make_shared<Block>(builder.finish()));
+        EXPECT_LE(cache.getUsage(), 16u * 300);
+    }
+    EXPECT_GT(cache.getUsage(), 0u);
+    // 最近插入的block仍在缓存中, 最早插入的已被淘汰
+    std::shared_ptr<Block> block = cache.lookup(1, 99);
+    ASSERT_TRUE(block);
+    EXPECT_TRUE(block->isValid());
+    EXPECT_FALSE(cache.lookup(1, 0));
+    EXPECT_FALSE(cache.lookup(2, 99));
+}
+
+TEST(SSTABLE, compressionDictionary) {
+    const std::string filename = "test-sstable-dict.sst";
+    TableConfig config;
+    config.block_size_threshold = 512;
+    config.prefix_extractor = newFixedPrefixExtractor(5);
+    std::vector<uint64_t> sizes;
+    for (uint64_t dict_bytes : {0, 8192}) {
+        config.compression_dict_bytes = dict_bytes;
+        // 一半的data block作为训练样本, 训练后写入的block同样使用字典
+        config.compression_dict_sample_bytes = 32 << 10;
+        {
+            std::shared_ptr<AppendOnlyFile> file = createAppendOnlyFile(filename);
+            SSTableBuilder builder(config, file.get());
+            for (int i = 0; i < 1000; ++i) {
+                char key[16];
+                snprintf(key, sizeof(key), "k%03d:%04d", i / 10, i);
+                builder.add(encodeInternalKey(key, 1, ItemType::VALUE), 
+                            "{\"id\": " + std::to_string(i) + ", \"status\": \"active\", \"region\": \"eu-west\"}");
+            }
+            ASSERT_TRUE(builder.finish().isSuccess());
+            ASSERT_TRUE(file->close().isSuccess());
+            sizes.push_back(builder.getFileSize());
+        }
+
+        std::shared_ptr<SSTable> table;
+        ASSERT_TRUE(SSTable::open(createRandomAccessFile(filename), sizes.back(), table).isSuccess());
+        SSTable::Iterator it(table);
+        int count = 0;
+        for (it.seekToFirst(); it.valid(); it.next()) {
+            ++count;
+        }
+        EXPECT_TRUE(it.getStatus().isSuccess());
+        EXPECT_EQ(count, 1000);
+        SSTable::LookupResult result;
+        ASSERT_TRUE(table->get(encodeLookupKey("k099:0999", MAX_SEQUENCE), result).isSuccess());
+        EXPECT_TRUE(result.found);
+        EXPECT_EQ(result.value, "{\"id\": 999, \"status\": \"active\", \"region\": \"eu-west\"}");
+
+        // 缓存的data block中的前缀也在过滤器中
+        for (int i = 0; i < 100; ++i) {
+            char prefix[8];
+            snprintf(prefix, sizeof(prefix), "k%03d:", i);
+            EXPECT_TRUE(table->prefixMayMatch(*config.prefix_extractor, prefix)) << prefix;
+        }
+        removeFile(filename);
+    }
+    EXPECT_LT(sizes[1], sizes[0]);
+}
+
+TEST(SSTABLE, blockHashIndex) {
+    TableConfig config;
+    config.block_group_size = 4;
+    BlockBuilder builder(config);
+    builder.enableHashIndex(0.75);
+    // 偶数键有两个版本, key0040的版本跨越两个组
+    std::vector<std::string> keys;
+    for (int i = 0; i < 100; i += 2) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%04d", i);
+        const int versions = i == 40 ? 6 : (i % 4 == 0 ? 2 : 1);
+        for (int v = versions; v > 0; --v) {
+            keys.push_back(encodeInternalKey(key, static_cast<uint64_t>(v), ItemType::VALUE));
+            builder.add(keys.back(), std::to_string(i) + "-" + std::to_string(v));
+        }
+    }
+    const size_t estimated_size = builder.getBlockSize();
+    Block block(builder.finish());
+    ASSERT_TRUE(block.isValid());
+    EXPECT_EQ(estimated_size, block.size());
+
+    Block::Iterator it(&block, compareInternalKey);
+    Block::Iterator expected(&block, compareInternalKey);
+    int skipped = 0;
+    for (int i = 0; i < 101; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%04d", i);
+        for (uint64_t seq : {MAX_SEQUENCE, static_cast<uint64_t>(1), static_cast<uint64_t>(4)}) {
+            const std::string target = encodeLookupKey(key, seq);
+            expected.seek(target);
+            if (!it.seekForGet(target)) {
+                // 只有不存在的用户键可以被哈希索引排除
+                EXPECT_FALSE(it.valid());
+                EXPECT_TRUE(!expected.valid() || extractUserKey(expected.key()) != key) << key;
+                ++skipped;
+                continue;
+            }
+            if (expected.valid() && extractUserKey(expected.key()) == key) {
+                ASSERT_TRUE(it.valid()) << key;
+                EXPECT_EQ(it.key(), expected.key()) << key;
+                EXPECT_EQ(it.value(), expected.value()) << key;
+            } else {
+                // 哈希冲突时停在其他用户键上
+                EXPECT_TRUE(!it.valid() || extractUserKey(it.key()) != key) << key;
+            }
+        }
+    }
+    EXPECT_GT(skipped, 0);
+    EXPECT_FALSE(it.isCorrupted());
+
+    // 普通遍历不受哈希索引影响
+    size_t count = 0;
+    for (it.seekToFirst(); it.valid(); it.next(), ++count) {
+        EXPECT_EQ(it.key(), keys[count]);
+    }
+    EXPECT_EQ(count, keys.size());
+    it.seekToLast();
+    ASSERT_TRUE(it.valid());
+    EXPECT_EQ(it.key(), keys.back());
+}
+
+TEST(SSTABLE, tableWithBlockHashIndex) {
+    const std::string filename = "test-sstable-hash.sst";
+    TableConfig config;
+    config.block_size_threshold = 512;
+    config.data_block_hash_ratio = 0.75;
+    uint64_t file_size = 0;
+    {
+        std::shared_ptr<AppendOnlyFile> file = createAppendOnlyFile(filename);
+        SSTableBuilder builder(config, file.get());
+        for (int i = 0; i < 1000; i += 2) {
+            char key[16];
+            snprintf(key, sizeof(key), "key%04d", i);
+            builder.add(encodeInternalKey(key, 10, ItemType::VALUE), "new" + std::to_string(i));
+            builder.add(encodeInternalKey(key, 5, ItemType::VALUE), "old" + std::to_string(i));
+        }
+        ASSERT_TRUE(builder.finish().isSuccess());
+        ASSERT_TRUE(file->close().isSuccess());
+        file_size = builder.getFileSize();
+    }
+    std::shared_ptr<SSTable> table;
+    ASSERT_TRUE(SSTable::open(createRandomAccessFile(filename), file_size, table).isSuccess());
+    for (int i = 0; i < 1000; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%04d", i);
+        SSTable::LookupResult result;
+        ASSERT_TRUE(table->get(encodeLookupKey(key, MAX_SEQUENCE), result).isSuccess());
+        EXPECT_EQ(result.found, i % 2 == 0) << key;
+        if (result.found) {
+            EXPECT_EQ(result.value, "new" + std::to_string(i));
+        }
+        result = SSTable::LookupResult();
+        ASSERT_TRUE(table->get(encodeLookupKey(key, 7), result).isSuccess());
+        if (i % 2 == 0) {
+            EXPECT_EQ(result.value, "old" + std::to_string(i));
+        }
+    }
+    removeFile(filename);
+}
+
+TEST(SSTABLE, partitionedIndex) {
+    const std::string filename = "test-sstable-partitioned.sst";
+    TableConfig config;
+    config.block_size_threshold = 256;
+    config.partition_index = true;
+    config.index_partition_size = 256;
+    config.prefix_extractor = newDelimitedPrefixExtractor(':', 1);
+    uint64_t file_size = 0;
+    {
+        // 偶数前缀p000: ~ p398:, 每个前缀20个键
+        std::shared_ptr<AppendOnlyFile> file = createAppendOnlyFile(filename);
+        SSTableBuilder builder(config, file.get());
+        for (int p = 0; p < 400; p += 2) {
+            for (int i = 0; i < 20; ++i) {
+                char key[32];
+                snprintf(key, sizeof(key), "p%03d:%04d", p, i);
+                builder.add(encodeInternalKey(key, 1, ItemType::VALUE), "value" + std::to_string(i));
+            }
+        }
+        ASSERT_TRUE(builder.finish().isSuccess());
+        ASSERT_TRUE(file->close().isSuccess());
+        file_size = builder.getFileSize();
+    }
+
+    // 打开时只读取顶层index, 点查只缓存用到的分区与data block
+    BlockCache cache(16 << 20);
+    std::shared_ptr<SSTable> table;
+    ASSERT_TRUE(SSTable::open(createRandomAccessFile(filename), file_size, table, &cache).isSuccess());
+    EXPECT_EQ(cache.getUsage(), 0u);
+    SSTable::LookupResult result;
+    ASSERT_TRUE(table->get(encodeLookupKey("p200:0007", MAX_SEQUENCE), result).isSuccess());
+    EXPECT_TRUE(result.found);
+    EXPECT_EQ(result.value, "value7");
+    const size_t lookup_usage = cache.getUsage();
+    EXPECT_GT(lookup_usage, 0u);
+    EXPECT_LT(lookup_usage * 20, file_size);
+    result = SSTable::LookupResult();
+    ASSERT_TRUE(table->get(encodeLookupKey("p201:0007", MAX_SEQUENCE), result).isSuccess());
+    EXPECT_FALSE(result.found);
+
+    SSTable::Iterator it(table);
+    int count = 0;
+    for (it.seekToFirst(); it.valid(); it.next(), ++count) {
+        char key[32];
+        snprintf(key, sizeof(key), "p%03d:%04d", count / 20 * 2, count % 20);
+        ASSERT_EQ(extractUserKey(it.key()), key);
+    }
+    EXPECT_TRUE(it.getStatus().isSuccess());
+    EXPECT_EQ(count, 4000);
+    for (it.seekToLast(); it.valid(); it.prev()) {
+        --count;
+    }
+    EXPECT_TRUE(it.getStatus().isSuccess());
+    EXPECT_EQ(count, 0);
+    EXPECT_GT(cache.getUsage(), lookup_usage * 10);
+
+    // 过滤器与index一起分区
+    const PrefixExtractor& extractor = *config.prefix_extractor;
+    int false_positives = 0;
+    for (int p = 0; p < 400; ++p) {
+        char prefix[8];
+        snprintf(prefix, sizeof(prefix), "p%03d:", p);
+        TableIteratorOptions options;
+        options.prefix_extractor = &extractor;
+        options.prefix = prefix;
+        SSTable::Iterator prefix_it(table, options);
+        prefix_it.seek(encodeLookupKey(prefix, MAX_SEQUENCE));
+        EXPECT_TRUE(prefix_it.getStatus().isSuccess());
+        if (p % 2 == 0) {
+            EXPECT_TRUE(table->prefixMayMatch(extractor, prefix)) << prefix;
+            ASSERT_TRUE(prefix_it.valid());
+            EXPECT_EQ(extractUserKey(prefix_it.key()), std::string(prefix) + "0000");
+        } else if (table->prefixMayMatch(extractor, prefix)) {
+            ++false_positives;
+        }
+    }
+    EXPECT_LT(false_positives, 20);
+    removeFile(filename);
+}
+
+TEST(SSTABLE, learnedIndex) {
+    // 间隔先均匀后按平方增长, 需要多段拟合
+    std::vector<std::string> keys;
+    for (uint64_t i = 0; i < 2000; ++i) {
+        const uint64_t value = i < 1000 ? i * 10 : 10000 + (i - 1000) * (i - 1000);
+        char key[32];
+        snprintf(key, sizeof(key), "user%012llu", static_cast<unsigned long long>(value));
+        keys.push_back(key);
+    }
+    LearnedIndexBuilder builder(2);
+    for (const std::string& key : keys) {
+        builder.addBlock(key);
+    }
+    LearnedIndexReader reader;
+    ASSERT_TRUE(reader.init(builder.finish()));
+
+    // 每个block的最后一个键, 以及与前一个键之间的键, 都落在预测的范围内
+    for (size_t i = 0; i < keys.size(); ++i) {
+        std::vector<std::string> targets(1, keys[i]);
+        if (i > 0) {
+            targets.push_back(keys[i - 1] + "5");
+        }
+        for (const std::string& target : targets) {
+            uint64_t first = 0;
+            uint64_t last = 0;
+            reader.predict(target, first, last);
+            EXPECT_LE(first, i) << target;
+            EXPECT_GE(last, i) << target;
+            EXPECT_LE(last - first, 6u) << target;
+        }
+    }
+    uint64_t first = 0;
+    uint64_t last = 0;
+    reader.predict("a", first, last);
+    EXPECT_EQ(first, 0u);
+    reader.predict("z", first, last);
+    EXPECT_EQ(last, keys.size() - 1);
+    EXPECT_FALSE(LearnedIndexReader().init("bad"));
+
+    const std::string filename = "test-sstable-learned.sst";
+    TableConfig config;
+    config.block_size_threshold = 256;
+    config.learned_index = true;
+    uint64_t file_size = 0;
+    {
+        std::shared_ptr<AppendOnlyFile> file = createAppendOnlyFile(filename);
+        SSTableBuilder table_builder(config, file.get());
+        for (int i = 0; i < 10000; i += 2) {
+            char key[16];
+            snprintf(key, sizeof(key), "id%08d", i);
+            table_builder.add(encodeInternalKey(key, 1, ItemType::VALUE), std::to_string(i));
+        }
+        ASSERT_TRUE(table_builder.finish().isSuccess());
+        ASSERT_TRUE(file->close().isSuccess());
+        file_size = table_builder.getFileSize();
+    }
+    std::shared_ptr<SSTable> table;
+    ASSERT_TRUE(SSTable::open(createRandomAccessFile(filename), file_size, table).isSuccess());
+    for (int i = 0; i < 10000; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "id%08d", i);
+        SSTable::LookupResult result;
+        ASSERT_TRUE(table->get(encodeLookupKey(key, MAX_SEQUENCE), result).isSuccess());
+        ASSERT_EQ(result.found, i % 2 == 0) << key;
+        if (result.found) {
+            EXPECT_EQ(result.value, std::to_string(i));
+        }
+    }
+    SSTable::Iterator it(table);
+    it.seek(encodeLookupKey("id00004321", MAX_SEQUENCE));
+    ASSERT_TRUE(it.valid());
+    EXPECT_EQ(extractUserKey(it.key()), "id00004322");
+    it.seek(encodeLookupKey("a", MAX_SEQUENCE));
+    ASSERT_TRUE(it.valid());
+    EXPECT_EQ(extractUserKey(it.key()), "id00000000");
+    it.seek(encodeLookupKey("id00009999", MAX_SEQUENCE));
+    EXPECT_FALSE(it.valid());
+    EXPECT_TRUE(it.getStatus().isSuccess());
+    removeFile(filename);
+}
+
+/**
+ * @brief 记录读取次数的文件, 检查点查是否直接使用文件映射
+ * 
+ */
+class CountingRandomAccessFile final : public RandomAccessFile {
+public:
+    explicit CountingRandomAccessFile(std::shared_ptr<RandomAccessFile> file) : file_(std::move(file)), reads(0) {}
+
+    OperatorResult read(uint64_t offset, size_t size, std::string& output) override {
+        ++reads;
+        return file_->read(offset, size, output);
+    }
+
+    const char* getMappedData() const override {
+        return file_->getMappedData();
+    }
+
+    std::string getFileName() const override {
+        return file_->getFileName();
+    }
+
+    std::string getDirName() const override {
+        return file_->getDirName();
+    }
+
+    bool isOpen() const override {
+        return file_->isOpen();
+    }
+
+    OperatorResult close() override {
+        return file_->close();
+    }
+private:
+    std::shared_ptr<RandomAccessFile> file_;
+public:
+    int reads;
+};
+
+TEST(SSTABLE, cuckooHashTable) {
+    const std::string filename = "test-sstable-cuckoo.sst";
+    TableConfig config;
+    config.block_size_threshold = 512;
+    config.format = TableFormat::CUCKOO_HASH_TABLE;
+    uint64_t file_size = 0;
+    {
+        // 偶数键: 新旧两个版本; 每10个键中有一个删除标记与一个合并操作数
+        std::shared_ptr<AppendOnlyFile> file = createAppendOnlyFile(filename);
+        SSTableBuilder builder(config, file.get());
+        for (int i = 0; i < 5000; i += 2) {
+            char key[16];
+            snprintf(key, sizeof(key), "key%06d", i);
+            if (i % 10 == 4) {
+                builder.add(encodeInternalKey(key, 20, ItemType::DELETION), "");
+            } else if (i % 10 == 6) {
+                builder.add(encodeInternalKey(key, 20, ItemType::MERGE), "operand" + std::to_string(i));
+            }
+            builder.add(encodeInternalKey(key, 10, ItemType::VALUE), "new" + std::to_string(i));
+            builder.add(encodeInternalKey(key, 5, ItemType::VALUE), "old" + std::to_string(i));
+        }
+        builder.addRangeTombstone(RangeTombstone{"key004000", "key004100", 15});
+        ASSERT_TRUE(builder.finish().isSuccess());
+        ASSERT_TRUE(file->close().isSuccess());
+        file_size = builder.getFileSize();
+    }
+
+    std::shared_ptr<CountingRandomAccessFile> file = 
+            std::make_shared<CountingRandomAccessFile>(createRandomAccessFile(filename));
+    std::shared_ptr<SSTable> table;
+    ASSERT_TRUE(SSTable::open(file, file_size, table).isSuccess());
+    file->reads = 0;
+    for (int i = 0; i < 5000; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%06d", i);
+        SSTable::LookupResult result;
+        ASSERT_TRUE(table->get(encodeLookupKey(key, MAX_SEQUENCE), result).isSuccess());
+        const bool covered = i >= 4000 && i < 4100;
+        if (i % 2 == 1) {
+            // 不存在的键也可能被范围删除标记遮住
+            EXPECT_EQ(result.found, covered) << key;
+        } else if (i % 10 == 6) {
+            // 合并操作数之后的版本按block格式查找
+            ASSERT_EQ(result.operands.size(), 1u) << key;
+            EXPECT_EQ(result.deleted, covered) << key;
+            if (!covered) {
+                EXPECT_EQ(result.value, "new" + std::to_string(i));
+            }
+        } else if (i % 10 == 4 || covered) {
+            EXPECT_TRUE(result.found && result.deleted) << key;
+        } else {
+            EXPECT_EQ(result.value, "new" + std::to_string(i)) << key;
+        }
+        // 快照之后的版本与范围删除标记不可见, 按block格式查找更旧的版本
+        result = SSTable::LookupResult();
+        ASSERT_TRUE(table->get(encodeLookupKey(key, 7), result).isSuccess());
+        EXPECT_EQ(result.found, i % 2 == 0) << key;
+        if (i % 2 == 0) {
+            EXPECT_EQ(result.value, "old" + std::to_string(i)) << key;
+        }
+    }
+    // 最新版本可见的点查与不存在的键只访问文件映射, 不读取index block与data block
+    file->reads = 0;
+    for (int i = 0; i < 4000; i += 10) {
+        SSTable::LookupResult result;
+        char key[16];
+        snprintf(key, sizeof(key), "key%06d", i + 1);
+        ASSERT_TRUE(table->get(encodeLookupKey(key, MAX_SEQUENCE), result).isSuccess());
+        EXPECT_FALSE(result.found);
+        snprintf(key, sizeof(key), "key%06d", i + 4);
+        ASSERT_TRUE(table->get(encodeLookupKey(key, MAX_SEQUENCE), result).isSuccess());
+        EXPECT_TRUE(result.found && result.deleted);
+    }
+    for (int i = 0; i < 4000; i += 10) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%06d", i);
+        SSTable::LookupResult result;
+        ASSERT_TRUE(table->get(encodeLookupKey(key, MAX_SEQUENCE), result).isSuccess());
+        EXPECT_EQ(result.value, "new" + std::to_string(i));
+    }
+    EXPECT_EQ(file->reads, 0);
+
+    // 遍历与block格式相同
+    SSTable::Iterator it(table);
+    int count = 0;
+    for (it.seekToFirst(); it.valid(); it.next()) {
+        ++count;
+    }
+    EXPECT_TRUE(it.getStatus().isSuccess());
+    EXPECT_EQ(count, 2500 * 2 + 500 * 2);
+    removeFile(filename);
+}
+
+
+TEST(SSTABLE, plainTable) {
+    const std::string filename = "test-sstable-plain.sst";
+    TableConfig config;
+    config.block_size_threshold = 512;
+    config.format = TableFormat::PLAIN_TABLE;
+    config.compression = CompressionType::LZ_COMPRESSION;
+    config.data_block_hash_ratio = 0.75;
+    uint64_t file_size = 0;
+    {
+        std::shared_ptr<AppendOnlyFile> file = createAppendOnlyFile(filename);
+        SSTableBuilder builder(config, file.get());
+        for (int i = 0; i < 3000; i += 2) {
+            char key[16];
+            snprintf(key, sizeof(key), "key%06d", i);
+            builder.add(encodeInternalKey(key, 10, ItemType::VALUE), "new" + std::to_string(i));
+            builder.add(encodeInternalKey(key, 5, ItemType::VALUE), "old" + std::to_string(i));
+        }
+        ASSERT_TRUE(builder.finish().isSuccess());
+        ASSERT_TRUE(file->close().isSuccess());
+        file_size = builder.getFileSize();
+    }
 
+    // 文件映射到内存时data block直接引用映射, 不读取文件也不占用缓存
+    BlockCache cache(1 << 20);
+    std::shared_ptr<CountingRandomAccessFile> file = 
+            std::make_shared<CountingRandomAccessFile>(createRandomAccessFile(filename));
+    std::shared_ptr<SSTable> table;
+    ASSERT_TRUE(SSTable::open(file, file_size, table, &cache).isSuccess());
+    file->reads = 0;
+    for (int i = 0; i < 3000; ++i) {
+        char key[16];
+        snprintf(key, sizeof(key), "key%06d", i);
+        SSTable::LookupResult result;
+        ASSERT_TRUE(table->get(encodeLookupKey(key, MAX_SEQUENCE), result).isSuccess());
+        EXPECT_EQ(result.found, i % 2 == 0) << key;
+        if (i % 2 == 0) {
+            EXPECT_EQ(result.value, "new" + std::to_string(i)) << key;
+        }
+        result = SSTable::LookupResult();
+        ASSERT_TRUE(table->get(encodeLookupKey(key, 7), result).isSuccess());
+        if (i % 2 == 0) {
+            EXPECT_EQ(result.value, "old" + std::to_string(i)) << key;
+        }
+    }
 
-}
\ No newline at end of file
+    SSTable::Iterator it(table);
+    int count = 0;
+    for (it.seekToFirst(); it.valid(); it.next()) {
+        ++count;
+    }
+    EXPECT_TRUE(it.getStatus().isSuccess());
+    EXPECT_EQ(count, 3000);
+    it.seek(encodeLookupKey("key001001", MAX_SEQUENCE));
+    ASSERT_TRUE(it.valid());
+    EXPECT_EQ(extractUserKey(it.key()), "key001002");
+    it.prev();
+    ASSERT_TRUE(it.valid());
+    EXPECT_EQ(it.value(), "old1000");
+    EXPECT_EQ(file->reads, 0);
+    EXPECT_EQ(cache.getUsage(), 0u);
+    removeFile(filename);
+}
+
+
+TEST(SSTABLE, zeroSequenceAtBaseLevel) {
+    std::shared_ptr<MemoryTable> memtable = std::make_shared<MemoryTable>();
+    memtable->add(20, ItemType::VALUE, "a", "a20");
+    memtable->add(6, ItemType::VALUE, "a", "a6");
+    memtable->add(5, ItemType::VALUE, "b", "b5");
+    memtable->add(4, ItemType::VALUE, "c", "c4");
+    memtable->add(7, ItemType::DELETION, "d", "");
+    memtable->add(8, ItemType::VALUE, "e", "e8");
+    memtable->add(9, ItemType::MERGE, "f", "f9");
+    // 比c的版本旧的范围删除标记, 序列号改写为0后会遮住它
+    RangeDelAggregator range_del(10);
+    range_del.add(RangeTombstone{"c", "d", 3});
+    range_del.finish();
+
+    MemoryTableIterator input(memtable);
+    CompactionIterator iter(&input, 10, &range_del, nullptr, 
+                            [](const std::string& user_key) { return user_key != "e"; });
+    std::vector<std::string> outputs;
+    for (iter.seekToFirst(); iter.valid(); iter.next()) {
+        outputs.push_back(iter.key());
+        if (extractUserKey(iter.key()) == "a" && outputs.size() == 2) {
+            EXPECT_EQ(iter.value(), "a6");
+        }
+    }
+    ASSERT_TRUE(iter.getStatus().isSuccess());
+    // 快照之后的版本、更深的层还有的键、被旧标记覆盖的键与合并操作数保留序列号
+    std::vector<std::string> expect = {
+        encodeInternalKey("a", 20, ItemType::VALUE),
+        encodeInternalKey("a", 0, ItemType::VALUE),
+        encodeInternalKey("b", 0, ItemType::VALUE),
+        encodeInternalKey("c", 4, ItemType::VALUE),
+        encodeInternalKey("e", 8, ItemType::VALUE),
+        encodeInternalKey("f", 9, ItemType::MERGE),
+    };
+    EXPECT_EQ(outputs, expect);
+}
+
+TEST(SSTABLE, parallelCompression) {
+    const std::string filename = "test-sstable-parallel.sst";
+    TableConfig config;
+    config.block_size_threshold = 512;
+    config.prefix_extractor = newFixedPrefixExtractor(5);
+    auto build = [&filename](const TableConfig& table_config, std::string& contents) {
+        std::shared_ptr<AppendOnlyFile> file = createAppendOnlyFile(filename);
+        SSTableBuilder builder(table_config, file.get());
+        for (int i = 0; i < 5000; ++i) {
+            char key[16];
+            snprintf(key, sizeof(key), "k%03d:%05d", i / 50, i);
+            // 一部分block压缩后没有变小, 按原样写入
+            const std::string value = i % 700 < 100 ? std::to_string(i * 2654435761u) + std::to_string(i * 40503u)
+                                                    : "{\"id\": " + std::to_string(i) + ", \"status\": \"active\"}";
+            builder.add(encodeInternalKey(key, 1, ItemType::VALUE), value);
+        }
+        ASSERT_TRUE(builder.finish().isSuccess());
+        ASSERT_TRUE(file->close().isSuccess());
+        ASSERT_TRUE(createRandomAccessFile(filename)->read(0, builder.getFileSize(), contents).isSuccess());
+        EXPECT_EQ(contents.size(), builder.getFileSize());
+    };
+
+    // 并行压缩只改变压缩在哪个线程上进行, 写出的文件与串行压缩相同
+    for (int variant = 0; variant < 3; ++variant) {
+        config.compression_dict_bytes = variant == 1 ? 4096 : 0;
+        config.compression_dict_sample_bytes = 16 << 10;
+        config.partition_index = variant == 2;
+        config.index_partition_size = 256;
+        std::string serial;
+        config.compression_threads = 0;
+        build(config, serial);
+        std::string parallel;
+        config.compression_threads = 4;
+        build(config, parallel);
+        EXPECT_EQ(serial.size(), parallel.size()) << variant;
+        EXPECT_TRUE(serial == parallel) << variant;
+
+        std::shared_ptr<SSTable> table;
+        ASSERT_TRUE(SSTable::open(createRandomAccessFile(filename), parallel.size(), table).isSuccess());
+        SSTable::Iterator it(table);
+        int count = 0;
+        for (it.seekToFirst(); it.valid(); it.next()) {
+            ++count;
+        }
+        EXPECT_TRUE(it.getStatus().isSuccess());
+        EXPECT_EQ(count, 5000);
+        EXPECT_TRUE(table->prefixMayMatch(*config.prefix_extractor, "k099:"));
+        removeFile(filename);
+    }
+}
+
+}